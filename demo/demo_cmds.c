@@ -372,6 +372,41 @@ static void cmd_download(anjay_demo_t *demo, const char *args_string) {
     }
 }
 
+static void cmd_download_ranges(anjay_demo_t *demo, const char *args_string) {
+    char url[256];
+    char target_file[256];
+    unsigned long max_connections;
+    unsigned long range_size;
+
+    if (sscanf(args_string, "%255s %255s %lu %lu", url, target_file,
+               &max_connections, &range_size)
+            != 4) {
+        demo_log(ERROR, "invalid arguments in: %s", args_string);
+        return;
+    }
+
+    FILE *f = fopen(target_file, "wb");
+    if (!f) {
+        demo_log(ERROR, "could not open file: %s", target_file);
+        return;
+    }
+
+    anjay_download_config_t cfg = {
+        .url = url,
+        .on_next_block = dl_write_next_block,
+        .on_download_finished = dl_finished,
+        .user_data = f,
+        .http_max_connections = (size_t) max_connections,
+        .http_range_size = (size_t) range_size
+    };
+
+    if (avs_is_err(anjay_download(demo->anjay, &cfg,
+                                  &(anjay_download_handle_t) { NULL }))) {
+        demo_log(ERROR, "could not schedule download");
+        fclose(f);
+    }
+}
+
 static void cmd_set_attrs(anjay_demo_t *demo, const char *args_string) {
     char *path = (char *) avs_malloc(strlen(args_string) + 1);
     if (!path) {
@@ -586,6 +621,11 @@ static const struct cmd_handler_def COMMAND_HANDLERS[] = {
     CMD_HANDLER("download", "url target_file [psk_identity psk_key]",
                 cmd_download,
                 "Download a file from given CoAP URL to target_file."),
+    CMD_HANDLER("download-ranges",
+                "url target_file max_connections range_size",
+                cmd_download_ranges,
+                "Download a file from given HTTP URL to target_file, using up "
+                "to max_connections parallel Range requests."),
     CMD_HANDLER("set-attrs", "", cmd_set_attrs, "Syntax [/a [/b [/c [/d] ] ] ] "
                 "ssid [pmin,pmax,lt,gt,st,epmin,epmax] "
                 "- e.g. /a/b 1 pmin=3,pmax=4"),
@@ -160,6 +160,7 @@
 #include <avsystem/coap/observe.h>
 #include <avsystem/coap/option.h>
 #include <avsystem/coap/streaming.h>
+#include <avsystem/coap/tcp.h>
 #include <avsystem/coap/token.h>
 #include <avsystem/coap/udp.h>
 
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2017-2019 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AVSYSTEM_COAP_TCP_H
+#define AVSYSTEM_COAP_TCP_H
+
+#include <avsystem/coap/config.h>
+
+#include <avsystem/commons/sched.h>
+#include <avsystem/commons/shared_buffer.h>
+#include <avsystem/commons/socket.h>
+
+#include <avsystem/coap/ctx.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef WITH_AVS_COAP_TCP
+
+/**
+ * Default time to wait for a response to a CoAP/TCP request, or for the peer's
+ * Capabilities and Settings Message after connecting.
+ */
+extern const avs_time_duration_t AVS_COAP_DEFAULT_TCP_REQUEST_TIMEOUT;
+
+/**
+ * Creates a CoAP/TCP context without associated socket.
+ *
+ * IMPORTANT: The socket MUST be set via @ref avs_coap_ctx_set_socket() before
+ * any operations on the context are performed. Otherwise the behavior is
+ * undefined. Setting the socket sends a Capabilities and Settings Message
+ * (CSM) and waits for the one sent by the peer.
+ *
+ * Only single messages are supported, i.e. the context does not declare
+ * support for BERT in its CSM.
+ *
+ * @param sched           Scheduler object that will be used to manage request
+ *                        timeouts.
+ *
+ *                        MUST NOT be NULL. Created context object does not
+ *                        take ownership of the scheduler, which MUST outlive
+ *                        created CoAP context object.
+ *
+ * @param in_buffer       Buffer whose capacity limits the size of incoming
+ *                        messages. It is advertised to the peer as
+ *                        Max-Message-Size.
+ *
+ *                        MUST NOT be NULL and MUST be different from
+ *                        @p out_buffer . Created context object does not take
+ *                        ownership of the buffer, which MUST outlive created
+ *                        CoAP context object.
+ *
+ * @param out_buffer      Buffer used for temporary storage of outgoing
+ *                        messages.
+ *
+ *                        MUST NOT be NULL and MUST be different from
+ *                        @p in_buffer . Created context object does not take
+ *                        ownership of the buffer, which MUST outlive created
+ *                        CoAP context object.
+ *
+ * @param request_timeout Time to wait for a response to a request, or for the
+ *                        peer's CSM. MUST be a valid, positive duration.
+ *
+ * @returns Created CoAP/TCP context on success, NULL on error.
+ *
+ * NOTE: @p in_buffer and @p out_buffer may be reused across different CoAP
+ * contexts if they are not used concurrently. Incomplete incoming messages are
+ * kept in a separate buffer owned by the context.
+ */
+avs_coap_ctx_t *avs_coap_tcp_ctx_create(avs_sched_t *sched,
+                                        avs_shared_buffer_t *in_buffer,
+                                        avs_shared_buffer_t *out_buffer,
+                                        avs_time_duration_t request_timeout);
+
+#endif // WITH_AVS_COAP_TCP
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AVSYSTEM_COAP_TCP_H
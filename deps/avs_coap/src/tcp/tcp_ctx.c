@@ -0,0 +1,817 @@
+/*
+ * Copyright 2017-2019 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_coap_config.h>
+
+#define MODULE_NAME coap_tcp
+#include <x_log_config.h>
+
+#include <assert.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <string.h>
+
+#include <avsystem/commons/errno.h>
+#include <avsystem/commons/shared_buffer.h>
+#include <avsystem/commons/socket.h>
+#include <avsystem/commons/utils.h>
+
+#include <avsystem/coap/option.h>
+#include <avsystem/coap/tcp.h>
+
+#include "code_utils.h"
+#include "common_utils.h"
+#include "ctx.h"
+#include "ctx_vtable.h"
+#include "options/iterator.h"
+#include "options/option.h"
+#include "options/options.h"
+
+#include "tcp/tcp_msg.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+const avs_time_duration_t AVS_COAP_DEFAULT_TCP_REQUEST_TIMEOUT = { 30, 0 };
+
+/**
+ * Space for locally generated messages (signaling messages and empty error
+ * responses), which never contain more than a short diagnostic payload.
+ */
+#define SMALL_MSG_BUFFER_SIZE 64
+
+/** Outgoing request waiting for a response. */
+typedef struct {
+    avs_coap_token_t token;
+    avs_time_monotonic_t expire_time;
+    avs_coap_send_result_handler_t *send_result_handler;
+    void *send_result_handler_arg;
+} avs_coap_tcp_pending_request_t;
+
+typedef struct {
+    const struct avs_coap_ctx_vtable *vtable;
+
+    avs_coap_base_t base;
+
+    avs_time_duration_t request_timeout;
+
+    /** Requests sent by us, sorted by expire_time. */
+    AVS_LIST(avs_coap_tcp_pending_request_t) pending_requests;
+
+    /** Max-Message-Size most recently announced by the peer. */
+    size_t peer_max_message_size;
+
+    /**
+     * State of the incoming message that is currently being received. The
+     * data may arrive in arbitrary chunks, so it is reassembled in recv_buf,
+     * which (unlike in_buffer) is not shared with other contexts.
+     */
+    struct {
+        /** Bytes of the current message consumed so far. */
+        uint64_t received;
+        /** Size of the header and token, or 0 if not known yet. */
+        size_t header_size;
+        /** Size of the whole message, or 0 if not known yet. */
+        uint64_t msg_size;
+    } recv;
+
+    size_t recv_buf_capacity;
+    uint8_t recv_buf[];
+} avs_coap_tcp_ctx_t;
+
+AVS_STATIC_ASSERT(offsetof(avs_coap_tcp_ctx_t, vtable) == 0,
+                  vtable_field_must_be_first_in_tcp_ctx_t);
+
+static void log_tcp_msg_summary(const char *info,
+                                const avs_coap_tcp_msg_t *msg) {
+    (void) info;
+    (void) msg;
+    LOG(DEBUG, "%s: %s (token: %s), payload: %u B", info,
+        AVS_COAP_CODE_STRING(msg->code), AVS_COAP_TOKEN_HEX(&msg->token),
+        (unsigned) msg->payload_size);
+}
+
+static size_t tcp_max_payload_size(size_t max_msg_size,
+                                   size_t token_size,
+                                   size_t options_size) {
+    // worst case, as the size of Extended Length depends on the payload size
+    const size_t msg_size = (AVS_COAP_TCP_MAX_HEADER_SIZE + token_size
+                             + options_size + sizeof(AVS_COAP_PAYLOAD_MARKER));
+    if (msg_size > max_msg_size) {
+        return 0;
+    }
+    return max_msg_size - msg_size;
+}
+
+static size_t
+coap_tcp_max_outgoing_payload_size(avs_coap_ctx_t *ctx_,
+                                   size_t token_size,
+                                   const avs_coap_options_t *options,
+                                   uint8_t code) {
+    (void) code;
+    avs_coap_tcp_ctx_t *ctx = (avs_coap_tcp_ctx_t *) ctx_;
+    return tcp_max_payload_size(AVS_MIN(ctx->base.out_buffer->capacity,
+                                        ctx->peer_max_message_size),
+                                token_size, options ? options->size : 0);
+}
+
+static size_t
+coap_tcp_max_incoming_payload_size(avs_coap_ctx_t *ctx_,
+                                   size_t token_size,
+                                   const avs_coap_options_t *options,
+                                   uint8_t code) {
+    (void) code;
+    avs_coap_tcp_ctx_t *ctx = (avs_coap_tcp_ctx_t *) ctx_;
+    return tcp_max_payload_size(ctx->recv_buf_capacity, token_size,
+                                options ? options->size : 0);
+}
+
+static avs_error_t send_serialized_msg(avs_coap_tcp_ctx_t *ctx,
+                                       const avs_coap_tcp_msg_t *msg,
+                                       const void *msg_buf,
+                                       size_t msg_size) {
+    log_tcp_msg_summary("send", msg);
+
+    avs_error_t err = avs_net_socket_send(ctx->base.socket, msg_buf, msg_size);
+    if (avs_is_err(err)) {
+        LOG(DEBUG, "send failed: %s", AVS_COAP_STRERROR(err));
+    }
+    return err;
+}
+
+static avs_error_t send_small_msg(avs_coap_tcp_ctx_t *ctx,
+                                  const avs_coap_tcp_msg_t *msg) {
+    uint8_t buf[SMALL_MSG_BUFFER_SIZE];
+    size_t msg_size;
+    avs_error_t err =
+            _avs_coap_tcp_msg_serialize(msg, buf, sizeof(buf), &msg_size);
+    if (avs_is_err(err)) {
+        AVS_UNREACHABLE("SMALL_MSG_BUFFER_SIZE too small");
+        return err;
+    }
+    return send_serialized_msg(ctx, msg, buf, msg_size);
+}
+
+static void send_empty_response(avs_coap_tcp_ctx_t *ctx,
+                                const avs_coap_token_t *token,
+                                uint8_t response_code) {
+    const avs_coap_tcp_msg_t msg = {
+        .code = response_code,
+        .token = *token
+    };
+    (void) send_small_msg(ctx, &msg);
+}
+
+static void send_abort(avs_coap_tcp_ctx_t *ctx, const char *diagnostic) {
+    (void) diagnostic;
+    avs_coap_tcp_msg_t msg = {
+        .code = AVS_COAP_CODE_ABORT
+    };
+#ifdef WITH_AVS_COAP_DIAGNOSTIC_MESSAGES
+    msg.payload = diagnostic;
+    msg.payload_size = strlen(diagnostic);
+#endif // WITH_AVS_COAP_DIAGNOSTIC_MESSAGES
+    LOG(DEBUG, "sending Abort: %s", diagnostic);
+    (void) send_small_msg(ctx, &msg);
+}
+
+static avs_error_t send_csm(avs_coap_tcp_ctx_t *ctx) {
+    uint8_t options_buf[8];
+    avs_coap_tcp_msg_t msg = {
+        .code = AVS_COAP_CODE_CSM,
+        .options = avs_coap_options_create_empty(options_buf,
+                                                 sizeof(options_buf))
+    };
+    // Block-Wise-Transfer is deliberately not announced: BERT is not
+    // supported, and plain BLOCK options are allowed without it
+    avs_error_t err = avs_coap_options_add_u32(
+            &msg.options, AVS_COAP_OPTION_CSM_MAX_MESSAGE_SIZE,
+            (uint32_t) AVS_MIN(ctx->recv_buf_capacity, UINT32_MAX));
+    if (avs_is_err(err)) {
+        AVS_UNREACHABLE("options_buf too small");
+        return err;
+    }
+    return send_small_msg(ctx, &msg);
+}
+
+static inline avs_coap_borrowed_msg_t
+borrowed_msg_from_tcp_msg(const avs_coap_tcp_msg_t *msg) {
+    return (avs_coap_borrowed_msg_t) {
+        .code = msg->code,
+        .token = msg->token,
+        .options = msg->options,
+        .payload = msg->payload,
+        .payload_size = msg->payload_size,
+        .total_payload_size = msg->payload_size
+    };
+}
+
+static AVS_LIST(avs_coap_tcp_pending_request_t) *
+find_pending_request_ptr(avs_coap_tcp_ctx_t *ctx,
+                         const avs_coap_token_t *token) {
+    AVS_LIST(avs_coap_tcp_pending_request_t) *request_ptr;
+    AVS_LIST_FOREACH_PTR(request_ptr, &ctx->pending_requests) {
+        if (avs_coap_token_equal(&(*request_ptr)->token, token)) {
+            return request_ptr;
+        }
+    }
+    return NULL;
+}
+
+static void
+insert_pending_request(avs_coap_tcp_ctx_t *ctx,
+                       AVS_LIST(avs_coap_tcp_pending_request_t) request) {
+    AVS_LIST(avs_coap_tcp_pending_request_t) *insert_ptr =
+            &ctx->pending_requests;
+    while (*insert_ptr
+           && !avs_time_monotonic_before(request->expire_time,
+                                         (*insert_ptr)->expire_time)) {
+        insert_ptr = AVS_LIST_NEXT_PTR(insert_ptr);
+    }
+    AVS_LIST_INSERT(insert_ptr, request);
+    _avs_coap_reschedule_retry_or_request_expired_job(
+            (avs_coap_ctx_t *) ctx, ctx->pending_requests->expire_time);
+}
+
+/**
+ * Detaches @p request from the pending list before calling its handler, so
+ * that the handler is free to do anything with the context.
+ */
+static void finish_pending_request(
+        avs_coap_tcp_ctx_t *ctx,
+        AVS_LIST(avs_coap_tcp_pending_request_t) *request_ptr,
+        avs_coap_send_result_t result,
+        avs_error_t fail_err) {
+    AVS_LIST(avs_coap_tcp_pending_request_t) request =
+            AVS_LIST_DETACH(request_ptr);
+    request->send_result_handler((avs_coap_ctx_t *) ctx, result, fail_err,
+                                 NULL, request->send_result_handler_arg);
+    AVS_LIST_DELETE(&request);
+}
+
+static void handle_response(avs_coap_tcp_ctx_t *ctx,
+                            const avs_coap_tcp_msg_t *msg) {
+    AVS_LIST(avs_coap_tcp_pending_request_t) *request_ptr =
+            find_pending_request_ptr(ctx, &msg->token);
+    if (!request_ptr) {
+        LOG(DEBUG, "Received response does not match any known request, "
+                   "ignoring");
+        return;
+    }
+
+    AVS_LIST(avs_coap_tcp_pending_request_t) request =
+            AVS_LIST_DETACH(request_ptr);
+    const avs_coap_borrowed_msg_t response = borrowed_msg_from_tcp_msg(msg);
+    if (request->send_result_handler((avs_coap_ctx_t *) ctx,
+                                     AVS_COAP_SEND_RESULT_OK, AVS_OK,
+                                     &response,
+                                     request->send_result_handler_arg)
+            == AVS_COAP_RESPONSE_NOT_ACCEPTED) {
+        // keep waiting for a response the handler is willing to accept
+        insert_pending_request(ctx, request);
+    } else {
+        AVS_LIST_DELETE(&request);
+    }
+}
+
+static avs_error_t handle_csm(avs_coap_tcp_ctx_t *ctx,
+                              avs_coap_tcp_msg_t *msg) {
+    for (avs_coap_option_iterator_t it = _avs_coap_optit_begin(&msg->options);
+         !_avs_coap_optit_end(&it);
+         _avs_coap_optit_next(&it)) {
+        const uint32_t number = _avs_coap_optit_number(&it);
+        // RFC 8323, 5.3: odd-numbered options are critical
+        if (number % 2 && number != AVS_COAP_OPTION_CSM_MAX_MESSAGE_SIZE
+                && number != AVS_COAP_OPTION_CSM_BLOCK_WISE_TRANSFER) {
+            LOG(DEBUG, "unknown critical CSM option: %" PRIu32, number);
+            send_abort(ctx, "unknown critical CSM option");
+            return _avs_coap_err(
+                    AVS_COAP_ERR_TCP_UNKNOWN_CSM_CRITICAL_OPTION_RECEIVED);
+        }
+    }
+
+    uint32_t max_message_size;
+    switch (avs_coap_options_get_u32(&msg->options,
+                                     AVS_COAP_OPTION_CSM_MAX_MESSAGE_SIZE,
+                                     &max_message_size)) {
+    case 0:
+        ctx->peer_max_message_size = max_message_size;
+        break;
+    case AVS_COAP_OPTION_MISSING:
+        break;
+    default:
+        send_abort(ctx, "malformed Max-Message-Size option");
+        return _avs_coap_err(AVS_COAP_ERR_TCP_MALFORMED_CSM_OPTIONS_RECEIVED);
+    }
+
+    LOG(DEBUG, "peer Max-Message-Size: %u",
+        (unsigned) ctx->peer_max_message_size);
+    return AVS_OK;
+}
+
+static avs_error_t handle_signaling_msg(avs_coap_tcp_ctx_t *ctx,
+                                        avs_coap_tcp_msg_t *msg) {
+    switch (msg->code) {
+    case AVS_COAP_CODE_CSM:
+        return handle_csm(ctx, msg);
+
+    case AVS_COAP_CODE_PING: {
+        const avs_coap_tcp_msg_t pong = {
+            .code = AVS_COAP_CODE_PONG,
+            .token = msg->token
+        };
+        return send_small_msg(ctx, &pong);
+    }
+
+    case AVS_COAP_CODE_PONG:
+        // we never send Ping, so there is nothing to match it with
+        return AVS_OK;
+
+    case AVS_COAP_CODE_RELEASE:
+        LOG(INFO, "Release message received");
+        return _avs_coap_err(AVS_COAP_ERR_TCP_RELEASE_RECEIVED);
+
+    case AVS_COAP_CODE_ABORT:
+        LOG(INFO, "Abort message received: %.*s",
+            (int) AVS_MIN(msg->payload_size, INT_MAX),
+            (const char *) msg->payload);
+        return _avs_coap_err(AVS_COAP_ERR_TCP_ABORT_RECEIVED);
+
+    default:
+        LOG(DEBUG, "unknown signaling message %s, ignoring",
+            AVS_COAP_CODE_STRING(msg->code));
+        return AVS_OK;
+    }
+}
+
+static avs_error_t handle_malformed_msg(avs_coap_tcp_ctx_t *ctx,
+                                        const avs_coap_tcp_msg_t *msg,
+                                        avs_error_t err) {
+    // header and token are validated before the rest of the message is
+    // received, so only options or payload may be invalid here
+    if (_avs_coap_code_is_signaling_message(msg->code)) {
+        if (msg->code == AVS_COAP_CODE_CSM) {
+            send_abort(ctx, "malformed CSM options");
+            return _avs_coap_err(
+                    AVS_COAP_ERR_TCP_MALFORMED_CSM_OPTIONS_RECEIVED);
+        }
+    } else if (avs_coap_code_is_request(msg->code)) {
+        // As defined in RFC7252, a CoAP message with Bad Option code
+        // should be send if options are unrecognized or malformed.
+        send_empty_response(ctx, &msg->token, AVS_COAP_CODE_BAD_OPTION);
+    } else if (avs_coap_code_is_response(msg->code)) {
+        AVS_LIST(avs_coap_tcp_pending_request_t) *request_ptr =
+                find_pending_request_ptr(ctx, &msg->token);
+        if (request_ptr) {
+            finish_pending_request(ctx, request_ptr, AVS_COAP_SEND_RESULT_FAIL,
+                                   err);
+        }
+    }
+    LOG(DEBUG, "malformed CoAP message received, ignoring");
+    return AVS_OK;
+}
+
+static void handle_truncated_msg(avs_coap_tcp_ctx_t *ctx) {
+    avs_coap_tcp_msg_t truncated_msg;
+    if (avs_is_err(_avs_coap_tcp_msg_parse_header(
+                &truncated_msg, ctx->recv_buf, ctx->recv.header_size))) {
+        AVS_UNREACHABLE("header is validated before it is complete");
+        return;
+    }
+
+    LOG(DEBUG,
+        "%s (token: %s) too large (%" PRIu64 " B), discarding its contents",
+        AVS_COAP_CODE_STRING(truncated_msg.code),
+        AVS_COAP_TOKEN_HEX(&truncated_msg.token), ctx->recv.msg_size);
+
+    if (avs_coap_code_is_request(truncated_msg.code)) {
+        send_empty_response(ctx, &truncated_msg.token,
+                            AVS_COAP_CODE_REQUEST_ENTITY_TOO_LARGE);
+    } else if (avs_coap_code_is_response(truncated_msg.code)) {
+        AVS_LIST(avs_coap_tcp_pending_request_t) *request_ptr =
+                find_pending_request_ptr(ctx, &truncated_msg.token);
+        if (request_ptr) {
+            finish_pending_request(
+                    ctx, request_ptr, AVS_COAP_SEND_RESULT_FAIL,
+                    _avs_coap_err(AVS_COAP_ERR_TRUNCATED_MESSAGE_RECEIVED));
+        }
+    }
+}
+
+static inline bool recv_msg_fits(const avs_coap_tcp_ctx_t *ctx) {
+    return ctx->recv.msg_size <= ctx->recv_buf_capacity;
+}
+
+/**
+ * Returns the part of recv_buf the next chunk of the current message shall be
+ * received into. Messages are received exactly up to their end, so that the
+ * beginning of the next one is left in the socket.
+ */
+static void get_recv_window(avs_coap_tcp_ctx_t *ctx,
+                            uint8_t **out_ptr,
+                            size_t *out_size) {
+    if (!ctx->recv.header_size) {
+        // first byte determines the header size
+        *out_ptr = ctx->recv_buf;
+        *out_size = 1;
+    } else if (!ctx->recv.msg_size) {
+        *out_ptr = ctx->recv_buf + ctx->recv.received;
+        *out_size = ctx->recv.header_size - (size_t) ctx->recv.received;
+    } else if (recv_msg_fits(ctx)) {
+        *out_ptr = ctx->recv_buf + ctx->recv.received;
+        *out_size = (size_t) (ctx->recv.msg_size - ctx->recv.received);
+    } else {
+        // message too large: keep the header, overwrite everything else
+        *out_ptr = ctx->recv_buf + ctx->recv.header_size;
+        *out_size = (size_t) AVS_MIN(
+                ctx->recv.msg_size - ctx->recv.received,
+                (uint64_t) (ctx->recv_buf_capacity - ctx->recv.header_size));
+    }
+}
+
+static avs_error_t update_recv_state(avs_coap_tcp_ctx_t *ctx) {
+    if (!ctx->recv.header_size
+            && !(ctx->recv.header_size =
+                         _avs_coap_tcp_header_size(ctx->recv_buf[0]))) {
+        send_abort(ctx, "malformed message header");
+        return _avs_coap_err(AVS_COAP_ERR_TCP_ABORT_SENT);
+    }
+
+    if (!ctx->recv.msg_size && ctx->recv.received == ctx->recv.header_size) {
+        ctx->recv.msg_size = _avs_coap_tcp_msg_size(ctx->recv_buf);
+        if (!recv_msg_fits(ctx)) {
+            handle_truncated_msg(ctx);
+        }
+    }
+    return AVS_OK;
+}
+
+static inline bool is_timeout(avs_error_t err) {
+    return err.category == AVS_ERRNO_CATEGORY && err.code == AVS_ETIMEDOUT;
+}
+
+/**
+ * Receives the current message, or as much of it as is available.
+ *
+ * @param out_msg_size Set to the size of the message placed in recv_buf once
+ *                     it is complete, or to 0 otherwise. Messages too large
+ *                     for recv_buf are discarded and never reported here.
+ *
+ * @returns AVS_OK if any data was received, AVS_ETIMEDOUT if none was
+ *          available, or another error if the connection is not usable.
+ */
+static avs_error_t recv_msg(avs_coap_tcp_ctx_t *ctx, size_t *out_msg_size) {
+    *out_msg_size = 0;
+
+    bool data_received = false;
+    while (true) {
+        uint8_t *window;
+        size_t window_size;
+        get_recv_window(ctx, &window, &window_size);
+        assert(window_size > 0);
+
+        size_t bytes_received;
+        avs_error_t err = avs_net_socket_receive(
+                ctx->base.socket, &bytes_received, window, window_size);
+        if (avs_is_err(err)) {
+            if (data_received && is_timeout(err)) {
+                // the rest of the message will be received later
+                return AVS_OK;
+            }
+            return err;
+        }
+        if (bytes_received == 0) {
+            LOG(DEBUG, "connection closed by peer");
+            return _avs_coap_err(AVS_COAP_ERR_TCP_CONN_CLOSED);
+        }
+        data_received = true;
+        ctx->recv.received += bytes_received;
+
+        if (avs_is_err((err = update_recv_state(ctx)))) {
+            return err;
+        }
+
+        if (ctx->recv.msg_size && ctx->recv.received == ctx->recv.msg_size) {
+            if (recv_msg_fits(ctx)) {
+                *out_msg_size = (size_t) ctx->recv.msg_size;
+            }
+            memset(&ctx->recv, 0, sizeof(ctx->recv));
+            return AVS_OK;
+        }
+    }
+}
+
+static avs_error_t parse_msg(avs_coap_tcp_ctx_t *ctx,
+                             size_t msg_size,
+                             avs_coap_tcp_msg_t *out_msg) {
+    avs_error_t err =
+            _avs_coap_tcp_msg_parse(out_msg, ctx->recv_buf, msg_size);
+    if (avs_is_ok(err)) {
+        log_tcp_msg_summary("recv", out_msg);
+    }
+    return err;
+}
+
+static avs_error_t
+coap_tcp_receive_message(avs_coap_ctx_t *ctx_,
+                         uint8_t *in_buffer,
+                         size_t in_buffer_capacity,
+                         avs_coap_borrowed_msg_t *out_request) {
+    // incoming data is reassembled in recv_buf instead
+    (void) in_buffer;
+    (void) in_buffer_capacity;
+
+    avs_coap_tcp_ctx_t *ctx = (avs_coap_tcp_ctx_t *) ctx_;
+    memset(out_request, 0, sizeof(*out_request));
+
+    size_t msg_size;
+    avs_error_t err = recv_msg(ctx, &msg_size);
+    if (avs_is_err(err) || !msg_size) {
+        return err;
+    }
+
+    avs_coap_tcp_msg_t msg;
+    if (avs_is_err((err = parse_msg(ctx, msg_size, &msg)))) {
+        return handle_malformed_msg(ctx, &msg, err);
+    }
+
+    if (_avs_coap_code_is_signaling_message(msg.code)) {
+        return handle_signaling_msg(ctx, &msg);
+    } else if (avs_coap_code_is_request(msg.code)) {
+        // msg points into recv_buf, which stays intact until the next call
+        *out_request = borrowed_msg_from_tcp_msg(&msg);
+    } else if (avs_coap_code_is_response(msg.code)) {
+        handle_response(ctx, &msg);
+    } else {
+        // RFC 8323, 3.4: Empty messages are always ignored
+    }
+    return AVS_OK;
+}
+
+static avs_error_t handle_first_msg(avs_coap_tcp_ctx_t *ctx,
+                                    size_t msg_size) {
+    avs_coap_tcp_msg_t msg;
+    avs_error_t err = parse_msg(ctx, msg_size, &msg);
+    if (msg.code != AVS_COAP_CODE_CSM) {
+        // RFC 8323, 5.3: CSM MUST be the first message on the connection
+        LOG(WARNING, "expected CSM, got %s", AVS_COAP_CODE_STRING(msg.code));
+        send_abort(ctx, "CSM expected");
+        return _avs_coap_err(AVS_COAP_ERR_TCP_CSM_NOT_RECEIVED);
+    }
+    if (avs_is_err(err)) {
+        return handle_malformed_msg(ctx, &msg, err);
+    }
+    return handle_csm(ctx, &msg);
+}
+
+static avs_error_t receive_csm(avs_coap_tcp_ctx_t *ctx) {
+    avs_net_socket_opt_value_t orig_recv_timeout;
+    avs_error_t err = avs_net_socket_get_opt(ctx->base.socket,
+                                             AVS_NET_SOCKET_OPT_RECV_TIMEOUT,
+                                             &orig_recv_timeout);
+    if (avs_is_err(err)) {
+        return err;
+    }
+
+    const avs_time_monotonic_t deadline =
+            avs_time_monotonic_add(avs_time_monotonic_now(),
+                                   ctx->request_timeout);
+    size_t msg_size = 0;
+    while (avs_is_ok(err) && !msg_size) {
+        const avs_time_duration_t time_left =
+                avs_time_monotonic_diff(deadline, avs_time_monotonic_now());
+        if (!avs_time_duration_less(AVS_TIME_DURATION_ZERO, time_left)) {
+            err = avs_errno(AVS_ETIMEDOUT);
+        } else if (avs_is_ok((err = avs_net_socket_set_opt(
+                                      ctx->base.socket,
+                                      AVS_NET_SOCKET_OPT_RECV_TIMEOUT,
+                                      (avs_net_socket_opt_value_t) {
+                                          .recv_timeout = time_left
+                                      })))) {
+            err = recv_msg(ctx, &msg_size);
+        }
+    }
+
+    avs_error_t restore_err =
+            avs_net_socket_set_opt(ctx->base.socket,
+                                   AVS_NET_SOCKET_OPT_RECV_TIMEOUT,
+                                   orig_recv_timeout);
+
+    if (is_timeout(err)) {
+        LOG(WARNING, "CSM not received in time");
+        err = _avs_coap_err(AVS_COAP_ERR_TCP_CSM_NOT_RECEIVED);
+    } else if (avs_is_ok(err)) {
+        err = handle_first_msg(ctx, msg_size);
+    }
+    return avs_is_ok(err) ? restore_err : err;
+}
+
+static avs_error_t coap_tcp_setsock(avs_coap_ctx_t *ctx_,
+                                    avs_net_socket_t *socket) {
+    avs_coap_tcp_ctx_t *ctx = (avs_coap_tcp_ctx_t *) ctx_;
+    avs_error_t err = _avs_coap_ctx_set_socket_base(ctx_, socket);
+    if (avs_is_err(err)) {
+        return err;
+    }
+
+    if (avs_is_err((err = send_csm(ctx)))
+            || avs_is_err((err = receive_csm(ctx)))) {
+        // leave the context as if the call never happened
+        ctx->base.socket = NULL;
+        ctx->peer_max_message_size = AVS_COAP_TCP_DEFAULT_MAX_MESSAGE_SIZE;
+        memset(&ctx->recv, 0, sizeof(ctx->recv));
+    }
+    return err;
+}
+
+static avs_error_t
+coap_tcp_send_message(avs_coap_ctx_t *ctx_,
+                      const avs_coap_borrowed_msg_t *msg,
+                      avs_coap_send_result_handler_t *send_result_handler,
+                      void *send_result_handler_arg) {
+    avs_coap_tcp_ctx_t *ctx = (avs_coap_tcp_ctx_t *) ctx_;
+
+    AVS_LIST(avs_coap_tcp_pending_request_t) request = NULL;
+    if (send_result_handler && avs_coap_code_is_request(msg->code)) {
+        if (!(request = AVS_LIST_NEW_ELEMENT(avs_coap_tcp_pending_request_t))) {
+            return avs_errno(AVS_ENOMEM);
+        }
+        *request = (avs_coap_tcp_pending_request_t) {
+            .token = msg->token,
+            .expire_time = avs_time_monotonic_add(avs_time_monotonic_now(),
+                                                  ctx->request_timeout),
+            .send_result_handler = send_result_handler,
+            .send_result_handler_arg = send_result_handler_arg
+        };
+    }
+
+    const avs_coap_tcp_msg_t tcp_msg = {
+        .code = msg->code,
+        .token = msg->token,
+        .options = msg->options,
+        .payload = msg->payload,
+        .payload_size = msg->payload_size
+    };
+
+    uint8_t *out_buffer = avs_shared_buffer_acquire(ctx->base.out_buffer);
+    size_t msg_size;
+    avs_error_t err =
+            _avs_coap_tcp_msg_serialize(&tcp_msg, out_buffer,
+                                        ctx->base.out_buffer->capacity,
+                                        &msg_size);
+    if (avs_is_ok(err)) {
+        err = send_serialized_msg(ctx, &tcp_msg, out_buffer, msg_size);
+    }
+    avs_shared_buffer_release(ctx->base.out_buffer);
+
+    if (avs_is_err(err)) {
+        // don't call the handler, the caller is notified by the return value
+        AVS_LIST_DELETE(&request);
+    } else if (request) {
+        insert_pending_request(ctx, request);
+    } else if (send_result_handler) {
+        // TCP guarantees delivery, there is no acknowledgement to wait for
+        send_result_handler(ctx_, AVS_COAP_SEND_RESULT_OK, AVS_OK, NULL,
+                            send_result_handler_arg);
+    }
+    return err;
+}
+
+static void coap_tcp_abort_delivery(avs_coap_ctx_t *ctx_,
+                                    avs_coap_exchange_direction_t direction,
+                                    const avs_coap_token_t *token,
+                                    avs_coap_send_result_t result,
+                                    avs_error_t fail_err) {
+    if (direction != AVS_COAP_EXCHANGE_CLIENT_REQUEST) {
+        // notifications are considered delivered as soon as they are sent
+        return;
+    }
+
+    avs_coap_tcp_ctx_t *ctx = (avs_coap_tcp_ctx_t *) ctx_;
+    AVS_LIST(avs_coap_tcp_pending_request_t) *request_ptr =
+            find_pending_request_ptr(ctx, token);
+    if (request_ptr) {
+        finish_pending_request(ctx, request_ptr, result, fail_err);
+    }
+}
+
+static void coap_tcp_ignore_current_request(avs_coap_ctx_t *ctx,
+                                            const avs_coap_token_t *token) {
+    (void) ctx;
+    (void) token;
+    // No-op - messages are passed up only after they are received entirely
+}
+
+static avs_time_monotonic_t coap_tcp_on_timeout(avs_coap_ctx_t *ctx_) {
+    avs_coap_tcp_ctx_t *ctx = (avs_coap_tcp_ctx_t *) ctx_;
+    const avs_time_monotonic_t now = avs_time_monotonic_now();
+
+    while (ctx->pending_requests
+           && !avs_time_monotonic_before(now,
+                                         ctx->pending_requests->expire_time)) {
+        LOG(DEBUG, "msg %s: no response received in time",
+            AVS_COAP_TOKEN_HEX(&ctx->pending_requests->token));
+        finish_pending_request(ctx, &ctx->pending_requests,
+                               AVS_COAP_SEND_RESULT_FAIL,
+                               _avs_coap_err(AVS_COAP_ERR_TIMEOUT));
+    }
+
+    return ctx->pending_requests ? ctx->pending_requests->expire_time
+                                 : AVS_TIME_MONOTONIC_INVALID;
+}
+
+static avs_error_t coap_tcp_accept_observation(avs_coap_ctx_t *ctx_,
+                                               avs_coap_observe_t *observe) {
+    (void) ctx_;
+    (void) observe;
+
+#ifdef WITH_AVS_COAP_OBSERVE
+    return AVS_OK;
+#else  // WITH_AVS_COAP_OBSERVE
+    LOG(WARNING, "Observes support disabled");
+    return _avs_coap_err(AVS_COAP_ERR_FEATURE_DISABLED);
+#endif // WITH_AVS_COAP_OBSERVE
+}
+
+static void coap_tcp_cleanup(avs_coap_ctx_t *ctx_) {
+    avs_coap_tcp_ctx_t *ctx = (avs_coap_tcp_ctx_t *) ctx_;
+
+    while (ctx->pending_requests) {
+        finish_pending_request(ctx, &ctx->pending_requests,
+                               AVS_COAP_SEND_RESULT_CANCEL, AVS_OK);
+    }
+    avs_free(ctx);
+}
+
+static avs_coap_base_t *coap_tcp_get_base(avs_coap_ctx_t *ctx_) {
+    avs_coap_tcp_ctx_t *ctx = (avs_coap_tcp_ctx_t *) ctx_;
+    return &ctx->base;
+}
+
+static avs_coap_stats_t coap_tcp_get_stats(avs_coap_ctx_t *ctx_) {
+    (void) ctx_;
+    // there are no retransmissions in CoAP/TCP
+    return (avs_coap_stats_t) { 0 };
+}
+
+static const avs_coap_ctx_vtable_t COAP_TCP_VTABLE = {
+    .cleanup = coap_tcp_cleanup,
+    .get_base = coap_tcp_get_base,
+    .setsock = coap_tcp_setsock,
+    .max_outgoing_payload_size = coap_tcp_max_outgoing_payload_size,
+    .max_incoming_payload_size = coap_tcp_max_incoming_payload_size,
+    .send_message = coap_tcp_send_message,
+    .abort_delivery = coap_tcp_abort_delivery,
+    .ignore_current_request = coap_tcp_ignore_current_request,
+    .receive_message = coap_tcp_receive_message,
+    .accept_observation = coap_tcp_accept_observation,
+    .on_timeout = coap_tcp_on_timeout,
+    .get_stats = coap_tcp_get_stats
+};
+
+avs_coap_ctx_t *avs_coap_tcp_ctx_create(avs_sched_t *sched,
+                                        avs_shared_buffer_t *in_buffer,
+                                        avs_shared_buffer_t *out_buffer,
+                                        avs_time_duration_t request_timeout) {
+    assert(in_buffer);
+    assert(out_buffer);
+
+    if (!avs_time_duration_less(AVS_TIME_DURATION_ZERO, request_timeout)) {
+        LOG(ERROR, "invalid CoAP/TCP request timeout");
+        return NULL;
+    }
+    // header and token are always received before the message size is checked
+    if (in_buffer->capacity
+            < AVS_COAP_TCP_MAX_HEADER_SIZE + AVS_COAP_MAX_TOKEN_LENGTH) {
+        LOG(ERROR, "input buffer too small");
+        return NULL;
+    }
+
+    avs_coap_tcp_ctx_t *ctx = (avs_coap_tcp_ctx_t *) avs_calloc(
+            1, sizeof(avs_coap_tcp_ctx_t) + in_buffer->capacity);
+    if (!ctx) {
+        return NULL;
+    }
+
+    _avs_coap_base_init(&ctx->base, (avs_coap_ctx_t *) ctx, in_buffer,
+                        out_buffer, sched);
+
+    ctx->vtable = &COAP_TCP_VTABLE;
+    ctx->request_timeout = request_timeout;
+    ctx->peer_max_message_size = AVS_COAP_TCP_DEFAULT_MAX_MESSAGE_SIZE;
+    ctx->recv_buf_capacity = in_buffer->capacity;
+
+    return (avs_coap_ctx_t *) ctx;
+}
@@ -0,0 +1,266 @@
+/*
+ * Copyright 2017-2019 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_coap_config.h>
+
+#define MODULE_NAME coap_tcp
+#include <x_log_config.h>
+
+#include <avsystem/commons/utils.h>
+
+#include <avsystem/coap/ctx.h>
+
+#include "tcp/tcp_msg.h"
+
+#include "code_utils.h"
+#include "common_utils.h"
+#include "options/options.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+/*
+ * RFC 8323, 3.2. Message Format: values of the 4-bit Len field above 12
+ * indicate that the actual length is stored in an Extended Length field.
+ */
+#define TCP_LEN_EXT8 13
+#define TCP_LEN_EXT16 14
+#define TCP_LEN_EXT32 15
+
+#define TCP_LEN_EXT8_OFFSET 13
+#define TCP_LEN_EXT16_OFFSET 269
+#define TCP_LEN_EXT32_OFFSET 65805
+
+static inline uint8_t get_len_nibble(uint8_t first_byte) {
+    return (uint8_t) (first_byte >> 4);
+}
+
+static inline uint8_t get_token_length(uint8_t first_byte) {
+    return (uint8_t) (first_byte & 0x0F);
+}
+
+static size_t extended_length_size(uint8_t len_nibble) {
+    switch (len_nibble) {
+    case TCP_LEN_EXT8:
+        return 1;
+    case TCP_LEN_EXT16:
+        return 2;
+    case TCP_LEN_EXT32:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+size_t _avs_coap_tcp_header_size(uint8_t first_byte) {
+    if (get_token_length(first_byte) > AVS_COAP_MAX_TOKEN_LENGTH) {
+        LOG(DEBUG, "invalid token longer than %u bytes",
+            (unsigned) AVS_COAP_MAX_TOKEN_LENGTH);
+        return 0;
+    }
+    return 1 + extended_length_size(get_len_nibble(first_byte)) + 1
+           + get_token_length(first_byte);
+}
+
+uint64_t _avs_coap_tcp_msg_size(const uint8_t *header) {
+    const uint8_t len_nibble = get_len_nibble(header[0]);
+    uint64_t length = 0;
+    for (size_t i = 0; i < extended_length_size(len_nibble); ++i) {
+        length = (length << 8) | header[1 + i];
+    }
+
+    switch (len_nibble) {
+    case TCP_LEN_EXT8:
+        length += TCP_LEN_EXT8_OFFSET;
+        break;
+    case TCP_LEN_EXT16:
+        length += TCP_LEN_EXT16_OFFSET;
+        break;
+    case TCP_LEN_EXT32:
+        length += TCP_LEN_EXT32_OFFSET;
+        break;
+    default:
+        length = len_nibble;
+        break;
+    }
+
+    return _avs_coap_tcp_header_size(header[0]) + length;
+}
+
+static avs_error_t parse_header(avs_coap_tcp_msg_t *out_msg,
+                                bytes_dispenser_t *dispenser) {
+    uint8_t first_byte;
+    if (_avs_coap_bytes_extract(dispenser, &first_byte, 1)) {
+        return _avs_coap_err(AVS_COAP_ERR_MALFORMED_MESSAGE);
+    }
+
+    if (!_avs_coap_tcp_header_size(first_byte)) {
+        return _avs_coap_err(AVS_COAP_ERR_MALFORMED_MESSAGE);
+    }
+
+    // Extended Length was already used to find the end of the message
+    if (_avs_coap_bytes_extract(
+                dispenser, NULL,
+                extended_length_size(get_len_nibble(first_byte)))
+            || _avs_coap_bytes_extract(dispenser, &out_msg->code, 1)) {
+        LOG(DEBUG, "malformed CoAP/TCP header");
+        return _avs_coap_err(AVS_COAP_ERR_MALFORMED_MESSAGE);
+    }
+
+    return _avs_coap_parse_token(&out_msg->token,
+                                 get_token_length(first_byte), dispenser);
+}
+
+avs_error_t _avs_coap_tcp_msg_parse_header(avs_coap_tcp_msg_t *out_msg,
+                                           const uint8_t *header,
+                                           size_t header_size) {
+    bytes_dispenser_t dispenser = {
+        .read_ptr = header,
+        .bytes_left = header_size
+    };
+    memset(out_msg, 0, sizeof(*out_msg));
+    return parse_header(out_msg, &dispenser);
+}
+
+static avs_error_t parse_payload(avs_coap_tcp_msg_t *out_msg,
+                                 bytes_dispenser_t *dispenser) {
+    out_msg->payload = dispenser->read_ptr;
+    out_msg->payload_size = dispenser->bytes_left;
+
+    if (out_msg->payload_size == 0) {
+        return AVS_OK;
+    }
+
+    // ensured by _avs_coap_options_parse
+    assert(*dispenser->read_ptr == AVS_COAP_PAYLOAD_MARKER);
+
+    out_msg->payload = dispenser->read_ptr + 1;
+    out_msg->payload_size -= 1;
+
+    if (out_msg->payload_size == 0) {
+        LOG(DEBUG, "payload marker must be omitted if there is no payload");
+        return _avs_coap_err(AVS_COAP_ERR_MALFORMED_OPTIONS);
+    }
+
+    return AVS_OK;
+}
+
+avs_error_t _avs_coap_tcp_msg_parse(avs_coap_tcp_msg_t *out_msg,
+                                    const uint8_t *packet,
+                                    size_t packet_size) {
+    assert(packet_size > 0);
+    assert(_avs_coap_tcp_msg_size(packet) == packet_size);
+
+    bytes_dispenser_t dispenser = {
+        .read_ptr = packet,
+        .bytes_left = packet_size
+    };
+    memset(out_msg, 0, sizeof(*out_msg));
+
+    avs_error_t err;
+    (void) (avs_is_err((err = parse_header(out_msg, &dispenser)))
+            || avs_is_err((err = _avs_coap_options_parse(
+                                   &out_msg->options, &dispenser, NULL, NULL)))
+            || avs_is_err((err = parse_payload(out_msg, &dispenser))));
+
+#ifdef WITH_AVS_COAP_BLOCK
+    if (avs_is_ok(err)
+            && !_avs_coap_options_block_payload_valid(&out_msg->options,
+                                                      out_msg->code,
+                                                      out_msg->payload_size)) {
+        err = _avs_coap_err(AVS_COAP_ERR_MALFORMED_OPTIONS);
+    }
+#endif // WITH_AVS_COAP_BLOCK
+
+    return err;
+}
+
+static int append_header(bytes_appender_t *appender,
+                         const avs_coap_tcp_msg_t *msg,
+                         uint64_t length) {
+    uint8_t len_nibble;
+    uint64_t extended_length;
+    if (length < TCP_LEN_EXT8_OFFSET) {
+        len_nibble = (uint8_t) length;
+        extended_length = 0;
+    } else if (length < TCP_LEN_EXT16_OFFSET) {
+        len_nibble = TCP_LEN_EXT8;
+        extended_length = length - TCP_LEN_EXT8_OFFSET;
+    } else if (length < TCP_LEN_EXT32_OFFSET) {
+        len_nibble = TCP_LEN_EXT16;
+        extended_length = length - TCP_LEN_EXT16_OFFSET;
+    } else {
+        len_nibble = TCP_LEN_EXT32;
+        extended_length = length - TCP_LEN_EXT32_OFFSET;
+        if (extended_length > UINT32_MAX) {
+            return -1;
+        }
+    }
+
+    const uint8_t first_byte =
+            (uint8_t) ((len_nibble << 4) | (uint8_t) msg->token.size);
+    if (_avs_coap_bytes_append(appender, &first_byte, 1)) {
+        return -1;
+    }
+
+    for (size_t i = extended_length_size(len_nibble); i > 0; --i) {
+        const uint8_t byte = (uint8_t) (extended_length >> (8 * (i - 1)));
+        if (_avs_coap_bytes_append(appender, &byte, 1)) {
+            return -1;
+        }
+    }
+
+    return _avs_coap_bytes_append(appender, &msg->code, 1);
+}
+
+avs_error_t _avs_coap_tcp_msg_serialize(const avs_coap_tcp_msg_t *msg,
+                                        uint8_t *buf,
+                                        size_t buf_size,
+                                        size_t *out_bytes_written) {
+    assert(msg);
+    assert(buf);
+    assert(out_bytes_written);
+    assert(msg->token.size <= AVS_COAP_MAX_TOKEN_LENGTH);
+
+    const bool has_payload = (msg->payload && msg->payload_size > 0);
+    const uint64_t length =
+            (uint64_t) msg->options.size
+            + (has_payload ? sizeof(AVS_COAP_PAYLOAD_MARKER) + msg->payload_size
+                           : 0);
+
+    bytes_appender_t appender = {
+        .write_ptr = buf,
+        .bytes_left = buf_size
+    };
+
+    if (append_header(&appender, msg, length)
+            || _avs_coap_bytes_append(&appender, msg->token.bytes,
+                                      msg->token.size)
+            || _avs_coap_bytes_append(&appender, msg->options.begin,
+                                      msg->options.size)) {
+        return _avs_coap_err(AVS_COAP_ERR_MESSAGE_TOO_BIG);
+    }
+
+    if (has_payload
+            && (_avs_coap_bytes_append(&appender, &AVS_COAP_PAYLOAD_MARKER,
+                                       sizeof(AVS_COAP_PAYLOAD_MARKER))
+                || _avs_coap_bytes_append(&appender, msg->payload,
+                                          msg->payload_size))) {
+        return _avs_coap_err(AVS_COAP_ERR_MESSAGE_TOO_BIG);
+    }
+
+    *out_bytes_written = buf_size - appender.bytes_left;
+    return AVS_OK;
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2017-2019 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AVS_COAP_SRC_TCP_TCP_MSG_H
+#define AVS_COAP_SRC_TCP_TCP_MSG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <avsystem/coap/code.h>
+#include <avsystem/coap/ctx.h>
+#include <avsystem/coap/option.h>
+#include <avsystem/coap/token.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/** @{
+ * Signaling message codes, as defined in RFC 8323.
+ */
+#define AVS_COAP_CODE_CSM AVS_COAP_CODE(7, 1)
+#define AVS_COAP_CODE_PING AVS_COAP_CODE(7, 2)
+#define AVS_COAP_CODE_PONG AVS_COAP_CODE(7, 3)
+#define AVS_COAP_CODE_RELEASE AVS_COAP_CODE(7, 4)
+#define AVS_COAP_CODE_ABORT AVS_COAP_CODE(7, 5)
+/** @} */
+
+/** @{
+ * Signaling options, as defined in RFC 8323. Numbers are only meaningful
+ * together with the signaling code they are attached to.
+ */
+#define AVS_COAP_OPTION_CSM_MAX_MESSAGE_SIZE 2
+#define AVS_COAP_OPTION_CSM_BLOCK_WISE_TRANSFER 4
+/** @} */
+
+/** Max-Message-Size to assume until the peer's CSM says otherwise. */
+#define AVS_COAP_TCP_DEFAULT_MAX_MESSAGE_SIZE 1152
+
+/**
+ * Maximum size of everything that precedes the token in a CoAP/TCP message:
+ * Len/TKL byte, up to 4 bytes of Extended Length and the Code byte.
+ */
+#define AVS_COAP_TCP_MAX_HEADER_SIZE 6
+
+/** Non-owning wrapper around a CoAP/TCP message buffer. */
+typedef struct {
+    uint8_t code;
+    avs_coap_token_t token;
+    avs_coap_options_t options;
+    const void *payload;
+    size_t payload_size;
+} avs_coap_tcp_msg_t;
+
+/**
+ * @returns Size of the header and token of a CoAP/TCP message starting with
+ *          @p first_byte , or 0 if its token length is invalid.
+ */
+size_t _avs_coap_tcp_header_size(uint8_t first_byte);
+
+/**
+ * @param header Buffer holding at least
+ *               <c>_avs_coap_tcp_header_size(header[0])</c> bytes.
+ *
+ * @returns Size of the whole CoAP/TCP message whose header is in @p header .
+ */
+uint64_t _avs_coap_tcp_msg_size(const uint8_t *header);
+
+/**
+ * Parses the header and token of a CoAP/TCP message. Only code and token are
+ * filled in @p out_msg .
+ */
+avs_error_t _avs_coap_tcp_msg_parse_header(avs_coap_tcp_msg_t *out_msg,
+                                           const uint8_t *header,
+                                           size_t header_size);
+
+avs_error_t _avs_coap_tcp_msg_parse(avs_coap_tcp_msg_t *out_msg,
+                                    const uint8_t *packet,
+                                    size_t packet_size);
+
+avs_error_t _avs_coap_tcp_msg_serialize(const avs_coap_tcp_msg_t *msg,
+                                        uint8_t *buf,
+                                        size_t buf_size,
+                                        size_t *out_bytes_written);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif // AVS_COAP_SRC_TCP_TCP_MSG_H
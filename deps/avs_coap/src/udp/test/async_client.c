@@ -288,6 +288,64 @@ AVS_UNIT_TEST(udp_async_client, send_request_multiple_with_nstart) {
     ASSERT_OK(avs_coap_async_handle_incoming_packet(env.coap_ctx, NULL, NULL));
 }
 
+AVS_UNIT_TEST(udp_async_client, send_request_window_with_nstart) {
+    test_env_t env __attribute__((cleanup(test_teardown))) =
+            test_setup_with_nstart(2);
+
+    const test_msg_t *requests[] = {
+        COAP_MSG(CON, GET, ID(0), TOKEN(nth_token(0))),
+        COAP_MSG(CON, GET, ID(1), TOKEN(nth_token(1))),
+        COAP_MSG(CON, GET, ID(2), TOKEN(nth_token(2))),
+        COAP_MSG(CON, GET, ID(3), TOKEN(nth_token(3)))
+    };
+    const test_msg_t *responses[] = {
+        COAP_MSG(ACK, CONTENT, ID(0), TOKEN(nth_token(0))),
+        COAP_MSG(ACK, CONTENT, ID(1), TOKEN(nth_token(1))),
+        COAP_MSG(ACK, CONTENT, ID(2), TOKEN(nth_token(2))),
+        COAP_MSG(ACK, CONTENT, ID(3), TOKEN(nth_token(3)))
+    };
+    AVS_STATIC_ASSERT(AVS_ARRAY_SIZE(requests) == AVS_ARRAY_SIZE(responses),
+                      mismatched_requests_responses_lists);
+
+    avs_coap_exchange_id_t ids[AVS_ARRAY_SIZE(requests)];
+
+    // Start all requests. First two should be sent immediately.
+    expect_send(&env, requests[0]);
+    expect_send(&env, requests[1]);
+
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(requests); ++i) {
+        ASSERT_OK(avs_coap_client_send_async_request(
+                env.coap_ctx, &ids[i], &requests[i]->request_header, NULL, NULL,
+                test_response_handler, &env.expects_list));
+        ASSERT_TRUE(avs_coap_exchange_id_valid(ids[i]));
+    }
+
+    // Response to the second request frees a slot for the third one, even
+    // though the first one is still in flight
+    expect_recv(&env, responses[1]);
+    expect_send(&env, requests[2]);
+    expect_handler_call(&env, &ids[1], AVS_COAP_CLIENT_REQUEST_OK,
+                        responses[1]);
+    expect_timeout(&env);
+    ASSERT_OK(avs_coap_async_handle_incoming_packet(env.coap_ctx, NULL, NULL));
+
+    expect_recv(&env, responses[0]);
+    expect_send(&env, requests[3]);
+    expect_handler_call(&env, &ids[0], AVS_COAP_CLIENT_REQUEST_OK,
+                        responses[0]);
+    expect_timeout(&env);
+    ASSERT_OK(avs_coap_async_handle_incoming_packet(env.coap_ctx, NULL, NULL));
+
+    for (size_t i = 2; i < AVS_ARRAY_SIZE(requests); ++i) {
+        expect_recv(&env, responses[i]);
+        expect_handler_call(&env, &ids[i], AVS_COAP_CLIENT_REQUEST_OK,
+                            responses[i]);
+        expect_timeout(&env);
+        ASSERT_OK(avs_coap_async_handle_incoming_packet(env.coap_ctx, NULL,
+                                                        NULL));
+    }
+}
+
 AVS_UNIT_TEST(udp_async_client, send_request_with_retransmissions) {
     test_env_t env __attribute__((cleanup(test_teardown))) =
             test_setup_default();
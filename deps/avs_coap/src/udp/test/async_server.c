@@ -39,6 +39,33 @@ AVS_UNIT_TEST(udp_async_server, coap_ping) {
     ASSERT_OK(avs_coap_async_handle_incoming_packet(env.coap_ctx, NULL, NULL));
 }
 
+AVS_UNIT_TEST(udp_async_server, all_ready_packets_handled_in_one_call) {
+    test_env_t env __attribute__((cleanup(test_teardown))) =
+            test_setup_default();
+
+    const test_msg_t *pings[] = {
+        COAP_MSG(CON, EMPTY, ID(0), NO_PAYLOAD),
+        COAP_MSG(CON, EMPTY, ID(1), NO_PAYLOAD),
+        COAP_MSG(CON, EMPTY, ID(2), NO_PAYLOAD)
+    };
+    const test_msg_t *pongs[] = {
+        COAP_MSG(RST, EMPTY, ID(0), NO_PAYLOAD),
+        COAP_MSG(RST, EMPTY, ID(1), NO_PAYLOAD),
+        COAP_MSG(RST, EMPTY, ID(2), NO_PAYLOAD)
+    };
+    AVS_STATIC_ASSERT(AVS_ARRAY_SIZE(pings) == AVS_ARRAY_SIZE(pongs),
+                      mismatched_pings_pongs_lists);
+
+    // datagrams that arrived at once should all be handled in a single call,
+    // without returning to the event loop in between
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(pings); ++i) {
+        expect_recv(&env, pings[i]);
+        expect_send(&env, pongs[i]);
+    }
+    expect_timeout(&env);
+    ASSERT_OK(avs_coap_async_handle_incoming_packet(env.coap_ctx, NULL, NULL));
+}
+
 AVS_UNIT_TEST(udp_async_server, non_request_non_response_non_empty_is_ignored) {
     test_env_t env __attribute__((cleanup(test_teardown))) =
             test_setup_default();
@@ -420,3 +420,39 @@ AVS_UNIT_TEST(coap_msg_cache, multiple_hosts_same_ids) {
 
     avs_coap_udp_response_cache_release(&cache);
 }
+
+AVS_UNIT_TEST(coap_msg_cache, many_entries_evicted_in_order) {
+    avs_coap_udp_response_cache_t *cache =
+            avs_coap_udp_response_cache_create(2048);
+
+    static const uint16_t msg_count = 500;
+    avs_coap_udp_cached_response_t cached_msg;
+    for (uint16_t id = 0; id < msg_count; ++id) {
+        test_udp_msg_t msg __attribute__((cleanup(free_msg))) =
+                setup_msg_with_id(id, "payload");
+        ASSERT_OK(_avs_coap_udp_response_cache_add(cache, "host", "port",
+                                                   &msg.udp_msg, &tx_params));
+        ASSERT_OK(_avs_coap_udp_response_cache_get(cache, "host", "port", id,
+                                                   &cached_msg));
+        assert_udp_msg_equal(msg.udp_msg, cached_msg.msg);
+        ASSERT_FAIL(_avs_coap_udp_response_cache_get(cache, "other", "port",
+                                                     id, &cached_msg));
+    }
+
+    // oldest entries should have been evicted; the newest ones should remain
+    // reachable
+    uint16_t first_present = 0;
+    while (first_present < msg_count
+           && avs_is_err(_avs_coap_udp_response_cache_get(
+                      cache, "host", "port", first_present, &cached_msg))) {
+        ++first_present;
+    }
+    ASSERT_TRUE(first_present > 0);
+    for (uint16_t id = first_present; id < msg_count; ++id) {
+        ASSERT_OK(_avs_coap_udp_response_cache_get(cache, "host", "port", id,
+                                                   &cached_msg));
+        ASSERT_EQ(_avs_coap_udp_header_get_id(&cached_msg.msg.header), id);
+    }
+
+    avs_coap_udp_response_cache_release(&cache);
+}
@@ -47,17 +47,21 @@ VISIBILITY_SOURCE_BEGIN
 /**
  * Owning wrapper around an unconfirmed outgoing CoAP/UDP message.
  *
- * List of CoAP/UDP exchanges is kept sorted by (hold, next_retransmit) tuple:
+ * Unconfirmed CoAP/UDP exchanges are kept in two lists:
  *
- * - up to NSTART first entries are "not held", i.e. are currently being
- *   retransmitted,
+ * - up to NSTART entries that are "not held", i.e. are currently being
+ *   retransmitted, are stored in unconfirmed_messages, sorted by
+ *   next_retransmit,
  *
- * - if more than NSTART exchanges were created, the rest is "held",
- *   i.e. not transmitted at all to honor NSTART defined by RFC7252.
+ * - if more than NSTART exchanges were created, the rest is "held", i.e. not
+ *   transmitted at all to honor NSTART defined by RFC7252. These are stored in
+ *   held_messages, in order of creation.
  *
  * Whenever an exchange is retransmitted, next_retransmit is updated to the
  * time of a next retransmission, and the exchange entry moved to appropriate
- * place in the exchange list to keep described ordering.
+ * place in the exchange list to keep described ordering. Each exchange has its
+ * own retry_state, so retransmission timeouts of exchanges started at the same
+ * time are independent of each other.
  */
 typedef struct {
     /** Handler to call when context is done with the message */
@@ -177,7 +181,18 @@ typedef struct {
 
     avs_coap_base_t base;
 
+    /**
+     * Exchanges currently in flight, i.e. not held due to NSTART, sorted by
+     * next_retransmit. Only these may be matched with incoming messages.
+     */
     AVS_LIST(avs_coap_udp_unconfirmed_msg_t) unconfirmed_messages;
+    /** Number of elements in @ref unconfirmed_messages */
+    size_t started_count;
+
+    /** Exchanges held due to NSTART, in order of creation. */
+    AVS_LIST(avs_coap_udp_unconfirmed_msg_t) held_messages;
+    /** Number of elements in @ref held_messages */
+    size_t held_count;
 
     avs_net_socket_t *socket;
     size_t last_mtu;
@@ -270,18 +285,15 @@ static uint16_t generate_id(avs_coap_udp_ctx_t *ctx) {
 }
 
 static size_t current_nstart(const avs_coap_udp_ctx_t *ctx) {
-    size_t started = 0;
-
-    AVS_LIST(avs_coap_udp_unconfirmed_msg_t) msg;
-    AVS_LIST_FOREACH(msg, ctx->unconfirmed_messages) {
-        if (!msg->hold) {
-            ++started;
-        } else {
-            break;
-        }
-    }
+    return ctx->started_count;
+}
 
-    return started;
+static inline bool nstart_invariant_holds(const avs_coap_udp_ctx_t *ctx) {
+    return ctx->started_count == AVS_LIST_SIZE(ctx->unconfirmed_messages)
+           && ctx->held_count == AVS_LIST_SIZE(ctx->held_messages)
+           && ctx->started_count
+                      == AVS_MIN(ctx->started_count + ctx->held_count,
+                                 ctx->tx_params.nstart);
 }
 
 static void _log_udp_msg_summary(const char *file,
@@ -399,15 +411,16 @@ static avs_time_monotonic_t get_first_retransmit_time(avs_coap_udp_ctx_t *ctx) {
 static AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *
 find_unconfirmed_insert_ptr(avs_coap_udp_ctx_t *ctx,
                             const avs_coap_udp_unconfirmed_msg_t *new_elem) {
+    if (new_elem->hold) {
+        return AVS_LIST_APPEND_PTR(&ctx->held_messages);
+    }
+
     AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *list_ptr = (AVS_LIST(
             avs_coap_udp_unconfirmed_msg_t) *) &ctx->unconfirmed_messages;
 
     AVS_LIST_ITERATE_PTR(list_ptr) {
-        if (!new_elem->hold && (*list_ptr)->hold) {
-            return list_ptr;
-        } else if (new_elem->hold == (*list_ptr)->hold
-                   && avs_time_monotonic_before(new_elem->next_retransmit,
-                                                (*list_ptr)->next_retransmit)) {
+        if (avs_time_monotonic_before(new_elem->next_retransmit,
+                                      (*list_ptr)->next_retransmit)) {
             return list_ptr;
         }
     }
@@ -417,17 +430,33 @@ find_unconfirmed_insert_ptr(avs_coap_udp_ctx_t *ctx,
     return list_ptr;
 }
 
-static AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *
-find_first_held_unconfirmed_ptr(avs_coap_udp_ctx_t *ctx) {
-    AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *unconfirmed_ptr;
+static void insert_unconfirmed(avs_coap_udp_ctx_t *ctx,
+                               AVS_LIST(avs_coap_udp_unconfirmed_msg_t) msg) {
+    AVS_LIST_INSERT(find_unconfirmed_insert_ptr(ctx, msg), msg);
+    if (msg->hold) {
+        ++ctx->held_count;
+    } else {
+        ++ctx->started_count;
+    }
+}
 
-    AVS_LIST_FOREACH_PTR(unconfirmed_ptr, &ctx->unconfirmed_messages) {
-        if ((*unconfirmed_ptr)->hold) {
-            return unconfirmed_ptr;
-        }
+static AVS_LIST(avs_coap_udp_unconfirmed_msg_t)
+detach_unconfirmed(avs_coap_udp_ctx_t *ctx,
+                   AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *msg_ptr) {
+    AVS_LIST(avs_coap_udp_unconfirmed_msg_t) msg = AVS_LIST_DETACH(msg_ptr);
+    if (msg->hold) {
+        assert(ctx->held_count > 0);
+        --ctx->held_count;
+    } else {
+        assert(ctx->started_count > 0);
+        --ctx->started_count;
     }
+    return msg;
+}
 
-    return NULL;
+static AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *
+find_first_held_unconfirmed_ptr(avs_coap_udp_ctx_t *ctx) {
+    return ctx->held_messages ? &ctx->held_messages : NULL;
 }
 
 static void reschedule_retransmission_job(avs_coap_udp_ctx_t *ctx) {
@@ -523,7 +552,7 @@ static void resume_next_unconfirmed(avs_coap_udp_ctx_t *ctx) {
             // avs_coap_async_send_request, adding a new held entry to the
             // context.
             avs_coap_udp_unconfirmed_msg_t *unconfirmed =
-                    AVS_LIST_DETACH(unconfirmed_ptr);
+                    detach_unconfirmed(ctx, unconfirmed_ptr);
             (void) call_send_result_handler(
                     ctx, unconfirmed, NULL, AVS_COAP_SEND_RESULT_FAIL,
                     _avs_coap_err(AVS_COAP_ERR_TIME_INVALID));
@@ -536,7 +565,7 @@ static void resume_next_unconfirmed(avs_coap_udp_ctx_t *ctx) {
     }
 
     AVS_LIST(avs_coap_udp_unconfirmed_msg_t) unconfirmed =
-            AVS_LIST_DETACH(unconfirmed_ptr);
+            detach_unconfirmed(ctx, unconfirmed_ptr);
     unconfirmed->hold = false;
     unconfirmed->next_retransmit = next_retransmit;
 
@@ -547,20 +576,18 @@ static void resume_next_unconfirmed(avs_coap_udp_ctx_t *ctx) {
                                         unconfirmed->packet_size);
 
     // the msg may need to be retransmitted before other started ones
-    AVS_LIST_INSERT(find_unconfirmed_insert_ptr(ctx, unconfirmed), unconfirmed);
+    insert_unconfirmed(ctx, unconfirmed);
     reschedule_retransmission_job(ctx);
 
-    assert(current_nstart(ctx)
-           == AVS_MIN(AVS_LIST_SIZE(ctx->unconfirmed_messages),
-                      ctx->tx_params.nstart));
+    assert(nstart_invariant_holds(ctx));
 }
 
 static void resume_unconfirmed_messages(avs_coap_udp_ctx_t *ctx) {
     assert(current_nstart(ctx) <= ctx->tx_params.nstart);
 
     const size_t resumed_msgs = current_nstart(ctx);
-    const size_t all_msgs = AVS_LIST_SIZE(ctx->unconfirmed_messages);
-    const size_t held_msgs = all_msgs - resumed_msgs;
+    const size_t held_msgs = ctx->held_count;
+    const size_t all_msgs = resumed_msgs + held_msgs;
 
     const size_t msgs_to_resume =
             AVS_MIN(ctx->tx_params.nstart - resumed_msgs, held_msgs);
@@ -591,9 +618,7 @@ static void finish_unconfirmed(avs_coap_udp_ctx_t *ctx) {
     resume_unconfirmed_messages(ctx);
 
     reschedule_retransmission_job(ctx);
-    assert(current_nstart(ctx)
-           == AVS_MIN(AVS_LIST_SIZE(ctx->unconfirmed_messages),
-                      ctx->tx_params.nstart));
+    assert(nstart_invariant_holds(ctx));
 }
 
 static void try_cleanup_unconfirmed(avs_coap_udp_ctx_t *ctx,
@@ -603,7 +628,8 @@ static void try_cleanup_unconfirmed(avs_coap_udp_ctx_t *ctx,
                                     avs_error_t fail_err) {
     assert(ctx);
     assert(unconfirmed);
-    AVS_ASSERT(!AVS_LIST_FIND_PTR(&ctx->unconfirmed_messages, unconfirmed),
+    AVS_ASSERT(!AVS_LIST_FIND_PTR(&ctx->unconfirmed_messages, unconfirmed)
+                       && !AVS_LIST_FIND_PTR(&ctx->held_messages, unconfirmed),
                "unconfirmed must be detached");
     LOG(DEBUG, "msg %s: %s", AVS_COAP_TOKEN_HEX(&unconfirmed->msg.token),
         send_result_string(result));
@@ -614,8 +640,7 @@ static void try_cleanup_unconfirmed(avs_coap_udp_ctx_t *ctx,
 
     if (response && result == AVS_COAP_SEND_RESULT_OK
             && handler_result != AVS_COAP_RESPONSE_ACCEPTED) {
-        AVS_LIST_INSERT(find_unconfirmed_insert_ptr(ctx, unconfirmed),
-                        unconfirmed);
+        insert_unconfirmed(ctx, unconfirmed);
     } else {
         finish_unconfirmed(ctx);
         AVS_LIST_DELETE(&unconfirmed);
@@ -635,13 +660,10 @@ static avs_coap_udp_exchange_direction_t direction_from_code(uint8_t code) {
 }
 
 static AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *
-find_unconfirmed_ptr(avs_coap_udp_ctx_t *ctx,
-                     avs_coap_udp_exchange_direction_t direction,
-                     const avs_coap_token_t *token,
-                     const uint16_t *id) {
-    AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *list_ptr =
-            &ctx->unconfirmed_messages;
-
+find_unconfirmed_ptr_in_list(AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *list_ptr,
+                             avs_coap_udp_exchange_direction_t direction,
+                             const avs_coap_token_t *token,
+                             const uint16_t *id) {
     AVS_LIST_ITERATE_PTR(list_ptr) {
         const avs_coap_udp_msg_t *msg = &(*list_ptr)->msg;
         if ((direction == AVS_COAP_UDP_EXCHANGE_ANY
@@ -655,6 +677,20 @@ find_unconfirmed_ptr(avs_coap_udp_ctx_t *ctx,
     return NULL;
 }
 
+/**
+ * Looks up an exchange that an incoming message may refer to. Held exchanges
+ * have never been sent, so only the ones in flight (at most NSTART) need to be
+ * searched.
+ */
+static inline AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *
+find_unconfirmed_ptr(avs_coap_udp_ctx_t *ctx,
+                     avs_coap_udp_exchange_direction_t direction,
+                     const avs_coap_token_t *token,
+                     const uint16_t *id) {
+    return find_unconfirmed_ptr_in_list(&ctx->unconfirmed_messages, direction,
+                                        token, id);
+}
+
 static inline AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *
 find_unconfirmed_ptr_by_token(avs_coap_udp_ctx_t *ctx,
                               avs_coap_udp_exchange_direction_t direction,
@@ -696,9 +732,13 @@ detach_unconfirmed_by_token(avs_coap_udp_ctx_t *ctx,
                             const avs_coap_token_t *token) {
     AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *msg_ptr =
             find_unconfirmed_ptr_by_token(ctx, direction, token);
+    if (!msg_ptr) {
+        msg_ptr = find_unconfirmed_ptr_in_list(&ctx->held_messages, direction,
+                                               token, NULL);
+    }
 
     if (msg_ptr) {
-        return AVS_LIST_DETACH(msg_ptr);
+        return detach_unconfirmed(ctx, msg_ptr);
     }
     return NULL;
 }
@@ -713,7 +753,7 @@ confirm_unconfirmed(avs_coap_udp_ctx_t *ctx,
     AVS_ASSERT(AVS_LIST_FIND_PTR(&ctx->unconfirmed_messages, *msg_ptr),
                "unconfirmed_msg must be enqueued");
 
-    avs_coap_udp_unconfirmed_msg_t *msg = AVS_LIST_DETACH(msg_ptr);
+    avs_coap_udp_unconfirmed_msg_t *msg = detach_unconfirmed(ctx, msg_ptr);
     try_cleanup_unconfirmed(ctx, msg, response, AVS_COAP_SEND_RESULT_OK,
                             AVS_OK);
 }
@@ -728,7 +768,7 @@ static void fail_unconfirmed(avs_coap_udp_ctx_t *ctx,
     AVS_ASSERT(AVS_LIST_FIND_PTR(&ctx->unconfirmed_messages, *msg_ptr),
                "unconfirmed_msg must be enqueued");
 
-    avs_coap_udp_unconfirmed_msg_t *msg = AVS_LIST_DETACH(msg_ptr);
+    avs_coap_udp_unconfirmed_msg_t *msg = detach_unconfirmed(ctx, msg_ptr);
     try_cleanup_unconfirmed(ctx, msg, truncated_msg, AVS_COAP_SEND_RESULT_FAIL,
                             err);
 }
@@ -817,12 +857,10 @@ retransmit_next_message_without_reschedule(avs_coap_udp_ctx_t *ctx) {
     }
 
     unconfirmed->next_retransmit = next_retransmit;
-    unconfirmed = AVS_LIST_DETACH(&ctx->unconfirmed_messages);
-    AVS_LIST_INSERT(find_unconfirmed_insert_ptr(ctx, unconfirmed), unconfirmed);
+    unconfirmed = detach_unconfirmed(ctx, &ctx->unconfirmed_messages);
+    insert_unconfirmed(ctx, unconfirmed);
 
-    assert(current_nstart(ctx)
-           == AVS_MIN(AVS_LIST_SIZE(ctx->unconfirmed_messages),
-                      ctx->tx_params.nstart));
+    assert(nstart_invariant_holds(ctx));
 }
 
 static avs_time_monotonic_t coap_udp_on_timeout(avs_coap_ctx_t *ctx_) {
@@ -849,9 +887,8 @@ enqueue_unconfirmed(avs_coap_udp_ctx_t *ctx,
     // do not send the message unless there is no other one waiting to be sent
     // that is held for longer than this one
     assert(ctx->tx_params.nstart > 0);
-    unconfirmed->hold =
-            (AVS_LIST_NTH(ctx->unconfirmed_messages, ctx->tx_params.nstart - 1)
-             != NULL);
+    unconfirmed->hold = (ctx->started_count + ctx->held_count
+                         >= ctx->tx_params.nstart);
 
     // use current time for all held jobs to not cause accidental reordering
     // due to ACK_RANDOM_FACTOR
@@ -882,7 +919,7 @@ enqueue_unconfirmed(avs_coap_udp_ctx_t *ctx,
         }
     }
 
-    AVS_LIST_INSERT(find_unconfirmed_insert_ptr(ctx, unconfirmed), unconfirmed);
+    insert_unconfirmed(ctx, unconfirmed);
     reschedule_retransmission_job(ctx);
     return AVS_OK;
 }
@@ -1234,17 +1271,15 @@ ack_request(avs_coap_udp_ctx_t *ctx,
     }
 
     avs_coap_udp_unconfirmed_msg_t *unconfirmed =
-            AVS_LIST_DETACH(unconfirmed_ptr);
+            detach_unconfirmed(ctx, unconfirmed_ptr);
     // disable further retransmissions
     unconfirmed->retry_state.retry_count = ctx->tx_params.max_retransmit;
     unconfirmed->next_retransmit = next_retransmit;
 
-    AVS_LIST_INSERT(find_unconfirmed_insert_ptr(ctx, unconfirmed), unconfirmed);
+    insert_unconfirmed(ctx, unconfirmed);
     reschedule_retransmission_job(ctx);
 
-    assert(current_nstart(ctx)
-           == AVS_MIN(AVS_LIST_SIZE(ctx->unconfirmed_messages),
-                      ctx->tx_params.nstart));
+    assert(nstart_invariant_holds(ctx));
 }
 
 static avs_error_t handle_empty(avs_coap_udp_ctx_t *ctx,
@@ -1490,9 +1525,10 @@ static avs_error_t coap_udp_accept_observation(avs_coap_ctx_t *ctx_,
 static void coap_udp_cleanup(avs_coap_ctx_t *ctx_) {
     avs_coap_udp_ctx_t *ctx = (avs_coap_udp_ctx_t *) ctx_;
 
-    while (ctx->unconfirmed_messages) {
-        avs_coap_udp_unconfirmed_msg_t *unconfirmed =
-                AVS_LIST_DETACH(&ctx->unconfirmed_messages);
+    while (ctx->unconfirmed_messages || ctx->held_messages) {
+        avs_coap_udp_unconfirmed_msg_t *unconfirmed = detach_unconfirmed(
+                ctx, ctx->unconfirmed_messages ? &ctx->unconfirmed_messages
+                                               : &ctx->held_messages);
         try_cleanup_unconfirmed(ctx, unconfirmed, NULL,
                                 AVS_COAP_SEND_RESULT_CANCEL, AVS_OK);
     }
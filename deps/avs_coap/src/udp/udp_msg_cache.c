@@ -42,11 +42,35 @@ typedef struct endpoint {
     char port[sizeof("65535")];
 } endpoint_t;
 
+/**
+ * Slot of the open-addressing (linear probing) index of cache entries, keyed
+ * by (endpoint, msg_id). A slot is empty if its endpoint is NULL.
+ */
+typedef struct {
+    const endpoint_t *endpoint;
+    uint16_t msg_id;
+    // position of the entry in the stream of all bytes ever appended to the
+    // buffer; see avs_coap_udp_response_cache::consumed_bytes
+    size_t position;
+} index_slot_t;
+
 struct avs_coap_udp_response_cache {
     AVS_LIST(endpoint_t) endpoints; // sorted by id
 
     // priority queue of cache_entry_t, sorted by expiration_time
     avs_buffer_t *buffer;
+
+    // Number of bytes consumed from the beginning of buffer since its creation
+    // (modulo SIZE_MAX + 1). Entry at a given position is located at
+    // (position - consumed_bytes) bytes from avs_buffer_data(), which, unlike
+    // raw pointers, stays valid when avs_buffer_t defragments itself.
+    size_t consumed_bytes;
+
+    // hash index of entries present in buffer; index_size is either 0 or
+    // a power of two
+    index_slot_t *index;
+    size_t index_size;
+    size_t index_used;
 };
 
 typedef struct cache_entry {
@@ -86,25 +110,35 @@ void avs_coap_udp_response_cache_release(
     if (cache_ptr && *cache_ptr) {
         avs_buffer_free(&(*cache_ptr)->buffer);
         AVS_LIST_CLEAR(&(*cache_ptr)->endpoints);
+        avs_free((*cache_ptr)->index);
         avs_free(*cache_ptr);
         *cache_ptr = NULL;
     }
 }
 
-static endpoint_t *cache_endpoint_add_ref(avs_coap_udp_response_cache_t *cache,
-                                          const char *remote_addr,
-                                          const char *remote_port) {
+static endpoint_t *cache_endpoint_find(avs_coap_udp_response_cache_t *cache,
+                                       const char *remote_addr,
+                                       const char *remote_port) {
     assert(remote_addr);
     assert(remote_port);
 
-    AVS_LIST(endpoint_t) *ep_ptr;
-    AVS_LIST_FOREACH_PTR(ep_ptr, &cache->endpoints) {
-        if (!strcmp(remote_addr, (*ep_ptr)->addr)
-                && !strcmp(remote_port, (*ep_ptr)->port)) {
-            ++(*ep_ptr)->refcount;
-            return *ep_ptr;
+    AVS_LIST(endpoint_t) ep;
+    AVS_LIST_FOREACH(ep, cache->endpoints) {
+        if (!strcmp(remote_addr, ep->addr) && !strcmp(remote_port, ep->port)) {
+            return ep;
         }
     }
+    return NULL;
+}
+
+static endpoint_t *cache_endpoint_add_ref(avs_coap_udp_response_cache_t *cache,
+                                          const char *remote_addr,
+                                          const char *remote_port) {
+    endpoint_t *ep = cache_endpoint_find(cache, remote_addr, remote_port);
+    if (ep) {
+        ++ep->refcount;
+        return ep;
+    }
 
     AVS_LIST(endpoint_t) new_ep = AVS_LIST_NEW_ELEMENT(endpoint_t);
     if (!new_ep) {
@@ -145,6 +179,93 @@ static void cache_endpoint_del_ref(avs_coap_udp_response_cache_t *cache,
     }
 }
 
+static size_t index_hash(const endpoint_t *endpoint, uint16_t msg_id) {
+    // Endpoints are interned, so their addresses may be used as identity.
+    // Message IDs are usually consecutive, so using them directly maps them to
+    // distinct slots.
+    return (size_t) msg_id ^ ((size_t) ((uintptr_t) endpoint >> 4) * 31u);
+}
+
+static index_slot_t *index_find(const avs_coap_udp_response_cache_t *cache,
+                                const endpoint_t *endpoint,
+                                uint16_t msg_id) {
+    if (!cache->index_size) {
+        return NULL;
+    }
+    const size_t mask = cache->index_size - 1;
+    for (size_t i = index_hash(endpoint, msg_id) & mask;
+         cache->index[i].endpoint;
+         i = (i + 1) & mask) {
+        if (cache->index[i].endpoint == endpoint
+                && cache->index[i].msg_id == msg_id) {
+            return &cache->index[i];
+        }
+    }
+    return NULL;
+}
+
+static void index_insert_unchecked(index_slot_t *index,
+                                   size_t index_size,
+                                   const index_slot_t *slot) {
+    const size_t mask = index_size - 1;
+    size_t i = index_hash(slot->endpoint, slot->msg_id) & mask;
+    while (index[i].endpoint) {
+        i = (i + 1) & mask;
+    }
+    index[i] = *slot;
+}
+
+/**
+ * Makes sure that one more entry can be inserted into the index while keeping
+ * its load factor at most 1/2.
+ */
+static int index_reserve(avs_coap_udp_response_cache_t *cache) {
+    if (2 * (cache->index_used + 1) <= cache->index_size) {
+        return 0;
+    }
+    const size_t new_size = cache->index_size ? 2 * cache->index_size : 16;
+    index_slot_t *new_index =
+            (index_slot_t *) avs_calloc(new_size, sizeof(index_slot_t));
+    if (!new_index) {
+        LOG(DEBUG, "out of memory");
+        return -1;
+    }
+    for (size_t i = 0; i < cache->index_size; ++i) {
+        if (cache->index[i].endpoint) {
+            index_insert_unchecked(new_index, new_size, &cache->index[i]);
+        }
+    }
+    avs_free(cache->index);
+    cache->index = new_index;
+    cache->index_size = new_size;
+    return 0;
+}
+
+static void index_remove(avs_coap_udp_response_cache_t *cache,
+                         const endpoint_t *endpoint,
+                         uint16_t msg_id) {
+    index_slot_t *slot = index_find(cache, endpoint, msg_id);
+    assert(slot);
+    const size_t mask = cache->index_size - 1;
+    size_t hole = (size_t) (slot - cache->index);
+    // backward shift deletion: move back any following entries that would
+    // otherwise become unreachable, instead of leaving a tombstone
+    for (size_t i = (hole + 1) & mask; cache->index[i].endpoint;
+         i = (i + 1) & mask) {
+        size_t home = index_hash(cache->index[i].endpoint,
+                                 cache->index[i].msg_id)
+                      & mask;
+        bool stays = (hole <= i) ? (hole < home && home <= i)
+                                 : (hole < home || home <= i);
+        if (!stays) {
+            cache->index[hole] = cache->index[i];
+            hole = i;
+        }
+    }
+    cache->index[hole].endpoint = NULL;
+    --cache->index_used;
+}
+
 static size_t padding_bytes_after_msg(size_t msg_size) {
     static const size_t entry_alignment = AVS_ALIGNOF(cache_entry_t);
     const size_t entry_length = offsetof(cache_entry_t, data) + msg_size;
@@ -170,6 +291,17 @@ static void cache_put_entry(avs_coap_udp_response_cache_t *cache,
         .msg_size = (uint16_t) msg_size
     };
 
+    assert(2 * (cache->index_used + 1) <= cache->index_size);
+    index_insert_unchecked(
+            cache->index, cache->index_size,
+            &(const index_slot_t) {
+                .endpoint = endpoint,
+                .msg_id = _avs_coap_udp_header_get_id(&msg->header),
+                .position = cache->consumed_bytes
+                            + avs_buffer_data_size(cache->buffer)
+            });
+    ++cache->index_used;
+
     assert(avs_buffer_data_size(cache->buffer) % AVS_ALIGNOF(cache_entry_t)
            == 0);
     int res;
@@ -242,6 +374,22 @@ static const cache_entry_t *entry_next(const cache_entry_t *entry) {
     return result;
 }
 
+static void entry_drop(avs_coap_udp_response_cache_t *cache,
+                       const cache_entry_t *entry) {
+    index_remove(cache, entry->endpoint, entry_id(entry));
+    cache_endpoint_del_ref(cache, entry->endpoint);
+}
+
+static void cache_consume_dropped(avs_coap_udp_response_cache_t *cache,
+                                  const cache_entry_t *first_remaining) {
+    size_t dropped_bytes =
+            (uintptr_t) first_remaining - (uintptr_t) entry_first(cache);
+    int res = avs_buffer_consume_bytes(cache->buffer, dropped_bytes);
+    assert(!res);
+    (void) res;
+    cache->consumed_bytes += dropped_bytes;
+}
+
 static void cache_free_bytes(avs_coap_udp_response_cache_t *cache,
                              size_t bytes_required) {
     assert(bytes_required <= avs_buffer_capacity(cache->buffer));
@@ -257,14 +405,11 @@ static void cache_free_bytes(avs_coap_udp_response_cache_t *cache,
             "msg_cache: dropping msg (id = %u) to make room for"
             " a new one (size = %lu)",
             entry_id(entry), (unsigned long) bytes_required);
-        cache_endpoint_del_ref(cache, entry->endpoint);
         bytes_free += entry_size(entry);
+        entry_drop(cache, entry);
     }
 
-    size_t expired_bytes = (uintptr_t) entry - (uintptr_t) entry_first(cache);
-    int res = avs_buffer_consume_bytes(cache->buffer, expired_bytes);
-    assert(!res);
-    (void) res;
+    cache_consume_dropped(cache, entry);
 }
 
 static void cache_drop_expired(avs_coap_udp_response_cache_t *cache,
@@ -275,34 +420,36 @@ static void cache_drop_expired(avs_coap_udp_response_cache_t *cache,
         if (entry_expired(entry, now)) {
             LOG(TRACE, "msg_cache: dropping expired msg (id = %u)",
                 entry_id(entry));
-            cache_endpoint_del_ref(cache, entry->endpoint);
+            entry_drop(cache, entry);
         } else {
             break;
         }
     }
 
-    size_t expired_bytes = (uintptr_t) entry - (uintptr_t) entry_first(cache);
-    int res = avs_buffer_consume_bytes(cache->buffer, expired_bytes);
-    assert(!res);
-    (void) res;
+    cache_consume_dropped(cache, entry);
 }
 
 static const cache_entry_t *
-find_entry(const avs_coap_udp_response_cache_t *cache,
+find_entry(avs_coap_udp_response_cache_t *cache,
            const char *remote_addr,
            const char *remote_port,
            uint16_t msg_id) {
-    for (const cache_entry_t *entry = entry_first(cache);
-         entry_valid(cache, entry);
-         entry = entry_next(entry)) {
-        if (entry_id(entry) == msg_id
-                && !strcmp(entry->endpoint->addr, remote_addr)
-                && !strcmp(entry->endpoint->port, remote_port)) {
-            return entry;
-        }
+    const endpoint_t *endpoint =
+            cache_endpoint_find(cache, remote_addr, remote_port);
+    if (!endpoint) {
+        return NULL;
     }
-
-    return NULL;
+    const index_slot_t *slot = index_find(cache, endpoint, msg_id);
+    if (!slot) {
+        return NULL;
+    }
+    const cache_entry_t *entry =
+            (const cache_entry_t *) (avs_buffer_data(cache->buffer)
+                                     + (slot->position
+                                        - cache->consumed_bytes));
+    assert(entry_valid(cache, entry));
+    assert(entry->endpoint == endpoint && entry_id(entry) == msg_id);
+    return entry;
 }
 
 int _avs_coap_udp_response_cache_add(
@@ -332,6 +479,10 @@ int _avs_coap_udp_response_cache_add(
         return AVS_COAP_MSG_CACHE_DUPLICATE;
     }
 
+    if (index_reserve(cache)) {
+        return -1;
+    }
+
     endpoint_t *ep = cache_endpoint_add_ref(cache, remote_addr, remote_port);
     if (!ep) {
         return -1;
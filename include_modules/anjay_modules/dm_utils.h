@@ -274,6 +274,13 @@ int _anjay_dm_foreach_instance(anjay_t *anjay,
                                anjay_dm_foreach_instance_handler_t *handler,
                                void *data);
 
+/**
+ * Informs the library that effective notification attributes of some paths
+ * might have changed, e.g. because they have been modified in the Attribute
+ * Storage module. Invalidates all attributes cached for observations.
+ */
+void _anjay_dm_attributes_changed(anjay_t *anjay);
+
 int _anjay_dm_get_sorted_instance_list(anjay_t *anjay,
                                        const anjay_dm_object_def_t *const *obj,
                                        AVS_LIST(anjay_iid_t) *out);
@@ -452,6 +459,10 @@ int _anjay_dm_call_list_instances(anjay_t *anjay,
                                   const anjay_dm_object_def_t *const *obj_ptr,
                                   anjay_dm_list_ctx_t *ctx,
                                   const anjay_dm_module_t *current_module);
+int _anjay_dm_call_instance_present(anjay_t *anjay,
+                                    const anjay_dm_object_def_t *const *obj_ptr,
+                                    anjay_iid_t iid,
+                                    const anjay_dm_module_t *current_module);
 int _anjay_dm_call_instance_reset(anjay_t *anjay,
                                   const anjay_dm_object_def_t *const *obj_ptr,
                                   anjay_iid_t iid,
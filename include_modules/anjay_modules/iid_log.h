@@ -0,0 +1,115 @@
+/*
+ * Copyright 2017-2019 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_INCLUDE_ANJAY_MODULES_IID_LOG_H
+#define ANJAY_INCLUDE_ANJAY_MODULES_IID_LOG_H
+
+#include <anjay_config.h>
+
+#include <avsystem/commons/list.h>
+#include <avsystem/commons/rbtree.h>
+
+#include <anjay/core.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/**
+ * Type-specific operations on Object Instance representations kept in an
+ * @ref anjay_iid_log_t . The representation MUST begin with an
+ * <c>anjay_iid_t</c> field holding the Instance ID.
+ */
+typedef struct {
+    /** Size of a single Instance representation. */
+    size_t instance_size;
+
+    /**
+     * Makes @p dst a deep copy of @p src . On failure, @p dst shall be left in
+     * a state in which it can be passed to @ref destroy_instances.
+     */
+    int (*clone_instance)(void *dst, const void *src);
+
+    /** Destroys all Instances on the list pointed to by @p instances_ptr . */
+    void (*destroy_instances)(AVS_LIST(void) *instances_ptr);
+} anjay_iid_log_handlers_t;
+
+/**
+ * Rollback log of a transaction on an Object whose Instances are kept on an
+ * AVS_LIST sorted by Instance ID. Only the Instances actually touched within
+ * the transaction are logged.
+ *
+ * A zero-initialized structure is an empty log.
+ */
+typedef struct {
+    /**
+     * Original states of Instances modified or removed during the current
+     * transaction.
+     */
+    AVS_LIST(void) saved_instances;
+    /** IIDs of Instances created during the current transaction. */
+    AVS_LIST(anjay_iid_t) created_iids;
+    /** IIDs present in either of the above, for quick lookup. */
+    AVS_RBTREE(anjay_iid_t) logged_iids;
+} anjay_iid_log_t;
+
+static inline bool _anjay_iid_log_empty(const anjay_iid_log_t *log) {
+    return !log->saved_instances && !log->created_iids && !log->logged_iids;
+}
+
+/**
+ * Saves a copy of @p inst so that it can be restored on rollback. Only the
+ * first call for a given Instance actually copies anything.
+ *
+ * @returns 0 on success, or ANJAY_ERR_INTERNAL in case of error.
+ */
+int _anjay_iid_log_save_instance(anjay_iid_log_t *log,
+                                 const anjay_iid_log_handlers_t *handlers,
+                                 const void *inst);
+
+/**
+ * Records that Instance @p iid has been created, so that it is removed on
+ * rollback.
+ *
+ * @returns 0 on success, or ANJAY_ERR_INTERNAL in case of error.
+ */
+int _anjay_iid_log_mark_created(anjay_iid_log_t *log, anjay_iid_t iid);
+
+/**
+ * Detaches the Instance pointed to by @p inst_ptr from its list. If its
+ * original state has not been logged yet, the Instance is moved to the log
+ * as-is; otherwise it is destroyed.
+ */
+void _anjay_iid_log_remove_instance(anjay_iid_log_t *log,
+                                    const anjay_iid_log_handlers_t *handlers,
+                                    AVS_LIST(void) *inst_ptr);
+
+/**
+ * Drops all rollback information, e.g. when the transaction is committed.
+ */
+void _anjay_iid_log_forget(anjay_iid_log_t *log,
+                           const anjay_iid_log_handlers_t *handlers);
+
+/**
+ * Restores the state of @p instances_ptr from before the transaction: removes
+ * created Instances and puts the saved ones back in IID order. Leaves the log
+ * empty.
+ */
+void _anjay_iid_log_rollback(anjay_iid_log_t *log,
+                             const anjay_iid_log_handlers_t *handlers,
+                             AVS_LIST(void) *instances_ptr);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_INCLUDE_ANJAY_MODULES_IID_LOG_H */
@@ -246,6 +246,88 @@ typedef struct anjay_configuration {
      */
     avs_net_socket_tls_ciphersuites_t default_tls_ciphersuites;
 
+    /**
+     * If set to true, the library will cache the list of Instance IDs of each
+     * Object that does not implement the <c>instance_present</c> handler, so
+     * that checking presence of an Object Instance does not require calling
+     * the <c>list_instances</c> handler each time.
+     *
+     * The cache of a given Object is invalidated whenever its Instances are
+     * created or removed through the data model handlers, and whenever
+     * @ref anjay_notify_instances_changed is called for it. Enabling this
+     * option thus requires the application to reliably call
+     * @ref anjay_notify_instances_changed after any change to the set of
+     * Object Instances made by means other than LwM2M.
+     */
+    bool cache_instance_lists;
+
+    /**
+     * If set to true, the list of Resources returned by the
+     * <c>list_resources</c> handler of each Object Instance will be cached
+     * during processing of a single LwM2M request or a single notification
+     * cycle, so that the handler is called at most once per Object Instance in
+     * that period, instead of once for every Resource accessed.
+     *
+     * The cache never outlives the request or notification cycle in which it
+     * was filled, and is invalidated whenever Resources are written to, or
+     * @ref anjay_notify_changed is called for the Object Instance.
+     */
+    bool cache_resource_lists;
+
+    /**
+     * If set to true, effective notification attributes (as set using
+     * Write-Attributes, inherited from higher levels of the data model, or
+     * defaulted from the Server Object) will be resolved once for each path of
+     * each observation and reused on each notification, instead of calling the
+     * attribute handlers of all levels of the data model each time.
+     *
+     * The cache is invalidated whenever a Write-Attributes request is
+     * processed, the Server Object changes, the Attribute Storage module is
+     * modified through its API, or the set of Object Instances changes.
+     * Enabling this option thus requires that attributes returned by custom
+     * attribute handlers do not change by means other than Write-Attributes,
+     * and that the application reliably calls
+     * @ref anjay_notify_instances_changed as described for
+     * <c>cache_instance_lists</c>.
+     */
+    bool cache_observe_attributes;
+
+    /**
+     * If set to a value greater than 1, Notify messages queued for a single
+     * observation (e.g. while the client was offline or in Queue Mode) are
+     * merged, so that up to this many consecutive values are conveyed in a
+     * single notification, as separate timestamped records. Values queued for
+     * other observations on the same connection are not reordered with
+     * respect to each other.
+     *
+     * Merging is only performed for notifications using a Content-Format that
+     * is able to carry timestamps, i.e. LwM2M JSON or SenML CBOR. Values that
+     * would be otherwise sent using other formats, as well as error
+     * notifications, are always sent separately.
+     *
+     * If set to 0 or 1, each queued value is sent in a separate notification.
+     */
+    size_t aggregated_notification_limit;
+
+    /**
+     * If set to true, the contents of the Access Control Object will be
+     * indexed by the target Object Instance, so that checking access rights
+     * for an Object Instance does not require reading all Access Control
+     * Object Instances through the data model each time. This matters most for
+     * Read requests that cover many Object Instances.
+     *
+     * The index is dropped whenever the Access Control Object is modified
+     * through the data model handlers, and whenever @ref anjay_notify_changed
+     * or @ref anjay_notify_instances_changed is called for it. Enabling this
+     * option thus requires the application to reliably call these functions
+     * after any change to a custom Access Control Object implementation made
+     * by means other than LwM2M. The Access Control module does so.
+     *
+     * This option has no effect if Anjay is compiled without Access Control
+     * support.
+     */
+    bool cache_access_control;
+
 } anjay_configuration_t;
 
 /**
@@ -663,6 +745,52 @@ int anjay_exit_offline(anjay_t *anjay);
  */
 bool anjay_all_connections_failed(anjay_t *anjay);
 
+/**
+ * Dumps the state of all currently active observations into @p out_stream.
+ *
+ * For each observation, its token, observed paths, the last value sent to the
+ * server (along with its timestamp) and the CoAP-level Observe state are
+ * stored. Notifications that are queued, but have not been sent yet, are NOT
+ * persisted. Attributes are not stored either - they are always evaluated
+ * from the data model (e.g. the Attribute Storage module, which has its own
+ * persistence API).
+ *
+ * @param anjay      Anjay object to operate on.
+ * @param out_stream Stream to write to.
+ *
+ * @returns AVS_OK in case of success, or an error code. In particular,
+ *          <c>avs_errno(AVS_ENOTSUP)</c> is returned if Anjay has been compiled
+ *          without support for Observe or persistence.
+ */
+avs_error_t anjay_observe_persist(anjay_t *anjay, avs_stream_t *out_stream);
+
+/**
+ * Loads observations previously stored using @ref anjay_observe_persist.
+ *
+ * Restored observations are not activated immediately. Each of them is
+ * attached to its LwM2M Server connection (identified by the Short Server ID)
+ * when that connection is first established. Because of that, this function
+ * SHOULD be called right after @ref anjay_new and installing the data model,
+ * before the first call to @ref anjay_sched_run. Observations for connections
+ * that are already established when this function is called will only be
+ * restored after those connections are recreated from scratch.
+ *
+ * Once restored, notifications are sent based on the last sent values that
+ * have been persisted, i.e. the usual rules for pmin, pmax, gt, lt and st
+ * attributes apply as if the application had never been restarted.
+ *
+ * Calling this function discards any observations loaded by a previous call
+ * that have not been attached yet. On failure, no state is modified.
+ *
+ * @param anjay     Anjay object to operate on.
+ * @param in_stream Stream to read from.
+ *
+ * @returns AVS_OK in case of success, or an error code. In particular,
+ *          <c>avs_errno(AVS_ENOTSUP)</c> is returned if Anjay has been compiled
+ *          without support for Observe or persistence.
+ */
+avs_error_t anjay_observe_restore(anjay_t *anjay, avs_stream_t *in_stream);
+
 typedef struct {
     /**
      * DTLS keys or certificates.
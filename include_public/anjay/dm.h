@@ -142,6 +142,33 @@ anjay_dm_list_instances_t(anjay_t *anjay,
                           const anjay_dm_object_def_t *const *obj_ptr,
                           anjay_dm_list_ctx_t *ctx);
 
+/**
+ * A handler that checks whether an Object Instance with a given Instance ID
+ * exists.
+ *
+ * This handler is optional. If it is not implemented, the library determines
+ * presence of Object Instances using @ref anjay_dm_list_instances_t, which
+ * requires enumerating all Instances up to the one in question. Implementing it
+ * is recommended for Objects that may have a large number of Instances.
+ *
+ * @param anjay   Anjay object to operate on.
+ * @param obj_ptr Object definition pointer, as passed to
+ *                @ref anjay_register_object .
+ * @param iid     Instance ID to check.
+ *
+ * @returns This handler should return:
+ * - a positive value if the Object Instance is present,
+ * - 0 if the Object Instance is not present,
+ * - a negative value in case of error. If it returns one of ANJAY_ERR_
+ *   constants, the response message will have an appropriate CoAP response
+ *   code. Otherwise, the device will respond with an unspecified (but valid)
+ *   error code.
+ */
+typedef int
+anjay_dm_instance_present_t(anjay_t *anjay,
+                            const anjay_dm_object_def_t *const *obj_ptr,
+                            anjay_iid_t iid);
+
 /**
  * Convenience function to use as the list_instances handler in Single Instance
  * objects.
@@ -719,6 +746,13 @@ typedef struct {
      */
     anjay_dm_transaction_rollback_t *transaction_rollback;
 
+    /**
+     * Check whether an Object Instance exists (optional),
+     * @ref anjay_dm_instance_present_t
+     *
+     * Placed last to keep the layout of the preceding members unchanged.
+     */
+    anjay_dm_instance_present_t *instance_present;
 } anjay_dm_handlers_t;
 
 /** A struct defining an LwM2M Object. */
@@ -822,7 +856,8 @@ int anjay_unregister_object(anjay_t *anjay,
  * Checks whether the passed string is a valid LwM2M Binding Mode.
  *
  * @return true for <c>"U"</c>, <c>"S"</c>, <c>"US"</c>, <c>"UQ"</c>,
- *         <c>"SQ"</c>, <c>"UQS"</c>, false in any other case.
+ *         <c>"SQ"</c>, <c>"UQS"</c> (and <c>"T"</c>, <c>"TQ"</c> if CoAP/TCP
+ *         support is compiled in), false in any other case.
  */
 bool anjay_binding_mode_valid(const char *binding_mode);
 
@@ -168,6 +168,47 @@ typedef struct anjay_download_config {
      * inherit parameters from Anjay.
      */
     avs_coap_udp_tx_params_t *coap_tx_params;
+
+    /**
+     * Maximum number of CoAP Block2 requests kept in flight at the same time.
+     * Ignored for HTTP(S) transfers.
+     *
+     * If set to a value greater than 1, the downloader requests that many
+     * consecutive blocks in parallel, using explicit block numbers, which
+     * greatly reduces download time over high-latency links. Blocks received
+     * out of order are buffered (up to this number of blocks), so
+     * @ref anjay_download_config_t#on_next_block is still called with
+     * consecutive chunks of data. The NSTART transmission parameter is raised
+     * to this value if necessary.
+     *
+     * 0 or 1 (default) means that blocks are requested one at a time.
+     */
+    size_t coap_max_outstanding_blocks;
+
+    /**
+     * Maximum number of connections used to download the resource over
+     * HTTP(S) in parallel. Ignored for CoAP(S) transfers.
+     *
+     * If set to a value greater than 1 and the server reports the resource
+     * size, an ETag and support for byte ranges, the resource is split into
+     * ranges of @ref anjay_download_config_t#http_range_size bytes, which are
+     * requested over separate connections. All responses are required to
+     * carry the same ETag. Data is still passed to
+     * @ref anjay_download_config_t#on_next_block in order, which requires
+     * buffering up to <c>http_max_connections * http_range_size</c> bytes.
+     * If any of the conditions is not met, the download continues over a
+     * single connection.
+     *
+     * 0 or 1 (default) means that a single connection is used.
+     */
+    size_t http_max_connections;
+
+    /**
+     * Size of a single range requested when
+     * @ref anjay_download_config_t#http_max_connections is greater than 1.
+     * If 0, 16 KiB ranges are used.
+     */
+    size_t http_range_size;
 } anjay_download_config_t;
 
 typedef void *anjay_download_handle_t;
@@ -17,7 +17,7 @@
 #include <anjay_config.h>
 
 #include <inttypes.h>
-#include <string.h>
+#include <stddef.h>
 
 #include <avsystem/commons/rbtree.h>
 
@@ -46,6 +46,76 @@ find_instance(access_control_t *access_control, anjay_iid_t iid) {
     return access_control->last_accessed_instance;
 }
 
+static void
+destroy_instances(AVS_LIST(access_control_instance_t) *instances_ptr) {
+    AVS_LIST_CLEAR(instances_ptr) {
+        AVS_LIST_CLEAR(&(*instances_ptr)->acl);
+    }
+}
+
+AVS_STATIC_ASSERT(offsetof(access_control_instance_t, iid) == 0,
+                  access_control_instance_iid_first);
+
+static int clone_instance(void *dst_, const void *src_) {
+    access_control_instance_t *dst = (access_control_instance_t *) dst_;
+    const access_control_instance_t *src =
+            (const access_control_instance_t *) src_;
+    *dst = *src;
+    if (src->acl && !(dst->acl = AVS_LIST_SIMPLE_CLONE(src->acl))) {
+        ac_log(ERROR, "out of memory");
+        return -1;
+    }
+    return 0;
+}
+
+static void destroy_instances_clb(AVS_LIST(void) *instances_ptr) {
+    destroy_instances((AVS_LIST(access_control_instance_t) *) instances_ptr);
+}
+
+static const anjay_iid_log_handlers_t IID_LOG_HANDLERS = {
+    .instance_size = sizeof(access_control_instance_t),
+    .clone_instance = clone_instance,
+    .destroy_instances = destroy_instances_clb
+};
+
+/**
+ * Saves a copy of @p inst so that it can be restored on rollback. Only the
+ * first call for a given instance within a transaction copies anything.
+ */
+static int save_instance(access_control_t *access_control,
+                         const access_control_instance_t *inst) {
+    if (!access_control->in_transaction) {
+        return 0;
+    }
+    return _anjay_iid_log_save_instance(&access_control->log,
+                                        &IID_LOG_HANDLERS, inst);
+}
+
+static int mark_created(access_control_t *access_control, anjay_iid_t iid) {
+    if (!access_control->in_transaction) {
+        return 0;
+    }
+    return _anjay_iid_log_mark_created(&access_control->log, iid);
+}
+
+/**
+ * Detaches the instance pointed to by @p inst_ptr . If the instance is needed
+ * for rollback, it is moved to the rollback log instead of being destroyed.
+ */
+static void remove_instance(access_control_t *access_control,
+                            AVS_LIST(access_control_instance_t) *inst_ptr) {
+    if (access_control->last_accessed_instance == *inst_ptr) {
+        access_control->last_accessed_instance = NULL;
+    }
+    if (access_control->in_transaction) {
+        _anjay_iid_log_remove_instance(&access_control->log, &IID_LOG_HANDLERS,
+                                       (AVS_LIST(void) *) inst_ptr);
+    } else {
+        AVS_LIST(access_control_instance_t) element = AVS_LIST_DETACH(inst_ptr);
+        destroy_instances(&element);
+    }
+}
+
 static int
 ac_list_instances(anjay_t *anjay, obj_ptr_t obj_ptr, anjay_dm_list_ctx_t *ctx) {
     (void) anjay;
@@ -70,6 +140,10 @@ ac_instance_reset(anjay_t *anjay, obj_ptr_t obj_ptr, anjay_iid_t iid) {
     if (!inst) {
         return ANJAY_ERR_NOT_FOUND;
     }
+    int retval = save_instance(access_control, inst);
+    if (retval) {
+        return retval;
+    }
     AVS_LIST_CLEAR(&inst->acl);
     inst->has_acl = false;
     inst->owner = 0;
@@ -104,6 +178,15 @@ static int ac_instance_create(anjay_t *anjay,
                                                     new_instance, NULL);
     if (retval) {
         AVS_LIST_CLEAR(&new_instance);
+    } else if ((retval = mark_created(access_control, new_instance->iid))) {
+        // rollback would not know about it, so remove it right away
+        AVS_LIST(access_control_instance_t) *inst_ptr = AVS_LIST_FIND_PTR(
+                &access_control->current.instances, new_instance);
+        assert(inst_ptr);
+        if (access_control->last_accessed_instance == new_instance) {
+            access_control->last_accessed_instance = NULL;
+        }
+        AVS_LIST_DELETE(inst_ptr);
     }
     access_control->needs_validation = true;
     _anjay_access_control_mark_modified(access_control);
@@ -119,12 +202,7 @@ static int ac_instance_remove(anjay_t *anjay,
     AVS_LIST(access_control_instance_t) *it;
     AVS_LIST_FOREACH_PTR(it, &access_control->current.instances) {
         if ((*it)->iid == iid) {
-            if (access_control->last_accessed_instance
-                    && access_control->last_accessed_instance->iid == iid) {
-                access_control->last_accessed_instance = NULL;
-            }
-            AVS_LIST_CLEAR(&(*it)->acl);
-            AVS_LIST_DELETE(it);
+            remove_instance(access_control, it);
             _anjay_access_control_mark_modified(access_control);
             return 0;
         } else if ((*it)->iid > iid) {
@@ -240,12 +318,16 @@ static int ac_resource_write(anjay_t *anjay,
     if (!inst) {
         return ANJAY_ERR_NOT_FOUND;
     }
+    int retval = save_instance(access_control, inst);
+    if (retval) {
+        return retval;
+    }
 
     switch (rid) {
     case ANJAY_DM_RID_ACCESS_CONTROL_OID: {
         assert(riid == ANJAY_ID_INVALID);
         int32_t oid;
-        int retval = anjay_get_i32(ctx, &oid);
+        retval = anjay_get_i32(ctx, &oid);
         if (retval) {
             return retval;
         } else if (!_anjay_access_control_target_oid_valid(oid)) {
@@ -259,7 +341,7 @@ static int ac_resource_write(anjay_t *anjay,
     case ANJAY_DM_RID_ACCESS_CONTROL_OIID: {
         assert(riid == ANJAY_ID_INVALID);
         int32_t oiid;
-        int retval = anjay_get_i32(ctx, &oiid);
+        retval = anjay_get_i32(ctx, &oiid);
         if (retval) {
             return retval;
         } else if (oiid < 0 || oiid > UINT16_MAX) {
@@ -271,7 +353,7 @@ static int ac_resource_write(anjay_t *anjay,
         return 0;
     }
     case ANJAY_DM_RID_ACCESS_CONTROL_ACL: {
-        int retval = write_to_acl_array(&inst->acl, riid, ctx);
+        retval = write_to_acl_array(&inst->acl, riid, ctx);
         if (!retval) {
             inst->has_acl = true;
             access_control->needs_validation = true;
@@ -282,7 +364,7 @@ static int ac_resource_write(anjay_t *anjay,
     case ANJAY_DM_RID_ACCESS_CONTROL_OWNER: {
         assert(riid == ANJAY_ID_INVALID);
         int32_t ssid;
-        int retval = anjay_get_i32(ctx, &ssid);
+        retval = anjay_get_i32(ctx, &ssid);
         if (retval) {
             return retval;
         } else if (ssid <= 0 || ssid > ANJAY_SSID_BOOTSTRAP) {
@@ -313,6 +395,10 @@ static int ac_resource_reset(anjay_t *anjay,
 
     assert(rid == ANJAY_DM_RID_ACCESS_CONTROL_ACL);
     (void) rid;
+    int retval = save_instance(access_control, inst);
+    if (retval) {
+        return retval;
+    }
     AVS_LIST_CLEAR(&inst->acl);
     inst->has_acl = true;
     access_control->needs_validation = true;
@@ -351,10 +437,10 @@ static int ac_list_resource_instances(anjay_t *anjay,
 static int ac_transaction_begin(anjay_t *anjay, obj_ptr_t obj_ptr) {
     (void) anjay;
     access_control_t *ac = _anjay_access_control_from_obj_ptr(obj_ptr);
-    if (_anjay_access_control_clone_state(&ac->saved_state, &ac->current)) {
-        ac_log(ERROR, "out of memory");
-        return ANJAY_ERR_INTERNAL;
-    }
+    assert(!ac->in_transaction);
+    assert(_anjay_iid_log_empty(&ac->log));
+    ac->in_transaction = true;
+    ac->saved_modified_since_persist = ac->current.modified_since_persist;
     return 0;
 }
 
@@ -443,7 +529,8 @@ finish:
 static int ac_transaction_commit(anjay_t *anjay, obj_ptr_t obj_ptr) {
     (void) anjay;
     access_control_t *ac = _anjay_access_control_from_obj_ptr(obj_ptr);
-    _anjay_access_control_clear_state(&ac->saved_state);
+    _anjay_iid_log_forget(&ac->log, &IID_LOG_HANDLERS);
+    ac->in_transaction = false;
     ac->needs_validation = false;
     return 0;
 }
@@ -451,9 +538,10 @@ static int ac_transaction_commit(anjay_t *anjay, obj_ptr_t obj_ptr) {
 static int ac_transaction_rollback(anjay_t *anjay, obj_ptr_t obj_ptr) {
     (void) anjay;
     access_control_t *ac = _anjay_access_control_from_obj_ptr(obj_ptr);
-    _anjay_access_control_clear_state(&ac->current);
-    ac->current = ac->saved_state;
-    memset(&ac->saved_state, 0, sizeof(ac->saved_state));
+    _anjay_iid_log_rollback(&ac->log, &IID_LOG_HANDLERS,
+                            (AVS_LIST(void) *) &ac->current.instances);
+    ac->current.modified_since_persist = ac->saved_modified_since_persist;
+    ac->in_transaction = false;
     ac->needs_validation = false;
     ac->last_accessed_instance = NULL;
     return 0;
@@ -462,14 +550,19 @@ static int ac_transaction_rollback(anjay_t *anjay, obj_ptr_t obj_ptr) {
 static void ac_delete(void *access_control_) {
     access_control_t *access_control = (access_control_t *) access_control_;
     _anjay_access_control_clear_state(&access_control->current);
-    _anjay_access_control_clear_state(&access_control->saved_state);
+    _anjay_iid_log_forget(&access_control->log, &IID_LOG_HANDLERS);
     avs_free(access_control);
 }
 
 void anjay_access_control_purge(anjay_t *anjay) {
     assert(anjay);
     access_control_t *ac = _anjay_access_control_get(anjay);
-    _anjay_access_control_clear_state(&ac->current);
+    // within a transaction, instances are moved to the rollback log rather
+    // than destroyed, so that rolling back restores the purged state, as it
+    // did when purge only cleared the current state
+    while (ac->current.instances) {
+        remove_instance(ac, &ac->current.instances);
+    }
     _anjay_access_control_mark_modified(ac);
     ac->last_accessed_instance = NULL;
     ac->needs_validation = false;
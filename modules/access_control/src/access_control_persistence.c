@@ -197,6 +197,11 @@ avs_error_t anjay_access_control_restore(anjay_t *anjay, avs_stream_t *in) {
     if (avs_is_ok((err = restore(anjay, ac, in)))) {
         _anjay_access_control_clear_modified(ac);
         ac_log(INFO, "Access Control state restored");
+        if (anjay_notify_instances_changed(anjay,
+                                           ANJAY_DM_OID_ACCESS_CONTROL)) {
+            ac_log(WARNING, "Could not schedule access control instance "
+                            "changes notifications");
+        }
     }
     return err;
 }
@@ -37,40 +37,6 @@ void _anjay_access_control_clear_state(access_control_state_t *state) {
     state->modified_since_persist = false;
 }
 
-int _anjay_access_control_clone_state(access_control_state_t *dest,
-                                      const access_control_state_t *src) {
-    assert(!dest->instances);
-    AVS_LIST(access_control_instance_t) *dest_tail = &dest->instances;
-    AVS_LIST(access_control_instance_t) src_inst;
-    AVS_LIST_FOREACH(src_inst, src->instances) {
-        AVS_LIST(access_control_instance_t) dest_inst =
-                AVS_LIST_NEW_ELEMENT(access_control_instance_t);
-        if (!dest_inst) {
-            goto error;
-        }
-        AVS_LIST_INSERT(dest_tail, dest_inst);
-        AVS_LIST_ADVANCE_PTR(&dest_tail);
-        *dest_inst = *src_inst;
-        dest_inst->acl = NULL;
-        AVS_LIST(acl_entry_t) *dest_acl_tail = &dest_inst->acl;
-        AVS_LIST(acl_entry_t) src_acl;
-        AVS_LIST_FOREACH(src_acl, src_inst->acl) {
-            AVS_LIST(acl_entry_t) dest_acl = AVS_LIST_NEW_ELEMENT(acl_entry_t);
-            if (!dest_acl) {
-                goto error;
-            }
-            AVS_LIST_INSERT(dest_acl_tail, dest_acl);
-            AVS_LIST_ADVANCE_PTR(&dest_acl_tail);
-            *dest_acl = *src_acl;
-        }
-    }
-    dest->modified_since_persist = src->modified_since_persist;
-    return 0;
-error:
-    _anjay_access_control_clear_state(dest);
-    return -1;
-}
-
 static int add_instances_without_iids(
         access_control_t *access_control,
         AVS_LIST(access_control_instance_t) *instances_to_move,
@@ -261,6 +227,11 @@ static int set_acl(anjay_t *anjay,
     if (!ac_instance_needs_inserting) {
         if (!result) {
             _anjay_access_control_mark_modified(ac);
+            if (anjay_notify_changed(anjay, ANJAY_DM_OID_ACCESS_CONTROL,
+                                     ac_instance->iid,
+                                     ANJAY_DM_RID_ACCESS_CONTROL_ACL)) {
+                ac_log(WARNING, "Could not schedule ACL change notification");
+            }
         }
         return result;
     }
@@ -24,6 +24,7 @@
 #include <anjay/access_control.h>
 
 #include <anjay_modules/dm_utils.h>
+#include <anjay_modules/iid_log.h>
 #include <anjay_modules/notify.h>
 #include <anjay_modules/utils_core.h>
 
@@ -57,7 +58,10 @@ typedef struct {
 typedef struct {
     const anjay_dm_object_def_t *obj_def;
     access_control_state_t current;
-    access_control_state_t saved_state;
+    /* Rollback log of the current transaction */
+    anjay_iid_log_t log;
+    bool saved_modified_since_persist;
+    bool in_transaction;
     access_control_instance_t *last_accessed_instance;
     bool needs_validation;
     bool sync_in_progress;
@@ -81,9 +85,6 @@ access_control_t *_anjay_access_control_get(anjay_t *anjay);
 
 void _anjay_access_control_clear_state(access_control_state_t *state);
 
-int _anjay_access_control_clone_state(access_control_state_t *dest,
-                                      const access_control_state_t *src);
-
 int _anjay_access_control_validate_ssid(anjay_t *anjay, anjay_ssid_t ssid);
 
 int _anjay_access_control_add_instance(
@@ -25,6 +25,7 @@
 
 #include <anjay_test/dm.h>
 
+#include "../../../../src/access_utils.h"
 #include "../../../../src/anjay_core.h"
 #include "../../../../src/servers/servers_internal.h"
 #include "../mod_access_control.h"
@@ -148,3 +149,194 @@ AVS_UNIT_TEST(access_control, set_acl) {
 
     DM_TEST_FINISH;
 }
+
+static void add_ac_instance(access_control_t *ac,
+                            anjay_iid_t iid,
+                            anjay_iid_t target_iid,
+                            anjay_ssid_t owner) {
+    AVS_LIST(access_control_instance_t) inst =
+            _anjay_access_control_create_missing_ac_instance(
+                    owner, &(const acl_target_t) {
+                               .oid = TEST_OID,
+                               .iid = target_iid
+                           });
+    AVS_UNIT_ASSERT_NOT_NULL(inst);
+    inst->iid = iid;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_access_control_add_instance(ac, inst, NULL));
+}
+
+static const access_control_instance_t *
+find_ac_instance(access_control_t *ac, anjay_iid_t iid) {
+    AVS_LIST(access_control_instance_t) inst;
+    AVS_LIST_FOREACH(inst, ac->current.instances) {
+        if (inst->iid == iid) {
+            return inst;
+        }
+    }
+    return NULL;
+}
+
+AVS_UNIT_TEST(access_control, rollback_restores_only_touched_instances) {
+    DM_TEST_INIT_WITH_OBJECTS(&FAKE_SECURITY, &FAKE_SERVER, &TEST);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_access_control_install(anjay));
+    // prevent sending Update, as that will fail in the test environment
+    avs_sched_del(&anjay->servers->servers->next_action_handle);
+
+    access_control_t *ac = _anjay_access_control_get(anjay);
+    const anjay_dm_object_def_t *const *obj_ptr = &ac->obj_def;
+    add_ac_instance(ac, 1, 1, 1);
+    add_ac_instance(ac, 2, 2, 1);
+    const access_control_instance_t *untouched = find_ac_instance(ac, 2);
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            (*obj_ptr)->handlers.transaction_begin(anjay, obj_ptr));
+    AVS_UNIT_ASSERT_SUCCESS((*obj_ptr)->handlers.resource_reset(
+            anjay, obj_ptr, 1, ANJAY_DM_RID_ACCESS_CONTROL_ACL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            (*obj_ptr)->handlers.instance_remove(anjay, obj_ptr, 1));
+    AVS_UNIT_ASSERT_SUCCESS(
+            (*obj_ptr)->handlers.instance_create(anjay, obj_ptr, 3));
+    AVS_UNIT_ASSERT_SUCCESS((*obj_ptr)->handlers.resource_reset(
+            anjay, obj_ptr, 3, ANJAY_DM_RID_ACCESS_CONTROL_ACL));
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(ac->log.saved_instances), 1);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(ac->log.created_iids), 1);
+    AVS_UNIT_ASSERT_SUCCESS(
+            (*obj_ptr)->handlers.transaction_rollback(anjay, obj_ptr));
+
+    AVS_UNIT_ASSERT_NULL(ac->log.saved_instances);
+    AVS_UNIT_ASSERT_NULL(ac->log.created_iids);
+    AVS_UNIT_ASSERT_NULL(ac->log.logged_iids);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(ac->current.instances), 2);
+    AVS_UNIT_ASSERT_NULL(find_ac_instance(ac, 3));
+    AVS_UNIT_ASSERT_TRUE(find_ac_instance(ac, 2) == untouched);
+    const access_control_instance_t *restored = find_ac_instance(ac, 1);
+    AVS_UNIT_ASSERT_NOT_NULL(restored);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(restored->acl), 1);
+    AVS_UNIT_ASSERT_EQUAL(restored->acl->ssid, 1);
+    AVS_UNIT_ASSERT_EQUAL(ac->current.instances->iid, 1);
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(access_control, purge_in_transaction) {
+    DM_TEST_INIT_WITH_OBJECTS(&FAKE_SECURITY, &FAKE_SERVER, &TEST);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_access_control_install(anjay));
+    // prevent sending Update, as that will fail in the test environment
+    avs_sched_del(&anjay->servers->servers->next_action_handle);
+
+    access_control_t *ac = _anjay_access_control_get(anjay);
+    const anjay_dm_object_def_t *const *obj_ptr = &ac->obj_def;
+    add_ac_instance(ac, 1, 1, 1);
+    add_ac_instance(ac, 2, 2, 1);
+
+    // rollback restores all purged instances
+    AVS_UNIT_ASSERT_SUCCESS(
+            (*obj_ptr)->handlers.transaction_begin(anjay, obj_ptr));
+    anjay_access_control_purge(anjay);
+    AVS_UNIT_ASSERT_NULL(ac->current.instances);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(ac->log.saved_instances), 2);
+    AVS_UNIT_ASSERT_SUCCESS(
+            (*obj_ptr)->handlers.transaction_rollback(anjay, obj_ptr));
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(ac->current.instances), 2);
+    AVS_UNIT_ASSERT_NOT_NULL(find_ac_instance(ac, 1));
+    AVS_UNIT_ASSERT_NOT_NULL(find_ac_instance(ac, 2));
+
+    // commit drops them for good
+    AVS_UNIT_ASSERT_SUCCESS(
+            (*obj_ptr)->handlers.transaction_begin(anjay, obj_ptr));
+    anjay_access_control_purge(anjay);
+    AVS_UNIT_ASSERT_SUCCESS(
+            (*obj_ptr)->handlers.transaction_commit(anjay, obj_ptr));
+    AVS_UNIT_ASSERT_NULL(ac->current.instances);
+    AVS_UNIT_ASSERT_NULL(ac->log.saved_instances);
+    AVS_UNIT_ASSERT_NULL(ac->log.logged_iids);
+
+    DM_TEST_FINISH;
+}
+
+static bool test_action_allowed(anjay_t *anjay,
+                                anjay_iid_t iid,
+                                anjay_ssid_t ssid,
+                                anjay_request_action_t action) {
+    return _anjay_instance_action_allowed(
+            anjay, &(const anjay_action_info_t) {
+                       .oid = TEST_OID,
+                       .iid = iid,
+                       .ssid = ssid,
+                       .action = action
+                   });
+}
+
+AVS_UNIT_TEST(access_control, acl_index) {
+    DM_TEST_INIT_GENERIC((&FAKE_SECURITY, &FAKE_SERVER, &TEST), (1, 2),
+                         (.cache_access_control = true));
+    (void) mocksocks;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_access_control_install(anjay));
+    // prevent sending Update, as that will fail in the test environment
+    AVS_LIST(anjay_server_info_t) server;
+    AVS_LIST_FOREACH(server, anjay->servers->servers) {
+        avs_sched_del(&server->next_action_handle);
+    }
+
+    access_control_t *ac = _anjay_access_control_get(anjay);
+    const anjay_dm_object_def_t *const *obj_ptr = &ac->obj_def;
+    // /TEST/1: ACL entry for SSID 1
+    add_ac_instance(ac, 1, 1, 1);
+    // /TEST/2: default ACL entry only
+    add_ac_instance(ac, 2, 2, 1);
+    ac->current.instances->next->acl->ssid = ANJAY_SSID_ANY;
+    ac->current.instances->next->acl->mask = ANJAY_ACCESS_MASK_READ;
+    // /TEST/3: empty ACL, owned by SSID 2
+    add_ac_instance(ac, 3, 3, 2);
+    AVS_LIST_CLEAR(&AVS_LIST_NTH(ac->current.instances, 2)->acl);
+
+    // index hit
+    AVS_UNIT_ASSERT_NULL(anjay->access_control_index);
+    AVS_UNIT_ASSERT_TRUE(test_action_allowed(anjay, 1, 1, ANJAY_ACTION_WRITE));
+    AVS_RBTREE(anjay_acl_index_entry_t) index = anjay->access_control_index;
+    AVS_UNIT_ASSERT_NOT_NULL(index);
+    AVS_UNIT_ASSERT_FALSE(test_action_allowed(anjay, 1, 2, ANJAY_ACTION_READ));
+    AVS_UNIT_ASSERT_TRUE(anjay->access_control_index == index);
+
+    // default SSID fallback
+    AVS_UNIT_ASSERT_TRUE(test_action_allowed(anjay, 2, 2, ANJAY_ACTION_READ));
+    AVS_UNIT_ASSERT_FALSE(test_action_allowed(anjay, 2, 2, ANJAY_ACTION_WRITE));
+
+    // owner fallback
+    AVS_UNIT_ASSERT_TRUE(test_action_allowed(anjay, 3, 2, ANJAY_ACTION_DELETE));
+    AVS_UNIT_ASSERT_FALSE(test_action_allowed(anjay, 3, 1, ANJAY_ACTION_READ));
+
+    // no Access Control instance
+    AVS_UNIT_ASSERT_FALSE(test_action_allowed(anjay, 4, 1, ANJAY_ACTION_READ));
+
+    // ACL write
+    AVS_UNIT_ASSERT_SUCCESS(anjay_access_control_set_acl(
+            anjay, TEST_OID, 1, 1, ANJAY_ACCESS_MASK_READ));
+    AVS_UNIT_ASSERT_NULL(anjay->access_control_index);
+    AVS_UNIT_ASSERT_FALSE(test_action_allowed(anjay, 1, 1, ANJAY_ACTION_WRITE));
+    AVS_UNIT_ASSERT_TRUE(test_action_allowed(anjay, 1, 1, ANJAY_ACTION_READ));
+    AVS_UNIT_ASSERT_NOT_NULL(anjay->access_control_index);
+
+    // instance create
+    _anjay_dm_transaction_begin(anjay);
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_dm_call_instance_create(anjay, obj_ptr, 4, NULL));
+    AVS_UNIT_ASSERT_NULL(anjay->access_control_index);
+    AVS_UNIT_ASSERT_EQUAL(
+            _anjay_dm_transaction_finish_without_validation(anjay, -1), -1);
+    AVS_UNIT_ASSERT_TRUE(test_action_allowed(anjay, 1, 1, ANJAY_ACTION_READ));
+    AVS_UNIT_ASSERT_NOT_NULL(anjay->access_control_index);
+
+    // instance delete
+    _anjay_dm_transaction_begin(anjay);
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_dm_call_instance_remove(anjay, obj_ptr, 1, NULL));
+    AVS_UNIT_ASSERT_NULL(anjay->access_control_index);
+    AVS_UNIT_ASSERT_FALSE(test_action_allowed(anjay, 1, 1, ANJAY_ACTION_READ));
+    AVS_UNIT_ASSERT_EQUAL(
+            _anjay_dm_transaction_finish_without_validation(anjay, -1), -1);
+    AVS_UNIT_ASSERT_NULL(anjay->access_control_index);
+    AVS_UNIT_ASSERT_TRUE(test_action_allowed(anjay, 1, 1, ANJAY_ACTION_READ));
+
+    DM_TEST_FINISH;
+}
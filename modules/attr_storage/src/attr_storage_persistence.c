@@ -453,6 +453,7 @@ avs_error_t anjay_attr_storage_restore(anjay_t *anjay, avs_stream_t *in) {
     if (avs_is_ok(err)) {
         as_log(INFO, "Attribute Storage state restored");
     }
+    _anjay_dm_attributes_changed(anjay);
     as->modified_since_persist = avs_is_err(err);
     return err;
 }
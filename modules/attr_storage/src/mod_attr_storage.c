@@ -113,6 +113,7 @@ void anjay_attr_storage_purge(anjay_t *anjay) {
     }
     _anjay_attr_storage_clear(as);
     _anjay_attr_storage_mark_modified(as);
+    _anjay_dm_attributes_changed(anjay);
 }
 
 //// HELPERS ///////////////////////////////////////////////////////////////////
@@ -939,6 +940,7 @@ int anjay_attr_storage_set_object_attrs(anjay_t *anjay,
 
     int result;
     if (!(result = write_object_attrs(anjay, ssid, obj, &internal_attrs))) {
+        _anjay_dm_attributes_changed(anjay);
         (void) anjay_notify_instances_changed(anjay, oid);
     }
     return result;
@@ -972,6 +974,7 @@ int anjay_attr_storage_set_instance_attrs(
     int result;
     if (!(result = write_instance_attrs(anjay, ssid, obj, iid,
                                         &internal_attrs))) {
+        _anjay_dm_attributes_changed(anjay);
         (void) anjay_notify_instances_changed(anjay, oid);
     }
     return result;
@@ -1009,6 +1012,7 @@ int anjay_attr_storage_set_resource_attrs(
     int result;
     if (!(result = write_resource_attrs(anjay, ssid, obj, iid, rid,
                                         &internal_attrs))) {
+        _anjay_dm_attributes_changed(anjay);
         (void) anjay_notify_instances_changed(anjay, oid);
     }
     return result;
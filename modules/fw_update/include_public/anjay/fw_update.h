@@ -606,6 +606,55 @@ anjay_fw_update_load_security_from_dm(anjay_t *anjay, const char *raw_url);
  */
 int anjay_fw_update_set_result(anjay_t *anjay, anjay_fw_update_result_t result);
 
+/**
+ * Checks whether the Firmware Update Object state has changed since the last
+ * successful call to @ref anjay_fw_update_persist or
+ * @ref anjay_fw_update_restore.
+ *
+ * During a Pull-mode download, every chunk of data successfully passed to
+ * @ref anjay_fw_update_stream_write_t counts as a modification.
+ */
+bool anjay_fw_update_is_modified(anjay_t *anjay);
+
+/**
+ * Dumps the Firmware Update Object state to the @p out_stream.
+ *
+ * The persisted data consists of the State and Update Result resources, the
+ * Package URI and, for Pull-mode downloads, the number of bytes already passed
+ * to @ref anjay_fw_update_stream_write_t along with the ETag of the package.
+ * The application SHOULD make sure that all such data is committed to
+ * non-volatile memory before calling this function, otherwise the restored
+ * download will not continue from the right offset.
+ *
+ * @param anjay      Anjay instance with Firmware Update Object installed.
+ * @param out_stream Stream to write to.
+ * @return 0 in case of success, negative value in case of an error.
+ */
+avs_error_t anjay_fw_update_persist(anjay_t *anjay, avs_stream_t *out_stream);
+
+/**
+ * Attempts to restore the Firmware Update Object state from specified
+ * @p in_stream.
+ *
+ * This function is intended to be called right after
+ * @ref anjay_fw_update_install with <c>initial_state</c> set to <c>NULL</c>;
+ * it fails if the object is not in the Idle state. If restoration fails, the
+ * object is left untouched.
+ *
+ * If the persisted state was Downloading and some data has already been
+ * written, the download is resumed in the same way as with
+ * @ref ANJAY_FW_UPDATE_INITIAL_DOWNLOADING: the
+ * @ref anjay_fw_update_stream_open_t handler is NOT called, and further data
+ * is passed to @ref anjay_fw_update_stream_write_t as if appended to what was
+ * written before the reboot. If no data has been written yet, the download is
+ * started over from the beginning.
+ *
+ * @param anjay     Anjay instance with Firmware Update Object installed.
+ * @param in_stream Stream to read from.
+ * @return 0 in case of success, negative value in case of an error.
+ */
+avs_error_t anjay_fw_update_restore(anjay_t *anjay, avs_stream_t *in_stream);
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,6 +16,7 @@
 
 #include <anjay_config.h>
 
+#include <stddef.h>
 #include <string.h>
 
 #include <anjay/download.h>
@@ -29,6 +30,9 @@
 #include <avsystem/coap/code.h>
 
 #include <avsystem/commons/errno.h>
+#ifdef WITH_AVS_PERSISTENCE
+#    include <avsystem/commons/persistence.h>
+#endif // WITH_AVS_PERSISTENCE
 #include <avsystem/commons/url.h>
 #include <avsystem/commons/utils.h>
 
@@ -70,7 +74,12 @@ typedef struct fw_repr {
     fw_update_state_t state;
     anjay_fw_update_result_t result;
     const char *package_uri;
+    // number of bytes of a Pull download passed to stream_write so far,
+    // together with the ETag they belong to; used to resume after reboot
+    size_t bytes_written;
+    anjay_etag_t *package_etag;
     bool retry_download_on_expired;
+    bool modified_since_persist;
     avs_sched_handle_t update_job;
 } fw_repr_t;
 
@@ -86,6 +95,7 @@ static void set_update_result(anjay_t *anjay,
         fw_log(DEBUG, "Firmware Update Result change: %d -> %d",
                (int) fw->result, (int) new_result);
         fw->result = new_result;
+        fw->modified_since_persist = true;
         anjay_notify_changed(anjay, FW_OID, 0, FW_RES_UPDATE_RESULT);
     }
 }
@@ -96,6 +106,7 @@ set_state(anjay_t *anjay, fw_repr_t *fw, fw_update_state_t new_state) {
         fw_log(DEBUG, "Firmware Update State change: %d -> %d", (int) fw->state,
                (int) new_state);
         fw->state = new_state;
+        fw->modified_since_persist = true;
         anjay_notify_changed(anjay, FW_OID, 0, FW_RES_STATE);
     }
 }
@@ -179,6 +190,9 @@ static void reset_user_state(fw_repr_t *fw) {
     set_user_state(&fw->user_state, UPDATE_STATE_IDLE);
     avs_free(fw->security_from_dm);
     fw->security_from_dm = NULL;
+    fw->bytes_written = 0;
+    avs_free(fw->package_etag);
+    fw->package_etag = NULL;
 }
 
 static int get_security_config(anjay_t *anjay,
@@ -376,6 +390,33 @@ static anjay_transport_security_t transport_security_from_uri(const char *uri) {
 }
 #    endif // WITH_COAP_DOWNLOAD || WITH_HTTP_DOWNLOAD
 
+static bool etag_equal(const anjay_etag_t *left, const anjay_etag_t *right) {
+    if (!left || !right) {
+        return left == right;
+    }
+    return left->size == right->size
+           && !memcmp(left->value, right->value, left->size);
+}
+
+static void update_package_etag(fw_repr_t *fw, const anjay_etag_t *etag) {
+    if (etag_equal(fw->package_etag, etag)) {
+        return;
+    }
+    anjay_etag_t *copy = NULL;
+    if (etag) {
+        size_t struct_size = offsetof(anjay_etag_t, value) + etag->size;
+        if (!(copy = (anjay_etag_t *) avs_malloc(struct_size))) {
+            fw_log(WARNING, "could not copy ETag, firmware download will not "
+                            "be resumable");
+        } else {
+            memcpy(copy, etag, struct_size);
+        }
+    }
+    avs_free(fw->package_etag);
+    fw->package_etag = copy;
+    fw->modified_since_persist = true;
+}
+
 static avs_error_t download_write_block(anjay_t *anjay,
                                         const uint8_t *data,
                                         size_t data_size,
@@ -397,6 +438,11 @@ static avs_error_t download_write_block(anjay_t *anjay,
         return avs_errno(AVS_UNKNOWN_ERROR);
     }
 
+    update_package_etag(fw, etag);
+    if (data_size > 0) {
+        fw->bytes_written += data_size;
+        fw->modified_since_persist = true;
+    }
     return AVS_OK;
 }
 
@@ -518,6 +564,8 @@ static int schedule_background_anjay_download(anjay_t *anjay,
     }
 
     fw->retry_download_on_expired = (etag != NULL);
+    fw->bytes_written = start_offset;
+    update_package_etag(fw, etag);
     set_update_result(anjay, fw, ANJAY_FW_UPDATE_RESULT_INITIAL);
     set_state(anjay, fw, UPDATE_STATE_DOWNLOADING);
     fw_log(INFO, "download started: %s", fw->package_uri);
@@ -674,6 +722,7 @@ static int fw_write(anjay_t *anjay,
         if (!result) {
             avs_free((void *) (intptr_t) fw->package_uri);
             fw->package_uri = new_uri;
+            fw->modified_since_persist = true;
 
             if (len == 0) {
                 reset(anjay, fw);
@@ -796,6 +845,7 @@ fw_on_notify(anjay_t *anjay, anjay_notify_queue_t incoming_queue, void *fw_) {
         // we're already in the middle of it
         fw->state = UPDATE_STATE_DOWNLOADED;
         fw->result = ANJAY_FW_UPDATE_RESULT_OUT_OF_MEMORY;
+        fw->modified_since_persist = true;
     }
     return 0;
 }
@@ -804,6 +854,7 @@ static void fw_delete(void *fw_) {
     fw_repr_t *fw = (fw_repr_t *) fw_;
     avs_sched_del(&fw->update_job);
     avs_free(fw->security_from_dm);
+    avs_free(fw->package_etag);
     avs_free((void *) (intptr_t) fw->package_uri);
     avs_free(fw);
 }
@@ -963,3 +1014,240 @@ int anjay_fw_update_set_result(anjay_t *anjay,
     set_update_result(anjay, fw, result);
     return 0;
 }
+
+static fw_repr_t *find_fw(anjay_t *anjay) {
+    const anjay_dm_object_def_t *const *obj =
+            _anjay_dm_find_object_by_oid(anjay, ANJAY_DM_OID_FIRMWARE_UPDATE);
+    return obj ? get_fw(obj) : NULL;
+}
+
+bool anjay_fw_update_is_modified(anjay_t *anjay) {
+    assert(anjay);
+    fw_repr_t *fw = find_fw(anjay);
+    return fw && fw->modified_since_persist;
+}
+
+#ifdef WITH_AVS_PERSISTENCE
+
+typedef enum { PERSISTENCE_VERSION_0 } fw_persistence_version_t;
+
+typedef char magic_t[4];
+static const magic_t MAGIC_V0 = { 'F', 'W', 'U', PERSISTENCE_VERSION_0 };
+
+typedef struct {
+    uint8_t state;
+    uint8_t result;
+    char *package_uri;
+    uint64_t bytes_written;
+    anjay_etag_t *package_etag;
+} fw_persisted_state_t;
+
+static avs_error_t handle_etag(avs_persistence_context_t *ctx,
+                               anjay_etag_t **etag_ptr) {
+    bool has_etag = (*etag_ptr != NULL);
+    uint8_t size = (has_etag ? (*etag_ptr)->size : 0);
+    avs_error_t err;
+    if (avs_is_err((err = avs_persistence_bool(ctx, &has_etag))) || !has_etag
+            || avs_is_err((err = avs_persistence_u8(ctx, &size)))) {
+        return err;
+    }
+    if (avs_persistence_direction(ctx) == AVS_PERSISTENCE_RESTORE) {
+        assert(!*etag_ptr);
+        if (!(*etag_ptr = (anjay_etag_t *) avs_malloc(
+                      offsetof(anjay_etag_t, value) + size))) {
+            return avs_errno(AVS_ENOMEM);
+        }
+        (*etag_ptr)->size = size;
+    }
+    return avs_persistence_bytes(ctx, (*etag_ptr)->value, size);
+}
+
+static avs_error_t handle_state(avs_persistence_context_t *ctx,
+                                fw_persisted_state_t *state) {
+    avs_error_t err;
+    (void) (avs_is_err((err = avs_persistence_u8(ctx, &state->state)))
+            || avs_is_err((err = avs_persistence_u8(ctx, &state->result)))
+            || avs_is_err((err = avs_persistence_string(ctx,
+                                                        &state->package_uri)))
+            || avs_is_err((err = avs_persistence_u64(ctx,
+                                                     &state->bytes_written)))
+            || avs_is_err((err = handle_etag(ctx, &state->package_etag))));
+    return err;
+}
+
+static fw_update_state_t get_persisted_state(const fw_repr_t *fw) {
+    // Execute on the Update resource that did not reach perform_upgrade yet
+    // cannot be continued after reboot; the server will need to repeat it
+    if (fw->state == UPDATE_STATE_UPDATING
+            && fw->user_state.state != UPDATE_STATE_UPDATING) {
+        return UPDATE_STATE_DOWNLOADED;
+    }
+    return fw->state;
+}
+
+avs_error_t anjay_fw_update_persist(anjay_t *anjay, avs_stream_t *out_stream) {
+    assert(anjay);
+
+    fw_repr_t *fw = find_fw(anjay);
+    if (!fw) {
+        return avs_errno(AVS_EBADF);
+    }
+    avs_persistence_context_t persist_ctx =
+            avs_persistence_store_context_create(out_stream);
+
+    avs_error_t err =
+            avs_persistence_bytes(&persist_ctx, (void *) (intptr_t) MAGIC_V0,
+                                  sizeof(MAGIC_V0));
+    if (avs_is_err(err)) {
+        return err;
+    }
+    fw_persisted_state_t state = {
+        .state = (uint8_t) get_persisted_state(fw),
+        .result = (uint8_t) fw->result,
+        .package_uri = (char *) (intptr_t) fw->package_uri,
+        .bytes_written = fw->bytes_written,
+        .package_etag = fw->package_etag
+    };
+    if (avs_is_ok((err = handle_state(&persist_ctx, &state)))) {
+        fw->modified_since_persist = false;
+        fw_log(INFO, "Firmware Update Object state persisted");
+    }
+    return err;
+}
+
+static int validate_persisted_state(const fw_persisted_state_t *state) {
+    if (state->state > UPDATE_STATE_UPDATING
+            || state->result > ANJAY_FW_UPDATE_RESULT_UNSUPPORTED_PROTOCOL
+            || (uint64_t) (size_t) state->bytes_written
+                           != state->bytes_written
+            || (state->state == UPDATE_STATE_DOWNLOADING
+                && !state->package_uri)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int apply_persisted_state(anjay_t *anjay,
+                                 fw_repr_t *fw,
+                                 fw_persisted_state_t *state) {
+    avs_free((void *) (intptr_t) fw->package_uri);
+    fw->package_uri = NULL;
+    fw->modified_since_persist = false;
+
+    anjay_fw_update_initial_state_t initial_state = {
+        .persisted_uri = state->package_uri,
+        .resume_offset = (size_t) state->bytes_written,
+        .resume_etag = state->package_etag
+    };
+    switch ((fw_update_state_t) state->state) {
+    case UPDATE_STATE_IDLE:
+        initial_state.result = ANJAY_FW_UPDATE_INITIAL_NEUTRAL;
+        break;
+    case UPDATE_STATE_DOWNLOADING:
+#ifdef WITH_DOWNLOADER
+        if (!state->bytes_written) {
+            // nothing was written yet, so the download can start over
+            // normally, including the call to stream_open
+            fw->package_uri = state->package_uri;
+            state->package_uri = NULL;
+            if (schedule_background_anjay_download(anjay, fw, 0, NULL)) {
+                fw_log(WARNING, "Could not restart firmware download");
+            }
+            return 0;
+        }
+#endif // WITH_DOWNLOADER
+        initial_state.result = ANJAY_FW_UPDATE_INITIAL_DOWNLOADING;
+        break;
+    case UPDATE_STATE_DOWNLOADED:
+        initial_state.result = ANJAY_FW_UPDATE_INITIAL_DOWNLOADED;
+        break;
+    case UPDATE_STATE_UPDATING:
+        initial_state.result = ANJAY_FW_UPDATE_INITIAL_UPDATING;
+        break;
+    }
+    if (initialize_fw_repr(anjay, fw, &initial_state)) {
+        fw_log(ERROR, "Could not apply persisted Firmware Update state");
+        return -1;
+    }
+    // initial results cover only a subset of Update Result values, so the
+    // persisted one is applied directly
+    if (state->state == UPDATE_STATE_IDLE
+            || state->state == UPDATE_STATE_DOWNLOADED) {
+        fw->result = (anjay_fw_update_result_t) state->result;
+    }
+    if (!fw->package_uri) {
+        fw->package_uri = state->package_uri;
+        state->package_uri = NULL;
+    }
+    return 0;
+}
+
+avs_error_t anjay_fw_update_restore(anjay_t *anjay, avs_stream_t *in_stream) {
+    assert(anjay);
+
+    fw_repr_t *fw = find_fw(anjay);
+    if (!fw) {
+        return avs_errno(AVS_EBADF);
+    }
+    if (fw->state != UPDATE_STATE_IDLE
+            || fw->user_state.state != UPDATE_STATE_IDLE) {
+        fw_log(WARNING, "Cannot restore Firmware Update Object state while "
+                        "an update is in progress");
+        return avs_errno(AVS_EBUSY);
+    }
+    avs_persistence_context_t restore_ctx =
+            avs_persistence_restore_context_create(in_stream);
+
+    magic_t magic_header;
+    avs_error_t err = avs_persistence_bytes(&restore_ctx, magic_header,
+                                            sizeof(magic_header));
+    if (avs_is_err(err)) {
+        fw_log(WARNING, "Could not read Firmware Update Object header");
+        return err;
+    }
+    if (memcmp(magic_header, MAGIC_V0, sizeof(magic_t))) {
+        fw_log(WARNING, "Header magic constant mismatch");
+        return avs_errno(AVS_EBADMSG);
+    }
+
+    fw_persisted_state_t state;
+    memset(&state, 0, sizeof(state));
+    if (avs_is_ok((err = handle_state(&restore_ctx, &state)))
+            && validate_persisted_state(&state)) {
+        err = avs_errno(AVS_EBADMSG);
+    }
+    if (avs_is_ok(err) && apply_persisted_state(anjay, fw, &state)) {
+        err = avs_errno(AVS_EBADMSG);
+    }
+    if (avs_is_ok(err)) {
+        anjay_notify_changed(anjay, FW_OID, 0, FW_RES_PACKAGE_URI);
+        anjay_notify_changed(anjay, FW_OID, 0, FW_RES_STATE);
+        anjay_notify_changed(anjay, FW_OID, 0, FW_RES_UPDATE_RESULT);
+        fw_log(INFO, "Firmware Update Object state restored");
+    }
+    avs_free(state.package_uri);
+    avs_free(state.package_etag);
+    return err;
+}
+
+#    ifdef ANJAY_TEST
+#        include "test/persistence.c"
+#    endif
+
+#else // WITH_AVS_PERSISTENCE
+
+avs_error_t anjay_fw_update_persist(anjay_t *anjay, avs_stream_t *out_stream) {
+    (void) anjay;
+    (void) out_stream;
+    fw_log(ERROR, "Persistence not compiled in");
+    return avs_errno(AVS_ENOTSUP);
+}
+
+avs_error_t anjay_fw_update_restore(anjay_t *anjay, avs_stream_t *in_stream) {
+    (void) anjay;
+    (void) in_stream;
+    fw_log(ERROR, "Persistence not compiled in");
+    return avs_errno(AVS_ENOTSUP);
+}
+
+#endif // WITH_AVS_PERSISTENCE
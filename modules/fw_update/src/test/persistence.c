@@ -0,0 +1,253 @@
+/*
+ * Copyright 2017-2019 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/stream.h>
+#include <avsystem/commons/stream/stream_membuf.h>
+#include <avsystem/commons/unit/test.h>
+
+#include <anjay_test/utils.h>
+
+static const anjay_configuration_t CONFIG = {
+    .endpoint_name = "test"
+};
+
+static int
+test_stream_open(void *user_ptr, const char *uri, const anjay_etag_t *etag) {
+    (void) user_ptr;
+    (void) uri;
+    (void) etag;
+    return 0;
+}
+
+static int test_stream_write(void *user_ptr, const void *data, size_t length) {
+    (void) user_ptr;
+    (void) data;
+    (void) length;
+    return 0;
+}
+
+static int test_stream_finish(void *user_ptr) {
+    (void) user_ptr;
+    return 0;
+}
+
+static void test_reset(void *user_ptr) {
+    (void) user_ptr;
+}
+
+static int test_perform_upgrade(void *user_ptr) {
+    (void) user_ptr;
+    return 0;
+}
+
+static const anjay_fw_update_handlers_t TEST_HANDLERS = {
+    .stream_open = test_stream_open,
+    .stream_write = test_stream_write,
+    .stream_finish = test_stream_finish,
+    .reset = test_reset,
+    .perform_upgrade = test_perform_upgrade
+};
+
+typedef struct {
+    anjay_t *anjay_stored;
+    anjay_t *anjay_restored;
+    fw_repr_t *stored;
+    fw_repr_t *restored;
+    avs_stream_t *stream;
+} fw_persistence_test_env_t;
+
+#define SCOPED_FW_PERSISTENCE_TEST_ENV(Name)                               \
+    SCOPED_PTR(fw_persistence_test_env_t, fw_persistence_test_env_destroy) \
+    Name = fw_persistence_test_env_create();
+
+static fw_persistence_test_env_t *fw_persistence_test_env_create(void) {
+    fw_persistence_test_env_t *env =
+            (__typeof__(env)) avs_calloc(1, sizeof(*env));
+    AVS_UNIT_ASSERT_NOT_NULL(env);
+    env->anjay_stored = anjay_new(&CONFIG);
+    AVS_UNIT_ASSERT_NOT_NULL(env->anjay_stored);
+    env->anjay_restored = anjay_new(&CONFIG);
+    AVS_UNIT_ASSERT_NOT_NULL(env->anjay_restored);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_fw_update_install(
+            env->anjay_stored, &TEST_HANDLERS, NULL, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_fw_update_install(
+            env->anjay_restored, &TEST_HANDLERS, NULL, NULL));
+    env->stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(env->stream);
+    env->stored = find_fw(env->anjay_stored);
+    AVS_UNIT_ASSERT_NOT_NULL(env->stored);
+    env->restored = find_fw(env->anjay_restored);
+    AVS_UNIT_ASSERT_NOT_NULL(env->restored);
+    return env;
+}
+
+static void fw_persistence_test_env_destroy(fw_persistence_test_env_t **env) {
+    anjay_delete((*env)->anjay_stored);
+    anjay_delete((*env)->anjay_restored);
+    avs_stream_cleanup(&(*env)->stream);
+    avs_free(*env);
+}
+
+static void set_package_uri(fw_repr_t *fw, const char *uri) {
+    avs_free((void *) (intptr_t) fw->package_uri);
+    AVS_UNIT_ASSERT_NOT_NULL((fw->package_uri = avs_strdup(uri)));
+}
+
+static void persist_and_restore(fw_persistence_test_env_t *env) {
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_fw_update_persist(env->anjay_stored, env->stream));
+    AVS_UNIT_ASSERT_FALSE(anjay_fw_update_is_modified(env->anjay_stored));
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_fw_update_restore(env->anjay_restored, env->stream));
+    AVS_UNIT_ASSERT_FALSE(anjay_fw_update_is_modified(env->anjay_restored));
+}
+
+static void store_raw_state(fw_persistence_test_env_t *env,
+                            fw_persisted_state_t *state) {
+    avs_persistence_context_t ctx =
+            avs_persistence_store_context_create(env->stream);
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_bytes(
+            &ctx, (void *) (intptr_t) MAGIC_V0, sizeof(MAGIC_V0)));
+    AVS_UNIT_ASSERT_SUCCESS(handle_state(&ctx, state));
+}
+
+AVS_UNIT_TEST(fw_persistence, idle_with_result) {
+    SCOPED_FW_PERSISTENCE_TEST_ENV(env);
+    env->stored->result = ANJAY_FW_UPDATE_RESULT_CONNECTION_LOST;
+    set_package_uri(env->stored, "http://example.com/firmware");
+    persist_and_restore(env);
+
+    AVS_UNIT_ASSERT_EQUAL(env->restored->state, UPDATE_STATE_IDLE);
+    AVS_UNIT_ASSERT_EQUAL(env->restored->user_state.state, UPDATE_STATE_IDLE);
+    AVS_UNIT_ASSERT_EQUAL(env->restored->result,
+                          ANJAY_FW_UPDATE_RESULT_CONNECTION_LOST);
+    AVS_UNIT_ASSERT_EQUAL_STRING(env->restored->package_uri,
+                                 "http://example.com/firmware");
+}
+
+#ifdef WITH_HTTP_DOWNLOAD
+AVS_UNIT_TEST(fw_persistence, downloading) {
+    SCOPED_FW_PERSISTENCE_TEST_ENV(env);
+    static const char ETAG_VALUE[] = "tag";
+    anjay_etag_t *etag = (anjay_etag_t *) avs_malloc(
+            offsetof(anjay_etag_t, value) + sizeof(ETAG_VALUE) - 1);
+    AVS_UNIT_ASSERT_NOT_NULL(etag);
+    etag->size = sizeof(ETAG_VALUE) - 1;
+    memcpy(etag->value, ETAG_VALUE, etag->size);
+
+    env->stored->state = UPDATE_STATE_DOWNLOADING;
+    env->stored->user_state.state = UPDATE_STATE_DOWNLOADING;
+    env->stored->bytes_written = 1234;
+    env->stored->package_etag = etag;
+    set_package_uri(env->stored, "http://example.com/firmware");
+    persist_and_restore(env);
+
+    AVS_UNIT_ASSERT_EQUAL(env->restored->state, UPDATE_STATE_DOWNLOADING);
+    AVS_UNIT_ASSERT_EQUAL(env->restored->user_state.state,
+                          UPDATE_STATE_DOWNLOADING);
+    AVS_UNIT_ASSERT_EQUAL(env->restored->result,
+                          ANJAY_FW_UPDATE_RESULT_INITIAL);
+    AVS_UNIT_ASSERT_EQUAL_STRING(env->restored->package_uri,
+                                 "http://example.com/firmware");
+    AVS_UNIT_ASSERT_EQUAL(env->restored->bytes_written, 1234);
+    AVS_UNIT_ASSERT_TRUE(etag_equal(env->restored->package_etag, etag));
+    AVS_UNIT_ASSERT_TRUE(env->restored->retry_download_on_expired);
+}
+#endif // WITH_HTTP_DOWNLOAD
+
+AVS_UNIT_TEST(fw_persistence, downloaded) {
+    SCOPED_FW_PERSISTENCE_TEST_ENV(env);
+    env->stored->state = UPDATE_STATE_DOWNLOADED;
+    env->stored->user_state.state = UPDATE_STATE_DOWNLOADED;
+    env->stored->result = ANJAY_FW_UPDATE_RESULT_FAILED;
+    set_package_uri(env->stored, "http://example.com/firmware");
+    persist_and_restore(env);
+
+    AVS_UNIT_ASSERT_EQUAL(env->restored->state, UPDATE_STATE_DOWNLOADED);
+    AVS_UNIT_ASSERT_EQUAL(env->restored->user_state.state,
+                          UPDATE_STATE_DOWNLOADED);
+    AVS_UNIT_ASSERT_EQUAL(env->restored->result,
+                          ANJAY_FW_UPDATE_RESULT_FAILED);
+    AVS_UNIT_ASSERT_EQUAL_STRING(env->restored->package_uri,
+                                 "http://example.com/firmware");
+}
+
+AVS_UNIT_TEST(fw_persistence, updating) {
+    SCOPED_FW_PERSISTENCE_TEST_ENV(env);
+    env->stored->state = UPDATE_STATE_UPDATING;
+    env->stored->user_state.state = UPDATE_STATE_UPDATING;
+    persist_and_restore(env);
+
+    AVS_UNIT_ASSERT_EQUAL(env->restored->state, UPDATE_STATE_UPDATING);
+    AVS_UNIT_ASSERT_EQUAL(env->restored->user_state.state,
+                          UPDATE_STATE_UPDATING);
+    AVS_UNIT_ASSERT_EQUAL(env->restored->result,
+                          ANJAY_FW_UPDATE_RESULT_INITIAL);
+    AVS_UNIT_ASSERT_NULL(env->restored->package_uri);
+}
+
+AVS_UNIT_TEST(fw_persistence, updating_not_yet_performed) {
+    SCOPED_FW_PERSISTENCE_TEST_ENV(env);
+    /* perform_upgrade did not run yet, so Updating is not persisted */
+    env->stored->state = UPDATE_STATE_UPDATING;
+    env->stored->user_state.state = UPDATE_STATE_DOWNLOADED;
+    persist_and_restore(env);
+
+    AVS_UNIT_ASSERT_EQUAL(env->restored->state, UPDATE_STATE_DOWNLOADED);
+    AVS_UNIT_ASSERT_EQUAL(env->restored->user_state.state,
+                          UPDATE_STATE_DOWNLOADED);
+}
+
+AVS_UNIT_TEST(fw_persistence, invalid_state) {
+    SCOPED_FW_PERSISTENCE_TEST_ENV(env);
+    fw_persisted_state_t state = {
+        .state = UPDATE_STATE_UPDATING + 1,
+        .result = ANJAY_FW_UPDATE_RESULT_INITIAL
+    };
+    store_raw_state(env, &state);
+    AVS_UNIT_ASSERT_FAILED(
+            anjay_fw_update_restore(env->anjay_restored, env->stream));
+    AVS_UNIT_ASSERT_EQUAL(env->restored->state, UPDATE_STATE_IDLE);
+    AVS_UNIT_ASSERT_EQUAL(env->restored->user_state.state, UPDATE_STATE_IDLE);
+}
+
+AVS_UNIT_TEST(fw_persistence, invalid_result) {
+    SCOPED_FW_PERSISTENCE_TEST_ENV(env);
+    fw_persisted_state_t state = {
+        .state = UPDATE_STATE_IDLE,
+        .result = ANJAY_FW_UPDATE_RESULT_UNSUPPORTED_PROTOCOL + 1
+    };
+    store_raw_state(env, &state);
+    AVS_UNIT_ASSERT_FAILED(
+            anjay_fw_update_restore(env->anjay_restored, env->stream));
+    AVS_UNIT_ASSERT_EQUAL(env->restored->state, UPDATE_STATE_IDLE);
+    AVS_UNIT_ASSERT_EQUAL(env->restored->result,
+                          ANJAY_FW_UPDATE_RESULT_INITIAL);
+}
+
+AVS_UNIT_TEST(fw_persistence, downloading_without_uri) {
+    SCOPED_FW_PERSISTENCE_TEST_ENV(env);
+    fw_persisted_state_t state = {
+        .state = UPDATE_STATE_DOWNLOADING,
+        .result = ANJAY_FW_UPDATE_RESULT_INITIAL,
+        .bytes_written = 1234
+    };
+    store_raw_state(env, &state);
+    AVS_UNIT_ASSERT_FAILED(
+            anjay_fw_update_restore(env->anjay_restored, env->stream));
+    AVS_UNIT_ASSERT_EQUAL(env->restored->state, UPDATE_STATE_IDLE);
+    AVS_UNIT_ASSERT_NULL(env->restored->package_uri);
+}
@@ -182,8 +182,7 @@ static int del_instance(sec_repr_t *repr, anjay_iid_t iid) {
     AVS_LIST(sec_instance_t) *it;
     AVS_LIST_FOREACH_PTR(it, &repr->instances) {
         if ((*it)->iid == iid) {
-            AVS_LIST(sec_instance_t) element = AVS_LIST_DETACH(it);
-            _anjay_sec_destroy_instances(&element);
+            _anjay_sec_transaction_remove_instance(repr, it);
             _anjay_sec_mark_modified(repr);
             return 0;
         }
@@ -302,6 +301,9 @@ static int sec_write(anjay_t *anjay,
     int retval;
     assert(inst);
 
+    if ((retval = _anjay_sec_transaction_save_instance(repr, inst))) {
+        return retval;
+    }
     _anjay_sec_mark_modified(repr);
 
     switch ((security_resource_t) rid) {
@@ -381,6 +383,11 @@ static int sec_instance_create(anjay_t *anjay,
     if (!created) {
         return ANJAY_ERR_INTERNAL;
     }
+    int retval = _anjay_sec_transaction_mark_created(repr, iid);
+    if (retval) {
+        AVS_LIST_CLEAR(&created);
+        return retval;
+    }
 
     created->iid = iid;
     created->ssid = iid;
@@ -434,9 +441,14 @@ static int sec_instance_reset(anjay_t *anjay,
                               const anjay_dm_object_def_t *const *obj_ptr,
                               anjay_iid_t iid) {
     (void) anjay;
-    sec_instance_t *inst = find_instance(_anjay_sec_get(obj_ptr), iid);
+    sec_repr_t *repr = _anjay_sec_get(obj_ptr);
+    sec_instance_t *inst = find_instance(repr, iid);
     assert(inst);
 
+    int retval = _anjay_sec_transaction_save_instance(repr, inst);
+    if (retval) {
+        return retval;
+    }
     _anjay_sec_destroy_instance_fields(inst);
     memset(inst, 0, sizeof(sec_instance_t));
     inst->iid = iid;
@@ -504,7 +516,7 @@ static void security_purge(sec_repr_t *repr) {
         _anjay_sec_mark_modified(repr);
     }
     _anjay_sec_destroy_instances(&repr->instances);
-    _anjay_sec_destroy_instances(&repr->saved_instances);
+    _anjay_sec_transaction_forget(repr);
 }
 
 static void security_delete(void *repr) {
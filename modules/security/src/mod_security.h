@@ -24,6 +24,7 @@
 
 #include <anjay/security.h>
 
+#include <anjay_modules/iid_log.h>
 #include <anjay_modules/raw_buffer.h>
 #include <anjay_modules/utils_core.h>
 
@@ -75,7 +76,9 @@ typedef struct {
 typedef struct {
     const anjay_dm_object_def_t *def;
     AVS_LIST(sec_instance_t) instances;
-    AVS_LIST(sec_instance_t) saved_instances;
+    /* Rollback log of the current transaction */
+    anjay_iid_log_t log;
+    bool in_transaction;
     bool modified_since_persist;
     bool saved_modified_since_persist;
 } sec_repr_t;
@@ -192,6 +192,10 @@ avs_error_t anjay_security_object_restore(anjay_t *anjay,
         _anjay_sec_destroy_instances(&backup.instances);
         _anjay_sec_clear_modified(repr);
         persistence_log(INFO, "Security Object state restored");
+        if (anjay_notify_instances_changed(anjay, ANJAY_DM_OID_SECURITY)) {
+            persistence_log(WARNING, "Could not schedule Security Object "
+                                     "instance changes notifications");
+        }
     }
     return err;
 }
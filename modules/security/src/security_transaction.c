@@ -15,6 +15,7 @@
  */
 
 #include <assert.h>
+#include <stddef.h>
 #include <string.h>
 
 #include "security_transaction.h"
@@ -192,18 +193,64 @@ finish:
     return result;
 }
 
-int _anjay_sec_transaction_begin_impl(sec_repr_t *repr) {
-    assert(!repr->saved_instances);
-    repr->saved_instances = _anjay_sec_clone_instances(repr);
-    if (!repr->saved_instances && repr->instances) {
-        return ANJAY_ERR_INTERNAL;
+AVS_STATIC_ASSERT(offsetof(sec_instance_t, iid) == 0, sec_instance_iid_first);
+
+static int clone_instance(void *dst, const void *src) {
+    return _anjay_sec_clone_instance((sec_instance_t *) dst,
+                                     (const sec_instance_t *) src);
+}
+
+static void destroy_instances(AVS_LIST(void) *instances_ptr) {
+    _anjay_sec_destroy_instances((AVS_LIST(sec_instance_t) *) instances_ptr);
+}
+
+static const anjay_iid_log_handlers_t IID_LOG_HANDLERS = {
+    .instance_size = sizeof(sec_instance_t),
+    .clone_instance = clone_instance,
+    .destroy_instances = destroy_instances
+};
+
+int _anjay_sec_transaction_save_instance(sec_repr_t *repr,
+                                         const sec_instance_t *inst) {
+    if (!repr->in_transaction) {
+        return 0;
+    }
+    return _anjay_iid_log_save_instance(&repr->log, &IID_LOG_HANDLERS, inst);
+}
+
+int _anjay_sec_transaction_mark_created(sec_repr_t *repr, anjay_iid_t iid) {
+    if (!repr->in_transaction) {
+        return 0;
     }
+    return _anjay_iid_log_mark_created(&repr->log, iid);
+}
+
+void _anjay_sec_transaction_remove_instance(
+        sec_repr_t *repr, AVS_LIST(sec_instance_t) *inst_ptr) {
+    if (repr->in_transaction) {
+        _anjay_iid_log_remove_instance(&repr->log, &IID_LOG_HANDLERS,
+                                       (AVS_LIST(void) *) inst_ptr);
+    } else {
+        AVS_LIST(sec_instance_t) element = AVS_LIST_DETACH(inst_ptr);
+        _anjay_sec_destroy_instances(&element);
+    }
+}
+
+void _anjay_sec_transaction_forget(sec_repr_t *repr) {
+    _anjay_iid_log_forget(&repr->log, &IID_LOG_HANDLERS);
+}
+
+int _anjay_sec_transaction_begin_impl(sec_repr_t *repr) {
+    assert(!repr->in_transaction);
+    assert(_anjay_iid_log_empty(&repr->log));
+    repr->in_transaction = true;
     repr->saved_modified_since_persist = repr->modified_since_persist;
     return 0;
 }
 
 int _anjay_sec_transaction_commit_impl(sec_repr_t *repr) {
-    _anjay_sec_destroy_instances(&repr->saved_instances);
+    _anjay_sec_transaction_forget(repr);
+    repr->in_transaction = false;
     return 0;
 }
 
@@ -212,9 +259,9 @@ int _anjay_sec_transaction_validate_impl(anjay_t *anjay, sec_repr_t *repr) {
 }
 
 int _anjay_sec_transaction_rollback_impl(sec_repr_t *repr) {
-    _anjay_sec_destroy_instances(&repr->instances);
-    repr->instances = repr->saved_instances;
-    repr->saved_instances = NULL;
+    _anjay_iid_log_rollback(&repr->log, &IID_LOG_HANDLERS,
+                            (AVS_LIST(void) *) &repr->instances);
     repr->modified_since_persist = repr->saved_modified_since_persist;
+    repr->in_transaction = false;
     return 0;
 }
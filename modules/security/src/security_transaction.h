@@ -24,6 +24,32 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
 
 int _anjay_sec_object_validate(anjay_t *anjay, sec_repr_t *repr);
 
+/**
+ * Saves a copy of @p inst so that it can be restored on rollback. Needs to be
+ * called before each modification of an instance; only the first call for a
+ * given instance within a transaction actually copies anything.
+ */
+int _anjay_sec_transaction_save_instance(sec_repr_t *repr,
+                                         const sec_instance_t *inst);
+
+/**
+ * Records that instance @p iid has been created, so that it is removed on
+ * rollback.
+ */
+int _anjay_sec_transaction_mark_created(sec_repr_t *repr, anjay_iid_t iid);
+
+/**
+ * Detaches the instance pointed to by @p inst_ptr from the instance list. The
+ * instance is either kept for rollback or destroyed immediately.
+ */
+void _anjay_sec_transaction_remove_instance(sec_repr_t *repr,
+                                            AVS_LIST(sec_instance_t) *inst_ptr);
+
+/**
+ * Drops all rollback information gathered so far in the current transaction.
+ */
+void _anjay_sec_transaction_forget(sec_repr_t *repr);
+
 int _anjay_sec_transaction_begin_impl(sec_repr_t *repr);
 int _anjay_sec_transaction_commit_impl(sec_repr_t *repr);
 int _anjay_sec_transaction_validate_impl(anjay_t *anjay, sec_repr_t *repr);
@@ -115,9 +115,16 @@ void _anjay_sec_destroy_instances(AVS_LIST(sec_instance_t) *instances_ptr) {
     }
 }
 
-static int _anjay_sec_clone_instance(sec_instance_t *dest,
-                                     const sec_instance_t *src) {
+int _anjay_sec_clone_instance(sec_instance_t *dest,
+                              const sec_instance_t *src) {
     *dest = *src;
+    /* make sure that a partially cloned instance can be safely destroyed */
+    dest->public_cert_or_psk_identity = ANJAY_RAW_BUFFER_EMPTY;
+    dest->private_cert_or_psk_key = ANJAY_RAW_BUFFER_EMPTY;
+    dest->server_public_key = ANJAY_RAW_BUFFER_EMPTY;
+    dest->sms_key_params = ANJAY_RAW_BUFFER_EMPTY;
+    dest->sms_secret_key = ANJAY_RAW_BUFFER_EMPTY;
+    dest->sms_number = NULL;
 
     dest->server_uri = avs_strdup(src->server_uri);
     if (!dest->server_uri) {
@@ -125,40 +132,34 @@ static int _anjay_sec_clone_instance(sec_instance_t *dest,
         return -1;
     }
 
-    dest->public_cert_or_psk_identity = ANJAY_RAW_BUFFER_EMPTY;
     if (_anjay_raw_buffer_clone(&dest->public_cert_or_psk_identity,
                                 &src->public_cert_or_psk_identity)) {
         security_log(ERROR, "Cannot clone Pk Or Identity resource");
         return -1;
     }
 
-    dest->private_cert_or_psk_key = ANJAY_RAW_BUFFER_EMPTY;
     if (_anjay_raw_buffer_clone(&dest->private_cert_or_psk_key,
                                 &src->private_cert_or_psk_key)) {
         security_log(ERROR, "Cannot clone Secret Key resource");
         return -1;
     }
 
-    dest->server_public_key = ANJAY_RAW_BUFFER_EMPTY;
     if (_anjay_raw_buffer_clone(&dest->server_public_key,
                                 &src->server_public_key)) {
         security_log(ERROR, "Cannot clone Server Public Key resource");
         return -1;
     }
 
-    dest->sms_key_params = ANJAY_RAW_BUFFER_EMPTY;
     if (_anjay_raw_buffer_clone(&dest->sms_key_params, &src->sms_key_params)) {
         security_log(ERROR, "Cannot clone SMS Binding Key Parameters resource");
         return -1;
     }
 
-    dest->sms_secret_key = ANJAY_RAW_BUFFER_EMPTY;
     if (_anjay_raw_buffer_clone(&dest->sms_secret_key, &src->sms_secret_key)) {
         security_log(ERROR, "Cannot clone SMS Binding Secret Key(s) resource");
         return -1;
     }
 
-    dest->sms_number = NULL;
     if (src->sms_number) {
         dest->sms_number = avs_strdup(src->sms_number);
         if (!dest->sms_number) {
@@ -85,3 +85,37 @@ AVS_UNIT_TEST(security_object_api, add_instances_with_duplicated_ssids) {
     AVS_UNIT_ASSERT_FAILED(
             anjay_security_object_add_instance(env->anjay, &instance2, &iid));
 }
+
+AVS_UNIT_TEST(security_object_api, rollback_restores_only_touched_instances) {
+    SCOPED_SERVER_TEST_ENV(env);
+    anjay_iid_t iid = 1;
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_security_object_add_instance(env->anjay, &instance1, &iid));
+    iid = 2;
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_security_object_add_instance(env->anjay, &instance2, &iid));
+
+    const anjay_dm_object_def_t *const *obj_ptr =
+            _anjay_dm_find_object_by_oid(env->anjay, ANJAY_DM_OID_SECURITY);
+    sec_repr_t *repr = _anjay_sec_get(obj_ptr);
+    const sec_instance_t *untouched = find_instance(repr, 2);
+
+    AVS_UNIT_ASSERT_SUCCESS(sec_transaction_begin(env->anjay, obj_ptr));
+    AVS_UNIT_ASSERT_SUCCESS(sec_instance_remove(env->anjay, obj_ptr, 1));
+    AVS_UNIT_ASSERT_SUCCESS(sec_instance_create(env->anjay, obj_ptr, 3));
+    AVS_UNIT_ASSERT_SUCCESS(sec_instance_reset(env->anjay, obj_ptr, 3));
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(repr->log.saved_instances), 1);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(repr->log.created_iids), 1);
+    AVS_UNIT_ASSERT_SUCCESS(sec_transaction_rollback(env->anjay, obj_ptr));
+
+    AVS_UNIT_ASSERT_NULL(repr->log.saved_instances);
+    AVS_UNIT_ASSERT_NULL(repr->log.created_iids);
+    AVS_UNIT_ASSERT_NULL(repr->log.logged_iids);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(repr->instances), 2);
+    AVS_UNIT_ASSERT_NULL(find_instance(repr, 3));
+    AVS_UNIT_ASSERT_TRUE(find_instance(repr, 2) == untouched);
+    AVS_UNIT_ASSERT_NOT_NULL(find_instance(repr, 1));
+    AVS_UNIT_ASSERT_EQUAL_STRING(find_instance(repr, 1)->server_uri,
+                                 instance1.server_uri);
+    AVS_UNIT_ASSERT_EQUAL(repr->instances->iid, 1);
+}
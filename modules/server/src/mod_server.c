@@ -68,6 +68,9 @@ static int assign_iid(server_repr_t *repr, anjay_iid_t *inout_iid) {
 
 static int insert_created_instance(server_repr_t *repr,
                                    AVS_LIST(server_instance_t) new_instance) {
+    if (_anjay_serv_transaction_mark_created(repr, new_instance->iid)) {
+        return -1;
+    }
     AVS_LIST(server_instance_t) *ptr;
     AVS_LIST_FOREACH_PTR(ptr, &repr->instances) {
         assert((*ptr)->iid != new_instance->iid);
@@ -126,7 +129,7 @@ static int del_instance(server_repr_t *repr, anjay_iid_t iid) {
     AVS_LIST(server_instance_t) *it;
     AVS_LIST_FOREACH_PTR(it, &repr->instances) {
         if ((*it)->iid == iid) {
-            AVS_LIST_DELETE(it);
+            _anjay_serv_transaction_remove_instance(repr, it);
             _anjay_serv_mark_modified(repr);
             return 0;
         } else if ((*it)->iid > iid) {
@@ -194,9 +197,14 @@ static int serv_instance_reset(anjay_t *anjay,
                                const anjay_dm_object_def_t *const *obj_ptr,
                                anjay_iid_t iid) {
     (void) anjay;
-    server_instance_t *inst = find_instance(_anjay_serv_get(obj_ptr), iid);
+    server_repr_t *repr = _anjay_serv_get(obj_ptr);
+    server_instance_t *inst = find_instance(repr, iid);
     assert(inst);
 
+    int retval = _anjay_serv_transaction_save_instance(repr, inst);
+    if (retval) {
+        return retval;
+    }
     bool has_ssid = inst->has_ssid;
     anjay_ssid_t ssid = inst->data.ssid;
     reset_instance_resources(inst);
@@ -293,6 +301,9 @@ static int serv_write(anjay_t *anjay,
     assert(inst);
     int retval;
 
+    if ((retval = _anjay_serv_transaction_save_instance(repr, inst))) {
+        return retval;
+    }
     _anjay_serv_mark_modified(repr);
 
     switch ((server_rid_t) rid) {
@@ -448,7 +459,7 @@ static void server_purge(server_repr_t *repr) {
         _anjay_serv_mark_modified(repr);
     }
     _anjay_serv_destroy_instances(&repr->instances);
-    _anjay_serv_destroy_instances(&repr->saved_instances);
+    _anjay_serv_transaction_forget(repr);
 }
 
 static void server_delete(void *repr) {
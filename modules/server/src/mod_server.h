@@ -21,6 +21,7 @@
 #include <anjay/core.h>
 #include <anjay/server.h>
 
+#include <anjay_modules/iid_log.h>
 #include <anjay_modules/utils_core.h>
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
@@ -50,7 +51,9 @@ typedef struct {
 typedef struct {
     const anjay_dm_object_def_t *def;
     AVS_LIST(server_instance_t) instances;
-    AVS_LIST(server_instance_t) saved_instances;
+    /* Rollback log of the current transaction */
+    anjay_iid_log_t log;
+    bool in_transaction;
     bool modified_since_persist;
     bool saved_modified_since_persist;
 } server_repr_t;
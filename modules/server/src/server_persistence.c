@@ -268,6 +268,10 @@ avs_error_t anjay_server_object_restore(anjay_t *anjay,
         _anjay_serv_destroy_instances(&backup.instances);
         _anjay_serv_clear_modified(repr);
         persistence_log(INFO, "Server Object state restored");
+        if (anjay_notify_instances_changed(anjay, ANJAY_DM_OID_SERVER)) {
+            persistence_log(WARNING, "Could not schedule Server Object "
+                                     "instance changes notifications");
+        }
     }
     return err;
 }
@@ -16,6 +16,7 @@
 
 #include <assert.h>
 #include <inttypes.h>
+#include <stddef.h>
 #include <string.h>
 
 #include "server_transaction.h"
@@ -123,18 +124,67 @@ int _anjay_serv_object_validate(server_repr_t *repr) {
     return result;
 }
 
-int _anjay_serv_transaction_begin_impl(server_repr_t *repr) {
-    assert(!repr->saved_instances);
-    repr->saved_instances = _anjay_serv_clone_instances(repr);
-    if (!repr->saved_instances && repr->instances) {
-        return ANJAY_ERR_INTERNAL;
+AVS_STATIC_ASSERT(offsetof(server_instance_t, iid) == 0,
+                  server_instance_iid_first);
+
+static int clone_instance(void *dst, const void *src) {
+    _anjay_serv_clone_instance((server_instance_t *) dst,
+                               (const server_instance_t *) src);
+    return 0;
+}
+
+static void destroy_instances(AVS_LIST(void) *instances_ptr) {
+    _anjay_serv_destroy_instances(
+            (AVS_LIST(server_instance_t) *) instances_ptr);
+}
+
+static const anjay_iid_log_handlers_t IID_LOG_HANDLERS = {
+    .instance_size = sizeof(server_instance_t),
+    .clone_instance = clone_instance,
+    .destroy_instances = destroy_instances
+};
+
+int _anjay_serv_transaction_save_instance(server_repr_t *repr,
+                                          const server_instance_t *inst) {
+    if (!repr->in_transaction) {
+        return 0;
     }
+    return _anjay_iid_log_save_instance(&repr->log, &IID_LOG_HANDLERS, inst);
+}
+
+int _anjay_serv_transaction_mark_created(server_repr_t *repr, anjay_iid_t iid) {
+    if (!repr->in_transaction) {
+        return 0;
+    }
+    return _anjay_iid_log_mark_created(&repr->log, iid);
+}
+
+void _anjay_serv_transaction_remove_instance(
+        server_repr_t *repr, AVS_LIST(server_instance_t) *inst_ptr) {
+    if (repr->in_transaction) {
+        _anjay_iid_log_remove_instance(&repr->log, &IID_LOG_HANDLERS,
+                                       (AVS_LIST(void) *) inst_ptr);
+    } else {
+        AVS_LIST(server_instance_t) element = AVS_LIST_DETACH(inst_ptr);
+        _anjay_serv_destroy_instances(&element);
+    }
+}
+
+void _anjay_serv_transaction_forget(server_repr_t *repr) {
+    _anjay_iid_log_forget(&repr->log, &IID_LOG_HANDLERS);
+}
+
+int _anjay_serv_transaction_begin_impl(server_repr_t *repr) {
+    assert(!repr->in_transaction);
+    assert(_anjay_iid_log_empty(&repr->log));
+    repr->in_transaction = true;
     repr->saved_modified_since_persist = repr->modified_since_persist;
     return 0;
 }
 
 int _anjay_serv_transaction_commit_impl(server_repr_t *repr) {
-    _anjay_serv_destroy_instances(&repr->saved_instances);
+    _anjay_serv_transaction_forget(repr);
+    repr->in_transaction = false;
     return 0;
 }
 
@@ -143,9 +193,9 @@ int _anjay_serv_transaction_validate_impl(server_repr_t *repr) {
 }
 
 int _anjay_serv_transaction_rollback_impl(server_repr_t *repr) {
-    _anjay_serv_destroy_instances(&repr->instances);
+    _anjay_iid_log_rollback(&repr->log, &IID_LOG_HANDLERS,
+                            (AVS_LIST(void) *) &repr->instances);
     repr->modified_since_persist = repr->saved_modified_since_persist;
-    repr->instances = repr->saved_instances;
-    repr->saved_instances = NULL;
+    repr->in_transaction = false;
     return 0;
 }
@@ -50,18 +50,12 @@ int _anjay_serv_fetch_binding(anjay_input_ctx_t *ctx,
     return anjay_binding_mode_valid(*out_binding) ? 0 : ANJAY_ERR_BAD_REQUEST;
 }
 
-AVS_LIST(server_instance_t)
-_anjay_serv_clone_instances(const server_repr_t *repr) {
-    AVS_LIST(server_instance_t) clone = AVS_LIST_SIMPLE_CLONE(repr->instances);
-    if (clone) {
-        AVS_LIST(server_instance_t) it;
-        AVS_LIST_FOREACH(it, clone) {
-            if (it->data.binding) {
-                it->data.binding = it->binding_buf;
-            }
-        }
+void _anjay_serv_clone_instance(server_instance_t *dest,
+                                const server_instance_t *src) {
+    *dest = *src;
+    if (dest->data.binding) {
+        dest->data.binding = dest->binding_buf;
     }
-    return clone;
 }
 
 void _anjay_serv_destroy_instances(AVS_LIST(server_instance_t) *instances) {
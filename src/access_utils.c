@@ -188,6 +188,49 @@ static int foreach_acl(anjay_t *anjay,
     return result;
 }
 
+typedef struct {
+    anjay_ssid_t ssid;
+    // false if reading the mask failed; only ever set in the ACL index
+    bool mask_valid;
+    anjay_access_mask_t mask;
+} acl_entry_t;
+
+static int read_acl_clb(anjay_t *anjay,
+                        const anjay_dm_object_def_t *const *obj,
+                        anjay_iid_t iid,
+                        anjay_rid_t rid,
+                        anjay_riid_t riid,
+                        void *endptr_ptr_) {
+    AVS_LIST(acl_entry_t) **endptr_ptr = (AVS_LIST(acl_entry_t) **) endptr_ptr_;
+    assert(!**endptr_ptr);
+    if (!(**endptr_ptr = AVS_LIST_NEW_ELEMENT(acl_entry_t))) {
+        return -1;
+    }
+    (**endptr_ptr)->ssid = riid;
+    (**endptr_ptr)->mask_valid = true;
+    int result = read_mask(anjay, obj, iid, rid, riid, &(**endptr_ptr)->mask);
+    if (result) {
+        AVS_LIST_DELETE(*endptr_ptr);
+    } else {
+        AVS_LIST_ADVANCE_PTR(endptr_ptr);
+    }
+    return result;
+}
+
+static int read_acl(anjay_t *anjay,
+                    const anjay_dm_object_def_t *const *ac_obj,
+                    anjay_iid_t ac_iid,
+                    AVS_LIST(acl_entry_t) *out_acl) {
+    assert(out_acl);
+    assert(!*out_acl);
+    AVS_LIST(acl_entry_t) *endptr = out_acl;
+    int result = foreach_acl(anjay, ac_obj, ac_iid, read_acl_clb, &endptr);
+    if (result) {
+        AVS_LIST_CLEAR(out_acl);
+    }
+    return result;
+}
+
 typedef struct {
     anjay_iid_t ac_iid;
     anjay_oid_t target_oid;
@@ -264,15 +307,170 @@ static int get_mask(anjay_t *anjay,
     return 0;
 }
 
+struct anjay_acl_index_entry_struct {
+    anjay_oid_t oid;
+    anjay_iid_t iid;
+    // false if listing the ACL failed
+    bool acl_valid;
+    anjay_ssid_t owner;
+    AVS_LIST(acl_entry_t) acl;
+};
+
+static int acl_index_entry_cmp(const void *left_, const void *right_) {
+    const anjay_acl_index_entry_t *left =
+            (const anjay_acl_index_entry_t *) left_;
+    const anjay_acl_index_entry_t *right =
+            (const anjay_acl_index_entry_t *) right_;
+    if (left->oid != right->oid) {
+        return left->oid < right->oid ? -1 : 1;
+    }
+    return left->iid < right->iid ? -1 : (left->iid > right->iid);
+}
+
+static void clear_acl_index(AVS_RBTREE(anjay_acl_index_entry_t) *index_ptr) {
+    AVS_RBTREE_DELETE(index_ptr) {
+        AVS_LIST_CLEAR(&(**index_ptr)->acl);
+    }
+}
+
+static int index_acl_entry_clb(anjay_t *anjay,
+                               const anjay_dm_object_def_t *const *obj,
+                               anjay_iid_t iid,
+                               anjay_rid_t rid,
+                               anjay_riid_t riid,
+                               void *endptr_ptr_) {
+    AVS_LIST(acl_entry_t) **endptr_ptr = (AVS_LIST(acl_entry_t) **) endptr_ptr_;
+    assert(!**endptr_ptr);
+    if (!(**endptr_ptr = AVS_LIST_NEW_ELEMENT(acl_entry_t))) {
+        anjay_log(ERROR, "out of memory");
+        return -1;
+    }
+    (**endptr_ptr)->ssid = riid;
+    // an unreadable entry only affects the SSID it would apply to
+    (**endptr_ptr)->mask_valid =
+            !read_mask(anjay, obj, iid, rid, riid, &(**endptr_ptr)->mask);
+    AVS_LIST_ADVANCE_PTR(endptr_ptr);
+    return 0;
+}
+
+static int index_ac_instance_clb(anjay_t *anjay,
+                                 const anjay_dm_object_def_t *const *ac_obj,
+                                 anjay_iid_t ac_iid,
+                                 void *index_) {
+    AVS_RBTREE(anjay_acl_index_entry_t) index =
+            (AVS_RBTREE(anjay_acl_index_entry_t)) index_;
+    AVS_RBTREE_ELEM(anjay_acl_index_entry_t) entry =
+            AVS_RBTREE_ELEM_NEW(anjay_acl_index_entry_t);
+    if (!entry) {
+        anjay_log(ERROR, "out of memory");
+        return -1;
+    }
+    // if any of the IDs cannot be read, building the index fails, and access
+    // is checked without it, just as if the index was disabled
+    int result = read_ids_from_ac_instance(anjay, ac_iid, &entry->oid,
+                                           &entry->iid, &entry->owner);
+    if (result) {
+        AVS_RBTREE_ELEM_DELETE_DETACHED(&entry);
+        return result;
+    }
+    AVS_LIST(acl_entry_t) *endptr = &entry->acl;
+    if (!(entry->acl_valid = !foreach_acl(anjay, ac_obj, ac_iid,
+                                          index_acl_entry_clb, &endptr))) {
+        AVS_LIST_CLEAR(&entry->acl);
+    }
+    if (AVS_RBTREE_INSERT(index, entry) != entry) {
+        // another instance refers to the same target; the one enumerated
+        // first by list_instances wins, just like in
+        // find_ac_instance_by_target()
+        AVS_LIST_CLEAR(&entry->acl);
+        AVS_RBTREE_ELEM_DELETE_DETACHED(&entry);
+    }
+    return 0;
+}
+
+static AVS_RBTREE(anjay_acl_index_entry_t)
+get_acl_index(anjay_t *anjay, const anjay_dm_object_def_t *const *ac_obj) {
+    if (!anjay->cache_access_control) {
+        return NULL;
+    }
+    if (!anjay->access_control_index) {
+        AVS_RBTREE(anjay_acl_index_entry_t) index =
+                AVS_RBTREE_NEW(anjay_acl_index_entry_t, acl_index_entry_cmp);
+        if (!index) {
+            anjay_log(ERROR, "out of memory");
+            return NULL;
+        }
+        if (_anjay_dm_foreach_instance(anjay, ac_obj, index_ac_instance_clb,
+                                       index)) {
+            clear_acl_index(&index);
+            return NULL;
+        }
+        anjay->access_control_index = index;
+    }
+    return anjay->access_control_index;
+}
+
+static anjay_access_mask_t
+indexed_access_control_mask(AVS_RBTREE(anjay_acl_index_entry_t) index,
+                            anjay_oid_t oid,
+                            anjay_iid_t iid,
+                            anjay_ssid_t ssid) {
+    const anjay_acl_index_entry_t key = {
+        .oid = oid,
+        .iid = iid
+    };
+    AVS_RBTREE_ELEM(anjay_acl_index_entry_t) entry =
+            AVS_RBTREE_FIND(index, &key);
+    if (!entry) {
+        return ANJAY_ACCESS_MASK_NONE;
+    }
+    if (!entry->acl_valid) {
+        anjay_log(WARNING, "failed to read ACL!");
+        return ANJAY_ACCESS_MASK_NONE;
+    }
+    if (!entry->acl) {
+        // Empty ACL - only the owner of the instance has access
+        return entry->owner == ssid
+                       ? (ANJAY_ACCESS_MASK_FULL & ~ANJAY_ACCESS_MASK_CREATE)
+                       : ANJAY_ACCESS_MASK_NONE;
+    }
+    const acl_entry_t *found = NULL;
+    AVS_LIST(acl_entry_t) acl;
+    AVS_LIST_FOREACH(acl, entry->acl) {
+        if (acl->ssid == ssid) {
+            found = acl;
+            break;
+        } else if (!acl->ssid) {
+            // default ACL entry, unless one for the given SSID is found
+            found = acl;
+        }
+    }
+    if (!found) {
+        return ANJAY_ACCESS_MASK_NONE;
+    }
+    if (!found->mask_valid) {
+        anjay_log(WARNING, "failed to read ACL!");
+        return ANJAY_ACCESS_MASK_NONE;
+    }
+    return found->mask;
+}
+
 static anjay_access_mask_t access_control_mask(anjay_t *anjay,
                                                anjay_oid_t oid,
                                                anjay_iid_t iid,
                                                anjay_ssid_t ssid) {
     const anjay_dm_object_def_t *const *ac_obj =
             _anjay_dm_find_object_by_oid(anjay, ANJAY_DM_OID_ACCESS_CONTROL);
+    if (!ac_obj) {
+        return ANJAY_ACCESS_MASK_NONE;
+    }
+    AVS_RBTREE(anjay_acl_index_entry_t) index = get_acl_index(anjay, ac_obj);
+    if (index) {
+        return indexed_access_control_mask(index, oid, iid, ssid);
+    }
+
     anjay_iid_t ac_iid;
-    if (!ac_obj
-            || find_ac_instance_by_target(anjay, ac_obj, &ac_iid, oid, iid)) {
+    if (find_ac_instance_by_target(anjay, ac_obj, &ac_iid, oid, iid)) {
         return ANJAY_ACCESS_MASK_NONE;
     }
 
@@ -392,6 +590,26 @@ bool _anjay_instance_action_allowed(anjay_t *anjay,
 #endif // WITH_ACCESS_CONTROL
 }
 
+bool _anjay_access_control_depends_on_ssid(anjay_t *anjay) {
+#ifndef WITH_ACCESS_CONTROL
+    (void) anjay;
+    return false;
+#else
+    return get_access_control(anjay) && !is_single_ssid_environment(anjay);
+#endif // WITH_ACCESS_CONTROL
+}
+
+void _anjay_access_control_invalidate_index(anjay_t *anjay, anjay_oid_t oid) {
+#ifndef WITH_ACCESS_CONTROL
+    (void) anjay;
+    (void) oid;
+#else
+    if (oid == ANJAY_DM_OID_ACCESS_CONTROL) {
+        clear_acl_index(&anjay->access_control_index);
+    }
+#endif // WITH_ACCESS_CONTROL
+}
+
 #ifdef WITH_ACCESS_CONTROL
 
 static void what_changed(anjay_ssid_t origin_ssid,
@@ -463,46 +681,6 @@ enumerate_valid_ssids_clb(anjay_t *anjay,
     return 0;
 }
 
-typedef struct {
-    anjay_ssid_t ssid;
-    anjay_access_mask_t mask;
-} acl_entry_t;
-
-static int read_acl_clb(anjay_t *anjay,
-                        const anjay_dm_object_def_t *const *obj,
-                        anjay_iid_t iid,
-                        anjay_rid_t rid,
-                        anjay_riid_t riid,
-                        void *endptr_ptr_) {
-    AVS_LIST(acl_entry_t) **endptr_ptr = (AVS_LIST(acl_entry_t) **) endptr_ptr_;
-    assert(!**endptr_ptr);
-    if (!(**endptr_ptr = AVS_LIST_NEW_ELEMENT(acl_entry_t))) {
-        return -1;
-    }
-    (**endptr_ptr)->ssid = riid;
-    int result = read_mask(anjay, obj, iid, rid, riid, &(**endptr_ptr)->mask);
-    if (result) {
-        AVS_LIST_DELETE(*endptr_ptr);
-    } else {
-        AVS_LIST_ADVANCE_PTR(endptr_ptr);
-    }
-    return result;
-}
-
-static int read_acl(anjay_t *anjay,
-                    const anjay_dm_object_def_t *const *ac_obj,
-                    anjay_iid_t ac_iid,
-                    AVS_LIST(acl_entry_t) *out_acl) {
-    assert(out_acl);
-    assert(!*out_acl);
-    AVS_LIST(acl_entry_t) *endptr = out_acl;
-    int result = foreach_acl(anjay, ac_obj, ac_iid, read_acl_clb, &endptr);
-    if (result) {
-        AVS_LIST_CLEAR(out_acl);
-    }
-    return result;
-}
-
 /**
  * Finds the server that will become the new owner of the given ACL.
  * Servers with both Write and Delete rights are ranked with value 2, those with
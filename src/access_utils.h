@@ -43,6 +43,23 @@ typedef struct {
 bool _anjay_instance_action_allowed(anjay_t *anjay,
                                     const anjay_action_info_t *info);
 
+/**
+ * Checks whether results of @ref _anjay_instance_action_allowed might differ
+ * between non-Bootstrap Servers, i.e. whether the Access Control object is
+ * present and there is more than one such Server. If this function returns
+ * false, data read on behalf of any non-Bootstrap Server may be reused for
+ * all others.
+ */
+bool _anjay_access_control_depends_on_ssid(anjay_t *anjay);
+
+/**
+ * Drops the index of the Access Control Object (see
+ * @ref anjay_configuration_t::cache_access_control) if @p oid is the Access
+ * Control Object ID. MUST be called whenever the Access Control Object might
+ * have changed.
+ */
+void _anjay_access_control_invalidate_index(anjay_t *anjay, anjay_oid_t oid);
+
 /**
  * Performs implicit creations and deletions of Access Control object instances
  * according to data model changes.
@@ -38,6 +38,7 @@
 
 #include <anjay_config_log.h>
 
+#include "access_utils.h"
 #include "anjay_core.h"
 #include "coap/content_format.h"
 #include "coap/msg_details.h"
@@ -131,7 +132,9 @@ static int init(anjay_t *anjay, const anjay_configuration_t *config) {
 
     _anjay_observe_init(&anjay->observe,
                         config->confirmable_notifications,
-                        config->stored_notification_limit);
+                        config->stored_notification_limit,
+                        config->aggregated_notification_limit,
+                        config->cache_observe_attributes);
 
 #ifdef WITH_DOWNLOADER
     if (_anjay_downloader_init(&anjay->downloader, anjay)) {
@@ -141,6 +144,11 @@ static int init(anjay_t *anjay, const anjay_configuration_t *config) {
 
     anjay->prefer_hierarchical_formats = config->prefer_hierarchical_formats;
     anjay->use_connection_id = config->use_connection_id;
+    anjay->dm.cache_instance_lists = config->cache_instance_lists;
+    anjay->dm.cache_resource_lists = config->cache_resource_lists;
+#ifdef WITH_ACCESS_CONTROL
+    anjay->cache_access_control = config->cache_access_control;
+#endif // WITH_ACCESS_CONTROL
 
     return 0;
 }
@@ -193,6 +201,7 @@ static void anjay_delete_impl(anjay_t *anjay, bool deregister) {
     _anjay_observe_cleanup(&anjay->observe);
 
     _anjay_dm_cleanup(anjay);
+    _anjay_access_control_invalidate_index(anjay, ANJAY_DM_OID_ACCESS_CONTROL);
     _anjay_notify_clear_queue(&anjay->scheduled_notify.queue);
 
     avs_free(anjay->default_tls_ciphersuites.ids);
@@ -679,6 +688,10 @@ _anjay_max_transmit_wait_for_transport(anjay_t *anjay,
     case ANJAY_SOCKET_TRANSPORT_UDP:
         return avs_coap_udp_max_transmit_wait(&anjay->udp_tx_params);
 #endif // WITH_AVS_COAP_UDP
+#ifdef WITH_AVS_COAP_TCP
+    case ANJAY_SOCKET_TRANSPORT_TCP:
+        return AVS_COAP_DEFAULT_TCP_REQUEST_TIMEOUT;
+#endif // WITH_AVS_COAP_TCP
     default:
         AVS_UNREACHABLE("Should never happen");
         return AVS_TIME_DURATION_INVALID;
@@ -693,6 +706,10 @@ _anjay_exchange_lifetime_for_transport(anjay_t *anjay,
     case ANJAY_SOCKET_TRANSPORT_UDP:
         return avs_coap_udp_exchange_lifetime(&anjay->udp_tx_params);
 #endif // WITH_AVS_COAP_UDP
+#ifdef WITH_AVS_COAP_TCP
+    case ANJAY_SOCKET_TRANSPORT_TCP:
+        return AVS_COAP_DEFAULT_TCP_REQUEST_TIMEOUT;
+#endif // WITH_AVS_COAP_TCP
     default:
         AVS_UNREACHABLE("Should never happen");
         return AVS_TIME_DURATION_INVALID;
@@ -795,6 +812,7 @@ int anjay_sched_calculate_wait_time_ms(anjay_t *anjay, int limit_ms) {
 
 void anjay_sched_run(anjay_t *anjay) {
     avs_sched_run(anjay->sched);
+    _anjay_observe_read_cache_clear(&anjay->observe);
 }
 
 avs_error_t anjay_download(anjay_t *anjay,
@@ -821,6 +839,28 @@ void anjay_download_abort(anjay_t *anjay, anjay_download_handle_t handle) {
 #endif // WITH_DOWNLOADER
 }
 
+avs_error_t anjay_observe_persist(anjay_t *anjay, avs_stream_t *out_stream) {
+#if defined(WITH_OBSERVE) && defined(WITH_AVS_PERSISTENCE)
+    return _anjay_observe_persist(anjay, out_stream);
+#else  // defined(WITH_OBSERVE) && defined(WITH_AVS_PERSISTENCE)
+    (void) anjay;
+    (void) out_stream;
+    anjay_log(ERROR, "Observe persistence support disabled");
+    return avs_errno(AVS_ENOTSUP);
+#endif // defined(WITH_OBSERVE) && defined(WITH_AVS_PERSISTENCE)
+}
+
+avs_error_t anjay_observe_restore(anjay_t *anjay, avs_stream_t *in_stream) {
+#if defined(WITH_OBSERVE) && defined(WITH_AVS_PERSISTENCE)
+    return _anjay_observe_restore(anjay, in_stream);
+#else  // defined(WITH_OBSERVE) && defined(WITH_AVS_PERSISTENCE)
+    (void) anjay;
+    (void) in_stream;
+    anjay_log(ERROR, "Observe persistence support disabled");
+    return avs_errno(AVS_ENOTSUP);
+#endif // defined(WITH_OBSERVE) && defined(WITH_AVS_PERSISTENCE)
+}
+
 #ifdef ANJAY_TEST
 #    include "test/anjay.c"
 #endif // ANJAY_TEST
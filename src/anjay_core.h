@@ -19,9 +19,11 @@
 
 #include <avsystem/commons/list.h>
 #include <avsystem/commons/net.h>
+#include <avsystem/commons/rbtree.h>
 #include <avsystem/commons/shared_buffer.h>
 #include <avsystem/commons/stream.h>
 
+#include <avsystem/coap/tcp.h>
 #include <avsystem/coap/udp.h>
 
 #include "dm_core.h"
@@ -45,6 +47,10 @@ typedef struct {
     AVS_LIST(const anjay_dm_object_def_t *const *) objs_in_transaction;
 } anjay_transaction_state_t;
 
+#ifdef WITH_ACCESS_CONTROL
+typedef struct anjay_acl_index_entry_struct anjay_acl_index_entry_t;
+#endif // WITH_ACCESS_CONTROL
+
 struct anjay_struct {
     bool offline;
     avs_sched_handle_t enter_offline_job_handle;
@@ -83,6 +89,13 @@ struct anjay_struct {
 #endif // WITH_DOWNLOADER
 #ifdef WITH_ACCESS_CONTROL
     bool access_control_sync_in_progress;
+    bool cache_access_control;
+    /**
+     * Access Control Object Instances indexed by their target Object Instance.
+     * Only used if @ref anjay_t::cache_access_control is set. NULL if not
+     * built yet, or invalidated since; see access_utils.c.
+     */
+    AVS_RBTREE(anjay_acl_index_entry_t) access_control_index;
 #endif // WITH_ACCESS_CONTROL
     bool prefer_hierarchical_formats;
 #ifdef WITH_NET_STATS
@@ -20,6 +20,7 @@
 
 #include <anjay_modules/dm_utils.h>
 
+#include "../access_utils.h"
 #include "../anjay_core.h"
 #include "../utils_core.h"
 
@@ -27,8 +28,12 @@ VISIBILITY_SOURCE_BEGIN
 
 #define dm_log(...) _anjay_log(anjay_dm, __VA_ARGS__)
 
+typedef void (*func_ptr_t)(void);
+
+AVS_STATIC_ASSERT(sizeof(anjay_dm_handlers_t) % sizeof(func_ptr_t) == 0,
+                  dm_handlers_consist_of_function_pointers);
+
 static bool has_handler(const anjay_dm_handlers_t *def, size_t handler_offset) {
-    typedef void (*func_ptr_t)(void);
     return *(AVS_APPLY_OFFSET(func_ptr_t, def, handler_offset));
 }
 
@@ -43,30 +48,31 @@ get_handler_from_list(AVS_LIST(anjay_dm_installed_module_t) module_list,
     return NULL;
 }
 
-static const anjay_dm_handlers_t *
-get_next_handler_from_overlay(anjay_t *anjay,
-                              const anjay_dm_module_t *current_module,
-                              size_t handler_offset) {
-    assert(current_module);
-
-    AVS_LIST(anjay_dm_installed_module_t) *current_head =
-            _anjay_dm_module_find_ptr(anjay, current_module);
-    if (current_head) {
-        return get_handler_from_list(AVS_LIST_NEXT(*current_head),
-                                     handler_offset);
+void _anjay_dm_refresh_handler_dispatch(anjay_dm_t *dm) {
+    for (size_t slot = 0; slot < ANJAY_DM_HANDLER_SLOTS; ++slot) {
+        const size_t handler_offset = slot * sizeof(func_ptr_t);
+        dm->overlay[slot] = get_handler_from_list(dm->modules, handler_offset);
+        AVS_LIST(anjay_dm_installed_module_t) module;
+        AVS_LIST_FOREACH(module, dm->modules) {
+            module->next_overlay[slot] =
+                    get_handler_from_list(AVS_LIST_NEXT(module),
+                                          handler_offset);
+        }
     }
-    return NULL;
 }
 
 static const anjay_dm_handlers_t *
 get_handler_from_overlay(anjay_t *anjay,
                          const anjay_dm_module_t *current_module,
                          size_t handler_offset) {
+    const size_t slot = handler_offset / sizeof(func_ptr_t);
+    assert(slot < ANJAY_DM_HANDLER_SLOTS);
     if (current_module) {
-        return get_next_handler_from_overlay(anjay, current_module,
-                                             handler_offset);
+        anjay_dm_installed_module_t *current =
+                _anjay_dm_module_find(anjay, current_module);
+        return current ? current->next_overlay[slot] : NULL;
     } else {
-        return get_handler_from_list(anjay->dm.modules, handler_offset);
+        return anjay->dm.overlay[slot];
     }
 }
 
@@ -148,6 +154,27 @@ int _anjay_dm_call_list_instances(anjay_t *anjay,
                               anjay, obj_ptr, ctx);
 }
 
+int _anjay_dm_call_instance_present(anjay_t *anjay,
+                                    const anjay_dm_object_def_t *const *obj_ptr,
+                                    anjay_iid_t iid,
+                                    const anjay_dm_module_t *current_module) {
+    dm_log(TRACE, "instance_present /%u/%u", (*obj_ptr)->oid, iid);
+    const anjay_dm_handlers_t *handler =
+            get_handler(anjay, obj_ptr, current_module,
+                        offsetof(anjay_dm_handlers_t, instance_present));
+    if (!handler) {
+        dm_log(DEBUG, "instance_present handler not set for object /%u",
+               (*obj_ptr)->oid);
+        return ANJAY_ERR_METHOD_NOT_ALLOWED;
+    }
+    int result = handler->instance_present(anjay, obj_ptr, iid);
+    if (result < 0) {
+        dm_log(DEBUG, "instance_present failed with code %d (%s)", result,
+               AVS_COAP_CODE_STRING(_anjay_make_error_response_code(result)));
+    }
+    return result;
+}
+
 int _anjay_dm_call_instance_reset(anjay_t *anjay,
                                   const anjay_dm_object_def_t *const *obj_ptr,
                                   anjay_iid_t iid,
@@ -157,6 +184,8 @@ int _anjay_dm_call_instance_reset(anjay_t *anjay,
     if (result) {
         return result;
     }
+    _anjay_dm_invalidate_resource_cache(anjay, (*obj_ptr)->oid, iid);
+    _anjay_access_control_invalidate_index(anjay, (*obj_ptr)->oid);
     CHECKED_TAIL_CALL_HANDLER(anjay, obj_ptr, current_module, instance_reset,
                               anjay, obj_ptr, iid);
 }
@@ -170,6 +199,9 @@ int _anjay_dm_call_instance_create(anjay_t *anjay,
     if (result) {
         return result;
     }
+    _anjay_dm_invalidate_resource_cache(anjay, (*obj_ptr)->oid, iid);
+    _anjay_access_control_invalidate_index(anjay, (*obj_ptr)->oid);
+    _anjay_dm_invalidate_instance_cache(anjay, (*obj_ptr)->oid);
     CHECKED_TAIL_CALL_HANDLER(anjay, obj_ptr, current_module, instance_create,
                               anjay, obj_ptr, iid);
 }
@@ -183,6 +215,9 @@ int _anjay_dm_call_instance_remove(anjay_t *anjay,
     if (result) {
         return result;
     }
+    _anjay_dm_invalidate_resource_cache(anjay, (*obj_ptr)->oid, iid);
+    _anjay_access_control_invalidate_index(anjay, (*obj_ptr)->oid);
+    _anjay_dm_invalidate_instance_cache(anjay, (*obj_ptr)->oid);
     CHECKED_TAIL_CALL_HANDLER(anjay, obj_ptr, current_module, instance_remove,
                               anjay, obj_ptr, iid);
 }
@@ -251,6 +286,8 @@ int _anjay_dm_call_resource_write(anjay_t *anjay,
     if (result) {
         return result;
     }
+    _anjay_dm_invalidate_resource_cache(anjay, (*obj_ptr)->oid, iid);
+    _anjay_access_control_invalidate_index(anjay, (*obj_ptr)->oid);
     CHECKED_TAIL_CALL_HANDLER(anjay, obj_ptr, current_module, resource_write,
                               anjay, obj_ptr, iid, rid, riid, ctx);
 }
@@ -272,6 +309,8 @@ int _anjay_dm_call_resource_reset(anjay_t *anjay,
                                   anjay_rid_t rid,
                                   const anjay_dm_module_t *current_module) {
     dm_log(TRACE, "resource_reset /%u/%u/%u", (*obj_ptr)->oid, iid, rid);
+    _anjay_dm_invalidate_resource_cache(anjay, (*obj_ptr)->oid, iid);
+    _anjay_access_control_invalidate_index(anjay, (*obj_ptr)->oid);
     CHECKED_TAIL_CALL_HANDLER(anjay, obj_ptr, current_module, resource_reset,
                               anjay, obj_ptr, iid, rid);
 }
@@ -357,6 +396,10 @@ int _anjay_dm_call_transaction_rollback(
         const anjay_dm_object_def_t *const *obj_ptr,
         const anjay_dm_module_t *current_module) {
     dm_log(TRACE, "rollback_object /%u", (*obj_ptr)->oid);
+    _anjay_dm_invalidate_instance_cache(anjay, (*obj_ptr)->oid);
+    _anjay_dm_invalidate_resource_cache(anjay, (*obj_ptr)->oid,
+                                        ANJAY_ID_INVALID);
+    _anjay_access_control_invalidate_index(anjay, (*obj_ptr)->oid);
     CHECKED_TAIL_CALL_HANDLER(anjay, obj_ptr, current_module,
                               transaction_rollback, anjay, obj_ptr);
 }
@@ -16,6 +16,8 @@
 
 #include <anjay_config.h>
 
+#include <string.h>
+
 #include "../anjay_core.h"
 
 VISIBILITY_SOURCE_BEGIN
@@ -34,14 +36,52 @@ _anjay_dm_module_find_ptr(anjay_t *anjay, const anjay_dm_module_t *module) {
     return NULL;
 }
 
+static size_t module_lower_bound(const anjay_dm_t *dm,
+                                 const anjay_dm_module_t *module) {
+    size_t begin = 0;
+    size_t end = dm->modules_count;
+    while (begin < end) {
+        size_t mid = begin + (end - begin) / 2;
+        if ((uintptr_t) dm->modules_by_def[mid]->def < (uintptr_t) module) {
+            begin = mid + 1;
+        } else {
+            end = mid;
+        }
+    }
+    return begin;
+}
+
+anjay_dm_installed_module_t *
+_anjay_dm_module_find(anjay_t *anjay, const anjay_dm_module_t *module) {
+    if (!anjay) {
+        return NULL;
+    }
+    size_t index = module_lower_bound(&anjay->dm, module);
+    if (index < anjay->dm.modules_count
+            && anjay->dm.modules_by_def[index]->def == module) {
+        return anjay->dm.modules_by_def[index];
+    }
+    return NULL;
+}
+
 int _anjay_dm_module_install(anjay_t *anjay,
                              const anjay_dm_module_t *module,
                              void *arg) {
-    if (_anjay_dm_module_find_ptr(anjay, module)) {
+    if (_anjay_dm_module_find(anjay, module)) {
         anjay_log(ERROR, "module %p is already installed",
                   (const void *) module);
         return -1;
     }
+    anjay_dm_installed_module_t **new_index =
+            (anjay_dm_installed_module_t **) avs_realloc(
+                    anjay->dm.modules_by_def,
+                    (anjay->dm.modules_count + 1)
+                            * sizeof(*anjay->dm.modules_by_def));
+    if (!new_index) {
+        anjay_log(ERROR, "out of memory");
+        return -1;
+    }
+    anjay->dm.modules_by_def = new_index;
     AVS_LIST(anjay_dm_installed_module_t) new_entry =
             AVS_LIST_NEW_ELEMENT(anjay_dm_installed_module_t);
     if (!new_entry) {
@@ -51,6 +91,15 @@ int _anjay_dm_module_install(anjay_t *anjay,
     new_entry->def = module;
     new_entry->arg = arg;
     AVS_LIST_INSERT(&anjay->dm.modules, new_entry);
+
+    size_t index = module_lower_bound(&anjay->dm, module);
+    memmove(&anjay->dm.modules_by_def[index + 1],
+            &anjay->dm.modules_by_def[index],
+            (anjay->dm.modules_count - index)
+                    * sizeof(*anjay->dm.modules_by_def));
+    anjay->dm.modules_by_def[index] = new_entry;
+    ++anjay->dm.modules_count;
+    _anjay_dm_refresh_handler_dispatch(&anjay->dm);
     return 0;
 }
 
@@ -65,13 +114,21 @@ int _anjay_dm_module_uninstall(anjay_t *anjay,
     if ((*module_ptr)->def->deleter) {
         (*module_ptr)->def->deleter((*module_ptr)->arg);
     }
+    size_t index = module_lower_bound(&anjay->dm, module);
+    assert(index < anjay->dm.modules_count
+           && anjay->dm.modules_by_def[index] == *module_ptr);
+    memmove(&anjay->dm.modules_by_def[index],
+            &anjay->dm.modules_by_def[index + 1],
+            (anjay->dm.modules_count - index - 1)
+                    * sizeof(*anjay->dm.modules_by_def));
+    --anjay->dm.modules_count;
     AVS_LIST_DELETE(module_ptr);
+    _anjay_dm_refresh_handler_dispatch(&anjay->dm);
     return 0;
 }
 
 void *_anjay_dm_module_get_arg(anjay_t *anjay,
                                const anjay_dm_module_t *module) {
-    AVS_LIST(anjay_dm_installed_module_t) *entry_ptr =
-            _anjay_dm_module_find_ptr(anjay, module);
-    return entry_ptr ? (*entry_ptr)->arg : NULL;
+    anjay_dm_installed_module_t *entry = _anjay_dm_module_find(anjay, module);
+    return entry ? entry->arg : NULL;
 }
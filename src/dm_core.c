@@ -19,10 +19,12 @@
 #include <assert.h>
 #include <inttypes.h>
 #include <math.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 
 #include <anjay/core.h>
+#include <avsystem/commons/memory.h>
 #include <avsystem/commons/stream.h>
 #include <avsystem/commons/stream/stream_membuf.h>
 #include <avsystem/commons/stream_v_table.h>
@@ -70,6 +72,70 @@ static int validate_version(const anjay_dm_object_def_t *obj_def) {
     return 0;
 }
 
+/**
+ * Returns index of the first entry in anjay->dm.objects whose Object ID is not
+ * less than @p oid, or anjay->dm.objects_count if there is no such entry.
+ */
+static size_t object_lower_bound(const anjay_dm_t *dm, anjay_oid_t oid) {
+    size_t lo = 0;
+    size_t hi = dm->objects_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (dm->objects[mid].oid < oid) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static anjay_dm_object_entry_t *find_object_entry(anjay_dm_t *dm,
+                                                  anjay_oid_t oid) {
+    size_t index = object_lower_bound(dm, oid);
+    if (index < dm->objects_count && dm->objects[index].oid == oid) {
+        return &dm->objects[index];
+    }
+    return NULL;
+}
+
+static void clear_instance_cache(anjay_dm_object_entry_t *entry) {
+    avs_free(entry->cached_iids);
+    entry->cached_iids = NULL;
+    entry->cached_iids_count = 0;
+    entry->iids_cached = false;
+}
+
+void _anjay_dm_attributes_changed(anjay_t *anjay) {
+    ++anjay->dm.attributes_generation;
+}
+
+void _anjay_dm_invalidate_instance_cache(anjay_t *anjay, anjay_oid_t oid) {
+    ++anjay->dm.instances_generation;
+    if (!anjay->dm.cache_instance_lists) {
+        return;
+    }
+    anjay_dm_object_entry_t *entry = find_object_entry(&anjay->dm, oid);
+    if (entry) {
+        clear_instance_cache(entry);
+    }
+}
+
+static int ensure_objects_capacity(anjay_dm_t *dm) {
+    if (dm->objects_count < dm->objects_capacity) {
+        return 0;
+    }
+    size_t new_capacity = dm->objects_capacity ? 2 * dm->objects_capacity : 8;
+    anjay_dm_object_entry_t *new_objects = (anjay_dm_object_entry_t *)
+            avs_realloc(dm->objects, new_capacity * sizeof(*new_objects));
+    if (!new_objects) {
+        return -1;
+    }
+    dm->objects = new_objects;
+    dm->objects_capacity = new_capacity;
+    return 0;
+}
+
 int anjay_register_object(anjay_t *anjay,
                           const anjay_dm_object_def_t *const *def_ptr) {
     if (!def_ptr || !*def_ptr) {
@@ -88,36 +154,31 @@ int anjay_register_object(anjay_t *anjay,
         return -1;
     }
 
-    AVS_LIST(const anjay_dm_object_def_t *const *) *obj_iter;
-
-    AVS_LIST_FOREACH_PTR(obj_iter, &anjay->dm.objects) {
-        assert(*obj_iter && **obj_iter);
-
-        if ((***obj_iter)->oid >= (*def_ptr)->oid) {
-            break;
-        }
-    }
-
-    if (*obj_iter && (***obj_iter)->oid == (*def_ptr)->oid) {
-        dm_log(ERROR, "data model object /%u already registered",
-               (*def_ptr)->oid);
+    const anjay_oid_t oid = (*def_ptr)->oid;
+    size_t index = object_lower_bound(&anjay->dm, oid);
+    if (index < anjay->dm.objects_count
+            && anjay->dm.objects[index].oid == oid) {
+        dm_log(ERROR, "data model object /%u already registered", oid);
         return -1;
     }
 
-    AVS_LIST(const anjay_dm_object_def_t *const *) new_elem =
-            AVS_LIST_NEW_ELEMENT(const anjay_dm_object_def_t *const *);
-    if (!new_elem) {
+    if (ensure_objects_capacity(&anjay->dm)) {
         dm_log(ERROR, "out of memory");
         return -1;
     }
 
-    *new_elem = def_ptr;
-    AVS_LIST_INSERT(obj_iter, new_elem);
+    memmove(&anjay->dm.objects[index + 1], &anjay->dm.objects[index],
+            (anjay->dm.objects_count - index) * sizeof(*anjay->dm.objects));
+    anjay->dm.objects[index] = (anjay_dm_object_entry_t) {
+        .oid = oid,
+        .def_ptr = def_ptr
+    };
+    ++anjay->dm.objects_count;
+    ++anjay->dm.instances_generation;
 
-    dm_log(INFO, "successfully registered object /%u", (**new_elem)->oid);
-    if (anjay_notify_instances_changed(anjay, (**new_elem)->oid)) {
-        dm_log(WARNING, "anjay_notify_instances_changed() failed on /%u",
-               (**new_elem)->oid);
+    dm_log(INFO, "successfully registered object /%u", oid);
+    if (anjay_notify_instances_changed(anjay, oid)) {
+        dm_log(WARNING, "anjay_notify_instances_changed() failed on /%u", oid);
     }
     if (anjay_schedule_registration_update(anjay, ANJAY_SSID_ANY)) {
         dm_log(WARNING, "anjay_schedule_registration_update() failed");
@@ -148,20 +209,14 @@ int anjay_unregister_object(anjay_t *anjay,
         return -1;
     }
 
-    AVS_LIST(const anjay_dm_object_def_t *const *) *obj_iter;
-    AVS_LIST_FOREACH_PTR(obj_iter, &anjay->dm.objects) {
-        assert(*obj_iter && **obj_iter);
-        if ((***obj_iter)->oid >= (*def_ptr)->oid) {
-            break;
-        }
-    }
-
-    if (!*obj_iter || (***obj_iter)->oid != (*def_ptr)->oid) {
+    size_t index = object_lower_bound(&anjay->dm, (*def_ptr)->oid);
+    if (index >= anjay->dm.objects_count
+            || anjay->dm.objects[index].oid != (*def_ptr)->oid) {
         dm_log(ERROR, "object %" PRIu16 " is not currently registered",
                (*def_ptr)->oid);
         return -1;
     }
-    if (**obj_iter != def_ptr) {
+    if (anjay->dm.objects[index].def_ptr != def_ptr) {
         dm_log(ERROR,
                "object %" PRIu16 " that is registered is not "
                "the same as the object passed for unregister",
@@ -169,9 +224,16 @@ int anjay_unregister_object(anjay_t *anjay,
         return -1;
     }
 
-    AVS_LIST(const anjay_dm_object_def_t *const *) detached =
-            AVS_LIST_DETACH(obj_iter);
+    clear_instance_cache(&anjay->dm.objects[index]);
+    _anjay_dm_invalidate_resource_cache(anjay, (*def_ptr)->oid,
+                                        ANJAY_ID_INVALID);
+    _anjay_access_control_invalidate_index(anjay, (*def_ptr)->oid);
+    --anjay->dm.objects_count;
+    memmove(&anjay->dm.objects[index], &anjay->dm.objects[index + 1],
+            (anjay->dm.objects_count - index) * sizeof(*anjay->dm.objects));
+    ++anjay->dm.instances_generation;
 
+    AVS_LIST(const anjay_dm_object_def_t *const *) *obj_iter;
     AVS_LIST_FOREACH_PTR(obj_iter,
                          &anjay->transaction_state.objs_in_transaction) {
         if (**obj_iter >= def_ptr) {
@@ -207,7 +269,6 @@ int anjay_unregister_object(anjay_t *anjay,
                                  (*def_ptr)->oid);
 #endif // WITH_BOOTSTRAP
     dm_log(INFO, "successfully unregistered object /%u", (*def_ptr)->oid);
-    AVS_LIST_DELETE(&detached);
     if (anjay_schedule_registration_update(anjay, ANJAY_SSID_ANY)) {
         dm_log(WARNING, "anjay_schedule_registration_update() failed");
     }
@@ -220,20 +281,34 @@ void _anjay_dm_cleanup(anjay_t *anjay) {
             anjay->dm.modules->def->deleter(anjay->dm.modules->arg);
         }
     }
-
-    AVS_LIST_CLEAR(&anjay->dm.objects);
+    avs_free(anjay->dm.modules_by_def);
+    anjay->dm.modules_by_def = NULL;
+    anjay->dm.modules_count = 0;
+    _anjay_dm_refresh_handler_dispatch(&anjay->dm);
+    _anjay_dm_invalidate_resource_cache(anjay, ANJAY_ID_INVALID,
+                                        ANJAY_ID_INVALID);
+    avs_free(anjay->dm.resource_cache);
+    anjay->dm.resource_cache = NULL;
+    anjay->dm.resource_cache_capacity = 0;
+
+    for (size_t i = 0; i < anjay->dm.objects_count; ++i) {
+        clear_instance_cache(&anjay->dm.objects[i]);
+    }
+    avs_free(anjay->dm.objects);
+    anjay->dm.objects = NULL;
+    anjay->dm.objects_count = 0;
+    anjay->dm.objects_capacity = 0;
 }
 
 const anjay_dm_object_def_t *const *
 _anjay_dm_find_object_by_oid(anjay_t *anjay, anjay_oid_t oid) {
-    AVS_LIST(const anjay_dm_object_def_t *const *) obj;
-    AVS_LIST_FOREACH(obj, anjay->dm.objects) {
-        assert(*obj && **obj);
-        if ((**obj)->oid == oid) {
-            return *obj;
-        }
+    size_t index = object_lower_bound(&anjay->dm, oid);
+    if (index < anjay->dm.objects_count
+            && anjay->dm.objects[index].oid == oid) {
+        assert(anjay->dm.objects[index].def_ptr
+               && *anjay->dm.objects[index].def_ptr);
+        return anjay->dm.objects[index].def_ptr;
     }
-
     return NULL;
 }
 
@@ -518,6 +593,7 @@ static int invoke_action(anjay_t *anjay,
     case ANJAY_ACTION_DELETE:
         return invoke_transactional_action(anjay, obj, request, in_ctx);
     case ANJAY_ACTION_WRITE_ATTRIBUTES:
+        _anjay_dm_attributes_changed(anjay);
         return _anjay_dm_write_attributes(anjay, obj, request);
     case ANJAY_ACTION_EXECUTE:
         assert(in_ctx);
@@ -579,7 +655,9 @@ int _anjay_dm_perform_action(anjay_t *anjay, const anjay_request_t *request) {
         result = ANJAY_ERR_UNAUTHORIZED;
     }
     if (!result) {
+        _anjay_dm_resource_cache_begin(anjay);
         result = invoke_action(anjay, obj, request, in_ctx);
+        _anjay_dm_resource_cache_end(anjay);
     }
     int destroy_result = _anjay_input_ctx_destroy(&in_ctx);
     return result ? result : destroy_result;
@@ -588,19 +666,27 @@ int _anjay_dm_perform_action(anjay_t *anjay, const anjay_request_t *request) {
 int _anjay_dm_foreach_object(anjay_t *anjay,
                              anjay_dm_foreach_object_handler_t *handler,
                              void *data) {
-    AVS_LIST(const anjay_dm_object_def_t *const *) obj;
-    AVS_LIST_FOREACH(obj, anjay->dm.objects) {
-        assert(*obj && **obj);
-
-        int result = handler(anjay, *obj, data);
+    // NOTE: the handler may register or unregister Objects, which may
+    // reallocate the array; hence we look up the next Object by its ID
+    // instead of iterating over a pointer or a fixed index.
+    size_t index = 0;
+    while (index < anjay->dm.objects_count) {
+        const anjay_dm_object_def_t *const *obj =
+                anjay->dm.objects[index].def_ptr;
+        const anjay_oid_t oid = anjay->dm.objects[index].oid;
+        assert(obj && *obj);
+
+        int result = handler(anjay, obj, data);
         if (result == ANJAY_FOREACH_BREAK) {
-            dm_log(TRACE, "foreach_object: break on /%u", (**obj)->oid);
+            dm_log(TRACE, "foreach_object: break on /%u", oid);
             return 0;
         } else if (result) {
-            dm_log(DEBUG, "foreach_object_handler failed for /%u (%d)",
-                   (**obj)->oid, result);
+            dm_log(DEBUG, "foreach_object_handler failed for /%u (%d)", oid,
+                   result);
             return result;
         }
+        // oid + 1 cannot overflow, as ANJAY_ID_INVALID is never registered
+        index = object_lower_bound(&anjay->dm, (anjay_oid_t) (oid + 1));
     }
 
     return 0;
@@ -731,9 +817,98 @@ static int instance_present_clb(anjay_t *anjay,
     return ANJAY_FOREACH_CONTINUE;
 }
 
+typedef struct {
+    anjay_iid_t *iids;
+    size_t count;
+    size_t capacity;
+} iid_array_t;
+
+static int collect_iid_clb(anjay_t *anjay,
+                           const anjay_dm_object_def_t *const *obj,
+                           anjay_iid_t iid,
+                           void *array_) {
+    (void) anjay;
+    (void) obj;
+    iid_array_t *array = (iid_array_t *) array_;
+    if (array->count >= array->capacity) {
+        size_t new_capacity = array->capacity ? 2 * array->capacity : 8;
+        anjay_iid_t *new_iids = (anjay_iid_t *) avs_realloc(
+                array->iids, new_capacity * sizeof(*new_iids));
+        if (!new_iids) {
+            dm_log(ERROR, "out of memory");
+            return -1;
+        }
+        array->iids = new_iids;
+        array->capacity = new_capacity;
+    }
+    array->iids[array->count++] = iid;
+    return 0;
+}
+
+static int refresh_instance_cache(anjay_t *anjay,
+                                  const anjay_dm_object_def_t *const *obj_ptr,
+                                  anjay_dm_object_entry_t **entry_ptr) {
+    iid_array_t array = { NULL, 0, 0 };
+    int result = _anjay_dm_foreach_instance(anjay, obj_ptr, collect_iid_clb,
+                                            &array);
+    // the list_instances handler might have (un)registered some Objects,
+    // invalidating the entry pointer, so we need to look it up again
+    *entry_ptr = find_object_entry(&anjay->dm, (*obj_ptr)->oid);
+    if (!result && (!*entry_ptr || (*entry_ptr)->def_ptr != obj_ptr)) {
+        result = ANJAY_ERR_NOT_FOUND;
+    }
+    if (result) {
+        avs_free(array.iids);
+        return result;
+    }
+    clear_instance_cache(*entry_ptr);
+    (*entry_ptr)->cached_iids = array.iids;
+    (*entry_ptr)->cached_iids_count = array.count;
+    (*entry_ptr)->iids_cached = true;
+    return 0;
+}
+
+static int cached_instance_present(anjay_t *anjay,
+                                   const anjay_dm_object_def_t *const *obj_ptr,
+                                   anjay_iid_t iid) {
+    anjay_dm_object_entry_t *entry =
+            find_object_entry(&anjay->dm, (*obj_ptr)->oid);
+    if (!entry || entry->def_ptr != obj_ptr) {
+        dm_log(ERROR, "Object /%u is not registered", (*obj_ptr)->oid);
+        return ANJAY_ERR_NOT_FOUND;
+    }
+    if (!entry->iids_cached) {
+        int result = refresh_instance_cache(anjay, obj_ptr, &entry);
+        if (result) {
+            return result;
+        }
+    }
+    size_t lo = 0;
+    size_t hi = entry->cached_iids_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (entry->cached_iids[mid] < iid) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo < entry->cached_iids_count && entry->cached_iids[lo] == iid)
+                   ? 1
+                   : 0;
+}
+
 int _anjay_dm_instance_present(anjay_t *anjay,
                                const anjay_dm_object_def_t *const *obj_ptr,
                                anjay_iid_t iid) {
+    if (_anjay_dm_handler_implemented(anjay, obj_ptr, NULL,
+                                      offsetof(anjay_dm_handlers_t,
+                                               instance_present))) {
+        return _anjay_dm_call_instance_present(anjay, obj_ptr, iid, NULL);
+    }
+    if (anjay->dm.cache_instance_lists) {
+        return cached_instance_present(anjay, obj_ptr, iid);
+    }
     instance_present_args_t args = {
         .iid_to_find = iid,
         .found = false
@@ -803,16 +978,11 @@ void anjay_dm_emit_res(anjay_dm_resource_list_ctx_t *ctx,
     }
 }
 
-int _anjay_dm_foreach_resource(anjay_t *anjay,
+static int list_resources_impl(anjay_t *anjay,
                                const anjay_dm_object_def_t *const *obj,
                                anjay_iid_t iid,
                                anjay_dm_foreach_resource_handler_t *handler,
                                void *data) {
-    if (!obj) {
-        dm_log(ERROR, "attempt to iterate through NULL Object");
-        return -1;
-    }
-
     anjay_dm_resource_list_ctx_t ctx = {
         .anjay = anjay,
         .obj = obj,
@@ -831,6 +1001,238 @@ int _anjay_dm_foreach_resource(anjay_t *anjay,
     return ctx.result == ANJAY_FOREACH_BREAK ? 0 : ctx.result;
 }
 
+static bool resource_cache_active(anjay_t *anjay) {
+    return anjay->dm.cache_resource_lists && anjay->dm.resource_cache_depth > 0;
+}
+
+void _anjay_dm_resource_cache_begin(anjay_t *anjay) {
+    ++anjay->dm.resource_cache_depth;
+}
+
+static size_t resource_cache_lower_bound(const anjay_dm_t *dm,
+                                         anjay_oid_t oid,
+                                         anjay_iid_t iid) {
+    size_t begin = 0;
+    size_t end = dm->resource_cache_count;
+    while (begin < end) {
+        size_t mid = begin + (end - begin) / 2;
+        const anjay_dm_cached_resource_list_t *entry = dm->resource_cache[mid];
+        if (entry->oid < oid || (entry->oid == oid && entry->iid < iid)) {
+            begin = mid + 1;
+        } else {
+            end = mid;
+        }
+    }
+    return begin;
+}
+
+static void release_resource_list(anjay_dm_cached_resource_list_t *entry) {
+    if (entry->pins) {
+        entry->detached = true;
+    } else {
+        avs_free(entry->resources);
+        avs_free(entry);
+    }
+}
+
+void _anjay_dm_resource_cache_end(anjay_t *anjay) {
+    assert(anjay->dm.resource_cache_depth > 0);
+    if (!--anjay->dm.resource_cache_depth) {
+        _anjay_dm_invalidate_resource_cache(anjay, ANJAY_ID_INVALID,
+                                            ANJAY_ID_INVALID);
+    }
+}
+
+void _anjay_dm_invalidate_resource_cache(anjay_t *anjay,
+                                         anjay_oid_t oid,
+                                         anjay_iid_t iid) {
+    anjay_dm_t *dm = &anjay->dm;
+    size_t begin = 0;
+    size_t end = dm->resource_cache_count;
+    if (oid != ANJAY_ID_INVALID) {
+        begin = resource_cache_lower_bound(
+                dm, oid, iid == ANJAY_ID_INVALID ? 0 : iid);
+        end = begin;
+        while (end < dm->resource_cache_count
+               && dm->resource_cache[end]->oid == oid
+               && (iid == ANJAY_ID_INVALID
+                   || dm->resource_cache[end]->iid == iid)) {
+            ++end;
+        }
+    }
+    if (begin == end) {
+        return;
+    }
+    for (size_t i = begin; i < end; ++i) {
+        release_resource_list(dm->resource_cache[i]);
+    }
+    memmove(&dm->resource_cache[begin], &dm->resource_cache[end],
+            (dm->resource_cache_count - end) * sizeof(*dm->resource_cache));
+    dm->resource_cache_count -= end - begin;
+}
+
+typedef struct {
+    anjay_dm_cached_resource_t *resources;
+    size_t count;
+    size_t capacity;
+} resource_array_t;
+
+static int record_resource_clb(anjay_t *anjay,
+                               const anjay_dm_object_def_t *const *obj,
+                               anjay_iid_t iid,
+                               anjay_rid_t rid,
+                               anjay_dm_resource_kind_t kind,
+                               anjay_dm_resource_presence_t presence,
+                               void *array_) {
+    (void) anjay;
+    (void) obj;
+    (void) iid;
+    resource_array_t *array = (resource_array_t *) array_;
+    if (array->count >= array->capacity) {
+        size_t new_capacity = array->capacity ? 2 * array->capacity : 8;
+        anjay_dm_cached_resource_t *new_resources =
+                (anjay_dm_cached_resource_t *) avs_realloc(
+                        array->resources,
+                        new_capacity * sizeof(*new_resources));
+        if (!new_resources) {
+            dm_log(ERROR, "out of memory");
+            return -1;
+        }
+        array->resources = new_resources;
+        array->capacity = new_capacity;
+    }
+    array->resources[array->count++] = (anjay_dm_cached_resource_t) {
+        .rid = rid,
+        .kind = kind,
+        .presence = presence
+    };
+    return 0;
+}
+
+static int insert_resource_list(anjay_dm_t *dm,
+                                size_t index,
+                                anjay_dm_cached_resource_list_t *entry) {
+    if (dm->resource_cache_count >= dm->resource_cache_capacity) {
+        size_t new_capacity =
+                dm->resource_cache_capacity ? 2 * dm->resource_cache_capacity
+                                            : 8;
+        anjay_dm_cached_resource_list_t **new_cache =
+                (anjay_dm_cached_resource_list_t **) avs_realloc(
+                        dm->resource_cache,
+                        new_capacity * sizeof(*new_cache));
+        if (!new_cache) {
+            return -1;
+        }
+        dm->resource_cache = new_cache;
+        dm->resource_cache_capacity = new_capacity;
+    }
+    memmove(&dm->resource_cache[index + 1], &dm->resource_cache[index],
+            (dm->resource_cache_count - index) * sizeof(*dm->resource_cache));
+    dm->resource_cache[index] = entry;
+    ++dm->resource_cache_count;
+    return 0;
+}
+
+static anjay_dm_cached_resource_list_t *
+get_cached_resource_list(anjay_t *anjay,
+                         const anjay_dm_object_def_t *const *obj,
+                         anjay_iid_t iid,
+                         int *out_result) {
+    size_t index = resource_cache_lower_bound(&anjay->dm, (*obj)->oid, iid);
+    if (index < anjay->dm.resource_cache_count
+            && anjay->dm.resource_cache[index]->oid == (*obj)->oid
+            && anjay->dm.resource_cache[index]->iid == iid) {
+        *out_result = 0;
+        return anjay->dm.resource_cache[index];
+    }
+
+    resource_array_t array = { NULL, 0, 0 };
+    if ((*out_result = list_resources_impl(anjay, obj, iid,
+                                           record_resource_clb, &array))) {
+        avs_free(array.resources);
+        return NULL;
+    }
+    anjay_dm_cached_resource_list_t *entry =
+            (anjay_dm_cached_resource_list_t *) avs_malloc(sizeof(*entry));
+    if (!entry) {
+        dm_log(ERROR, "out of memory");
+        avs_free(array.resources);
+        *out_result = -1;
+        return NULL;
+    }
+    *entry = (anjay_dm_cached_resource_list_t) {
+        .oid = (*obj)->oid,
+        .iid = iid,
+        .count = array.count,
+        .resources = array.resources
+    };
+    // list_resources handler might have modified the cache, so the position
+    // needs to be recalculated
+    index = resource_cache_lower_bound(&anjay->dm, (*obj)->oid, iid);
+    if ((index < anjay->dm.resource_cache_count
+         && anjay->dm.resource_cache[index]->oid == (*obj)->oid
+         && anjay->dm.resource_cache[index]->iid == iid)
+            || insert_resource_list(&anjay->dm, index, entry)) {
+        // the list is still usable for this single iteration
+        dm_log(DEBUG, "could not cache Resource list for /%u/%u",
+               (*obj)->oid, iid);
+        entry->detached = true;
+    }
+    return entry;
+}
+
+static int
+foreach_cached_resource(anjay_t *anjay,
+                        const anjay_dm_object_def_t *const *obj,
+                        anjay_iid_t iid,
+                        anjay_dm_foreach_resource_handler_t *handler,
+                        void *data) {
+    int result;
+    anjay_dm_cached_resource_list_t *entry =
+            get_cached_resource_list(anjay, obj, iid, &result);
+    if (!entry) {
+        return result;
+    }
+    // the entry is pinned, so that it is not freed even if the handler
+    // invalidates the cache
+    ++entry->pins;
+    result = 0;
+    for (size_t i = 0; i < entry->count; ++i) {
+        const anjay_dm_cached_resource_t *res = &entry->resources[i];
+        result = handler(anjay, obj, iid, res->rid, res->kind, res->presence,
+                         data);
+        if (result == ANJAY_FOREACH_BREAK) {
+            dm_log(TRACE, "foreach_resource: break on /%u/%u/%u", (*obj)->oid,
+                   iid, res->rid);
+            result = 0;
+            break;
+        } else if (result) {
+            dm_log(DEBUG, "foreach_resource_handler failed for /%u/%u/%u (%d)",
+                   (*obj)->oid, iid, res->rid, result);
+            break;
+        }
+    }
+    if (!--entry->pins && entry->detached) {
+        release_resource_list(entry);
+    }
+    return result;
+}
+
+int _anjay_dm_foreach_resource(anjay_t *anjay,
+                               const anjay_dm_object_def_t *const *obj,
+                               anjay_iid_t iid,
+                               anjay_dm_foreach_resource_handler_t *handler,
+                               void *data) {
+    if (!obj) {
+        dm_log(ERROR, "attempt to iterate through NULL Object");
+        return -1;
+    }
+    if (resource_cache_active(anjay)) {
+        return foreach_cached_resource(anjay, obj, iid, handler, data);
+    }
+    return list_resources_impl(anjay, obj, iid, handler, data);
+}
+
 typedef struct {
     anjay_rid_t rid_to_find;
     anjay_dm_resource_kind_t kind;
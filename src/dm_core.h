@@ -31,18 +31,146 @@
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
 
+/**
+ * Number of handler slots in @ref anjay_dm_handlers_t. A slot index is the
+ * offset of a given handler field divided by the size of a function pointer.
+ */
+#define ANJAY_DM_HANDLER_SLOTS \
+    (sizeof(anjay_dm_handlers_t) / sizeof(void (*)(void)))
+
 typedef struct {
     const anjay_dm_module_t *def;
     void *arg;
+    /**
+     * For each handler slot: overlay handlers of the first module further down
+     * the module list that implements it, or NULL if there is no such module.
+     * Used when calling the underlying handler on behalf of this module.
+     */
+    const anjay_dm_handlers_t *next_overlay[ANJAY_DM_HANDLER_SLOTS];
 } anjay_dm_installed_module_t;
 
+typedef struct {
+    anjay_oid_t oid;
+    const anjay_dm_object_def_t *const *def_ptr;
+    /**
+     * Sorted array of Instance IDs, as last returned by the list_instances
+     * handler. Only used if @ref anjay_dm_t::cache_instance_lists is set, and
+     * only valid if <c>iids_cached</c> is true.
+     */
+    anjay_iid_t *cached_iids;
+    size_t cached_iids_count;
+    bool iids_cached;
+} anjay_dm_object_entry_t;
+
+typedef struct {
+    anjay_rid_t rid;
+    anjay_dm_resource_kind_t kind;
+    anjay_dm_resource_presence_t presence;
+} anjay_dm_cached_resource_t;
+
+typedef struct {
+    anjay_oid_t oid;
+    anjay_iid_t iid;
+    // number of iterations currently walking through this entry
+    size_t pins;
+    // true if the entry has been invalidated while pinned; it is no longer
+    // referenced by the cache and is freed when the last iteration finishes
+    bool detached;
+    size_t count;
+    anjay_dm_cached_resource_t *resources;
+} anjay_dm_cached_resource_list_t;
+
 struct anjay_dm {
-    AVS_LIST(const anjay_dm_object_def_t *const *) objects;
+    /**
+     * Registered Objects, sorted by Object ID. Kept as a flat array (instead
+     * of a list) so that @ref _anjay_dm_find_object_by_oid may perform a
+     * binary search, which is on the hot path of every request.
+     */
+    anjay_dm_object_entry_t *objects;
+    size_t objects_count;
+    size_t objects_capacity;
     AVS_LIST(anjay_dm_installed_module_t) modules;
+    /**
+     * Elements of @ref anjay_dm_t::modules, sorted by the address of their
+     * module definition, so that @ref _anjay_dm_module_find may perform a
+     * binary search when resolving handlers on behalf of a module.
+     */
+    anjay_dm_installed_module_t **modules_by_def;
+    size_t modules_count;
+    /**
+     * For each handler slot: overlay handlers of the most recently installed
+     * module that implements it, or NULL if there is no such module.
+     */
+    const anjay_dm_handlers_t *overlay[ANJAY_DM_HANDLER_SLOTS];
+    bool cache_instance_lists;
+    /**
+     * Incremented whenever the set of registered Objects, or the set of
+     * Instances of any of them, might have changed. If
+     * @ref anjay_dm_t::cache_instance_lists is set, this allows the
+     * registration logic to tell in constant time whether the list of Objects
+     * and Instances sent in the last Register or Update is still up to date.
+     */
+    uint64_t instances_generation;
+    /**
+     * Incremented whenever notification attributes might have changed in a
+     * way other than through a change of the set of Instances, i.e. on
+     * Write-Attributes, changes to the Server Object, or by a module calling
+     * @ref _anjay_dm_attributes_changed.
+     */
+    uint64_t attributes_generation;
+
+    bool cache_resource_lists;
+    /**
+     * Number of currently active (nested) caching periods, as started by
+     * @ref _anjay_dm_resource_cache_begin. Resource lists are only cached if
+     * this is nonzero.
+     */
+    unsigned resource_cache_depth;
+    /**
+     * Cached Resource lists, sorted by Object ID and Instance ID. Invalidated
+     * entries are removed immediately, so there is at most one entry for each
+     * Object Instance.
+     */
+    anjay_dm_cached_resource_list_t **resource_cache;
+    size_t resource_cache_count;
+    size_t resource_cache_capacity;
 };
 
 void _anjay_dm_cleanup(anjay_t *anjay);
 
+/**
+ * Drops the cached list of Instance IDs of a given Object, if any, and bumps
+ * @ref anjay_dm_t::instances_generation. MUST be called whenever the set of
+ * Instances of that Object might have changed.
+ */
+void _anjay_dm_invalidate_instance_cache(anjay_t *anjay, anjay_oid_t oid);
+
+/**
+ * Starts a period (e.g. processing of a single request or notification cycle)
+ * during which results of list_resources handlers may be cached, if enabled in
+ * the configuration. Calls may be nested; each call MUST be matched by a call
+ * to @ref _anjay_dm_resource_cache_end, which drops the cache once the
+ * outermost period is finished.
+ */
+void _anjay_dm_resource_cache_begin(anjay_t *anjay);
+
+void _anjay_dm_resource_cache_end(anjay_t *anjay);
+
+/**
+ * Invalidates cached Resource lists of a given Object Instance, or of all
+ * Instances of a given Object if @p iid is <c>ANJAY_ID_INVALID</c>.
+ */
+void _anjay_dm_invalidate_resource_cache(anjay_t *anjay,
+                                         anjay_oid_t oid,
+                                         anjay_iid_t iid);
+
+/**
+ * Recalculates the flattened overlay dispatch tables (@ref anjay_dm_t::overlay
+ * and @ref anjay_dm_installed_module_t::next_overlay). MUST be called after
+ * each modification of the module list.
+ */
+void _anjay_dm_refresh_handler_dispatch(anjay_dm_t *dm);
+
 typedef struct {
     bool has_min_period;
     bool has_max_period;
@@ -106,6 +234,9 @@ static inline int _anjay_dm_map_present_result(int result) {
 AVS_LIST(anjay_dm_installed_module_t) *
 _anjay_dm_module_find_ptr(anjay_t *anjay, const anjay_dm_module_t *module);
 
+anjay_dm_installed_module_t *
+_anjay_dm_module_find(anjay_t *anjay, const anjay_dm_module_t *module);
+
 int _anjay_dm_select_free_iid(anjay_t *anjay,
                               const anjay_dm_object_def_t *const *obj,
                               anjay_iid_t *new_iid_ptr);
@@ -38,6 +38,38 @@ AVS_STATIC_ASSERT(offsetof(anjay_etag_t, value)
 AVS_STATIC_ASSERT(AVS_ALIGNOF(anjay_etag_t) == AVS_ALIGNOF(avs_coap_etag_t),
                   coap_etag_alignment_compatible);
 
+typedef struct {
+    avs_coap_exchange_id_t exchange_id;
+    // offset of the next byte expected in response to this request
+    size_t offset;
+    // SIZE_MAX for the initial request, before the block size is known
+    size_t end_offset;
+} coap_block_request_t;
+
+typedef struct {
+    size_t offset;
+    size_t size;
+    uint8_t data[];
+} coap_reordered_block_t;
+
+typedef struct {
+    // maximum number of blocks requested at once; 0 or 1 disables the window
+    size_t max_blocks;
+    // block size used for further requests; 0 until the first response
+    size_t block_size;
+    size_t next_request_offset;
+    // SIZE_MAX until the last block is received
+    size_t end_offset;
+    // offset of the first block that could not be retrieved, SIZE_MAX if none
+    size_t failed_offset;
+    anjay_download_status_t failed_status;
+
+    AVS_LIST(coap_block_request_t) block_requests;
+    // blocks received out of order, sorted by offset
+    AVS_LIST(coap_reordered_block_t) reordered_blocks;
+    avs_sched_handle_t job_request_blocks;
+} coap_block_window_t;
+
 typedef struct {
     anjay_download_ctx_common_t common;
 
@@ -58,6 +90,7 @@ typedef struct {
     avs_coap_udp_tx_params_t tx_params;
 #endif // WITH_AVS_COAP_UDP
     avs_coap_ctx_t *coap;
+    coap_block_window_t window;
 
     avs_sched_handle_t job_start;
 } anjay_coap_download_ctx_t;
@@ -81,6 +114,9 @@ static void cleanup_coap_context(avs_sched_t *sched, const void *args_) {
 static void cleanup_coap_transfer(AVS_LIST(anjay_download_ctx_t) *ctx_ptr) {
     anjay_coap_download_ctx_t *ctx = (anjay_coap_download_ctx_t *) *ctx_ptr;
     avs_sched_del(&ctx->job_start);
+    avs_sched_del(&ctx->window.job_request_blocks);
+    AVS_LIST_CLEAR(&ctx->window.block_requests);
+    AVS_LIST_CLEAR(&ctx->window.reordered_blocks);
     _anjay_url_cleanup(&ctx->uri);
 
     anjay_t *anjay = _anjay_downloader_get_anjay(ctx->dl);
@@ -124,9 +160,18 @@ static inline bool etag_matches(const avs_coap_etag_t *a,
     return a->size == b->size && !memcmp(a->bytes, b->bytes, a->size);
 }
 
+static void cancel_block_requests(anjay_coap_download_ctx_t *dl_ctx) {
+    while (dl_ctx->window.block_requests) {
+        avs_coap_exchange_id_t id = dl_ctx->window.block_requests->exchange_id;
+        AVS_LIST_DELETE(&dl_ctx->window.block_requests);
+        avs_coap_exchange_cancel(dl_ctx->coap, id);
+    }
+}
+
 static void abort_download_transfer(anjay_coap_download_ctx_t *dl_ctx,
                                     anjay_download_status_t status) {
     avs_coap_exchange_cancel(dl_ctx->coap, dl_ctx->exchange_id);
+    cancel_block_requests(dl_ctx);
 
     AVS_LIST(anjay_download_ctx_t) *dl_ctx_ptr =
             _anjay_downloader_find_ctx_ptr_by_id(dl_ctx->dl, dl_ctx->common.id);
@@ -135,6 +180,238 @@ static void abort_download_transfer(anjay_coap_download_ctx_t *dl_ctx,
     }
 }
 
+static int check_response_etag(anjay_coap_download_ctx_t *dl_ctx,
+                               const avs_coap_response_header_t *hdr,
+                               avs_coap_etag_t *out_etag) {
+    if (read_etag(hdr, out_etag)) {
+        dl_log(DEBUG, "could not parse CoAP response");
+        abort_download_transfer(dl_ctx,
+                                _anjay_download_status_failed(
+                                        avs_errno(AVS_EPROTO)));
+        return -1;
+    }
+    // NOTE: avs_coap normally performs ETag validation for blockwise
+    // transfers. However, if we resumed the download from persistence
+    // information, avs_coap wouldn't know about the ETag used before, and
+    // would blindly accept any ETag. The same applies to blocks requested in
+    // parallel, as each of them is a separate exchange.
+    if (dl_ctx->etag.size == 0) {
+        dl_ctx->etag = *out_etag;
+    } else if (!etag_matches(&dl_ctx->etag, out_etag)) {
+        dl_log(DEBUG, "remote resource expired, aborting download");
+        abort_download_transfer(dl_ctx, _anjay_download_status_expired());
+        return -1;
+    }
+    return 0;
+}
+
+static void request_blocks_job(avs_sched_t *sched, const void *id_ptr);
+
+static int deliver_data(anjay_coap_download_ctx_t *dl_ctx,
+                        size_t offset,
+                        const uint8_t *data,
+                        size_t size) {
+    assert(offset <= dl_ctx->bytes_downloaded);
+    if (offset + size <= dl_ctx->bytes_downloaded) {
+        return 0;
+    }
+    const size_t skip = dl_ctx->bytes_downloaded - offset;
+    avs_error_t err = dl_ctx->common.on_next_block(
+            _anjay_downloader_get_anjay(dl_ctx->dl), data + skip, size - skip,
+            (const anjay_etag_t *) &dl_ctx->etag, dl_ctx->common.user_data);
+    if (avs_is_err(err)) {
+        abort_download_transfer(dl_ctx, _anjay_download_status_failed(err));
+        return -1;
+    }
+    dl_ctx->bytes_downloaded += size - skip;
+    return 0;
+}
+
+static int store_reordered_block(anjay_coap_download_ctx_t *dl_ctx,
+                                 size_t offset,
+                                 const uint8_t *data,
+                                 size_t size) {
+    AVS_LIST(coap_reordered_block_t) *insert_ptr;
+    AVS_LIST_FOREACH_PTR(insert_ptr, &dl_ctx->window.reordered_blocks) {
+        if ((*insert_ptr)->offset > offset) {
+            break;
+        }
+    }
+    AVS_LIST(coap_reordered_block_t) block =
+            (AVS_LIST(coap_reordered_block_t)) AVS_LIST_NEW_BUFFER(
+                    sizeof(coap_reordered_block_t) + size);
+    if (!block) {
+        dl_log(ERROR, "out of memory");
+        abort_download_transfer(dl_ctx, _anjay_download_status_failed(
+                                                avs_errno(AVS_ENOMEM)));
+        return -1;
+    }
+    block->offset = offset;
+    block->size = size;
+    memcpy(block->data, data, size);
+    AVS_LIST_INSERT(insert_ptr, block);
+    return 0;
+}
+
+/**
+ * Passes the chunk to the user if it is the next one in order, followed by
+ * any buffered chunks it makes contiguous. Chunks received ahead of time are
+ * buffered. Returns a negative value if the download has been aborted.
+ */
+static int accept_chunk(anjay_coap_download_ctx_t *dl_ctx,
+                        size_t offset,
+                        const uint8_t *data,
+                        size_t size) {
+    if (offset > dl_ctx->bytes_downloaded) {
+        return store_reordered_block(dl_ctx, offset, data, size);
+    }
+    if (deliver_data(dl_ctx, offset, data, size)) {
+        return -1;
+    }
+    AVS_LIST(coap_reordered_block_t) *blocks = &dl_ctx->window.reordered_blocks;
+    while (*blocks && (*blocks)->offset <= dl_ctx->bytes_downloaded) {
+        if (deliver_data(dl_ctx, (*blocks)->offset, (*blocks)->data,
+                         (*blocks)->size)) {
+            return -1;
+        }
+        AVS_LIST_DELETE(blocks);
+    }
+    return 0;
+}
+
+static void update_window(anjay_coap_download_ctx_t *dl_ctx) {
+    coap_block_window_t *window = &dl_ctx->window;
+    if (dl_ctx->bytes_downloaded >= window->end_offset) {
+        dl_log(INFO, "transfer id = %" PRIuPTR " finished", dl_ctx->common.id);
+        abort_download_transfer(dl_ctx, _anjay_download_status_success());
+    } else if (dl_ctx->bytes_downloaded >= window->failed_offset) {
+        abort_download_transfer(dl_ctx, window->failed_status);
+    } else {
+        dl_log(TRACE, "transfer id = %" PRIuPTR ": %lu B downloaded",
+               dl_ctx->common.id, (unsigned long) dl_ctx->bytes_downloaded);
+        anjay_t *anjay = _anjay_downloader_get_anjay(dl_ctx->dl);
+        if (!window->job_request_blocks
+                && AVS_SCHED_NOW(anjay->sched, &window->job_request_blocks,
+                                 request_blocks_job, &dl_ctx->common.id,
+                                 sizeof(dl_ctx->common.id))) {
+            dl_log(ERROR, "could not schedule block requests");
+            abort_download_transfer(dl_ctx, _anjay_download_status_failed(
+                                                    avs_errno(AVS_ENOMEM)));
+        }
+    }
+}
+
+static AVS_LIST(coap_block_request_t) *
+find_block_request_ptr(coap_block_window_t *window, avs_coap_exchange_id_t id) {
+    AVS_LIST(coap_block_request_t) *request_ptr;
+    AVS_LIST_FOREACH_PTR(request_ptr, &window->block_requests) {
+        if ((*request_ptr)->exchange_id.value == id.value) {
+            return request_ptr;
+        }
+    }
+    return NULL;
+}
+
+static void fail_block_request(anjay_coap_download_ctx_t *dl_ctx,
+                               AVS_LIST(coap_block_request_t) *request_ptr,
+                               anjay_download_status_t status) {
+    coap_block_window_t *window = &dl_ctx->window;
+    // Blocks requested past the end of the resource are expected to fail
+    // before the last block is received, so the error is only fatal once all
+    // the data preceding the failed block has been passed to the user.
+    if ((*request_ptr)->offset <= dl_ctx->bytes_downloaded) {
+        abort_download_transfer(dl_ctx, status);
+        return;
+    }
+    if ((*request_ptr)->offset < window->failed_offset) {
+        window->failed_offset = (*request_ptr)->offset;
+        window->failed_status = status;
+    }
+    AVS_LIST_DELETE(request_ptr);
+    update_window(dl_ctx);
+}
+
+static void
+handle_windowed_response(anjay_coap_download_ctx_t *dl_ctx,
+                         avs_coap_exchange_id_t id,
+                         avs_coap_client_request_state_t result,
+                         const avs_coap_client_async_response_t *response,
+                         avs_error_t err) {
+    coap_block_window_t *window = &dl_ctx->window;
+    AVS_LIST(coap_block_request_t) *request_ptr =
+            find_block_request_ptr(window, id);
+    if (!request_ptr) {
+        dl_log(DEBUG, "ignoring response to a dropped block request");
+        return;
+    }
+
+    if (result == AVS_COAP_CLIENT_REQUEST_FAIL) {
+        dl_log(DEBUG, "block request failed: %s", AVS_COAP_STRERROR(err));
+        if (err.category == AVS_COAP_ERR_CATEGORY
+                && err.code == AVS_COAP_ERR_ETAG_MISMATCH) {
+            abort_download_transfer(dl_ctx, _anjay_download_status_expired());
+        } else {
+            fail_block_request(dl_ctx, request_ptr,
+                               _anjay_download_status_failed(err));
+        }
+        return;
+    }
+
+    const uint8_t code = response->header.code;
+    if (code != AVS_COAP_CODE_CONTENT) {
+        dl_log(DEBUG, "server responded with %s (expected %s)",
+               AVS_COAP_CODE_STRING(code),
+               AVS_COAP_CODE_STRING(AVS_COAP_CODE_CONTENT));
+        fail_block_request(dl_ctx, request_ptr,
+                           _anjay_download_status_invalid_response(code));
+        return;
+    }
+    avs_coap_etag_t etag;
+    if (check_response_etag(dl_ctx, &response->header, &etag)) {
+        return;
+    }
+
+    avs_coap_option_block_t block2;
+    if (!avs_coap_options_get_block(&response->header.options,
+                                    AVS_COAP_BLOCK2, &block2)
+            && (!window->block_size || block2.size < window->block_size)) {
+        // the server is free to use smaller blocks than we asked for
+        window->block_size = block2.size;
+    }
+
+    coap_block_request_t *request = *request_ptr;
+    const size_t chunk_offset = response->payload_offset;
+    size_t chunk_end = chunk_offset + response->payload_size;
+    if (result == AVS_COAP_CLIENT_REQUEST_OK
+            && chunk_end < window->end_offset) {
+        window->end_offset = chunk_end;
+    }
+    if (request->end_offset == SIZE_MAX) {
+        // Response to the initial request - the following blocks will be
+        // requested in parallel, starting right after this one.
+        request->end_offset = chunk_end;
+        window->next_request_offset = chunk_end;
+    }
+    chunk_end = AVS_MIN(chunk_end, request->end_offset);
+    if (chunk_end > chunk_offset
+            && accept_chunk(dl_ctx, chunk_offset,
+                            (const uint8_t *) response->payload,
+                            chunk_end - chunk_offset)) {
+        return;
+    }
+    request->offset = AVS_MAX(request->offset, chunk_end);
+    if (result == AVS_COAP_CLIENT_REQUEST_OK
+            || request->offset >= request->end_offset) {
+        AVS_LIST_DELETE(request_ptr);
+        if (result == AVS_COAP_CLIENT_REQUEST_PARTIAL_CONTENT) {
+            // Following blocks are requested separately, do not let avs_coap
+            // continue this exchange.
+            avs_coap_exchange_cancel(dl_ctx->coap, id);
+        }
+    }
+    update_window(dl_ctx);
+}
+
 static void
 handle_coap_response(avs_coap_ctx_t *ctx,
                      avs_coap_exchange_id_t id,
@@ -149,6 +426,11 @@ handle_coap_response(avs_coap_ctx_t *ctx,
 
     anjay_coap_download_ctx_t *dl_ctx = (anjay_coap_download_ctx_t *) arg;
 
+    if (dl_ctx->window.max_blocks > 1) {
+        handle_windowed_response(dl_ctx, id, result, response, err);
+        return;
+    }
+
     assert(dl_ctx->exchange_id.value == id.value);
     (void) id;
 
@@ -165,22 +447,7 @@ handle_coap_response(avs_coap_ctx_t *ctx,
             return;
         }
         avs_coap_etag_t etag;
-        if (read_etag(&response->header, &etag)) {
-            dl_log(DEBUG, "could not parse CoAP response");
-            abort_download_transfer(dl_ctx,
-                                    _anjay_download_status_failed(
-                                            avs_errno(AVS_EPROTO)));
-            return;
-        }
-        // NOTE: avs_coap normally performs ETag validation for blockwise
-        // transfers. However, if we resumed the download from persistence
-        // information, avs_coap wouldn't know about the ETag used before, and
-        // would blindly accept any ETag.
-        if (dl_ctx->etag.size == 0) {
-            dl_ctx->etag = etag;
-        } else if (!etag_matches(&dl_ctx->etag, &etag)) {
-            dl_log(DEBUG, "remote resource expired, aborting download");
-            abort_download_transfer(dl_ctx, _anjay_download_status_expired());
+        if (check_response_etag(dl_ctx, &response->header, &etag)) {
             return;
         }
         const void *payload = response->payload;
@@ -228,8 +495,10 @@ handle_coap_response(avs_coap_ctx_t *ctx,
 }
 
 static void handle_coap_message(anjay_downloader_t *dl,
-                                AVS_LIST(anjay_download_ctx_t) *ctx_ptr) {
+                                AVS_LIST(anjay_download_ctx_t) *ctx_ptr,
+                                avs_net_socket_t *socket) {
     (void) dl;
+    (void) socket;
 
     // NOTE: The return value is ignored as there is not a lot we can do with
     // it.
@@ -237,16 +506,21 @@ static void handle_coap_message(anjay_downloader_t *dl,
             ((anjay_coap_download_ctx_t *) *ctx_ptr)->coap, NULL, NULL);
 }
 
-static int get_coap_socket(anjay_downloader_t *dl,
-                           anjay_download_ctx_t *ctx,
-                           avs_net_socket_t **out_socket,
-                           anjay_socket_transport_t *out_transport) {
+static int get_coap_sockets(anjay_downloader_t *dl,
+                            anjay_download_ctx_t *ctx,
+                            AVS_LIST(anjay_socket_entry_t) *out_sockets) {
     (void) dl;
-    if (!(*out_socket = ((anjay_coap_download_ctx_t *) ctx)->socket)) {
-        return -1;
+    anjay_coap_download_ctx_t *coap_ctx = (anjay_coap_download_ctx_t *) ctx;
+    if (!coap_ctx->socket) {
+        return 0;
     }
-    *out_transport = ANJAY_SOCKET_TRANSPORT_UDP;
-    return 0;
+    return _anjay_downloader_add_socket_entry(out_sockets, coap_ctx->socket,
+                                              coap_ctx->transport);
+}
+
+static bool coap_uses_socket(anjay_download_ctx_t *ctx,
+                             avs_net_socket_t *socket) {
+    return ((anjay_coap_download_ctx_t *) ctx)->socket == socket;
 }
 
 #ifdef ANJAY_TEST
@@ -286,25 +560,16 @@ static inline size_t initial_block2_option_size(anjay_coap_download_ctx_t *ctx,
     return block_size;
 }
 
-static void start_download_job(avs_sched_t *sched, const void *id_ptr) {
-    anjay_t *anjay = _anjay_get_from_sched(sched);
-    uintptr_t id = *(const uintptr_t *) id_ptr;
-    AVS_LIST(anjay_download_ctx_t) *dl_ctx_ptr =
-            _anjay_downloader_find_ctx_ptr_by_id(&anjay->downloader, id);
-    if (!dl_ctx_ptr) {
-        dl_log(DEBUG, "download id = %" PRIuPTR "expired", id);
-        return;
-    }
-    anjay_coap_download_ctx_t *ctx = (anjay_coap_download_ctx_t *) *dl_ctx_ptr;
-
-    avs_error_t err;
+static avs_error_t send_block_request(anjay_coap_download_ctx_t *ctx,
+                                      avs_coap_exchange_id_t *out_exchange_id,
+                                      size_t offset,
+                                      size_t block_size) {
     avs_coap_options_t options;
-    const uint8_t code = AVS_COAP_CODE_GET;
-    const size_t block_size = initial_block2_option_size(ctx, code);
-    if (avs_is_err((err = avs_coap_options_dynamic_init(&options)))) {
-        dl_log(ERROR, "download id = %" PRIuPTR "cannot start: out of memory",
-               id);
-        goto end;
+    avs_error_t err = avs_coap_options_dynamic_init(&options);
+    if (avs_is_err(err)) {
+        dl_log(ERROR, "download id = %" PRIuPTR ": out of memory",
+               ctx->common.id);
+        return err;
     }
 
     AVS_LIST(const anjay_string_t) elem;
@@ -326,22 +591,21 @@ static void start_download_job(avs_sched_t *sched, const void *id_ptr) {
     // When we start the download, there is no need to ask for a blockwise
     // transfer (by adding a BLOCK option explicitly). If the incoming payload
     // is too large, CoAP layer will negotiate smaller block sizes.
-    if (ctx->bytes_downloaded != 0
-            && avs_is_err(
-                       (err = avs_coap_options_add_block(
-                                &options,
-                                &(avs_coap_option_block_t) {
-                                    .type = AVS_COAP_BLOCK2,
-                                    .seq_num = (uint32_t) (ctx->bytes_downloaded
-                                                           / block_size),
-                                    .size = (uint16_t) block_size
-                                })))) {
+    if (offset != 0
+            && avs_is_err((err = avs_coap_options_add_block(
+                                   &options,
+                                   &(avs_coap_option_block_t) {
+                                       .type = AVS_COAP_BLOCK2,
+                                       .seq_num = (uint32_t) (offset
+                                                              / block_size),
+                                       .size = (uint16_t) block_size
+                                   })))) {
         goto end;
     }
 
-    err = avs_coap_client_send_async_request(ctx->coap, &ctx->exchange_id,
+    err = avs_coap_client_send_async_request(ctx->coap, out_exchange_id,
                                              &(avs_coap_request_header_t) {
-                                                 .code = code,
+                                                 .code = AVS_COAP_CODE_GET,
                                                  .options = options
                                              },
                                              NULL, NULL, handle_coap_response,
@@ -349,6 +613,107 @@ static void start_download_job(avs_sched_t *sched, const void *id_ptr) {
 
 end:
     avs_coap_options_cleanup(&options);
+    return err;
+}
+
+static avs_error_t add_block_request(anjay_coap_download_ctx_t *ctx,
+                                     size_t offset,
+                                     size_t end_offset,
+                                     size_t block_size) {
+    AVS_LIST(coap_block_request_t) request =
+            AVS_LIST_NEW_ELEMENT(coap_block_request_t);
+    if (!request) {
+        dl_log(ERROR, "out of memory");
+        return avs_errno(AVS_ENOMEM);
+    }
+    request->offset = offset;
+    request->end_offset = end_offset;
+    avs_error_t err = send_block_request(ctx, &request->exchange_id, offset,
+                                         block_size);
+    if (avs_is_err(err)) {
+        AVS_LIST_DELETE(&request);
+    } else {
+        AVS_LIST_INSERT(&ctx->window.block_requests, request);
+    }
+    return err;
+}
+
+static avs_error_t request_more_blocks(anjay_coap_download_ctx_t *ctx) {
+    coap_block_window_t *window = &ctx->window;
+    if (!window->block_size) {
+        // the initial request is still in progress
+        return AVS_OK;
+    }
+    const size_t window_start =
+            ctx->bytes_downloaded - ctx->bytes_downloaded % window->block_size;
+    const size_t limit = AVS_MIN(window->end_offset, window->failed_offset);
+    while (window->next_request_offset < limit
+           && (window->next_request_offset - window_start) / window->block_size
+                      < window->max_blocks) {
+        const size_t offset = window->next_request_offset;
+        avs_error_t err =
+                add_block_request(ctx, offset, offset + window->block_size,
+                                  window->block_size);
+        if (avs_is_err(err)) {
+            return err;
+        }
+        window->next_request_offset = offset + window->block_size;
+    }
+    return AVS_OK;
+}
+
+static void request_blocks_job(avs_sched_t *sched, const void *id_ptr) {
+    anjay_t *anjay = _anjay_get_from_sched(sched);
+    uintptr_t id = *(const uintptr_t *) id_ptr;
+    AVS_LIST(anjay_download_ctx_t) *dl_ctx_ptr =
+            _anjay_downloader_find_ctx_ptr_by_id(&anjay->downloader, id);
+    if (!dl_ctx_ptr) {
+        dl_log(DEBUG, "download id = %" PRIuPTR " expired", id);
+        return;
+    }
+    anjay_coap_download_ctx_t *ctx = (anjay_coap_download_ctx_t *) *dl_ctx_ptr;
+
+    avs_error_t err = request_more_blocks(ctx);
+    if (avs_is_err(err)) {
+        abort_download_transfer(ctx, _anjay_download_status_failed(err));
+    }
+}
+
+static avs_error_t start_windowed_download(anjay_coap_download_ctx_t *ctx,
+                                           size_t block_size) {
+    coap_block_window_t *window = &ctx->window;
+    cancel_block_requests(ctx);
+    AVS_LIST_CLEAR(&window->reordered_blocks);
+    window->block_size = 0;
+    window->next_request_offset = ctx->bytes_downloaded;
+    window->end_offset = SIZE_MAX;
+    window->failed_offset = SIZE_MAX;
+
+    // The first block is requested just like in a sequential download. Its
+    // response determines the block size used for the rest of the requests.
+    return add_block_request(ctx, ctx->bytes_downloaded, SIZE_MAX, block_size);
+}
+
+static void start_download_job(avs_sched_t *sched, const void *id_ptr) {
+    anjay_t *anjay = _anjay_get_from_sched(sched);
+    uintptr_t id = *(const uintptr_t *) id_ptr;
+    AVS_LIST(anjay_download_ctx_t) *dl_ctx_ptr =
+            _anjay_downloader_find_ctx_ptr_by_id(&anjay->downloader, id);
+    if (!dl_ctx_ptr) {
+        dl_log(DEBUG, "download id = %" PRIuPTR "expired", id);
+        return;
+    }
+    anjay_coap_download_ctx_t *ctx = (anjay_coap_download_ctx_t *) *dl_ctx_ptr;
+
+    const size_t block_size =
+            initial_block2_option_size(ctx, AVS_COAP_CODE_GET);
+    avs_error_t err;
+    if (ctx->window.max_blocks > 1) {
+        err = start_windowed_download(ctx, block_size);
+    } else {
+        err = send_block_request(ctx, &ctx->exchange_id, ctx->bytes_downloaded,
+                                 block_size);
+    }
 
     if (avs_is_err(err)) {
         _anjay_downloader_abort_transfer(ctx->dl, dl_ctx_ptr,
@@ -374,6 +739,14 @@ static avs_error_t reset_coap_ctx(anjay_coap_download_ctx_t *ctx) {
         break;
 #endif // WITH_AVS_COAP_UDP
 
+#ifdef WITH_AVS_COAP_TCP
+    case ANJAY_SOCKET_TRANSPORT_TCP:
+        ctx->coap = avs_coap_tcp_ctx_create(
+                anjay->sched, anjay->in_shared_buffer, anjay->out_shared_buffer,
+                AVS_COAP_DEFAULT_TCP_REQUEST_TIMEOUT);
+        break;
+#endif // WITH_AVS_COAP_TCP
+
     default:
         dl_log(ERROR,
                "anjay_coap_download_ctx_t is compatible only with "
@@ -464,7 +837,8 @@ _anjay_downloader_coap_ctx_new(anjay_downloader_t *dl,
     avs_net_ssl_configuration_t ssl_config;
     avs_error_t err = AVS_OK;
     static const anjay_download_ctx_vtable_t VTABLE = {
-        .get_socket = get_coap_socket,
+        .get_sockets = get_coap_sockets,
+        .uses_socket = coap_uses_socket,
         .handle_packet = handle_coap_message,
         .cleanup = cleanup_coap_transfer,
         .reconnect = reconnect_coap_transfer
@@ -573,6 +947,15 @@ _anjay_downloader_coap_ctx_new(anjay_downloader_t *dl,
     }
 #endif // WITH_AVS_COAP_UDP
 
+    ctx->window.max_blocks = cfg->coap_max_outstanding_blocks;
+#ifdef WITH_AVS_COAP_UDP
+    // Each block is requested in a separate exchange, so they would still be
+    // sent one by one if NSTART was lower than the window size.
+    if (ctx->tx_params.nstart < ctx->window.max_blocks) {
+        ctx->tx_params.nstart = ctx->window.max_blocks;
+    }
+#endif // WITH_AVS_COAP_UDP
+
     if (avs_is_err((err = reset_coap_ctx(ctx)))) {
         goto error;
     }
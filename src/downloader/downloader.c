@@ -122,30 +122,46 @@ void _anjay_downloader_cleanup(anjay_downloader_t *dl) {
     }
 }
 
-static int get_ctx_socket(anjay_downloader_t *dl,
-                          anjay_download_ctx_t *ctx,
-                          avs_net_socket_t **out_socket,
-                          anjay_socket_transport_t *out_transport) {
+int _anjay_downloader_add_socket_entry(
+        AVS_LIST(anjay_socket_entry_t) *out_sockets,
+        avs_net_socket_t *socket,
+        anjay_socket_transport_t transport) {
+    assert(socket);
+    AVS_LIST(anjay_socket_entry_t) elem =
+            AVS_LIST_NEW_ELEMENT(anjay_socket_entry_t);
+    if (!elem) {
+        return -1;
+    }
+
+    elem->socket = socket;
+    elem->transport = transport;
+    elem->ssid = ANJAY_SSID_ANY;
+    elem->queue_mode = false;
+    AVS_LIST_APPEND(out_sockets, elem);
+    return 0;
+}
+
+static int get_ctx_sockets(anjay_downloader_t *dl,
+                           anjay_download_ctx_t *ctx,
+                           AVS_LIST(anjay_socket_entry_t) *out_sockets) {
     assert(dl);
     assert(ctx);
     assert(ctx->common.vtable);
-    int result =
-            ctx->common.vtable->get_socket(dl, ctx, out_socket, out_transport);
-    if (!result) {
-        assert(*out_socket);
+    AVS_LIST(anjay_socket_entry_t) sockets = NULL;
+    if (ctx->common.vtable->get_sockets(dl, ctx, &sockets)) {
+        AVS_LIST_CLEAR(&sockets);
+        return -1;
     }
-    return result;
+    AVS_LIST_INSERT(out_sockets, sockets);
+    return 0;
 }
 
 static AVS_LIST(anjay_download_ctx_t) *
 find_ctx_ptr_by_socket(anjay_downloader_t *dl, avs_net_socket_t *socket) {
     AVS_LIST(anjay_download_ctx_t) *ctx;
     AVS_LIST_FOREACH_PTR(ctx, &dl->downloads) {
-        avs_net_socket_t *ctx_socket = NULL;
-        if (!get_ctx_socket(dl, *ctx, &ctx_socket,
-                            &(anjay_socket_transport_t) {
-                                    (anjay_socket_transport_t) 0 })
-                && ctx_socket == socket) {
+        assert((*ctx)->common.vtable);
+        if ((*ctx)->common.vtable->uses_socket(*ctx, socket)) {
             return ctx;
         }
     }
@@ -159,21 +175,9 @@ int _anjay_downloader_get_sockets(anjay_downloader_t *dl,
     AVS_LIST(anjay_download_ctx_t) dl_ctx;
 
     AVS_LIST_FOREACH(dl_ctx, dl->downloads) {
-        avs_net_socket_t *socket = NULL;
-        anjay_socket_transport_t transport;
-        if (!get_ctx_socket(dl, dl_ctx, &socket, &transport)) {
-            AVS_LIST(anjay_socket_entry_t) elem =
-                    AVS_LIST_NEW_ELEMENT(anjay_socket_entry_t);
-            if (!elem) {
-                AVS_LIST_CLEAR(&sockets);
-                return -1;
-            }
-
-            elem->socket = socket;
-            elem->transport = transport;
-            elem->ssid = ANJAY_SSID_ANY;
-            elem->queue_mode = false;
-            AVS_LIST_INSERT(&sockets, elem);
+        if (get_ctx_sockets(dl, dl_ctx, &sockets)) {
+            AVS_LIST_CLEAR(&sockets);
+            return -1;
         }
     }
 
@@ -205,7 +209,7 @@ int _anjay_downloader_handle_packet(anjay_downloader_t *dl,
 
     assert(*ctx);
     assert((*ctx)->common.vtable);
-    (*ctx)->common.vtable->handle_packet(dl, ctx);
+    (*ctx)->common.vtable->handle_packet(dl, ctx, socket);
     return 0;
 }
 
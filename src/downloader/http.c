@@ -30,6 +30,16 @@
 
 VISIBILITY_SOURCE_BEGIN
 
+#define DEFAULT_HTTP_RANGE_SIZE 16384
+
+typedef struct {
+    size_t offset; // offset of data[0] in the remote resource
+    size_t size;
+    size_t received;
+    avs_stream_t *stream; // NULL if finished or waiting for reconnection
+    uint8_t data[];
+} http_range_t;
+
 typedef struct {
     anjay_download_ctx_common_t common;
     avs_net_ssl_configuration_t ssl_configuration;
@@ -47,25 +57,60 @@ typedef struct {
     // we request Range: bytes=1200-, but the server responds with
     // Content-Range: bytes 1024-..., because it insists on using regular block
     // boundaries; we would then need to ignore 176 bytes without writing them.
+
+    // State related to parallel Range downloads:
+    size_t max_connections;
+    size_t range_size;
+    bool parallel;
+    size_t total_size; // SIZE_MAX if unknown
+    size_t next_range_offset;
+    // Sorted by offset. Once parallel mode is enabled, the connection opened
+    // by send_request() becomes the first range and ctx->stream is NULL.
+    AVS_LIST(http_range_t) ranges;
+    avs_sched_handle_t open_ranges_job;
 } anjay_http_download_ctx_t;
 
-static int read_start_byte_from_content_range(const char *content_range,
-                                              uint64_t *out_start_byte) {
-    uint64_t end_byte;
+/**
+ * Parses a Content-Range header value. @p out_complete_length is set to
+ * UINT64_MAX if the server did not specify it.
+ */
+static int parse_content_range(const char *content_range,
+                               uint64_t *out_start_byte,
+                               uint64_t *out_end_byte,
+                               uint64_t *out_complete_length) {
     long long complete_length;
     int after_slash = 0;
     if (avs_match_token(&content_range, "bytes", AVS_SPACES)
             || sscanf(content_range, "%" SCNu64 "-%" SCNu64 "/%n",
-                      out_start_byte, &end_byte, &after_slash)
+                      out_start_byte, out_end_byte, &after_slash)
                            < 2
-            || after_slash <= 0) {
+            || after_slash <= 0 || *out_end_byte < *out_start_byte) {
         return -1;
     }
-    return (strcmp(&content_range[after_slash], "*") == 0
-            || (!_anjay_safe_strtoll(&content_range[after_slash],
-                                     &complete_length)
-                && complete_length >= 1
-                && (uint64_t) (complete_length - 1) == end_byte))
+    if (strcmp(&content_range[after_slash], "*") == 0) {
+        *out_complete_length = UINT64_MAX;
+        return 0;
+    }
+    if (_anjay_safe_strtoll(&content_range[after_slash], &complete_length)
+            || complete_length < 1
+            || (uint64_t) complete_length <= *out_end_byte) {
+        return -1;
+    }
+    *out_complete_length = (uint64_t) complete_length;
+    return 0;
+}
+
+static int read_start_byte_from_content_range(const char *content_range,
+                                              uint64_t *out_start_byte,
+                                              uint64_t *out_complete_length) {
+    uint64_t end_byte;
+    if (parse_content_range(content_range, out_start_byte, &end_byte,
+                            out_complete_length)) {
+        return -1;
+    }
+    // response to an open-ended range request has to reach the end
+    return (*out_complete_length == UINT64_MAX
+            || *out_complete_length - 1 == end_byte)
                    ? 0
                    : -1;
 }
@@ -92,8 +137,104 @@ static inline bool etag_matches(const anjay_etag_t *etag, const char *text) {
            && memcmp(etag->value, &text[1], etag->size) == 0;
 }
 
-static void handle_http_packet(anjay_downloader_t *dl,
-                               AVS_LIST(anjay_download_ctx_t) *ctx_ptr) {
+static void open_ranges_job(avs_sched_t *sched, const void *id_ptr);
+
+static int schedule_open_ranges(anjay_downloader_t *dl,
+                                anjay_http_download_ctx_t *ctx) {
+    if (!ctx->open_ranges_job
+            && AVS_SCHED_NOW(_anjay_downloader_get_anjay(dl)->sched,
+                             &ctx->open_ranges_job, open_ranges_job,
+                             &ctx->common.id, sizeof(ctx->common.id))) {
+        dl_log(ERROR, "could not schedule download job");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Passes all data that became contiguous to the user and frees ranges that
+ * are no longer needed. Returns a negative value if the transfer has been
+ * finished or aborted.
+ */
+static int flush_ranges(anjay_downloader_t *dl,
+                        AVS_LIST(anjay_download_ctx_t) *ctx_ptr) {
+    anjay_http_download_ctx_t *ctx = (anjay_http_download_ctx_t *) *ctx_ptr;
+    anjay_t *anjay = _anjay_downloader_get_anjay(dl);
+    while (ctx->ranges && ctx->ranges->offset <= ctx->bytes_written) {
+        http_range_t *range = ctx->ranges;
+        const size_t received_end = range->offset + range->received;
+        if (received_end > ctx->bytes_written) {
+            avs_error_t err = ctx->common.on_next_block(
+                    anjay, &range->data[ctx->bytes_written - range->offset],
+                    received_end - ctx->bytes_written, ctx->etag,
+                    ctx->common.user_data);
+            if (avs_is_err(err)) {
+                _anjay_downloader_abort_transfer(
+                        dl, ctx_ptr, _anjay_download_status_failed(err));
+                return -1;
+            }
+            ctx->bytes_written = received_end;
+        }
+        if (range->received < range->size) {
+            break;
+        }
+        avs_stream_cleanup(&range->stream);
+        AVS_LIST_DELETE(&ctx->ranges);
+    }
+
+    if (ctx->bytes_written >= ctx->total_size) {
+        dl_log(INFO, "HTTP transfer id = %" PRIuPTR " finished",
+               ctx->common.id);
+        _anjay_downloader_abort_transfer(dl, ctx_ptr,
+                                         _anjay_download_status_success());
+        return -1;
+    }
+    if (schedule_open_ranges(dl, ctx)) {
+        _anjay_downloader_abort_transfer(dl, ctx_ptr,
+                                         _anjay_download_status_failed(
+                                                 avs_errno(AVS_ENOMEM)));
+        return -1;
+    }
+    return 0;
+}
+
+static int handle_range_packet(anjay_downloader_t *dl,
+                               AVS_LIST(anjay_download_ctx_t) *ctx_ptr,
+                               http_range_t *range) {
+    bool nonblock_read_ready;
+    do {
+        size_t bytes_read;
+        bool message_finished = false;
+
+        avs_error_t err = avs_stream_read(range->stream, &bytes_read,
+                                          &message_finished,
+                                          &range->data[range->received],
+                                          range->size - range->received);
+        if (avs_is_err(err)) {
+            _anjay_downloader_abort_transfer(
+                    dl, ctx_ptr, _anjay_download_status_failed(err));
+            return -1;
+        }
+        range->received += bytes_read;
+        if (range->received == range->size) {
+            // anything the server might still send is not needed
+            avs_stream_cleanup(&range->stream);
+            break;
+        }
+        if (message_finished) {
+            dl_log(ERROR, "HTTP response ended before the requested range");
+            _anjay_downloader_abort_transfer(dl, ctx_ptr,
+                                             _anjay_download_status_failed(
+                                                     avs_errno(AVS_EPROTO)));
+            return -1;
+        }
+        nonblock_read_ready = avs_stream_nonblock_read_ready(range->stream);
+    } while (nonblock_read_ready);
+    return flush_ranges(dl, ctx_ptr);
+}
+
+static void handle_primary_packet(anjay_downloader_t *dl,
+                                  AVS_LIST(anjay_download_ctx_t) *ctx_ptr) {
     anjay_http_download_ctx_t *ctx = (anjay_http_download_ctx_t *) *ctx_ptr;
     anjay_t *anjay = _anjay_downloader_get_anjay(dl);
     uint8_t *buffer = avs_shared_buffer_acquire(anjay->in_shared_buffer);
@@ -143,91 +284,297 @@ static void handle_http_packet(anjay_downloader_t *dl,
     avs_shared_buffer_release(anjay->in_shared_buffer);
 }
 
-static void send_request(avs_sched_t *sched, const void *id_ptr) {
-    anjay_t *anjay = _anjay_get_from_sched(sched);
-    uintptr_t id = *(const uintptr_t *) id_ptr;
-    AVS_LIST(anjay_download_ctx_t) *ctx_ptr =
-            _anjay_downloader_find_ctx_ptr_by_id(&anjay->downloader, id);
-    if (!ctx_ptr) {
-        dl_log(DEBUG, "download id = %" PRIuPTR "expired", id);
+static void handle_http_packet(anjay_downloader_t *dl,
+                               AVS_LIST(anjay_download_ctx_t) *ctx_ptr,
+                               avs_net_socket_t *socket) {
+    anjay_http_download_ctx_t *ctx = (anjay_http_download_ctx_t *) *ctx_ptr;
+    if (!ctx->parallel) {
+        handle_primary_packet(dl, ctx_ptr);
         return;
     }
+    AVS_LIST(http_range_t) range;
+    AVS_LIST_FOREACH(range, ctx->ranges) {
+        if (range->stream && avs_stream_net_getsock(range->stream) == socket) {
+            (void) handle_range_packet(dl, ctx_ptr, range);
+            return;
+        }
+    }
+}
 
-    AVS_LIST(const avs_http_header_t) received_headers = NULL;
-    anjay_http_download_ctx_t *ctx = (anjay_http_download_ctx_t *) *ctx_ptr;
+/**
+ * Opens a GET request stream for the download, asking for the part of the
+ * resource between @p range_start and @p range_end (exclusive; SIZE_MAX for
+ * the rest of the resource). On failure, @p out_status is filled with the
+ * status the download shall be aborted with.
+ */
+static int open_request_stream(anjay_http_download_ctx_t *ctx,
+                               avs_stream_t **out_stream,
+                               AVS_LIST(const avs_http_header_t) *headers,
+                               size_t range_start,
+                               size_t range_end,
+                               anjay_download_status_t *out_status) {
     avs_error_t err =
-            avs_http_open_stream(&ctx->stream, ctx->client, AVS_HTTP_GET,
+            avs_http_open_stream(out_stream, ctx->client, AVS_HTTP_GET,
                                  AVS_HTTP_CONTENT_IDENTITY, ctx->parsed_url,
                                  NULL, NULL);
-    if (avs_is_err(err) || !ctx->stream) {
-        _anjay_downloader_abort_transfer(&anjay->downloader, ctx_ptr,
-                                         _anjay_download_status_failed(err));
-        return;
+    if (avs_is_err(err) || !*out_stream) {
+        *out_status = _anjay_download_status_failed(err);
+        return -1;
     }
 
-    avs_http_set_header_storage(ctx->stream, &received_headers);
+    avs_http_set_header_storage(*out_stream, headers);
 
     char ifmatch[258];
     if (ctx->etag) {
         if (avs_simple_snprintf(ifmatch, sizeof(ifmatch), "\"%.*s\"",
                                 (int) ctx->etag->size, ctx->etag->value)
                         < 0
-                || avs_http_add_header(ctx->stream, "If-Match", ifmatch)) {
+                || avs_http_add_header(*out_stream, "If-Match", ifmatch)) {
             dl_log(ERROR, "Could not send If-Match header");
-            _anjay_downloader_abort_transfer(&anjay->downloader, ctx_ptr,
-                                             _anjay_download_status_failed(
-                                                     avs_errno(AVS_ENOMEM)));
-            return;
+            *out_status = _anjay_download_status_failed(avs_errno(AVS_ENOMEM));
+            return -1;
         }
     }
 
     // see docs on UINT_STR_BUF_SIZE in Commons for details on this formula
-    char range[sizeof("bytes=-") + (12 * sizeof(size_t)) / 5 + 1];
-    if (ctx->bytes_written > 0) {
-        if (avs_simple_snprintf(range, sizeof(range), "bytes=%lu-",
-                                (unsigned long) ctx->bytes_written)
+    char range[sizeof("bytes=-") + 2 * ((12 * sizeof(size_t)) / 5 + 1)];
+    if (range_start > 0 || range_end != SIZE_MAX) {
+        if ((range_end == SIZE_MAX
+                     ? avs_simple_snprintf(range, sizeof(range), "bytes=%lu-",
+                                           (unsigned long) range_start)
+                     : avs_simple_snprintf(range, sizeof(range),
+                                           "bytes=%lu-%lu",
+                                           (unsigned long) range_start,
+                                           (unsigned long) (range_end - 1)))
                         < 0
-                || avs_http_add_header(ctx->stream, "Range", range)) {
-            dl_log(ERROR, "Could not resume HTTP download: "
-                          "could not send Range header");
-            _anjay_downloader_abort_transfer(&anjay->downloader, ctx_ptr,
-                                             _anjay_download_status_failed(
-                                                     avs_errno(AVS_ENOMEM)));
-            return;
+                || avs_http_add_header(*out_stream, "Range", range)) {
+            dl_log(ERROR, "Could not send Range header");
+            *out_status = _anjay_download_status_failed(avs_errno(AVS_ENOMEM));
+            return -1;
         }
     }
 
-    if (avs_is_err((err = avs_stream_finish_message(ctx->stream)))) {
+    if (avs_is_err((err = avs_stream_finish_message(*out_stream)))) {
         int http_status = 200;
         if (err.category == AVS_HTTP_ERROR_CATEGORY) {
-            http_status = avs_http_status_code(ctx->stream);
+            http_status = avs_http_status_code(*out_stream);
         }
         if (http_status < 200 || http_status >= 300) {
             dl_log(WARNING, "HTTP error code %d received", http_status);
             if (http_status == 412) { // Precondition Failed
-                _anjay_downloader_abort_transfer(
-                        &anjay->downloader, ctx_ptr,
-                        _anjay_download_status_expired());
+                *out_status = _anjay_download_status_expired();
             } else {
-                _anjay_downloader_abort_transfer(
-                        &anjay->downloader, ctx_ptr,
-                        _anjay_download_status_invalid_response(http_status));
+                *out_status =
+                        _anjay_download_status_invalid_response(http_status);
             }
         } else {
             dl_log(ERROR, "Could not send HTTP request: %s",
                    AVS_COAP_STRERROR(err));
+            *out_status = _anjay_download_status_failed(err);
+        }
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Opens a connection for the part of @p range that has not been received yet.
+ * Returns a negative value if the transfer has been aborted.
+ */
+static int open_range(anjay_downloader_t *dl,
+                      AVS_LIST(anjay_download_ctx_t) *ctx_ptr,
+                      http_range_t *range) {
+    anjay_http_download_ctx_t *ctx = (anjay_http_download_ctx_t *) *ctx_ptr;
+    const size_t range_start = range->offset + range->received;
+    const size_t range_end = range->offset + range->size;
+    AVS_LIST(const avs_http_header_t) received_headers = NULL;
+    anjay_download_status_t status;
+    if (open_request_stream(ctx, &range->stream, &received_headers,
+                            range_start, range_end, &status)) {
+        goto fail;
+    }
+
+    bool range_valid = false;
+    AVS_LIST(const avs_http_header_t) it;
+    AVS_LIST_FOREACH(it, received_headers) {
+        if (avs_strcasecmp(it->key, "Content-Range") == 0) {
+            uint64_t start_byte, end_byte, complete_length;
+            range_valid = !parse_content_range(it->value, &start_byte,
+                                               &end_byte, &complete_length)
+                          && start_byte == range_start
+                          && end_byte == range_end - 1
+                          && complete_length == ctx->total_size;
+        } else if (avs_strcasecmp(it->key, "ETag") == 0
+                   && !etag_matches(ctx->etag, it->value)) {
+            dl_log(ERROR, "ETag does not match");
+            status = _anjay_download_status_expired();
+            goto fail;
+        }
+    }
+    avs_http_set_header_storage(range->stream, NULL);
+    if (!range_valid) {
+        dl_log(ERROR, "Server did not respond with the requested range");
+        status = _anjay_download_status_failed(avs_errno(AVS_EPROTO));
+        goto fail;
+    }
+    return 0;
+
+fail:
+    _anjay_downloader_abort_transfer(dl, ctx_ptr, status);
+    return -1;
+}
+
+/**
+ * Checks whether a new range may be started while @p connections connections
+ * are open. Received data is buffered until everything before it is passed to
+ * the user, so this also limits how far ahead of that point the ranges may
+ * reach.
+ */
+static bool can_start_range(const anjay_http_download_ctx_t *ctx,
+                            size_t connections) {
+    return connections < ctx->max_connections
+           && ctx->next_range_offset < ctx->total_size
+           && ctx->next_range_offset - ctx->bytes_written
+                      < ctx->max_connections * ctx->range_size;
+}
+
+static AVS_LIST(http_range_t) start_range(anjay_http_download_ctx_t *ctx) {
+    const size_t size =
+            AVS_MIN(ctx->range_size, ctx->total_size - ctx->next_range_offset);
+    AVS_LIST(http_range_t) range = (AVS_LIST(http_range_t)) AVS_LIST_NEW_BUFFER(
+            sizeof(http_range_t) + size);
+    if (!range) {
+        dl_log(ERROR, "out of memory");
+        return NULL;
+    }
+    range->offset = ctx->next_range_offset;
+    range->size = size;
+    AVS_LIST_APPEND(&ctx->ranges, range);
+    ctx->next_range_offset += size;
+    return range;
+}
+
+static void open_ranges_job(avs_sched_t *sched, const void *id_ptr) {
+    anjay_t *anjay = _anjay_get_from_sched(sched);
+    uintptr_t id = *(const uintptr_t *) id_ptr;
+    AVS_LIST(anjay_download_ctx_t) *ctx_ptr =
+            _anjay_downloader_find_ctx_ptr_by_id(&anjay->downloader, id);
+    if (!ctx_ptr) {
+        dl_log(DEBUG, "download id = %" PRIuPTR " expired", id);
+        return;
+    }
+    anjay_http_download_ctx_t *ctx = (anjay_http_download_ctx_t *) *ctx_ptr;
+
+    // resume ranges that lost their connections first
+    size_t connections = 0;
+    http_range_t *to_open = NULL;
+    AVS_LIST(http_range_t) range;
+    AVS_LIST_FOREACH(range, ctx->ranges) {
+        if (range->stream) {
+            ++connections;
+        } else if (!to_open && range->received < range->size) {
+            to_open = range;
+        }
+    }
+    if (!to_open && can_start_range(ctx, connections)
+            && !(to_open = start_range(ctx))) {
+        _anjay_downloader_abort_transfer(&anjay->downloader, ctx_ptr,
+                                         _anjay_download_status_failed(
+                                                 avs_errno(AVS_ENOMEM)));
+        return;
+    }
+    if (to_open) {
+        // Opening a connection blocks until the response headers are received,
+        // so only one is opened per job, letting the event loop handle other
+        // sockets in between. The next job opens another one if still needed.
+        if (open_range(&anjay->downloader, ctx_ptr, to_open)) {
+            return;
+        }
+        if (schedule_open_ranges(&anjay->downloader, ctx)) {
             _anjay_downloader_abort_transfer(&anjay->downloader, ctx_ptr,
                                              _anjay_download_status_failed(
-                                                     err));
+                                                     avs_errno(AVS_ENOMEM)));
+            return;
+        }
+    }
+
+    // Handle data that might have been buffered alongside the headers - see
+    // the comment at the end of send_request(). Handling a range may free
+    // ranges, so the search is restarted each time.
+    bool data_handled;
+    do {
+        data_handled = false;
+        AVS_LIST_FOREACH(range, ctx->ranges) {
+            if (!range->stream
+                    || !avs_stream_nonblock_read_ready(range->stream)) {
+                continue;
+            }
+            if (handle_range_packet(&anjay->downloader, ctx_ptr, range)) {
+                return;
+            }
+            data_handled = true;
+            break;
         }
+    } while (data_handled);
+}
+
+/**
+ * Switches to downloading the resource over multiple connections. The
+ * connection opened by send_request() is limited to the first range.
+ */
+static int start_parallel_download(anjay_http_download_ctx_t *ctx,
+                                   size_t total_size) {
+    assert(ctx->bytes_downloaded <= ctx->bytes_written);
+    const size_t end = ctx->bytes_written + ctx->range_size;
+    AVS_LIST(http_range_t) range = (AVS_LIST(http_range_t)) AVS_LIST_NEW_BUFFER(
+            sizeof(http_range_t) + (end - ctx->bytes_downloaded));
+    if (!range) {
+        dl_log(ERROR, "out of memory");
+        return -1;
+    }
+    range->offset = ctx->bytes_downloaded;
+    range->size = end - ctx->bytes_downloaded;
+    range->stream = ctx->stream;
+    ctx->stream = NULL;
+
+    ctx->ranges = range;
+    ctx->total_size = total_size;
+    ctx->next_range_offset = end;
+    ctx->parallel = true;
+    dl_log(INFO,
+           "HTTP transfer id = %" PRIuPTR ": using up to %lu connections",
+           ctx->common.id, (unsigned long) ctx->max_connections);
+    return 0;
+}
+
+static void send_request(avs_sched_t *sched, const void *id_ptr) {
+    anjay_t *anjay = _anjay_get_from_sched(sched);
+    uintptr_t id = *(const uintptr_t *) id_ptr;
+    AVS_LIST(anjay_download_ctx_t) *ctx_ptr =
+            _anjay_downloader_find_ctx_ptr_by_id(&anjay->downloader, id);
+    if (!ctx_ptr) {
+        dl_log(DEBUG, "download id = %" PRIuPTR "expired", id);
+        return;
+    }
+
+    AVS_LIST(const avs_http_header_t) received_headers = NULL;
+    anjay_http_download_ctx_t *ctx = (anjay_http_download_ctx_t *) *ctx_ptr;
+    anjay_download_status_t status;
+    if (open_request_stream(ctx, &ctx->stream, &received_headers,
+                            ctx->bytes_written, SIZE_MAX, &status)) {
+        _anjay_downloader_abort_transfer(&anjay->downloader, ctx_ptr, status);
         return;
     }
 
+    uint64_t complete_length = UINT64_MAX;
+    long long content_length = -1;
+    bool ranges_supported = false;
     AVS_LIST(const avs_http_header_t) it;
     AVS_LIST_FOREACH(it, received_headers) {
         if (avs_strcasecmp(it->key, "Content-Range") == 0) {
             uint64_t bytes_downloaded;
-            if (read_start_byte_from_content_range(it->value, &bytes_downloaded)
+            if (read_start_byte_from_content_range(it->value, &bytes_downloaded,
+                                                   &complete_length)
                     || bytes_downloaded > ctx->bytes_written) {
                 dl_log(ERROR,
                        "Could not resume HTTP download: "
@@ -239,6 +586,14 @@ static void send_request(avs_sched_t *sched, const void *id_ptr) {
                 return;
             }
             ctx->bytes_downloaded = (size_t) bytes_downloaded;
+            ranges_supported = true;
+        } else if (avs_strcasecmp(it->key, "Accept-Ranges") == 0) {
+            ranges_supported =
+                    ranges_supported || avs_strcasecmp(it->value, "bytes") == 0;
+        } else if (avs_strcasecmp(it->key, "Content-Length") == 0) {
+            if (_anjay_safe_strtoll(it->value, &content_length)) {
+                content_length = -1;
+            }
         } else if (avs_strcasecmp(it->key, "ETag") == 0) {
             if (ctx->etag) {
                 if (!etag_matches(ctx->etag, it->value)) {
@@ -256,6 +611,32 @@ static void send_request(avs_sched_t *sched, const void *id_ptr) {
     }
     avs_http_set_header_storage(ctx->stream, NULL);
 
+    if (ctx->max_connections > 1) {
+        uint64_t total_size = complete_length;
+        if (total_size == UINT64_MAX && ctx->bytes_written == 0
+                && content_length >= 0) {
+            total_size = (uint64_t) content_length;
+        }
+        if (!ctx->etag || !ranges_supported || total_size >= SIZE_MAX
+                || total_size <= (uint64_t) ctx->bytes_written + ctx->range_size
+                || ctx->bytes_written - ctx->bytes_downloaded
+                           >= ctx->range_size) {
+            dl_log(DEBUG,
+                   "HTTP transfer id = %" PRIuPTR
+                   ": parallel download not possible or not needed",
+                   ctx->common.id);
+        } else if (start_parallel_download(ctx, (size_t) total_size)) {
+            _anjay_downloader_abort_transfer(&anjay->downloader, ctx_ptr,
+                                             _anjay_download_status_failed(
+                                                     avs_errno(AVS_ENOMEM)));
+            return;
+        } else {
+            // handles data buffered alongside the headers as well
+            open_ranges_job(anjay->sched, &ctx->common.id);
+            return;
+        }
+    }
+
     /*
      * If the whole downloaded file is small enough and is received before
      * we end handling HTTP headers, it may be read by the underlying
@@ -266,31 +647,59 @@ static void send_request(avs_sched_t *sched, const void *id_ptr) {
      * buffer. We avoid this case by explicitly handling any buffered data
      * here.
      *
-     * Also, we must not call handle_http_packet unconditionally, because if
-     * there is no data buffered, the call would block waiting until a first
+     * Also, we must not call handle_primary_packet unconditionally, because
+     * if there is no data buffered, the call would block waiting until a first
      * chunk of data is received from the server.
      */
     if (avs_stream_nonblock_read_ready(ctx->stream)) {
-        handle_http_packet(&anjay->downloader, ctx_ptr);
+        handle_primary_packet(&anjay->downloader, ctx_ptr);
     }
 }
 
-static int get_http_socket(anjay_downloader_t *dl,
-                           anjay_download_ctx_t *ctx,
-                           avs_net_socket_t **out_socket,
-                           anjay_socket_transport_t *out_transport) {
+static int get_http_sockets(anjay_downloader_t *dl,
+                            anjay_download_ctx_t *ctx_,
+                            AVS_LIST(anjay_socket_entry_t) *out_sockets) {
     (void) dl;
-    if (!(*out_socket = avs_stream_net_getsock(
-                  ((anjay_http_download_ctx_t *) ctx)->stream))) {
+    anjay_http_download_ctx_t *ctx = (anjay_http_download_ctx_t *) ctx_;
+    avs_net_socket_t *socket;
+    if (ctx->stream && (socket = avs_stream_net_getsock(ctx->stream))
+            && _anjay_downloader_add_socket_entry(out_sockets, socket,
+                                                  ANJAY_SOCKET_TRANSPORT_TCP)) {
         return -1;
     }
-    *out_transport = ANJAY_SOCKET_TRANSPORT_TCP;
+    AVS_LIST(http_range_t) range;
+    AVS_LIST_FOREACH(range, ctx->ranges) {
+        if (range->stream && (socket = avs_stream_net_getsock(range->stream))
+                && _anjay_downloader_add_socket_entry(
+                           out_sockets, socket, ANJAY_SOCKET_TRANSPORT_TCP)) {
+            return -1;
+        }
+    }
     return 0;
 }
 
+static bool http_uses_socket(anjay_download_ctx_t *ctx_,
+                             avs_net_socket_t *socket) {
+    anjay_http_download_ctx_t *ctx = (anjay_http_download_ctx_t *) ctx_;
+    if (ctx->stream && avs_stream_net_getsock(ctx->stream) == socket) {
+        return true;
+    }
+    AVS_LIST(http_range_t) range;
+    AVS_LIST_FOREACH(range, ctx->ranges) {
+        if (range->stream && avs_stream_net_getsock(range->stream) == socket) {
+            return true;
+        }
+    }
+    return false;
+}
+
 static void cleanup_http_transfer(AVS_LIST(anjay_download_ctx_t) *ctx_ptr) {
     anjay_http_download_ctx_t *ctx = (anjay_http_download_ctx_t *) *ctx_ptr;
     avs_sched_del(&ctx->send_request_job);
+    avs_sched_del(&ctx->open_ranges_job);
+    AVS_LIST_CLEAR(&ctx->ranges) {
+        avs_stream_cleanup(&ctx->ranges->stream);
+    }
     avs_free(ctx->etag);
     avs_stream_cleanup(&ctx->stream);
     avs_url_free(ctx->parsed_url);
@@ -303,8 +712,18 @@ static avs_error_t
 reconnect_http_transfer(anjay_downloader_t *dl,
                         AVS_LIST(anjay_download_ctx_t) *ctx_ptr) {
     anjay_http_download_ctx_t *ctx = (anjay_http_download_ctx_t *) *ctx_ptr;
-    avs_stream_cleanup(&ctx->stream);
     anjay_t *anjay = _anjay_downloader_get_anjay(dl);
+    if (ctx->parallel) {
+        // ranges that are not complete yet will be requested again from the
+        // first byte that has not been received
+        AVS_LIST(http_range_t) range;
+        AVS_LIST_FOREACH(range, ctx->ranges) {
+            avs_stream_cleanup(&range->stream);
+        }
+        return schedule_open_ranges(dl, ctx) ? avs_errno(AVS_ENOMEM)
+                                             : AVS_OK;
+    }
+    avs_stream_cleanup(&ctx->stream);
     if (AVS_SCHED_NOW(anjay->sched, &ctx->send_request_job, send_request,
                       &ctx->common.id, sizeof(ctx->common.id))) {
         dl_log(ERROR, "could not schedule download job");
@@ -327,20 +746,33 @@ _anjay_downloader_http_ctx_new(anjay_downloader_t *dl,
     }
 
     static const anjay_download_ctx_vtable_t VTABLE = {
-        .get_socket = get_http_socket,
+        .get_sockets = get_http_sockets,
+        .uses_socket = http_uses_socket,
         .handle_packet = handle_http_packet,
         .cleanup = cleanup_http_transfer,
         .reconnect = reconnect_http_transfer
     };
     ctx->common.vtable = &VTABLE;
 
+    ctx->max_connections = cfg->http_max_connections;
+    ctx->range_size = cfg->http_range_size ? cfg->http_range_size
+                                           : DEFAULT_HTTP_RANGE_SIZE;
+    ctx->total_size = SIZE_MAX;
+
     avs_http_buffer_sizes_t http_buffer_sizes = AVS_HTTP_DEFAULT_BUFFER_SIZES;
-    if (cfg->start_offset > 0) {
-        // prevent sending Accept-Encoding
+    if (cfg->start_offset > 0 || ctx->max_connections > 1) {
+        // prevent sending Accept-Encoding - byte ranges refer to the encoded
+        // representation
         http_buffer_sizes.content_coding_input = 0;
     }
 
     avs_error_t err = AVS_OK;
+    if (ctx->max_connections > 1
+            && ctx->range_size > SIZE_MAX / ctx->max_connections) {
+        dl_log(ERROR, "invalid download config: HTTP range size too large");
+        err = avs_errno(AVS_EINVAL);
+        goto error;
+    }
     if (!(ctx->client = avs_http_new(&http_buffer_sizes))
             || _anjay_copy_tls_ciphersuites(
                        &ctx->ssl_configuration.ciphersuites,
@@ -29,12 +29,22 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
 #define dl_log(...) _anjay_log(downloader, __VA_ARGS__)
 
 typedef struct {
-    int (*get_socket)(anjay_downloader_t *dl,
-                      anjay_download_ctx_t *ctx,
-                      avs_net_socket_t **out_socket,
-                      anjay_socket_transport_t *out_transport);
+    /**
+     * Appends entries for all sockets currently used by the download to
+     * @p out_sockets, using @ref _anjay_downloader_add_socket_entry . Returns
+     * a negative value in case of an error.
+     */
+    int (*get_sockets)(anjay_downloader_t *dl,
+                       anjay_download_ctx_t *ctx,
+                       AVS_LIST(anjay_socket_entry_t) *out_sockets);
+    /**
+     * Checks whether @p socket is one of the sockets currently used by the
+     * download.
+     */
+    bool (*uses_socket)(anjay_download_ctx_t *ctx, avs_net_socket_t *socket);
     void (*handle_packet)(anjay_downloader_t *dl,
-                          AVS_LIST(anjay_download_ctx_t) *ctx_ptr);
+                          AVS_LIST(anjay_download_ctx_t) *ctx_ptr,
+                          avs_net_socket_t *socket);
     void (*cleanup)(AVS_LIST(anjay_download_ctx_t) *ctx_ptr);
     avs_error_t (*reconnect)(anjay_downloader_t *dl,
                              AVS_LIST(anjay_download_ctx_t) *ctx_ptr);
@@ -57,6 +67,11 @@ static inline anjay_t *_anjay_downloader_get_anjay(anjay_downloader_t *dl) {
 AVS_LIST(anjay_download_ctx_t) *
 _anjay_downloader_find_ctx_ptr_by_id(anjay_downloader_t *dl, uintptr_t id);
 
+int _anjay_downloader_add_socket_entry(
+        AVS_LIST(anjay_socket_entry_t) *out_sockets,
+        avs_net_socket_t *socket,
+        anjay_socket_transport_t transport);
+
 void _anjay_downloader_abort_transfer(anjay_downloader_t *dl,
                                       AVS_LIST(anjay_download_ctx_t) *ctx,
                                       anjay_download_status_t status);
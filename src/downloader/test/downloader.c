@@ -370,6 +370,81 @@ AVS_UNIT_TEST(downloader, coap_download_multiple_blocks) {
     teardown_simple();
 }
 
+static void expect_despair_block(size_t seq_num, size_t block_size) {
+    const size_t offset = seq_num * block_size;
+    on_next_block_args_t args = {
+        .data_size = AVS_MIN(block_size, sizeof(DESPAIR) - 1 - offset),
+        .result = AVS_OK
+    };
+    memcpy(args.data, &DESPAIR[offset], args.data_size);
+    expect_next_block(&SIMPLE_ENV.data, args);
+}
+
+AVS_UNIT_TEST(downloader, coap_download_parallel_blocks) {
+    static const size_t BLOCK_SIZE = 16;
+
+    setup_simple("coap://127.0.0.1:5683");
+    SIMPLE_ENV.cfg.coap_max_outstanding_blocks = 2;
+
+    avs_unit_mocksock_expect_connect(SIMPLE_ENV.mocksock, "127.0.0.1", "5683");
+
+    // the first block is requested on its own
+    const coap_test_msg_t *req =
+            COAP_MSG(CON, GET, ID_TOKEN_RAW(0, nth_token(0)), NO_PAYLOAD);
+    const coap_test_msg_t *res =
+            COAP_MSG(ACK, CONTENT, ID_TOKEN_RAW(0, nth_token(0)),
+                     BLOCK2(0, BLOCK_SIZE, DESPAIR));
+    avs_unit_mocksock_expect_output(SIMPLE_ENV.mocksock, &req->content,
+                                    req->length);
+    avs_unit_mocksock_input(SIMPLE_ENV.mocksock, &res->content, res->length);
+    expect_despair_block(0, BLOCK_SIZE);
+
+    // then pairs of blocks, with responses arriving in reverse order
+    const size_t num_blocks = DIV_CEIL(sizeof(DESPAIR) - 1, BLOCK_SIZE);
+    AVS_UNIT_ASSERT_EQUAL(num_blocks % 2, 0);
+    for (size_t i = 1; i < num_blocks; i += 2) {
+        const coap_test_msg_t *reqs[] = {
+            COAP_MSG(CON, GET, ID_TOKEN_RAW(i, nth_token(i)),
+                     BLOCK2(i, BLOCK_SIZE, "")),
+            COAP_MSG(CON, GET, ID_TOKEN_RAW(i + 1, nth_token(i + 1)),
+                     BLOCK2(i + 1, BLOCK_SIZE, ""))
+        };
+        // the last request is past the end of the resource
+        const coap_test_msg_t *second_res =
+                i + 1 < num_blocks
+                        ? COAP_MSG(ACK, CONTENT,
+                                   ID_TOKEN_RAW(i + 1, nth_token(i + 1)),
+                                   BLOCK2(i + 1, BLOCK_SIZE, DESPAIR))
+                        : COAP_MSG(ACK, BAD_OPTION,
+                                   ID_TOKEN_RAW(i + 1, nth_token(i + 1)),
+                                   NO_PAYLOAD);
+        const coap_test_msg_t *first_res =
+                COAP_MSG(ACK, CONTENT, ID_TOKEN_RAW(i, nth_token(i)),
+                         BLOCK2(i, BLOCK_SIZE, DESPAIR));
+
+        for (size_t j = 0; j < AVS_ARRAY_SIZE(reqs); ++j) {
+            avs_unit_mocksock_expect_output(SIMPLE_ENV.mocksock,
+                                            &reqs[j]->content, reqs[j]->length);
+        }
+        avs_unit_mocksock_input(SIMPLE_ENV.mocksock, &second_res->content,
+                                second_res->length);
+        avs_unit_mocksock_input(SIMPLE_ENV.mocksock, &first_res->content,
+                                first_res->length);
+
+        expect_despair_block(i, BLOCK_SIZE);
+        if (i + 1 < num_blocks) {
+            expect_despair_block(i + 1, BLOCK_SIZE);
+        }
+    }
+    expect_timeout(SIMPLE_ENV.mocksock);
+    expect_download_finished(&SIMPLE_ENV.data,
+                             _anjay_download_status_success());
+
+    perform_simple_download();
+
+    teardown_simple();
+}
+
 AVS_UNIT_TEST(downloader, download_abort_on_cleanup) {
     setup_simple("coap://127.0.0.1:5683");
 
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2017-2019 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <anjay_modules/iid_log.h>
+
+#include "utils_core.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+static inline anjay_iid_t instance_iid(const void *inst) {
+    return *(const anjay_iid_t *) inst;
+}
+
+static int logged_iid_cmp(const void *left, const void *right) {
+    return *(const anjay_iid_t *) left - *(const anjay_iid_t *) right;
+}
+
+static bool is_logged(const anjay_iid_log_t *log, anjay_iid_t iid) {
+    return log->logged_iids && AVS_RBTREE_FIND(log->logged_iids, &iid);
+}
+
+static int mark_logged(anjay_iid_log_t *log, anjay_iid_t iid) {
+    AVS_RBTREE_ELEM(anjay_iid_t) elem = NULL;
+    if ((!log->logged_iids
+         && !(log->logged_iids = AVS_RBTREE_NEW(anjay_iid_t, logged_iid_cmp)))
+            || !(elem = AVS_RBTREE_ELEM_NEW(anjay_iid_t))) {
+        anjay_log(ERROR, "out of memory");
+        return ANJAY_ERR_INTERNAL;
+    }
+    *elem = iid;
+    AVS_RBTREE_INSERT(log->logged_iids, elem);
+    return 0;
+}
+
+int _anjay_iid_log_save_instance(anjay_iid_log_t *log,
+                                 const anjay_iid_log_handlers_t *handlers,
+                                 const void *inst) {
+    if (is_logged(log, instance_iid(inst))) {
+        return 0;
+    }
+    AVS_LIST(void) saved = AVS_LIST_NEW_BUFFER(handlers->instance_size);
+    if (!saved) {
+        anjay_log(ERROR, "out of memory");
+        return ANJAY_ERR_INTERNAL;
+    }
+    if (handlers->clone_instance(saved, inst)
+            || mark_logged(log, instance_iid(inst))) {
+        handlers->destroy_instances(&saved);
+        return ANJAY_ERR_INTERNAL;
+    }
+    AVS_LIST_INSERT(&log->saved_instances, saved);
+    return 0;
+}
+
+int _anjay_iid_log_mark_created(anjay_iid_log_t *log, anjay_iid_t iid) {
+    if (is_logged(log, iid)) {
+        return 0;
+    }
+    AVS_LIST(anjay_iid_t) created = AVS_LIST_NEW_ELEMENT(anjay_iid_t);
+    if (!created) {
+        anjay_log(ERROR, "out of memory");
+        return ANJAY_ERR_INTERNAL;
+    }
+    int result = mark_logged(log, iid);
+    if (result) {
+        AVS_LIST_DELETE(&created);
+        return result;
+    }
+    *created = iid;
+    AVS_LIST_INSERT(&log->created_iids, created);
+    return 0;
+}
+
+void _anjay_iid_log_remove_instance(anjay_iid_log_t *log,
+                                    const anjay_iid_log_handlers_t *handlers,
+                                    AVS_LIST(void) *inst_ptr) {
+    AVS_LIST(void) element = AVS_LIST_DETACH(inst_ptr);
+    if (!is_logged(log, instance_iid(element))) {
+        // no need to copy anything - the removed instance is kept as-is;
+        // if marking fails, a later save may log a redundant copy, which is
+        // harmless as rollback restores the oldest one last
+        (void) mark_logged(log, instance_iid(element));
+        AVS_LIST_INSERT(&log->saved_instances, element);
+    } else {
+        handlers->destroy_instances(&element);
+    }
+}
+
+void _anjay_iid_log_forget(anjay_iid_log_t *log,
+                           const anjay_iid_log_handlers_t *handlers) {
+    handlers->destroy_instances(&log->saved_instances);
+    AVS_LIST_CLEAR(&log->created_iids);
+    AVS_RBTREE_DELETE(&log->logged_iids);
+}
+
+static AVS_LIST(void) *
+detach_current_instance(const anjay_iid_log_handlers_t *handlers,
+                        AVS_LIST(void) *instances_ptr,
+                        anjay_iid_t iid) {
+    AVS_LIST(void) *ptr;
+    AVS_LIST_FOREACH_PTR(ptr, instances_ptr) {
+        if (instance_iid(*ptr) >= iid) {
+            if (instance_iid(*ptr) == iid) {
+                AVS_LIST(void) element = AVS_LIST_DETACH(ptr);
+                handlers->destroy_instances(&element);
+            }
+            break;
+        }
+    }
+    return ptr;
+}
+
+void _anjay_iid_log_rollback(anjay_iid_log_t *log,
+                             const anjay_iid_log_handlers_t *handlers,
+                             AVS_LIST(void) *instances_ptr) {
+    AVS_LIST_CLEAR(&log->created_iids) {
+        detach_current_instance(handlers, instances_ptr, *log->created_iids);
+    }
+    // saved_instances is in reverse order of logging, so if an instance has
+    // been logged more than once, its oldest state is restored last
+    while (log->saved_instances) {
+        AVS_LIST(void) saved = AVS_LIST_DETACH(&log->saved_instances);
+        AVS_LIST_INSERT(detach_current_instance(handlers, instances_ptr,
+                                                instance_iid(saved)),
+                        saved);
+    }
+    AVS_RBTREE_DELETE(&log->logged_iids);
+}
@@ -18,10 +18,10 @@
 
 #include "../access_utils.h"
 #include "../dm/dm_read.h"
+#include "../utils_core.h"
 #include "batch_builder.h"
 #include "vtable.h"
 
-#include <avsystem/commons/list.h>
 #include <avsystem/commons/utils.h>
 
 #include <anjay_modules/dm_utils.h>
@@ -66,10 +66,15 @@ typedef struct {
     avs_time_real_t timestamp;
 } anjay_batch_entry_t;
 
+/**
+ * A compiled batch is a single heap block: this header, followed by the array
+ * of entries, followed by all string and bytes payloads the entries point to.
+ */
 struct anjay_batch_struct {
-    AVS_LIST(anjay_batch_entry_t) list;
     size_t ref_count;
     avs_time_real_t compilation_time;
+    size_t entry_count;
+    anjay_batch_entry_t entries[];
 };
 
 struct anjay_batch_data_output_state_struct {
@@ -78,7 +83,10 @@ struct anjay_batch_data_output_state_struct {
 
 typedef struct {
     const anjay_ret_bytes_ctx_vtable_t *vtable;
-    void *data;
+    anjay_batch_builder_t *builder;
+    // offset within builder's payload buffer; a pointer would be invalidated
+    // whenever the buffer is reallocated
+    size_t offset;
     size_t remaining_bytes;
 } builder_bytes_t;
 
@@ -91,36 +99,70 @@ typedef struct builder_out_struct {
     anjay_uri_path_t path;
 } builder_out_ctx_t;
 
+/**
+ * While building, entries and payloads are kept in two growable arrays. String
+ * and bytes entries have their value pointers left unset - their payloads are
+ * stored in @ref anjay_batch_builder_struct::payload in the same order as the
+ * entries themselves, so the pointers can be resolved in a single pass during
+ * compilation.
+ */
 struct anjay_batch_builder_struct {
-    AVS_LIST(anjay_batch_entry_t) list;
-    AVS_LIST(anjay_batch_entry_t) *last_element;
+    anjay_batch_entry_t *entries;
+    size_t entry_count;
+    size_t entry_capacity;
+
+    char *payload;
+    size_t payload_size;
+    size_t payload_capacity;
 };
 
 anjay_batch_builder_t *_anjay_batch_builder_new(void) {
-    anjay_batch_builder_t *builder =
-            (anjay_batch_builder_t *) avs_calloc(1,
-                                                 sizeof(anjay_batch_builder_t));
-    if (!builder) {
-        return NULL;
+    return (anjay_batch_builder_t *) avs_calloc(1,
+                                                sizeof(anjay_batch_builder_t));
+}
+
+static int ensure_entries_capacity(anjay_batch_builder_t *builder) {
+    if (builder->entry_count < builder->entry_capacity) {
+        return 0;
     }
-    builder->last_element = &builder->list;
-    return builder;
+    size_t new_capacity =
+            builder->entry_capacity ? 2 * builder->entry_capacity : 8;
+    anjay_batch_entry_t *new_entries = (anjay_batch_entry_t *) avs_realloc(
+            builder->entries, new_capacity * sizeof(*new_entries));
+    if (!new_entries) {
+        batch_log(ERROR, "out of memory");
+        return -1;
+    }
+    builder->entries = new_entries;
+    builder->entry_capacity = new_capacity;
+    return 0;
 }
 
-static int make_data_with_duplicated_string(anjay_batch_data_t *batch_data,
-                                            const char *str) {
-    assert(batch_data);
-    assert(str);
-    char *new_str = avs_strdup(str);
-    if (!new_str) {
+/**
+ * Reserves @p size bytes at the end of the payload buffer and returns the
+ * offset of the reserved area through @p out_offset.
+ */
+static int
+reserve_payload(anjay_batch_builder_t *builder, size_t size, size_t *out_offset) {
+    if (size > SIZE_MAX / 2 - builder->payload_size) {
         return -1;
     }
-    *batch_data = (anjay_batch_data_t) {
-        .type = ANJAY_BATCH_DATA_STRING,
-        .value = {
-            .string = new_str
+    if (builder->payload_size + size > builder->payload_capacity) {
+        size_t new_capacity =
+                builder->payload_capacity ? 2 * builder->payload_capacity : 64;
+        while (new_capacity < builder->payload_size + size) {
+            new_capacity *= 2;
         }
-    };
+        char *new_payload = (char *) avs_realloc(builder->payload, new_capacity);
+        if (!new_payload) {
+            batch_log(ERROR, "out of memory");
+            return -1;
+        }
+        builder->payload = new_payload;
+        builder->payload_capacity = new_capacity;
+    }
+    *out_offset = builder->payload_size;
+    builder->payload_size += size;
     return 0;
 }
 
@@ -133,16 +175,14 @@ static int batch_data_add(anjay_batch_builder_t *builder,
             && !_anjay_uri_path_has(uri, ANJAY_ID_RID)) {
         return -1;
     }
-    *builder->last_element = AVS_LIST_NEW_ELEMENT(anjay_batch_entry_t);
-    if (!*builder->last_element) {
+    if (ensure_entries_capacity(builder)) {
         return -1;
     }
-    **builder->last_element = (anjay_batch_entry_t) {
+    builder->entries[builder->entry_count++] = (anjay_batch_entry_t) {
         .path = *uri,
         .timestamp = timestamp,
         .data = data
     };
-    AVS_LIST_ADVANCE_PTR(&builder->last_element);
     return 0;
 }
 
@@ -189,11 +229,21 @@ int _anjay_batch_add_string(anjay_batch_builder_t *builder,
                             const anjay_uri_path_t *uri,
                             avs_time_real_t timestamp,
                             const char *str) {
-    anjay_batch_data_t str_data;
-    if (make_data_with_duplicated_string(&str_data, str)) {
+    assert(str);
+    const anjay_batch_data_t data = {
+        .type = ANJAY_BATCH_DATA_STRING
+    };
+    size_t size = strlen(str) + 1;
+    size_t offset;
+    if (reserve_payload(builder, size, &offset)) {
         return -1;
     }
-    return batch_data_add(builder, uri, timestamp, str_data);
+    if (batch_data_add(builder, uri, timestamp, data)) {
+        builder->payload_size = offset;
+        return -1;
+    }
+    memcpy(builder->payload + offset, str, size);
+    return 0;
 }
 
 int _anjay_batch_add_objlnk(anjay_batch_builder_t *builder,
@@ -213,41 +263,55 @@ int _anjay_batch_add_objlnk(anjay_batch_builder_t *builder,
     return batch_data_add(builder, uri, timestamp, data);
 }
 
-static void batch_entry_cleanup(void *entry_) {
-    anjay_batch_entry_t *entry = (anjay_batch_entry_t *) entry_;
-    if (entry->data.type == ANJAY_BATCH_DATA_STRING) {
-        avs_free((void *) (intptr_t) entry->data.value.string);
-    } else if (entry->data.type == ANJAY_BATCH_DATA_BYTES) {
-        avs_free((void *) (intptr_t) entry->data.value.bytes.data);
-    }
-}
-
-static void list_cleanup(AVS_LIST(anjay_batch_entry_t) list) {
-    AVS_LIST_CLEAR(&list) {
-        batch_entry_cleanup(list);
-    }
-}
-
 void _anjay_batch_builder_cleanup(anjay_batch_builder_t **builder) {
     if (builder && *builder) {
-        list_cleanup((*builder)->list);
+        avs_free((*builder)->entries);
+        avs_free((*builder)->payload);
         avs_free(*builder);
         *builder = NULL;
     }
 }
 
+/**
+ * Points string and bytes values of @p entries at consecutive parts of
+ * @p payload. See @ref anjay_batch_builder_struct for the layout.
+ */
+static void link_payloads(anjay_batch_entry_t *entries,
+                          size_t entry_count,
+                          const char *payload) {
+    for (size_t i = 0; i < entry_count; ++i) {
+        anjay_batch_data_t *data = &entries[i].data;
+        if (data->type == ANJAY_BATCH_DATA_STRING) {
+            data->value.string = payload;
+            payload += strlen(payload) + 1;
+        } else if (data->type == ANJAY_BATCH_DATA_BYTES) {
+            data->value.bytes.data = data->value.bytes.length ? payload : NULL;
+            payload += data->value.bytes.length;
+        }
+    }
+}
+
 anjay_batch_t *_anjay_batch_builder_compile(anjay_batch_builder_t **builder) {
     assert(builder && *builder);
-    anjay_batch_t *batch =
-            (anjay_batch_t *) avs_calloc(1, sizeof(anjay_batch_t));
+    const size_t entries_size =
+            (*builder)->entry_count * sizeof(anjay_batch_entry_t);
+    anjay_batch_t *batch = (anjay_batch_t *) avs_malloc(
+            sizeof(anjay_batch_t) + entries_size + (*builder)->payload_size);
     if (!batch) {
         return NULL;
     }
-    batch->list = (*builder)->list;
     batch->ref_count = 1;
     batch->compilation_time = avs_time_real_now();
-    avs_free(*builder);
-    *builder = NULL;
+    batch->entry_count = (*builder)->entry_count;
+    char *payload = (char *) &batch->entries[batch->entry_count];
+    if (entries_size) {
+        memcpy(batch->entries, (*builder)->entries, entries_size);
+    }
+    if ((*builder)->payload_size) {
+        memcpy(payload, (*builder)->payload, (*builder)->payload_size);
+    }
+    link_payloads(batch->entries, batch->entry_count, payload);
+    _anjay_batch_builder_cleanup(builder);
     return batch;
 }
 
@@ -263,7 +327,6 @@ void _anjay_batch_release(anjay_batch_t **batch) {
     assert((*batch)->ref_count);
 
     if (--((*batch)->ref_count) == 0) {
-        list_cleanup((*batch)->list);
         avs_free(*batch);
     }
     *batch = NULL;
@@ -282,8 +345,10 @@ bytes_append(anjay_ret_bytes_ctx_t *ctx, const void *data, size_t length) {
         return -1;
     }
 
-    memcpy(bytes->data, data, length);
-    bytes->data = ((uint8_t *) bytes->data) + length;
+    if (length) {
+        memcpy(bytes->builder->payload + bytes->offset, data, length);
+    }
+    bytes->offset += length;
     bytes->remaining_bytes -= length;
     return 0;
 }
@@ -305,31 +370,27 @@ static int bytes_begin(anjay_output_ctx_t *ctx_,
         return -1;
     }
 
-    void *buf = NULL;
-    if (length) {
-        buf = avs_malloc(length);
-        if (!buf) {
-            return -1;
-        }
+    size_t offset;
+    if (reserve_payload(ctx->builder, length, &offset)) {
+        return -1;
     }
 
     anjay_batch_data_t data = {
         .type = ANJAY_BATCH_DATA_BYTES,
         .value.bytes = {
-            .data = buf,
             .length = length
         }
     };
 
     if (batch_data_add(ctx->builder, &ctx->path, avs_time_real_now(), data)) {
-        avs_free(buf);
+        ctx->builder->payload_size = offset;
         return -1;
     }
 
     value_returned(ctx);
 
-    // Doesn't change owner of buf
-    ctx->bytes.data = buf;
+    ctx->bytes.builder = ctx->builder;
+    ctx->bytes.offset = offset;
     ctx->bytes.remaining_bytes = length;
     *out_bytes_ctx = (anjay_ret_bytes_ctx_t *) &ctx->bytes;
     return 0;
@@ -604,25 +665,28 @@ int _anjay_batch_data_output_entry(
         const anjay_batch_data_output_state_t **state,
         anjay_output_ctx_t *out_ctx) {
     assert(state);
-    const AVS_LIST(anjay_batch_entry_t) it;
+    const anjay_batch_entry_t *it;
+    const anjay_batch_entry_t *const end = &batch->entries[batch->entry_count];
     if (!*state) {
-        it = batch->list;
+        it = batch->entries;
     } else {
         it = &(*state)->entry;
-        assert(AVS_LIST_FIND_PTR(&batch->list, it) != NULL);
+        assert(it >= batch->entries && it < end);
     }
-    while (it
+    while (it < end
            && !is_server_allowed_to_read(anjay, it->path.ids[ANJAY_ID_OID],
                                          it->path.ids[ANJAY_ID_IID],
                                          target_ssid)) {
-        AVS_LIST_ADVANCE(&it);
+        ++it;
     }
     int result = 0;
-    if (it) {
+    if (it < end) {
         result = serialize_batch_entry(it, serialization_time, out_ctx);
-        AVS_LIST_ADVANCE(&it);
+        ++it;
     }
-    *state = AVS_CONTAINER_OF(it, anjay_batch_data_output_state_t, entry);
+    *state = (it < end) ? AVS_CONTAINER_OF(it, anjay_batch_data_output_state_t,
+                                           entry)
+                        : NULL;
     return result;
 }
 
@@ -657,26 +721,26 @@ bool _anjay_batch_values_equal(const anjay_batch_t *a, const anjay_batch_t *b) {
     if (!a || !b) {
         return !a && !b;
     }
-    AVS_LIST(anjay_batch_entry_t) ait = a->list;
-    AVS_LIST(anjay_batch_entry_t) bit = b->list;
-    while (ait && bit) {
-        if (!_anjay_uri_path_equal(&ait->path, &bit->path)
-                || !batch_data_equal(&ait->data, &bit->data)) {
+    if (a->entry_count != b->entry_count) {
+        return false;
+    }
+    for (size_t i = 0; i < a->entry_count; ++i) {
+        if (!_anjay_uri_path_equal(&a->entries[i].path, &b->entries[i].path)
+                || !batch_data_equal(&a->entries[i].data,
+                                     &b->entries[i].data)) {
             return false;
         }
-        AVS_LIST_ADVANCE(&ait);
-        AVS_LIST_ADVANCE(&bit);
     }
-    return !ait && !bit;
+    return true;
 }
 
 bool _anjay_batch_data_requires_hierarchical_format(
         const anjay_batch_t *batch) {
-    if (!batch || !batch->list || AVS_LIST_NEXT(batch->list)) {
+    if (!batch || batch->entry_count != 1) {
         // entry list is not exactly 1 element long
         return true;
     }
-    const anjay_batch_entry_t *const entry = batch->list;
+    const anjay_batch_entry_t *const entry = &batch->entries[0];
     if (entry->data.type == ANJAY_BATCH_DATA_START_AGGREGATE) {
         // batch consists of an empty aggregate, so isn't a single simple value
         return true;
@@ -690,7 +754,7 @@ double _anjay_batch_data_numeric_value(const anjay_batch_t *batch) {
         // not a simple value
         return NAN;
     }
-    const anjay_batch_entry_t *const entry = batch->list;
+    const anjay_batch_entry_t *const entry = &batch->entries[0];
     switch (entry->data.type) {
     case ANJAY_BATCH_DATA_INT:
         return (double) entry->data.value.int_value;
@@ -705,6 +769,178 @@ avs_time_real_t _anjay_batch_get_compilation_time(const anjay_batch_t *batch) {
     return batch->compilation_time;
 }
 
+#ifdef WITH_AVS_PERSISTENCE
+static avs_error_t handle_batch_data(avs_persistence_context_t *ctx,
+                                     anjay_batch_data_t *data) {
+    uint8_t type = (uint8_t) data->type;
+    avs_error_t err = avs_persistence_u8(ctx, &type);
+    if (avs_is_err(err)) {
+        return err;
+    }
+    data->type = (anjay_batch_data_type_t) type;
+
+    switch (data->type) {
+    case ANJAY_BATCH_DATA_BYTES:
+        return avs_persistence_sized_buffer(
+                ctx, (void **) (intptr_t) &data->value.bytes.data,
+                &data->value.bytes.length);
+    case ANJAY_BATCH_DATA_STRING: {
+        const bool restore =
+                (avs_persistence_direction(ctx) == AVS_PERSISTENCE_RESTORE);
+        char *string = NULL;
+        if (!restore) {
+            // NULL is never a valid value here; store it as an empty string
+            string = (char *) (intptr_t) (data->value.string
+                                                  ? data->value.string
+                                                  : "");
+        }
+        if (avs_is_err((err = avs_persistence_string(ctx, &string)))) {
+            return err;
+        }
+        if (restore) {
+            if (!string) {
+                batch_log(DEBUG, "invalid persisted batch string value");
+                return avs_errno(AVS_EBADMSG);
+            }
+            data->value.string = string;
+        }
+        return AVS_OK;
+    }
+    case ANJAY_BATCH_DATA_INT: {
+        uint64_t value = (uint64_t) data->value.int_value;
+        if (avs_is_ok((err = avs_persistence_u64(ctx, &value)))) {
+            data->value.int_value = (int64_t) value;
+        }
+        return err;
+    }
+    case ANJAY_BATCH_DATA_DOUBLE:
+        return avs_persistence_double(ctx, &data->value.double_value);
+    case ANJAY_BATCH_DATA_BOOL:
+        return avs_persistence_bool(ctx, &data->value.bool_value);
+    case ANJAY_BATCH_DATA_OBJLNK:
+        (void) (avs_is_err((err = avs_persistence_u16(
+                                    ctx, &data->value.objlnk.oid)))
+                || avs_is_err((err = avs_persistence_u16(
+                                       ctx, &data->value.objlnk.iid))));
+        return err;
+    case ANJAY_BATCH_DATA_START_AGGREGATE:
+        return AVS_OK;
+    }
+    batch_log(DEBUG, "invalid persisted batch data type: %u", (unsigned) type);
+    return avs_errno(AVS_EBADMSG);
+}
+
+static avs_error_t handle_batch_entry(avs_persistence_context_t *ctx,
+                                      anjay_batch_entry_t *entry) {
+    avs_error_t err = AVS_OK;
+    for (size_t i = 0; avs_is_ok(err) && i < AVS_ARRAY_SIZE(entry->path.ids);
+         ++i) {
+        err = avs_persistence_u16(ctx, &entry->path.ids[i]);
+    }
+    (void) (avs_is_err(err)
+            || avs_is_err(
+                       (err = _anjay_persistence_time(ctx, &entry->timestamp)))
+            || avs_is_err((err = handle_batch_data(ctx, &entry->data))));
+    return err;
+}
+
+static int builder_add_entry(anjay_batch_builder_t *builder,
+                             const anjay_batch_entry_t *entry) {
+    const void *payload = NULL;
+    size_t payload_size = 0;
+    anjay_batch_data_t data = entry->data;
+    if (data.type == ANJAY_BATCH_DATA_STRING) {
+        payload = data.value.string;
+        payload_size = strlen(data.value.string) + 1;
+        data.value.string = NULL;
+    } else if (data.type == ANJAY_BATCH_DATA_BYTES) {
+        payload = data.value.bytes.data;
+        payload_size = data.value.bytes.length;
+        data.value.bytes.data = NULL;
+    }
+    size_t offset;
+    if (reserve_payload(builder, payload_size, &offset)) {
+        return -1;
+    }
+    if (batch_data_add(builder, &entry->path, entry->timestamp, data)) {
+        builder->payload_size = offset;
+        return -1;
+    }
+    if (payload_size) {
+        memcpy(builder->payload + offset, payload, payload_size);
+    }
+    return 0;
+}
+
+static avs_error_t restore_batch_entry(avs_persistence_context_t *ctx,
+                                       anjay_batch_builder_t *builder) {
+    anjay_batch_entry_t entry;
+    memset(&entry, 0, sizeof(entry));
+    avs_error_t err = handle_batch_entry(ctx, &entry);
+    if (avs_is_ok(err) && builder_add_entry(builder, &entry)) {
+        err = avs_errno(AVS_EBADMSG);
+    }
+    // payloads of restored entries are allocated by avs_persistence
+    if (entry.data.type == ANJAY_BATCH_DATA_STRING) {
+        avs_free((void *) (intptr_t) entry.data.value.string);
+    } else if (entry.data.type == ANJAY_BATCH_DATA_BYTES) {
+        avs_free((void *) (intptr_t) entry.data.value.bytes.data);
+    }
+    return err;
+}
+
+static avs_error_t persist_batch(avs_persistence_context_t *ctx,
+                                 anjay_batch_t *batch) {
+    uint32_t count = (uint32_t) batch->entry_count;
+    avs_error_t err;
+    (void) (avs_is_err((err = _anjay_persistence_time(
+                                ctx, &batch->compilation_time)))
+            || avs_is_err((err = avs_persistence_u32(ctx, &count))));
+    for (size_t i = 0; avs_is_ok(err) && i < batch->entry_count; ++i) {
+        err = handle_batch_entry(ctx, &batch->entries[i]);
+    }
+    return err;
+}
+
+static avs_error_t restore_batch(avs_persistence_context_t *ctx,
+                                 anjay_batch_t **out_batch) {
+    anjay_batch_builder_t *builder = _anjay_batch_builder_new();
+    if (!builder) {
+        batch_log(ERROR, "out of memory");
+        return avs_errno(AVS_ENOMEM);
+    }
+    avs_time_real_t compilation_time;
+    uint32_t count;
+    avs_error_t err;
+    (void) (avs_is_err((err = _anjay_persistence_time(ctx, &compilation_time)))
+            || avs_is_err((err = avs_persistence_u32(ctx, &count))));
+    for (uint32_t i = 0; avs_is_ok(err) && i < count; ++i) {
+        err = restore_batch_entry(ctx, builder);
+    }
+    if (avs_is_ok(err)) {
+        if ((*out_batch = _anjay_batch_builder_compile(&builder))) {
+            (*out_batch)->compilation_time = compilation_time;
+        } else {
+            batch_log(ERROR, "out of memory");
+            err = avs_errno(AVS_ENOMEM);
+        }
+    }
+    _anjay_batch_builder_cleanup(&builder);
+    return err;
+}
+
+avs_error_t _anjay_batch_persistence(avs_persistence_context_t *ctx,
+                                     anjay_batch_t **batch_ptr) {
+    assert(batch_ptr);
+    if (avs_persistence_direction(ctx) == AVS_PERSISTENCE_RESTORE) {
+        assert(!*batch_ptr);
+        return restore_batch(ctx, batch_ptr);
+    }
+    assert(*batch_ptr);
+    return persist_batch(ctx, *batch_ptr);
+}
+#endif // WITH_AVS_PERSISTENCE
+
 #ifdef ANJAY_TEST
 #    include "test/batch_builder.c"
 #endif
@@ -19,6 +19,8 @@
 
 #include <anjay/anjay.h>
 
+#include <avsystem/commons/persistence.h>
+
 #include "../dm_core.h"
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
@@ -240,6 +242,19 @@ double _anjay_batch_data_numeric_value(const anjay_batch_t *batch);
  */
 avs_time_real_t _anjay_batch_get_compilation_time(const anjay_batch_t *batch);
 
+#ifdef WITH_AVS_PERSISTENCE
+/**
+ * Stores or restores (depending on the direction of @p ctx) a compiled batch.
+ *
+ * When storing, <c>*batch_ptr</c> MUST point to a valid batch, which is not
+ * modified. When restoring, <c>*batch_ptr</c> MUST be <c>NULL</c> - on success
+ * it is set to a newly allocated batch with refcount of 1; on failure it is
+ * left as <c>NULL</c>.
+ */
+avs_error_t _anjay_batch_persistence(avs_persistence_context_t *ctx,
+                                     anjay_batch_t **batch_ptr);
+#endif // WITH_AVS_PERSISTENCE
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif // ANJAY_BATCH_BUILDER_H
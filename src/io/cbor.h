@@ -0,0 +1,66 @@
+/*
+ * Copyright 2017-2019 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_IO_CBOR_H
+#define ANJAY_IO_CBOR_H
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/**
+ * CBOR major types, as defined in RFC 7049, section 2.1. They occupy the three
+ * most significant bits of the initial byte of each data item.
+ */
+typedef enum {
+    CBOR_MAJOR_TYPE_UINT = 0,
+    CBOR_MAJOR_TYPE_NEGATIVE_INT = 1,
+    CBOR_MAJOR_TYPE_BYTE_STRING = 2,
+    CBOR_MAJOR_TYPE_TEXT_STRING = 3,
+    CBOR_MAJOR_TYPE_ARRAY = 4,
+    CBOR_MAJOR_TYPE_MAP = 5,
+    CBOR_MAJOR_TYPE_TAG = 6,
+    CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_VALUE = 7
+} cbor_major_type_t;
+
+/**
+ * Values of the "additional information" field (five least significant bits of
+ * the initial byte) that have special meaning.
+ */
+#define CBOR_EXT_LENGTH_1BYTE 24
+#define CBOR_EXT_LENGTH_2BYTE 25
+#define CBOR_EXT_LENGTH_4BYTE 26
+#define CBOR_EXT_LENGTH_8BYTE 27
+#define CBOR_EXT_LENGTH_INDEFINITE 31
+
+#define CBOR_VALUE_BOOL_FALSE 20
+#define CBOR_VALUE_BOOL_TRUE 21
+#define CBOR_VALUE_NULL 22
+#define CBOR_VALUE_UNDEFINED 23
+#define CBOR_VALUE_FLOAT_16 25
+#define CBOR_VALUE_FLOAT_32 26
+#define CBOR_VALUE_FLOAT_64 27
+
+#define CBOR_INITIAL_BYTE(MajorType, AdditionalInfo) \
+    ((uint8_t) (((MajorType) << 5) | (AdditionalInfo)))
+
+#define CBOR_INDEFINITE_ARRAY_BEGIN \
+    CBOR_INITIAL_BYTE(CBOR_MAJOR_TYPE_ARRAY, CBOR_EXT_LENGTH_INDEFINITE)
+#define CBOR_BREAK                                            \
+    CBOR_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_VALUE, \
+                      CBOR_EXT_LENGTH_INDEFINITE)
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_IO_CBOR_H */
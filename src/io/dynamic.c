@@ -58,6 +58,14 @@ static anjay_output_ctx_t *spawn_json(avs_stream_t *stream,
 }
 #endif // WITH_LWM2M_JSON
 
+#ifdef WITH_CBOR
+static anjay_output_ctx_t *spawn_senml_cbor(avs_stream_t *stream,
+                                            const anjay_uri_path_t *uri) {
+    return _anjay_output_senml_like_create(stream, uri,
+                                           AVS_COAP_FORMAT_SENML_CBOR);
+}
+#endif // WITH_CBOR
+
 typedef struct {
     uint16_t format;
     anjay_input_ctx_constructor_t *input_ctx_constructor;
@@ -76,6 +84,10 @@ static const dynamic_format_def_t SUPPORTED_HIERARCHICAL_FORMATS[] = {
 #ifdef WITH_LWM2M_JSON
     { AVS_COAP_FORMAT_OMA_LWM2M_JSON, NULL, spawn_json },
 #endif // WITH_LWM2M_JSON
+#ifdef WITH_CBOR
+    { AVS_COAP_FORMAT_SENML_CBOR, _anjay_input_senml_cbor_create,
+      spawn_senml_cbor },
+#endif // WITH_CBOR
     { AVS_COAP_FORMAT_NONE, NULL, NULL }
 };
 
@@ -63,48 +63,69 @@ struct json_encoder_struct {
 
 static int begin_pair(json_encoder_t *ctx, senml_like_data_type_t type);
 
+/**
+ * RFC 4627 section 2.5 Strings:
+ *
+ * "(...)
+ *  All Unicode characters may be placed within the
+ *  quotation marks except for the characters that must be escaped:
+ *  quotation mark, reverse solidus, and the control characters (U+0000
+ *  through U+001F).
+ * "
+ *
+ * Additionally, all bytes outside of the printable ASCII range are escaped.
+ */
+static inline bool needs_escaping(uint8_t c) {
+    return c < 0x20 || c >= 127 || c == '\\' || c == '"';
+}
+
+static avs_error_t write_escaped_char(avs_stream_t *stream, uint8_t c) {
+    switch (c) {
+    case '\\':
+        return avs_stream_write(stream, "\\\\", 2);
+    case '"':
+        return avs_stream_write(stream, "\\\"", 2);
+    case '\b':
+        return avs_stream_write(stream, "\\b", 2);
+    case '\f':
+        return avs_stream_write(stream, "\\f", 2);
+    case '\n':
+        return avs_stream_write(stream, "\\n", 2);
+    case '\r':
+        return avs_stream_write(stream, "\\r", 2);
+    case '\t':
+        return avs_stream_write(stream, "\\t", 2);
+    default: {
+        static const char HEX_DIGITS[] = "0123456789abcdef";
+        const char escaped[] = { '\\', 'u', '0', '0', HEX_DIGITS[c >> 4],
+                                 HEX_DIGITS[c & 0xF] };
+        return avs_stream_write(stream, escaped, sizeof(escaped));
+    }
+    }
+}
+
 static int write_quoted_string(avs_stream_t *stream, const char *value) {
     if (avs_is_err(avs_stream_write(stream, "\"", 1))) {
         return -1;
     }
-    for (size_t i = 0; i < strlen(value); ++i) {
-        /**
-         * RFC 4627 section 2.5 Strings:
-         *
-         * "(...)
-         *  All Unicode characters may be placed within the
-         *  quotation marks except for the characters that must be escaped:
-         *  quotation mark, reverse solidus, and the control characters (U+0000
-         *  through U+001F).
-         * "
-         */
-        if ((value[i] == '\\' || value[i] == '"')
-                && avs_is_err(avs_stream_write(stream, "\\", 1))) {
+    const char *run_start = value;
+    for (const char *ptr = value;; ++ptr) {
+        if (*ptr && !needs_escaping((uint8_t) *ptr)) {
+            continue;
+        }
+        // write the whole run of characters that do not need escaping at once
+        if (ptr > run_start
+                && avs_is_err(avs_stream_write(stream, run_start,
+                                               (size_t) (ptr - run_start)))) {
             return -1;
         }
-
-        avs_error_t err;
-        if ((uint8_t) value[i] >= 0x20 && (uint8_t) value[i] < 127) {
-            err = avs_stream_write(stream, &value[i], 1);
-        } else if (value[i] == '\b') {
-            err = avs_stream_write(stream, "\\b", 2);
-        } else if (value[i] == '\f') {
-            err = avs_stream_write(stream, "\\f", 2);
-        } else if (value[i] == '\n') {
-            err = avs_stream_write(stream, "\\n", 2);
-        } else if (value[i] == '\r') {
-            err = avs_stream_write(stream, "\\r", 2);
-        } else if (value[i] == '\t') {
-            err = avs_stream_write(stream, "\\t", 2);
-        } else {
-            const int nibble0 = ((uint8_t) value[i] >> 4) & 0xF;
-            const int nibble1 = ((uint8_t) value[i]) & 0xF;
-            err = avs_stream_write_f(stream, "\\u00%x%x", nibble0, nibble1);
+        if (!*ptr) {
+            break;
         }
-
-        if (avs_is_err(err)) {
+        if (avs_is_err(write_escaped_char(stream, (uint8_t) *ptr))) {
             return -1;
         }
+        run_start = ptr + 1;
     }
     return avs_is_ok(avs_stream_write(stream, "\"", 1)) ? 0 : -1;
 }
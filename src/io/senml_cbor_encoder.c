@@ -0,0 +1,322 @@
+/*
+ * Copyright 2017-2019 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <math.h>
+#include <string.h>
+
+#include <avsystem/commons/log.h>
+#include <avsystem/commons/memory.h>
+#include <avsystem/commons/utils.h>
+
+#include "../io_core.h"
+#include "cbor.h"
+#include "common.h"
+#include "senml_like_encoder_vtable.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+#define cbor_log(level, ...) _anjay_log(senml_cbor, level, __VA_ARGS__)
+
+#define CBOR_CONTEXT_LEVEL_ARRAY 0
+#define CBOR_CONTEXT_LEVEL_MAP 1
+#define CBOR_CONTEXT_LEVEL_BYTES 2
+
+#define CBOR_MAX_CONTEXT_LEVEL 2
+
+typedef struct {
+    const anjay_senml_like_encoder_vtable_t *vtable;
+    avs_stream_t *stream;
+    // number of bytes of the currently encoded opaque value that still need to
+    // be passed to bytes_append()
+    size_t bytes_left;
+    uint8_t level;
+} senml_cbor_encoder_t;
+
+static inline void nested_context_push(senml_cbor_encoder_t *ctx,
+                                       uint8_t level) {
+    assert(ctx);
+    assert(ctx->level < CBOR_MAX_CONTEXT_LEVEL);
+    assert(ctx->level == level - 1);
+    (void) level;
+    ctx->level++;
+}
+
+static inline void nested_context_pop(senml_cbor_encoder_t *ctx) {
+    (void) ctx;
+    assert(ctx->level);
+    ctx->level--;
+}
+
+static int write_header(avs_stream_t *stream,
+                        cbor_major_type_t major_type,
+                        uint64_t argument) {
+    uint8_t buf[9];
+    size_t size;
+    if (argument < CBOR_EXT_LENGTH_1BYTE) {
+        buf[0] = CBOR_INITIAL_BYTE(major_type, argument);
+        size = 1;
+    } else if (argument <= UINT8_MAX) {
+        buf[0] = CBOR_INITIAL_BYTE(major_type, CBOR_EXT_LENGTH_1BYTE);
+        buf[1] = (uint8_t) argument;
+        size = 2;
+    } else if (argument <= UINT16_MAX) {
+        uint16_t value = avs_convert_be16((uint16_t) argument);
+        buf[0] = CBOR_INITIAL_BYTE(major_type, CBOR_EXT_LENGTH_2BYTE);
+        memcpy(&buf[1], &value, sizeof(value));
+        size = 1 + sizeof(value);
+    } else if (argument <= UINT32_MAX) {
+        uint32_t value = avs_convert_be32((uint32_t) argument);
+        buf[0] = CBOR_INITIAL_BYTE(major_type, CBOR_EXT_LENGTH_4BYTE);
+        memcpy(&buf[1], &value, sizeof(value));
+        size = 1 + sizeof(value);
+    } else {
+        uint64_t value = avs_convert_be64(argument);
+        buf[0] = CBOR_INITIAL_BYTE(major_type, CBOR_EXT_LENGTH_8BYTE);
+        memcpy(&buf[1], &value, sizeof(value));
+        size = 1 + sizeof(value);
+    }
+    return avs_is_ok(avs_stream_write(stream, buf, size)) ? 0 : -1;
+}
+
+static int write_int(avs_stream_t *stream, int64_t value) {
+    if (value >= 0) {
+        return write_header(stream, CBOR_MAJOR_TYPE_UINT, (uint64_t) value);
+    }
+    // -1 - value, computed without overflowing for INT64_MIN
+    return write_header(stream, CBOR_MAJOR_TYPE_NEGATIVE_INT,
+                        (uint64_t) (-(value + 1)));
+}
+
+static int write_text(avs_stream_t *stream, const char *value) {
+    size_t length = strlen(value);
+    if (write_header(stream, CBOR_MAJOR_TYPE_TEXT_STRING, length)
+            || avs_is_err(avs_stream_write(stream, value, length))) {
+        return -1;
+    }
+    return 0;
+}
+
+static int write_label(senml_cbor_encoder_t *ctx, senml_label_t label) {
+    if (ctx->level != CBOR_CONTEXT_LEVEL_MAP) {
+        return -1;
+    }
+    if (label == SENML_EXT_LABEL_OBJLNK) {
+        return write_text(ctx->stream, SENML_EXT_OBJLNK_REPR);
+    }
+    return write_int(ctx->stream, (int64_t) label);
+}
+
+static int encode_uint(anjay_senml_like_encoder_t *ctx_, uint64_t value) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (write_label(ctx, SENML_LABEL_VALUE)
+            || write_header(ctx->stream, CBOR_MAJOR_TYPE_UINT, value)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int encode_int(anjay_senml_like_encoder_t *ctx_, int64_t value) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (write_label(ctx, SENML_LABEL_VALUE) || write_int(ctx->stream, value)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int write_double(avs_stream_t *stream, double value) {
+    // Single precision is used whenever it does not lose any information, which
+    // is the case for most of the values coming from sensors.
+    if (isnan(value) || (double) (float) value == value) {
+        uint8_t buf[5] = { CBOR_INITIAL_BYTE(
+                CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_VALUE, CBOR_VALUE_FLOAT_32) };
+        uint32_t raw = avs_htonf((float) value);
+        memcpy(&buf[1], &raw, sizeof(raw));
+        return avs_is_ok(avs_stream_write(stream, buf, sizeof(buf))) ? 0 : -1;
+    } else {
+        uint8_t buf[9] = { CBOR_INITIAL_BYTE(
+                CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_VALUE, CBOR_VALUE_FLOAT_64) };
+        uint64_t raw = avs_htond(value);
+        memcpy(&buf[1], &raw, sizeof(raw));
+        return avs_is_ok(avs_stream_write(stream, buf, sizeof(buf))) ? 0 : -1;
+    }
+}
+
+static int encode_double(anjay_senml_like_encoder_t *ctx_, double value) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (write_label(ctx, SENML_LABEL_VALUE) || write_double(ctx->stream, value)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int encode_bool(anjay_senml_like_encoder_t *ctx_, bool value) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    const uint8_t data =
+            CBOR_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_VALUE,
+                              value ? CBOR_VALUE_BOOL_TRUE
+                                    : CBOR_VALUE_BOOL_FALSE);
+    if (write_label(ctx, SENML_LABEL_VALUE_BOOL)
+            || avs_is_err(avs_stream_write(ctx->stream, &data, 1))) {
+        return -1;
+    }
+    return 0;
+}
+
+static int encode_string(anjay_senml_like_encoder_t *ctx_, const char *value) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (write_label(ctx, SENML_LABEL_VALUE_STRING)
+            || write_text(ctx->stream, value)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int encode_objlnk(anjay_senml_like_encoder_t *ctx_, const char *value) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (write_label(ctx, SENML_EXT_LABEL_OBJLNK)
+            || write_text(ctx->stream, value)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int element_begin(anjay_senml_like_encoder_t *ctx_,
+                         const char *basename,
+                         const char *name,
+                         double time_s) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    // Exactly one value is encoded in every element, hence the "+ 1".
+    size_t pairs = (basename ? 1 : 0) + (name ? 1 : 0) + (isnan(time_s) ? 0 : 1)
+                   + 1;
+
+    if (write_header(ctx->stream, CBOR_MAJOR_TYPE_MAP, pairs)) {
+        return -1;
+    }
+    nested_context_push(ctx, CBOR_CONTEXT_LEVEL_MAP);
+    if ((basename
+         && (write_label(ctx, SENML_LABEL_BASE_NAME)
+             || write_text(ctx->stream, basename)))
+            || (name
+                && (write_label(ctx, SENML_LABEL_NAME)
+                    || write_text(ctx->stream, name)))
+            || (!isnan(time_s)
+                && (write_label(ctx, SENML_LABEL_TIME)
+                    || write_double(ctx->stream, time_s)))) {
+        return -1;
+    }
+    return 0;
+}
+
+static int element_end(anjay_senml_like_encoder_t *ctx_) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    // maps are definite-length, so there is nothing to terminate
+    nested_context_pop(ctx);
+    return 0;
+}
+
+static int bytes_begin(anjay_senml_like_encoder_t *ctx_, size_t size) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (write_label(ctx, SENML_LABEL_VALUE_OPAQUE)
+            || write_header(ctx->stream, CBOR_MAJOR_TYPE_BYTE_STRING, size)) {
+        return -1;
+    }
+    nested_context_push(ctx, CBOR_CONTEXT_LEVEL_BYTES);
+    ctx->bytes_left = size;
+    return 0;
+}
+
+static int
+bytes_append(anjay_senml_like_encoder_t *ctx_, const void *data, size_t size) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (ctx->level != CBOR_CONTEXT_LEVEL_BYTES || size > ctx->bytes_left) {
+        cbor_log(DEBUG, "attempted to write more bytes than declared");
+        return -1;
+    }
+    ctx->bytes_left -= size;
+    return avs_is_ok(avs_stream_write(ctx->stream, data, size)) ? 0 : -1;
+}
+
+static int bytes_end(anjay_senml_like_encoder_t *ctx_) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    nested_context_pop(ctx);
+    if (ctx->bytes_left) {
+        cbor_log(DEBUG, "%lu declared bytes were not written",
+                 (unsigned long) ctx->bytes_left);
+        return -1;
+    }
+    return 0;
+}
+
+static int encoder_cleanup(anjay_senml_like_encoder_t **ctx_) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) *ctx_;
+    const uint8_t data = CBOR_BREAK;
+    int retval = -1;
+
+    if (ctx->level == CBOR_CONTEXT_LEVEL_ARRAY
+            && avs_is_ok(avs_stream_write(ctx->stream, &data, 1))) {
+        retval = 0;
+    }
+
+    avs_free(*ctx_);
+    *ctx_ = NULL;
+    return retval;
+}
+
+static const anjay_senml_like_encoder_vtable_t SENML_CBOR_ENCODER_VTABLE = {
+    .senml_like_encode_uint = encode_uint,
+    .senml_like_encode_int = encode_int,
+    .senml_like_encode_double = encode_double,
+    .senml_like_encode_bool = encode_bool,
+    .senml_like_encode_string = encode_string,
+    .senml_like_encode_objlnk = encode_objlnk,
+    .senml_like_element_begin = element_begin,
+    .senml_like_element_end = element_end,
+    .senml_like_bytes_begin = bytes_begin,
+    .senml_like_bytes_append = bytes_append,
+    .senml_like_bytes_end = bytes_end,
+    .senml_like_encoder_cleanup = encoder_cleanup
+};
+
+anjay_senml_like_encoder_t *_anjay_senml_cbor_encoder_new(avs_stream_t *stream) {
+    if (!stream) {
+        cbor_log(DEBUG, "no stream provided");
+        return NULL;
+    }
+
+    senml_cbor_encoder_t *ctx =
+            (senml_cbor_encoder_t *) avs_calloc(1, sizeof(senml_cbor_encoder_t));
+    if (!ctx) {
+        cbor_log(DEBUG, "failed to allocate encoder context");
+        return NULL;
+    }
+    ctx->vtable = &SENML_CBOR_ENCODER_VTABLE;
+    ctx->stream = stream;
+
+    // The number of records is not known upfront, so the top-level array is
+    // encoded as indefinite-length one and terminated in encoder_cleanup().
+    const uint8_t data = CBOR_INDEFINITE_ARRAY_BEGIN;
+    if (avs_is_err(avs_stream_write(stream, &data, 1))) {
+        avs_free(ctx);
+        return NULL;
+    }
+    return (anjay_senml_like_encoder_t *) ctx;
+}
+
+#ifdef ANJAY_TEST
+#    include "test/senml_cbor_encoder.c"
+#endif
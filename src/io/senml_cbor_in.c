@@ -0,0 +1,794 @@
+/*
+ * Copyright 2017-2019 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <math.h>
+#include <string.h>
+
+#include <avsystem/commons/memory.h>
+#include <avsystem/commons/stream.h>
+#include <avsystem/commons/utils.h>
+
+#include "../utils_core.h"
+
+#include "cbor.h"
+#include "common.h"
+#include "vtable.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+#define LOG(...) _anjay_log(senml_cbor_in, __VA_ARGS__)
+
+/* Maximum nesting level of unknown values that are skipped */
+#define MAX_SKIPPED_NESTING_LEVEL 4
+
+/* Smallest piece in which string values are read into memory */
+#define STRING_MIN_READ_STEP 256
+
+/* Label value used for keys not recognized by this implementation */
+#define SENML_LABEL_UNKNOWN INT64_MAX
+
+typedef struct {
+    cbor_major_type_t major_type;
+    bool indefinite;
+    uint8_t additional_info;
+    uint64_t argument;
+} cbor_header_t;
+
+typedef enum {
+    SENML_CBOR_VALUE_INT,
+    SENML_CBOR_VALUE_UINT,
+    SENML_CBOR_VALUE_DOUBLE,
+    SENML_CBOR_VALUE_BOOL,
+    SENML_CBOR_VALUE_STRING,
+    SENML_CBOR_VALUE_OPAQUE,
+    SENML_CBOR_VALUE_OBJLNK
+} senml_cbor_value_type_t;
+
+typedef struct {
+    anjay_uri_path_t path;
+    senml_cbor_value_type_t type;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        bool b;
+    } value;
+    // used for string, opaque and objlnk values
+    char *data;
+    size_t length;
+    size_t bytes_read;
+} senml_cbor_entry_t;
+
+typedef struct {
+    const anjay_input_ctx_vtable_t *vtable;
+    avs_stream_t *stream;
+
+    anjay_uri_path_t uri_path;
+    // SenML Base Name applies to all subsequent records, until redefined
+    char basename[MAX_PATH_STRING_SIZE];
+
+    bool array_started;
+    bool array_indefinite;
+    uint64_t array_items_left;
+    bool finished;
+
+    bool has_entry;
+    senml_cbor_entry_t entry;
+} senml_cbor_in_t;
+
+static int read_bytes(senml_cbor_in_t *ctx, void *out, size_t size) {
+    avs_error_t err = avs_stream_read_reliably(ctx->stream, out, size);
+    if (avs_is_eof(err)) {
+        LOG(DEBUG, "unexpected end of CBOR payload");
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    return avs_is_ok(err) ? 0 : -1;
+}
+
+static int ignore_bytes(senml_cbor_in_t *ctx, uint64_t size) {
+    char ignored[64];
+    while (size) {
+        size_t chunk = (size_t) AVS_MIN(size, sizeof(ignored));
+        int result = read_bytes(ctx, ignored, chunk);
+        if (result) {
+            return result;
+        }
+        size -= chunk;
+    }
+    return 0;
+}
+
+static int decode_header(senml_cbor_in_t *ctx,
+                         uint8_t initial_byte,
+                         cbor_header_t *out_header) {
+    out_header->major_type = (cbor_major_type_t) (initial_byte >> 5);
+    out_header->additional_info = (uint8_t) (initial_byte & 0x1F);
+    out_header->indefinite = false;
+    out_header->argument = 0;
+
+    if (out_header->additional_info < CBOR_EXT_LENGTH_1BYTE) {
+        out_header->argument = out_header->additional_info;
+    } else if (out_header->additional_info <= CBOR_EXT_LENGTH_8BYTE) {
+        uint8_t buf[8];
+        size_t length = (size_t) 1 << (out_header->additional_info
+                                       - CBOR_EXT_LENGTH_1BYTE);
+        int result = read_bytes(ctx, buf, length);
+        if (result) {
+            return result;
+        }
+        for (size_t i = 0; i < length; ++i) {
+            out_header->argument = (out_header->argument << 8) | buf[i];
+        }
+    } else if (out_header->additional_info == CBOR_EXT_LENGTH_INDEFINITE
+               && out_header->major_type != CBOR_MAJOR_TYPE_UINT
+               && out_header->major_type != CBOR_MAJOR_TYPE_NEGATIVE_INT
+               && out_header->major_type != CBOR_MAJOR_TYPE_TAG) {
+        out_header->indefinite = true;
+    } else {
+        LOG(DEBUG, "malformed CBOR initial byte: 0x%02x",
+            (unsigned) initial_byte);
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    return 0;
+}
+
+static int read_header(senml_cbor_in_t *ctx, cbor_header_t *out_header) {
+    uint8_t initial_byte;
+    int result = read_bytes(ctx, &initial_byte, 1);
+    if (result) {
+        return result;
+    }
+    return decode_header(ctx, initial_byte, out_header);
+}
+
+static bool is_break(const cbor_header_t *header) {
+    return header->major_type == CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_VALUE
+           && header->indefinite;
+}
+
+static bool is_string(const cbor_header_t *header) {
+    return header->major_type == CBOR_MAJOR_TYPE_BYTE_STRING
+           || header->major_type == CBOR_MAJOR_TYPE_TEXT_STRING;
+}
+
+static int append_chunk(senml_cbor_in_t *ctx,
+                        uint64_t chunk_length,
+                        char **inout_buf,
+                        size_t *inout_length) {
+    if (chunk_length >= SIZE_MAX - *inout_length) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    const size_t end_length = *inout_length + (size_t) chunk_length;
+    int result = 0;
+    // The declared length comes from the peer, so the buffer is not allocated
+    // up front - it grows at most twice the size of the data actually read so
+    // far, and a truncated payload fails before anything big is allocated.
+    do {
+        size_t step = AVS_MIN(end_length - *inout_length,
+                              AVS_MAX(*inout_length, STRING_MIN_READ_STEP));
+        size_t new_length = *inout_length + step;
+        char *new_buf = (char *) avs_realloc(*inout_buf, new_length + 1);
+        if (!new_buf) {
+            LOG(ERROR, "out of memory");
+            return ANJAY_ERR_INTERNAL;
+        }
+        *inout_buf = new_buf;
+        result = read_bytes(ctx, new_buf + *inout_length, step);
+        new_buf[new_length] = '\0';
+        *inout_length = new_length;
+    } while (!result && *inout_length < end_length);
+    return result;
+}
+
+/**
+ * Reads a byte or text string described by @p header into a newly allocated,
+ * zero-terminated buffer. Indefinite-length strings are concatenated.
+ */
+static int read_string(senml_cbor_in_t *ctx,
+                       const cbor_header_t *header,
+                       char **out_buf,
+                       size_t *out_length) {
+    assert(is_string(header));
+    *out_buf = NULL;
+    *out_length = 0;
+    int result = 0;
+    if (!header->indefinite) {
+        result = append_chunk(ctx, header->argument, out_buf, out_length);
+    } else {
+        // make sure the result is a valid empty string if there are no chunks
+        result = append_chunk(ctx, 0, out_buf, out_length);
+        cbor_header_t chunk;
+        while (!result && !(result = read_header(ctx, &chunk))
+               && !is_break(&chunk)) {
+            if (chunk.major_type != header->major_type || chunk.indefinite) {
+                LOG(DEBUG, "invalid chunk of indefinite-length string");
+                result = ANJAY_ERR_BAD_REQUEST;
+            } else {
+                result = append_chunk(ctx, chunk.argument, out_buf,
+                                      out_length);
+            }
+        }
+    }
+    if (result) {
+        avs_free(*out_buf);
+        *out_buf = NULL;
+    }
+    return result;
+}
+
+static int read_short_text(senml_cbor_in_t *ctx,
+                           const cbor_header_t *header,
+                           char *out_buf,
+                           size_t buf_size) {
+    if (header->major_type != CBOR_MAJOR_TYPE_TEXT_STRING) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    char *data;
+    size_t length;
+    int result = read_string(ctx, header, &data, &length);
+    if (!result) {
+        if (length >= buf_size) {
+            result = ANJAY_ERR_BAD_REQUEST;
+        } else {
+            memcpy(out_buf, data, length + 1);
+        }
+        avs_free(data);
+    }
+    return result;
+}
+
+static int skip_value(senml_cbor_in_t *ctx,
+                      const cbor_header_t *header,
+                      unsigned nesting_level) {
+    if (nesting_level > MAX_SKIPPED_NESTING_LEVEL) {
+        LOG(DEBUG, "unknown value nested too deeply");
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    int result = 0;
+    switch (header->major_type) {
+    case CBOR_MAJOR_TYPE_BYTE_STRING:
+    case CBOR_MAJOR_TYPE_TEXT_STRING:
+        if (!header->indefinite) {
+            return ignore_bytes(ctx, header->argument);
+        }
+        // indefinite-length strings are skipped chunk by chunk, just like the
+        // contents of arrays
+        // fall-through
+    case CBOR_MAJOR_TYPE_ARRAY:
+    case CBOR_MAJOR_TYPE_MAP:
+    case CBOR_MAJOR_TYPE_TAG: {
+        uint64_t items = header->argument;
+        if (header->major_type == CBOR_MAJOR_TYPE_MAP) {
+            if (items > UINT64_MAX / 2) {
+                return ANJAY_ERR_BAD_REQUEST;
+            }
+            items *= 2;
+        } else if (header->major_type == CBOR_MAJOR_TYPE_TAG) {
+            items = 1;
+        }
+        for (uint64_t i = 0; !result && (header->indefinite || i < items);
+             ++i) {
+            cbor_header_t item;
+            if (!(result = read_header(ctx, &item))) {
+                if (header->indefinite && is_break(&item)) {
+                    break;
+                }
+                result = skip_value(ctx, &item, nesting_level + 1);
+            }
+        }
+        return result;
+    }
+    default:
+        // integers, floats and simple values have been consumed along with
+        // their headers
+        return is_break(header) ? ANJAY_ERR_BAD_REQUEST : 0;
+    }
+}
+
+static double decode_half_float(uint16_t half) {
+    // see RFC 7049, Appendix D
+    int exponent = (half >> 10) & 0x1F;
+    int mantissa = half & 0x3FF;
+    double value;
+    if (exponent == 0) {
+        value = ldexp(mantissa, -24);
+    } else if (exponent != 31) {
+        value = ldexp(mantissa + 1024, exponent - 25);
+    } else {
+        value = (mantissa == 0) ? INFINITY : NAN;
+    }
+    return (half & 0x8000) ? -value : value;
+}
+
+static int decode_number(const cbor_header_t *header,
+                         senml_cbor_entry_t *out_entry) {
+    switch (header->major_type) {
+    case CBOR_MAJOR_TYPE_UINT:
+        if (header->argument <= INT64_MAX) {
+            out_entry->type = SENML_CBOR_VALUE_INT;
+            out_entry->value.i = (int64_t) header->argument;
+        } else {
+            out_entry->type = SENML_CBOR_VALUE_UINT;
+            out_entry->value.u = header->argument;
+        }
+        return 0;
+    case CBOR_MAJOR_TYPE_NEGATIVE_INT:
+        if (header->argument > INT64_MAX) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        out_entry->type = SENML_CBOR_VALUE_INT;
+        out_entry->value.i = -1 - (int64_t) header->argument;
+        return 0;
+    case CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_VALUE:
+        out_entry->type = SENML_CBOR_VALUE_DOUBLE;
+        switch (header->additional_info) {
+        case CBOR_VALUE_FLOAT_16:
+            out_entry->value.d =
+                    decode_half_float((uint16_t) header->argument);
+            return 0;
+        case CBOR_VALUE_FLOAT_32:
+            out_entry->value.d = avs_ntohf(
+                    avs_convert_be32((uint32_t) header->argument));
+            return 0;
+        case CBOR_VALUE_FLOAT_64:
+            out_entry->value.d = avs_ntohd(avs_convert_be64(header->argument));
+            return 0;
+        default:
+            break;
+        }
+        // fall-through
+    default:
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+}
+
+static int read_label(senml_cbor_in_t *ctx,
+                      const cbor_header_t *header,
+                      int64_t *out_label) {
+    *out_label = SENML_LABEL_UNKNOWN;
+    switch (header->major_type) {
+    case CBOR_MAJOR_TYPE_UINT:
+        if (header->argument <= INT32_MAX) {
+            *out_label = (int64_t) header->argument;
+        }
+        return 0;
+    case CBOR_MAJOR_TYPE_NEGATIVE_INT:
+        if (header->argument <= INT32_MAX) {
+            *out_label = -1 - (int64_t) header->argument;
+        }
+        return 0;
+    case CBOR_MAJOR_TYPE_TEXT_STRING: {
+        char *key;
+        size_t length;
+        int result = read_string(ctx, header, &key, &length);
+        if (!result && !strcmp(key, SENML_EXT_OBJLNK_REPR)) {
+            *out_label = SENML_EXT_LABEL_OBJLNK;
+        }
+        avs_free(key);
+        return result;
+    }
+    default:
+        LOG(DEBUG, "invalid SenML label type");
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+}
+
+static int read_value(senml_cbor_in_t *ctx,
+                      int64_t label,
+                      const cbor_header_t *header) {
+    senml_cbor_entry_t *entry = &ctx->entry;
+    switch (label) {
+    case SENML_LABEL_VALUE:
+        return decode_number(header, entry);
+    case SENML_LABEL_VALUE_BOOL:
+        if (header->major_type != CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_VALUE
+                || (header->additional_info != CBOR_VALUE_BOOL_FALSE
+                    && header->additional_info != CBOR_VALUE_BOOL_TRUE)) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        entry->type = SENML_CBOR_VALUE_BOOL;
+        entry->value.b = (header->additional_info == CBOR_VALUE_BOOL_TRUE);
+        return 0;
+    case SENML_LABEL_VALUE_OPAQUE:
+        if (header->major_type != CBOR_MAJOR_TYPE_BYTE_STRING) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        entry->type = SENML_CBOR_VALUE_OPAQUE;
+        return read_string(ctx, header, &entry->data, &entry->length);
+    case SENML_LABEL_VALUE_STRING:
+    case SENML_EXT_LABEL_OBJLNK:
+        if (header->major_type != CBOR_MAJOR_TYPE_TEXT_STRING) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        entry->type = (label == SENML_LABEL_VALUE_STRING)
+                              ? SENML_CBOR_VALUE_STRING
+                              : SENML_CBOR_VALUE_OBJLNK;
+        return read_string(ctx, header, &entry->data, &entry->length);
+    default:
+        AVS_UNREACHABLE("not a value label");
+        return -1;
+    }
+}
+
+static int parse_path(const char *str, anjay_uri_path_t *out_path) {
+    *out_path = MAKE_ROOT_PATH();
+    size_t index = 0;
+    while (*str) {
+        if (*str++ != '/' || index >= AVS_ARRAY_SIZE(out_path->ids)) {
+            return -1;
+        }
+        const char *start = str;
+        uint32_t id = 0;
+        while (*str >= '0' && *str <= '9') {
+            id = id * 10 + (uint32_t) (*str++ - '0');
+            if (id >= ANJAY_ID_INVALID) {
+                return -1;
+            }
+        }
+        if (str == start) {
+            return -1;
+        }
+        out_path->ids[index++] = (uint16_t) id;
+    }
+    return index ? 0 : -1;
+}
+
+static int parse_record(senml_cbor_in_t *ctx, const cbor_header_t *header) {
+    if (header->major_type != CBOR_MAJOR_TYPE_MAP) {
+        LOG(DEBUG, "SenML record is not a CBOR map");
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    char name[MAX_PATH_STRING_SIZE] = "";
+    bool has_value = false;
+    int result = 0;
+    for (uint64_t i = 0; !result && (header->indefinite || i < header->argument);
+         ++i) {
+        cbor_header_t key;
+        cbor_header_t value;
+        int64_t label;
+        if ((result = read_header(ctx, &key))) {
+            break;
+        }
+        if (header->indefinite && is_break(&key)) {
+            break;
+        }
+        if ((result = read_label(ctx, &key, &label))
+                || (result = read_header(ctx, &value))) {
+            break;
+        }
+        switch (label) {
+        case SENML_LABEL_BASE_NAME:
+            result = read_short_text(ctx, &value, ctx->basename,
+                                     sizeof(ctx->basename));
+            break;
+        case SENML_LABEL_NAME:
+            result = read_short_text(ctx, &value, name, sizeof(name));
+            break;
+        case SENML_LABEL_VALUE:
+        case SENML_LABEL_VALUE_STRING:
+        case SENML_LABEL_VALUE_BOOL:
+        case SENML_LABEL_VALUE_OPAQUE:
+        case SENML_EXT_LABEL_OBJLNK:
+            if (has_value) {
+                LOG(DEBUG, "more than one value in a single SenML record");
+                result = ANJAY_ERR_BAD_REQUEST;
+            } else {
+                result = read_value(ctx, label, &value);
+                has_value = true;
+            }
+            break;
+        default:
+            // time and any other labels are irrelevant for writes
+            result = skip_value(ctx, &value, 0);
+            break;
+        }
+    }
+    if (result) {
+        return result;
+    }
+    if (!has_value) {
+        LOG(DEBUG, "SenML record without a value");
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+
+    char full_name[2 * MAX_PATH_STRING_SIZE];
+    if (avs_simple_snprintf(full_name, sizeof(full_name), "%s%s",
+                            ctx->basename, name)
+                    < 0
+            || parse_path(full_name, &ctx->entry.path)
+            || !_anjay_uri_path_has(&ctx->entry.path, ANJAY_ID_RID)) {
+        LOG(DEBUG, "invalid SenML record name: %s", full_name);
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    if (_anjay_uri_path_outside_base(&ctx->entry.path, &ctx->uri_path)) {
+        LOG(LAZY_DEBUG, "parsed path %s would be outside of uri-path %s",
+            ANJAY_DEBUG_MAKE_PATH(&ctx->entry.path),
+            ANJAY_DEBUG_MAKE_PATH(&ctx->uri_path));
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    return 0;
+}
+
+static void clear_entry(senml_cbor_in_t *ctx) {
+    avs_free(ctx->entry.data);
+    memset(&ctx->entry, 0, sizeof(ctx->entry));
+    ctx->has_entry = false;
+}
+
+static int read_next_record(senml_cbor_in_t *ctx) {
+    cbor_header_t header;
+    int result;
+    if (!ctx->array_started) {
+        uint8_t initial_byte;
+        avs_error_t err =
+                avs_stream_read_reliably(ctx->stream, &initial_byte, 1);
+        if (avs_is_eof(err)) {
+            // empty payload
+            ctx->finished = true;
+            return ANJAY_GET_PATH_END;
+        } else if (avs_is_err(err)) {
+            return -1;
+        }
+        if ((result = decode_header(ctx, initial_byte, &header))) {
+            return result;
+        }
+        if (header.major_type != CBOR_MAJOR_TYPE_ARRAY) {
+            LOG(DEBUG, "SenML payload is not a CBOR array");
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        ctx->array_started = true;
+        ctx->array_indefinite = header.indefinite;
+        ctx->array_items_left = header.argument;
+    }
+    if (!ctx->array_indefinite && !ctx->array_items_left) {
+        ctx->finished = true;
+        return ANJAY_GET_PATH_END;
+    }
+    if ((result = read_header(ctx, &header))) {
+        return result;
+    }
+    if (ctx->array_indefinite && is_break(&header)) {
+        ctx->finished = true;
+        return ANJAY_GET_PATH_END;
+    }
+    if (!ctx->array_indefinite) {
+        --ctx->array_items_left;
+    }
+    if ((result = parse_record(ctx, &header))) {
+        clear_entry(ctx);
+        return result;
+    }
+    ctx->has_entry = true;
+    return 0;
+}
+
+static int senml_cbor_get_path(anjay_input_ctx_t *ctx_,
+                               anjay_uri_path_t *out_path,
+                               bool *out_is_array) {
+    senml_cbor_in_t *ctx = (senml_cbor_in_t *) ctx_;
+    if (ctx->finished) {
+        return ANJAY_GET_PATH_END;
+    }
+    if (!ctx->has_entry) {
+        int result = read_next_record(ctx);
+        if (result) {
+            return result;
+        }
+    }
+    *out_path = ctx->entry.path;
+    *out_is_array = false;
+    return 0;
+}
+
+static int senml_cbor_next_entry(anjay_input_ctx_t *ctx_) {
+    senml_cbor_in_t *ctx = (senml_cbor_in_t *) ctx_;
+    // whole record has already been read in get_path, so there is nothing left
+    // to consume from the stream
+    clear_entry(ctx);
+    return 0;
+}
+
+static int get_entry(senml_cbor_in_t *ctx, senml_cbor_entry_t **out_entry) {
+    if (!ctx->has_entry) {
+        int result = _anjay_input_get_path((anjay_input_ctx_t *) ctx, NULL,
+                                           NULL);
+        if (result) {
+            return result == ANJAY_GET_PATH_END ? ANJAY_ERR_BAD_REQUEST
+                                                : result;
+        }
+    }
+    *out_entry = &ctx->entry;
+    return 0;
+}
+
+static int senml_cbor_get_some_bytes(anjay_input_ctx_t *ctx_,
+                                     size_t *out_bytes_read,
+                                     bool *out_message_finished,
+                                     void *out_buf,
+                                     size_t buf_size) {
+    senml_cbor_in_t *ctx = (senml_cbor_in_t *) ctx_;
+    senml_cbor_entry_t *entry;
+    int result = get_entry(ctx, &entry);
+    if (result) {
+        return result;
+    }
+    if (entry->type != SENML_CBOR_VALUE_OPAQUE
+            && entry->type != SENML_CBOR_VALUE_STRING) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    *out_bytes_read = AVS_MIN(buf_size, entry->length - entry->bytes_read);
+    memcpy(out_buf, entry->data + entry->bytes_read, *out_bytes_read);
+    entry->bytes_read += *out_bytes_read;
+    *out_message_finished = (entry->bytes_read == entry->length);
+    return 0;
+}
+
+static int
+senml_cbor_get_string(anjay_input_ctx_t *ctx_, char *out_buf, size_t buf_size) {
+    senml_cbor_in_t *ctx = (senml_cbor_in_t *) ctx_;
+    senml_cbor_entry_t *entry;
+    int result = get_entry(ctx, &entry);
+    if (result) {
+        return result;
+    }
+    if (entry->type != SENML_CBOR_VALUE_STRING || !buf_size) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    size_t bytes_to_copy =
+            AVS_MIN(buf_size - 1, entry->length - entry->bytes_read);
+    memcpy(out_buf, entry->data + entry->bytes_read, bytes_to_copy);
+    out_buf[bytes_to_copy] = '\0';
+    entry->bytes_read += bytes_to_copy;
+    return entry->bytes_read == entry->length ? 0 : ANJAY_BUFFER_TOO_SHORT;
+}
+
+static int senml_cbor_get_integer(anjay_input_ctx_t *ctx_, int64_t *value) {
+    senml_cbor_in_t *ctx = (senml_cbor_in_t *) ctx_;
+    senml_cbor_entry_t *entry;
+    int result = get_entry(ctx, &entry);
+    if (result) {
+        return result;
+    }
+    switch (entry->type) {
+    case SENML_CBOR_VALUE_INT:
+        *value = entry->value.i;
+        return 0;
+    case SENML_CBOR_VALUE_DOUBLE:
+        // integral values may have been encoded as floating-point numbers
+        if (entry->value.d == floor(entry->value.d)
+                && entry->value.d >= (double) INT64_MIN
+                && entry->value.d < (double) INT64_MAX) {
+            *value = (int64_t) entry->value.d;
+            return 0;
+        }
+        // fall-through
+    default:
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+}
+
+static int senml_cbor_get_double(anjay_input_ctx_t *ctx_, double *value) {
+    senml_cbor_in_t *ctx = (senml_cbor_in_t *) ctx_;
+    senml_cbor_entry_t *entry;
+    int result = get_entry(ctx, &entry);
+    if (result) {
+        return result;
+    }
+    switch (entry->type) {
+    case SENML_CBOR_VALUE_INT:
+        *value = (double) entry->value.i;
+        return 0;
+    case SENML_CBOR_VALUE_UINT:
+        *value = (double) entry->value.u;
+        return 0;
+    case SENML_CBOR_VALUE_DOUBLE:
+        *value = entry->value.d;
+        return 0;
+    default:
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+}
+
+static int senml_cbor_get_bool(anjay_input_ctx_t *ctx_, bool *value) {
+    senml_cbor_in_t *ctx = (senml_cbor_in_t *) ctx_;
+    senml_cbor_entry_t *entry;
+    int result = get_entry(ctx, &entry);
+    if (result) {
+        return result;
+    }
+    if (entry->type != SENML_CBOR_VALUE_BOOL) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    *value = entry->value.b;
+    return 0;
+}
+
+static int senml_cbor_get_objlnk(anjay_input_ctx_t *ctx_,
+                                 anjay_oid_t *out_oid,
+                                 anjay_iid_t *out_iid) {
+    senml_cbor_in_t *ctx = (senml_cbor_in_t *) ctx_;
+    senml_cbor_entry_t *entry;
+    int result = get_entry(ctx, &entry);
+    if (result) {
+        return result;
+    }
+    char objlnk[MAX_OBJLNK_STRING_SIZE];
+    if (entry->type != SENML_CBOR_VALUE_OBJLNK
+            || entry->length >= sizeof(objlnk)) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    memcpy(objlnk, entry->data, entry->length + 1);
+    if (_anjay_io_parse_objlnk(objlnk, out_oid, out_iid)) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    return 0;
+}
+
+static int senml_cbor_update_root_path(anjay_input_ctx_t *ctx_,
+                                       const anjay_uri_path_t *root_path) {
+    senml_cbor_in_t *ctx = (senml_cbor_in_t *) ctx_;
+    ctx->uri_path = (root_path ? *root_path : MAKE_ROOT_PATH());
+    if (ctx->has_entry
+            && _anjay_uri_path_outside_base(&ctx->entry.path, &ctx->uri_path)) {
+        // paths in SenML are absolute, so the already parsed record would end
+        // up outside of the new root
+        return -1;
+    }
+    return 0;
+}
+
+static int senml_cbor_in_close(anjay_input_ctx_t *ctx_) {
+    senml_cbor_in_t *ctx = (senml_cbor_in_t *) ctx_;
+    if (!ctx->finished) {
+        LOG(DEBUG, "input context is destroyed but not fully processed yet");
+    }
+    clear_entry(ctx);
+    return 0;
+}
+
+static const anjay_input_ctx_vtable_t SENML_CBOR_IN_VTABLE = {
+    .some_bytes = senml_cbor_get_some_bytes,
+    .string = senml_cbor_get_string,
+    .integer = senml_cbor_get_integer,
+    .floating = senml_cbor_get_double,
+    .boolean = senml_cbor_get_bool,
+    .objlnk = senml_cbor_get_objlnk,
+    .get_path = senml_cbor_get_path,
+    .next_entry = senml_cbor_next_entry,
+    .update_root_path = senml_cbor_update_root_path,
+    .close = senml_cbor_in_close
+};
+
+int _anjay_input_senml_cbor_create(anjay_input_ctx_t **out,
+                                   avs_stream_t **stream_ptr,
+                                   const anjay_uri_path_t *request_uri) {
+    senml_cbor_in_t *ctx =
+            (senml_cbor_in_t *) avs_calloc(1, sizeof(senml_cbor_in_t));
+    *out = (anjay_input_ctx_t *) ctx;
+    if (!ctx) {
+        return -1;
+    }
+    ctx->vtable = &SENML_CBOR_IN_VTABLE;
+    ctx->stream = *stream_ptr;
+    ctx->uri_path = (request_uri ? *request_uri : MAKE_ROOT_PATH());
+    return 0;
+}
+
+#ifdef ANJAY_TEST
+#    include "test/senml_cbor_in.c"
+#endif
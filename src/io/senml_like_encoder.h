@@ -114,6 +114,20 @@ int _anjay_senml_like_encoder_cleanup(anjay_senml_like_encoder_t **ctx);
 anjay_senml_like_encoder_t *_anjay_lwm2m_json_encoder_new(avs_stream_t *stream,
                                                           const char *basename);
 
+#ifdef WITH_CBOR
+/**
+ * Creates SenML CBOR encoder (content format 112).
+ * Writes the beginning of an indefinite-length CBOR array to stream. Basename,
+ * if any, is expected to be passed to the first
+ * @ref _anjay_senml_like_element_begin call.
+ *
+ * @param stream Stream to encode data to. Encoder doesn't take ownership of
+ *               stream.
+ * @returns Pointer to encoder in case of success, NULL otherwise.
+ */
+anjay_senml_like_encoder_t *_anjay_senml_cbor_encoder_new(avs_stream_t *stream);
+#endif // WITH_CBOR
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif // ANJAY_IO_SENML_LIKE_ENCODER_H
@@ -299,6 +299,12 @@ anjay_output_ctx_t *_anjay_output_senml_like_create(avs_stream_t *stream,
         break;
     }
 #endif // WITH_LWM2M_JSON
+#ifdef WITH_CBOR
+    case AVS_COAP_FORMAT_SENML_CBOR:
+        // basename is written along with the first record
+        ctx->encoder = _anjay_senml_cbor_encoder_new(stream);
+        break;
+#endif // WITH_CBOR
     default:
         senml_log(WARNING, "unsupported content format");
         goto error;
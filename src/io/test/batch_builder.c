@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <avsystem/commons/stream/stream_membuf.h>
 #include <avsystem/commons/unit/test.h>
 
 #include "../../coap/content_format.h"
@@ -59,7 +60,7 @@ AVS_UNIT_TEST(batch_builder, single_int_entry) {
     AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_int(
             builder, &MAKE_RESOURCE_INSTANCE_PATH(0, 0, 0, 0),
             AVS_TIME_REAL_INVALID, 0));
-    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(builder->list), 1);
+    AVS_UNIT_ASSERT_EQUAL(builder->entry_count, 1);
 
     builder_teardown(builder);
 }
@@ -73,7 +74,7 @@ AVS_UNIT_TEST(batch_builder, two_entries) {
     AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_int(
             builder, &MAKE_RESOURCE_INSTANCE_PATH(0, 0, 0, 0),
             AVS_TIME_REAL_INVALID, 0));
-    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(builder->list), 2);
+    AVS_UNIT_ASSERT_EQUAL(builder->entry_count, 2);
 
     builder_teardown(builder);
 }
@@ -90,15 +91,17 @@ AVS_UNIT_TEST(batch_builder, string_copy) {
     AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_string(
             builder, &MAKE_RESOURCE_INSTANCE_PATH(0, 0, 0, 0),
             AVS_TIME_REAL_INVALID, str));
-    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(builder->list), 1);
+    AVS_UNIT_ASSERT_EQUAL(builder->entry_count, 1);
 
     // Passed string shouldn't be required anymore.
     avs_free(str);
 
-    AVS_LIST(anjay_batch_entry_t) entry = AVS_LIST_TAIL(builder->list);
-    AVS_UNIT_ASSERT_EQUAL_STRING(entry->data.value.string, test_string.data);
+    anjay_batch_t *batch = _anjay_batch_builder_compile(&builder);
+    AVS_UNIT_ASSERT_NOT_NULL(batch);
+    AVS_UNIT_ASSERT_EQUAL_STRING(batch->entries[0].data.value.string,
+                                 test_string.data);
 
-    builder_teardown(builder);
+    _anjay_batch_release(&batch);
 }
 
 AVS_UNIT_TEST(batch_builder, compile) {
@@ -107,14 +110,120 @@ AVS_UNIT_TEST(batch_builder, compile) {
     AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_int(
             builder, &MAKE_RESOURCE_INSTANCE_PATH(0, 0, 0, 0),
             AVS_TIME_REAL_INVALID, 0));
-    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(builder->list), 1);
+    AVS_UNIT_ASSERT_EQUAL(builder->entry_count, 1);
 
     anjay_batch_t *batch = _anjay_batch_builder_compile(&builder);
     AVS_UNIT_ASSERT_NULL(builder);
 
-    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(batch->list), 1);
+    AVS_UNIT_ASSERT_EQUAL(batch->entry_count, 1);
     AVS_UNIT_ASSERT_EQUAL(batch->ref_count, 1);
 
     _anjay_batch_release(&batch);
     AVS_UNIT_ASSERT_NULL(batch);
 }
+
+AVS_UNIT_TEST(batch_builder, compile_flat_payloads) {
+    anjay_batch_builder_t *builder = builder_setup();
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_string(
+            builder, &MAKE_RESOURCE_PATH(0, 0, 0), AVS_TIME_REAL_INVALID,
+            "first"));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_int(builder,
+                                                 &MAKE_RESOURCE_PATH(0, 0, 1),
+                                                 AVS_TIME_REAL_INVALID, 42));
+    // enough strings to force reallocation of both builder arrays
+    for (anjay_rid_t rid = 2; rid < 64; ++rid) {
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_string(
+                builder, &MAKE_RESOURCE_PATH(0, 0, rid), AVS_TIME_REAL_INVALID,
+                "a somewhat longer string value"));
+    }
+
+    anjay_batch_t *batch = _anjay_batch_builder_compile(&builder);
+    AVS_UNIT_ASSERT_NOT_NULL(batch);
+    AVS_UNIT_ASSERT_EQUAL(batch->entry_count, 64);
+
+    const char *payload = (const char *) &batch->entries[batch->entry_count];
+    AVS_UNIT_ASSERT_TRUE(batch->entries[0].data.value.string == payload);
+    AVS_UNIT_ASSERT_EQUAL_STRING(batch->entries[0].data.value.string,
+                                 "first");
+    AVS_UNIT_ASSERT_EQUAL(batch->entries[1].data.value.int_value, 42);
+    for (size_t i = 2; i < batch->entry_count; ++i) {
+        AVS_UNIT_ASSERT_EQUAL_STRING(batch->entries[i].data.value.string,
+                                     "a somewhat longer string value");
+    }
+
+    _anjay_batch_release(&batch);
+}
+
+#ifdef WITH_AVS_PERSISTENCE
+AVS_UNIT_TEST(batch_builder, persistence_roundtrip) {
+    anjay_batch_builder_t *builder = builder_setup();
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_int(
+            builder, &MAKE_RESOURCE_PATH(1, 2, 3),
+            avs_time_real_from_scalar(1234, AVS_TIME_S), -42));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_string(
+            builder, &MAKE_RESOURCE_INSTANCE_PATH(1, 2, 4, 5),
+            AVS_TIME_REAL_INVALID, "Hello"));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_objlnk(
+            builder, &MAKE_RESOURCE_PATH(1, 2, 6), AVS_TIME_REAL_INVALID, 7,
+            8));
+
+    anjay_batch_t *batch = _anjay_batch_builder_compile(&builder);
+    AVS_UNIT_ASSERT_NOT_NULL(batch);
+
+    avs_stream_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    avs_persistence_context_t store_ctx =
+            avs_persistence_store_context_create(stream);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_persistence(&store_ctx, &batch));
+
+    anjay_batch_t *restored = NULL;
+    avs_persistence_context_t restore_ctx =
+            avs_persistence_restore_context_create(stream);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_persistence(&restore_ctx, &restored));
+    AVS_UNIT_ASSERT_NOT_NULL(restored);
+    AVS_UNIT_ASSERT_EQUAL(restored->ref_count, 1);
+    AVS_UNIT_ASSERT_TRUE(_anjay_batch_values_equal(batch, restored));
+    AVS_UNIT_ASSERT_TRUE(
+            avs_time_real_equal(_anjay_batch_get_compilation_time(batch),
+                                _anjay_batch_get_compilation_time(restored)));
+    AVS_UNIT_ASSERT_TRUE(avs_time_real_equal(
+            restored->entries[0].timestamp,
+            avs_time_real_from_scalar(1234, AVS_TIME_S)));
+
+    avs_stream_cleanup(&stream);
+    _anjay_batch_release(&restored);
+    _anjay_batch_release(&batch);
+}
+
+AVS_UNIT_TEST(batch_builder, persistence_null_string) {
+    avs_stream_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    avs_persistence_context_t store_ctx =
+            avs_persistence_store_context_create(stream);
+
+    // a batch with a single string entry whose value is NULL
+    avs_time_real_t time = AVS_TIME_REAL_INVALID;
+    uint32_t count = 1;
+    anjay_uri_path_t path = MAKE_RESOURCE_PATH(1, 2, 3);
+    uint8_t type = (uint8_t) ANJAY_BATCH_DATA_STRING;
+    char *string = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_persistence_time(&store_ctx, &time));
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_u32(&store_ctx, &count));
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(path.ids); ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(avs_persistence_u16(&store_ctx, &path.ids[i]));
+    }
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_persistence_time(&store_ctx, &time));
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_u8(&store_ctx, &type));
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_string(&store_ctx, &string));
+
+    anjay_batch_t *restored = NULL;
+    avs_persistence_context_t restore_ctx =
+            avs_persistence_restore_context_create(stream);
+    AVS_UNIT_ASSERT_FAILED(_anjay_batch_persistence(&restore_ctx, &restored));
+    AVS_UNIT_ASSERT_NULL(restored);
+
+    avs_stream_cleanup(&stream);
+}
+#endif // WITH_AVS_PERSISTENCE
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2017-2019 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <avsystem/commons/unit/test.h>
+
+#include "../../coap/content_format.h"
+
+#define TEST_ENV(Size, Uri)                                                  \
+    char buf[Size];                                                          \
+    avs_stream_outbuf_t outbuf = AVS_STREAM_OUTBUF_STATIC_INITIALIZER;       \
+    avs_stream_outbuf_set_buffer(&outbuf, buf, sizeof(buf));                 \
+    anjay_output_ctx_t *out = _anjay_output_senml_like_create(               \
+            (avs_stream_t *) &outbuf, (Uri), AVS_COAP_FORMAT_SENML_CBOR);    \
+    AVS_UNIT_ASSERT_NOT_NULL(out)
+
+#define VERIFY_BYTES(Data)                                       \
+    do {                                                         \
+        AVS_UNIT_ASSERT_EQUAL(avs_stream_outbuf_offset(&outbuf), \
+                              sizeof(Data) - 1);                 \
+        AVS_UNIT_ASSERT_EQUAL_BYTES(buf, Data);                  \
+    } while (0)
+
+AVS_UNIT_TEST(senml_cbor_encoder, empty) {
+    TEST_ENV(32, &MAKE_INSTANCE_PATH(3, 0));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    VERIFY_BYTES("\x9F\xFF");
+}
+
+AVS_UNIT_TEST(senml_cbor_encoder, basename_in_first_record) {
+    TEST_ENV(64, &MAKE_INSTANCE_PATH(3, 0));
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_output_set_path(out, &MAKE_RESOURCE_PATH(3, 0, 1)));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i64(out, 42));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_output_set_path(out, &MAKE_RESOURCE_PATH(3, 0, 2)));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_string(out, "foo"));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    VERIFY_BYTES("\x9F"
+                 "\xA3\x21\x64/3/0\x00\x62/1\x02\x18\x2A"
+                 "\xA2\x00\x62/2\x03\x63"
+                 "foo"
+                 "\xFF");
+}
+
+AVS_UNIT_TEST(senml_cbor_encoder, numbers) {
+    TEST_ENV(64, &MAKE_RESOURCE_PATH(3, 0, 1));
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_output_set_path(out, &MAKE_RESOURCE_PATH(3, 0, 1)));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i64(out, -500));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_output_set_path(out, &MAKE_RESOURCE_PATH(3, 0, 1)));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_double(out, 1.5));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_output_set_path(out, &MAKE_RESOURCE_PATH(3, 0, 1)));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_double(out, 0.1));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    VERIFY_BYTES("\x9F"
+                 "\xA2\x21\x66/3/0/1\x02\x39\x01\xF3"
+                 "\xA1\x02\xFA\x3F\xC0\x00\x00"
+                 "\xA1\x02\xFB\x3F\xB9\x99\x99\x99\x99\x99\x9A"
+                 "\xFF");
+}
+
+AVS_UNIT_TEST(senml_cbor_encoder, bytes_and_objlnk) {
+    TEST_ENV(64, &MAKE_INSTANCE_PATH(3, 0));
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_output_set_path(out, &MAKE_RESOURCE_PATH(3, 0, 1)));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_bytes(out, "\x01\x02\x03", 3));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_output_set_path(out, &MAKE_RESOURCE_PATH(3, 0, 2)));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_objlnk(out, 5, 6));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    VERIFY_BYTES("\x9F"
+                 "\xA3\x21\x64/3/0\x00\x62/1\x08\x43\x01\x02\x03"
+                 "\xA2\x00\x62/2\x63vlo\x63"
+                 "5:6"
+                 "\xFF");
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright 2017-2019 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <avsystem/commons/unit/memstream.h>
+
+#define AVS_UNIT_ENABLE_SHORT_ASSERTS
+#include <avsystem/commons/unit/test.h>
+
+#include <anjay/core.h>
+
+#define TEST_ENV(Data, Path)                                           \
+    avs_stream_t *stream = NULL;                                       \
+    ASSERT_OK(avs_unit_memstream_alloc(&stream, sizeof(Data)));        \
+    ASSERT_OK(avs_stream_write(stream, Data, sizeof(Data) - 1));       \
+    anjay_input_ctx_t *in;                                             \
+    ASSERT_OK(_anjay_input_senml_cbor_create(&in, &stream, &(Path)));
+
+#define TEST_TEARDOWN                             \
+    do {                                          \
+        ASSERT_OK(_anjay_input_ctx_destroy(&in)); \
+        ASSERT_OK(avs_stream_cleanup(&stream));   \
+    } while (0)
+
+#define ASSERT_PATH(Path)                                   \
+    do {                                                    \
+        anjay_uri_path_t path;                              \
+        ASSERT_OK(_anjay_input_get_path(in, &path, NULL));  \
+        ASSERT_TRUE(_anjay_uri_path_equal(&path, &(Path))); \
+    } while (0)
+
+AVS_UNIT_TEST(senml_cbor_in, single_integer) {
+    TEST_ENV("\x81\xA2\x00\x66/3/0/1\x02\x18\x2A", MAKE_INSTANCE_PATH(3, 0));
+
+    int64_t value;
+    ASSERT_PATH(MAKE_RESOURCE_PATH(3, 0, 1));
+    ASSERT_OK(anjay_get_i64(in, &value));
+    ASSERT_EQ(value, 42);
+    ASSERT_OK(_anjay_input_next_entry(in));
+    ASSERT_EQ(_anjay_input_get_path(in, NULL, NULL), ANJAY_GET_PATH_END);
+
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_cbor_in, basename_and_indefinite_array) {
+    TEST_ENV("\x9F"
+             "\xA3\x21\x64/3/0\x00\x62/1\x03\x63"
+             "foo"
+             "\xA2\x00\x62/2\x04\xF5"
+             "\xFF",
+             MAKE_OBJECT_PATH(3));
+
+    char buf[2];
+    bool value;
+    ASSERT_PATH(MAKE_RESOURCE_PATH(3, 0, 1));
+    ASSERT_EQ(anjay_get_string(in, buf, sizeof(buf)), ANJAY_BUFFER_TOO_SHORT);
+    ASSERT_EQ_STR(buf, "f");
+    ASSERT_EQ(anjay_get_string(in, buf, sizeof(buf)), ANJAY_BUFFER_TOO_SHORT);
+    ASSERT_EQ_STR(buf, "o");
+    ASSERT_OK(anjay_get_string(in, buf, sizeof(buf)));
+    ASSERT_EQ_STR(buf, "o");
+    ASSERT_OK(_anjay_input_next_entry(in));
+    ASSERT_PATH(MAKE_RESOURCE_PATH(3, 0, 2));
+    ASSERT_OK(anjay_get_bool(in, &value));
+    ASSERT_TRUE(value);
+    ASSERT_OK(_anjay_input_next_entry(in));
+    ASSERT_EQ(_anjay_input_get_path(in, NULL, NULL), ANJAY_GET_PATH_END);
+
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_cbor_in, floats) {
+    TEST_ENV("\x83"
+             "\xA2\x00\x66/3/0/1\x02\xF9\x3E\x00"
+             "\xA2\x00\x66/3/0/2\x02\xFA\x3F\xC0\x00\x00"
+             "\xA2\x00\x66/3/0/3\x02\xFB\x3F\xB9\x99\x99\x99\x99\x99\x9A",
+             MAKE_INSTANCE_PATH(3, 0));
+
+    double value;
+    int64_t int_value;
+    ASSERT_PATH(MAKE_RESOURCE_PATH(3, 0, 1));
+    ASSERT_OK(anjay_get_double(in, &value));
+    ASSERT_EQ(value, 1.5);
+    ASSERT_FAIL(anjay_get_i64(in, &int_value));
+    ASSERT_OK(_anjay_input_next_entry(in));
+    ASSERT_PATH(MAKE_RESOURCE_PATH(3, 0, 2));
+    ASSERT_OK(anjay_get_double(in, &value));
+    ASSERT_EQ(value, 1.5);
+    ASSERT_OK(_anjay_input_next_entry(in));
+    ASSERT_PATH(MAKE_RESOURCE_PATH(3, 0, 3));
+    ASSERT_OK(anjay_get_double(in, &value));
+    ASSERT_EQ(value, 0.1);
+    ASSERT_OK(_anjay_input_next_entry(in));
+    ASSERT_EQ(_anjay_input_get_path(in, NULL, NULL), ANJAY_GET_PATH_END);
+
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_cbor_in, bytes_and_objlnk) {
+    TEST_ENV("\x82"
+             "\xA2\x00\x66/3/0/1\x08\x43\x01\x02\x03"
+             "\xA2\x00\x66/3/0/2\x63vlo\x63"
+             "5:6",
+             MAKE_INSTANCE_PATH(3, 0));
+
+    char buf[8];
+    size_t bytes_read;
+    bool message_finished;
+    anjay_oid_t oid;
+    anjay_iid_t iid;
+    ASSERT_PATH(MAKE_RESOURCE_PATH(3, 0, 1));
+    ASSERT_OK(anjay_get_bytes(in, &bytes_read, &message_finished, buf,
+                              sizeof(buf)));
+    ASSERT_EQ(bytes_read, 3);
+    ASSERT_TRUE(message_finished);
+    ASSERT_EQ_BYTES(buf, "\x01\x02\x03");
+    ASSERT_OK(_anjay_input_next_entry(in));
+    ASSERT_PATH(MAKE_RESOURCE_PATH(3, 0, 2));
+    ASSERT_OK(anjay_get_objlnk(in, &oid, &iid));
+    ASSERT_EQ(oid, 5);
+    ASSERT_EQ(iid, 6);
+
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_cbor_in, path_outside_of_uri) {
+    TEST_ENV("\x81\xA2\x00\x66/3/0/1\x02\x01", MAKE_INSTANCE_PATH(3, 1));
+    ASSERT_EQ(_anjay_input_get_path(in, NULL, NULL), ANJAY_ERR_BAD_REQUEST);
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_cbor_in, multiple_values) {
+    TEST_ENV("\x81\xA3\x00\x66/3/0/1\x02\x01\x04\xF4",
+             MAKE_INSTANCE_PATH(3, 0));
+    ASSERT_EQ(_anjay_input_get_path(in, NULL, NULL), ANJAY_ERR_BAD_REQUEST);
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_cbor_in, unknown_labels_skipped) {
+    // time (6) and an unknown text label with a nested array
+    TEST_ENV("\x81\xA4\x00\x66/3/0/1\x06\x01\x61x\x82\x01\x02\x02\x07",
+             MAKE_INSTANCE_PATH(3, 0));
+
+    int64_t value;
+    ASSERT_PATH(MAKE_RESOURCE_PATH(3, 0, 1));
+    ASSERT_OK(anjay_get_i64(in, &value));
+    ASSERT_EQ(value, 7);
+
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_cbor_in, declared_string_length_exceeds_payload) {
+    // string value declared as 4 GB long, with only 3 bytes that follow
+    TEST_ENV("\x81\xA2\x00\x66/3/0/1\x03\x7A\xFF\xFF\xFF\xFF"
+             "foo",
+             MAKE_INSTANCE_PATH(3, 0));
+    ASSERT_EQ(_anjay_input_get_path(in, NULL, NULL), ANJAY_ERR_BAD_REQUEST);
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_cbor_in, long_string) {
+    static const char HEADER[] = "\x81\xA2\x00\x66/3/0/1\x03\x79\x03\xE8";
+    char data[sizeof(HEADER) - 1 + 1000];
+    memcpy(data, HEADER, sizeof(HEADER) - 1);
+    for (size_t i = sizeof(HEADER) - 1; i < sizeof(data); ++i) {
+        data[i] = (char) ('a' + i % 26);
+    }
+    avs_stream_t *stream = NULL;
+    ASSERT_OK(avs_unit_memstream_alloc(&stream, sizeof(data)));
+    ASSERT_OK(avs_stream_write(stream, data, sizeof(data)));
+    anjay_input_ctx_t *in;
+    ASSERT_OK(_anjay_input_senml_cbor_create(&in, &stream,
+                                             &MAKE_INSTANCE_PATH(3, 0)));
+
+    char buf[1001];
+    ASSERT_PATH(MAKE_RESOURCE_PATH(3, 0, 1));
+    ASSERT_OK(anjay_get_string(in, buf, sizeof(buf)));
+    ASSERT_EQ(strlen(buf), 1000);
+    ASSERT_EQ_BYTES_SIZED(buf, data + sizeof(HEADER) - 1, 1000);
+
+    TEST_TEARDOWN;
+}
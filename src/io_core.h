@@ -43,6 +43,9 @@ int _anjay_output_dynamic_construct(anjay_output_ctx_t **out_ctx,
 
 anjay_input_ctx_constructor_t _anjay_input_opaque_create;
 anjay_input_ctx_constructor_t _anjay_input_text_create;
+#ifdef WITH_CBOR
+anjay_input_ctx_constructor_t _anjay_input_senml_cbor_create;
+#endif // WITH_CBOR
 
 #ifdef WITH_LEGACY_CONTENT_FORMAT_SUPPORT
 uint16_t _anjay_translate_legacy_content_format(uint16_t format);
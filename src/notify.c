@@ -109,8 +109,19 @@ static int anjay_notify_perform_impl(anjay_t *anjay,
     if (!queue) {
         return 0;
     }
+    _anjay_dm_resource_cache_begin(anjay);
     int ret = 0;
     AVS_LIST(anjay_notify_queue_object_entry_t) it;
+    AVS_LIST_FOREACH(it, queue) {
+        if (it->instance_set_changes.instance_set_changed) {
+            _anjay_dm_invalidate_instance_cache(anjay, it->oid);
+        }
+        _anjay_access_control_invalidate_index(anjay, it->oid);
+        if (it->oid == ANJAY_DM_OID_SERVER) {
+            // Default Minimum/Maximum Period might have changed
+            _anjay_dm_attributes_changed(anjay);
+        }
+    }
     AVS_LIST_FOREACH(it, queue) {
         if (it->oid > ANJAY_DM_OID_SERVER) {
             break;
@@ -130,6 +141,7 @@ static int anjay_notify_perform_impl(anjay_t *anjay,
                                                            module->arg));
         }
     }
+    _anjay_dm_resource_cache_end(anjay);
     return ret;
 }
 
@@ -336,6 +348,8 @@ int anjay_notify_changed(anjay_t *anjay,
                          anjay_oid_t oid,
                          anjay_iid_t iid,
                          anjay_rid_t rid) {
+    _anjay_dm_invalidate_resource_cache(anjay, oid, iid);
+    _anjay_access_control_invalidate_index(anjay, oid);
     int retval;
     (void) ((retval = _anjay_notify_queue_resource_change(
                      &anjay->scheduled_notify.queue, oid, iid, rid))
@@ -344,6 +358,9 @@ int anjay_notify_changed(anjay_t *anjay,
 }
 
 int anjay_notify_instances_changed(anjay_t *anjay, anjay_oid_t oid) {
+    _anjay_dm_invalidate_instance_cache(anjay, oid);
+    _anjay_dm_invalidate_resource_cache(anjay, oid, ANJAY_ID_INVALID);
+    _anjay_access_control_invalidate_index(anjay, oid);
     int retval;
     (void) ((retval = _anjay_notify_queue_instance_set_unknown_change(
                      &anjay->scheduled_notify.queue, oid))
@@ -20,11 +20,13 @@
 #include <math.h>
 
 #include <avsystem/commons/errno.h>
+#include <avsystem/commons/stream/stream_inbuf.h>
 #include <avsystem/commons/stream/stream_membuf.h>
 #include <avsystem/commons/stream_v_table.h>
 
 #include <anjay_modules/time_defs.h>
 
+#include "../access_utils.h"
 #include "../anjay_core.h"
 #include "../coap/content_format.h"
 #include "../dm/dm_read.h"
@@ -65,17 +67,49 @@ int _anjay_observation_cmp(const void *left, const void *right) {
             &((const anjay_observation_t *) right)->token);
 }
 
+static int trigger_bucket_cmp(const void *left, const void *right) {
+    avs_time_monotonic_t left_instant =
+            ((const anjay_observe_trigger_bucket_t *) left)->instant;
+    avs_time_monotonic_t right_instant =
+            ((const anjay_observe_trigger_bucket_t *) right)->instant;
+    if (avs_time_monotonic_before(left_instant, right_instant)) {
+        return -1;
+    } else if (avs_time_monotonic_before(right_instant, left_instant)) {
+        return 1;
+    }
+    return 0;
+}
+
 int _anjay_observe_path_entry_cmp(const void *left, const void *right) {
     return _anjay_uri_path_compare(
             &((const anjay_observe_path_entry_t *) left)->path,
             &((const anjay_observe_path_entry_t *) right)->path);
 }
 
+static int read_cache_entry_cmp(const void *left_, const void *right_) {
+    const anjay_observe_read_cache_entry_t *left =
+            (const anjay_observe_read_cache_entry_t *) left_;
+    const anjay_observe_read_cache_entry_t *right =
+            (const anjay_observe_read_cache_entry_t *) right_;
+    int result = _anjay_uri_path_compare(&left->path, &right->path);
+    if (!result && left->action != right->action) {
+        result = left->action < right->action ? -1 : 1;
+    }
+    if (!result && left->access_class != right->access_class) {
+        result = left->access_class < right->access_class ? -1 : 1;
+    }
+    return result;
+}
+
 void _anjay_observe_init(anjay_observe_state_t *observe,
                          bool confirmable_notifications,
-                         size_t stored_notification_limit) {
+                         size_t stored_notification_limit,
+                         size_t aggregated_notification_limit,
+                         bool cache_attributes) {
     assert(!observe->connection_entries);
     observe->confirmable_notifications = confirmable_notifications;
+    observe->aggregated_notification_limit = aggregated_notification_limit;
+    observe->cache_attributes = cache_attributes;
 
     if (stored_notification_limit == 0) {
         observe->notify_queue_limit_mode = NOTIFY_QUEUE_UNLIMITED;
@@ -195,9 +229,20 @@ remove_from_observed_paths(anjay_observe_connection_entry_t *conn,
     }
 }
 
+static void cancel_trigger(anjay_observation_t *observation) {
+    if (observation->trigger_slot) {
+        assert(*observation->trigger_slot == observation);
+        *observation->trigger_slot = NULL;
+        observation->trigger_slot = NULL;
+        observation->trigger_bucket = NULL;
+    }
+}
+
 static void clear_observation(anjay_observe_connection_entry_t *connection,
                               anjay_observation_t *observation) {
-    avs_sched_del(&observation->notify_task);
+    cancel_trigger(observation);
+    avs_free(observation->attrs_cache);
+    observation->attrs_cache = NULL;
     while (observation->last_sent) {
         delete_value(&observation->last_sent);
     }
@@ -212,6 +257,8 @@ static void clear_observation(anjay_observe_connection_entry_t *connection,
                 server_last_unsent = *unsent_ptr;
             } else {
                 delete_value(unsent_ptr);
+                assert(connection->unsent_count > 0);
+                --connection->unsent_count;
             }
         }
         connection->unsent_last = server_last_unsent;
@@ -230,9 +277,11 @@ void _anjay_observe_cleanup_connection(anjay_observe_connection_entry_t *conn) {
     while (conn->unsent) {
         delete_value(&conn->unsent);
     }
+    conn->unsent_count = 0;
     AVS_RBTREE_DELETE(&conn->observations) {
         remove_from_observed_paths(conn, *conn->observations);
-        avs_sched_del(&(*conn->observations)->notify_task);
+        cancel_trigger(*conn->observations);
+        avs_free((*conn->observations)->attrs_cache);
         if ((*conn->observations)->last_sent) {
             delete_value(&(*conn->observations)->last_sent);
         }
@@ -242,15 +291,29 @@ void _anjay_observe_cleanup_connection(anjay_observe_connection_entry_t *conn) {
         assert(!AVS_RBTREE_FIRST(conn->observed_paths));
         AVS_RBTREE_DELETE(&conn->observed_paths);
     }
+    AVS_RBTREE_DELETE(&conn->trigger_buckets) {
+        avs_sched_del(&(*conn->trigger_buckets)->job);
+        AVS_LIST_CLEAR(&(*conn->trigger_buckets)->observations);
+    }
     if (conn->flush_task) {
         avs_sched_del(&conn->flush_task);
     }
 }
 
+void _anjay_observe_read_cache_clear(anjay_observe_state_t *observe) {
+    AVS_RBTREE_DELETE(&observe->read_cache) {
+        _anjay_batch_release(&(*observe->read_cache)->batch);
+    }
+}
+
 void _anjay_observe_cleanup(anjay_observe_state_t *observe) {
+    _anjay_observe_read_cache_clear(observe);
     AVS_LIST_CLEAR(&observe->connection_entries) {
         _anjay_observe_cleanup_connection(observe->connection_entries);
     }
+#ifdef WITH_AVS_PERSISTENCE
+    _anjay_observe_clear_restored(observe);
+#endif // WITH_AVS_PERSISTENCE
 }
 
 static void
@@ -265,16 +328,12 @@ static void delete_connection_if_empty(
         assert(!AVS_RBTREE_FIRST((*conn_ptr)->observed_paths));
         assert(!(*conn_ptr)->unsent);
         assert(!(*conn_ptr)->unsent_last);
+        assert(!(*conn_ptr)->unsent_count);
         delete_connection(conn_ptr);
     }
 }
 
-typedef struct {
-    anjay_observe_connection_entry_t *conn_state;
-    anjay_observation_t *observation;
-} trigger_observe_args_t;
-
-static void trigger_observe(avs_sched_t *sched, const void *args_);
+static void trigger_bucket_job(avs_sched_t *sched, const void *bucket_ptr);
 
 static const anjay_observation_value_t *
 newest_value(const anjay_observation_t *observation) {
@@ -286,9 +345,47 @@ newest_value(const anjay_observation_t *observation) {
     }
 }
 
+static inline const anjay_observe_trigger_bucket_t *
+trigger_bucket_query(const avs_time_monotonic_t *instant) {
+    return AVS_CONTAINER_OF(instant, anjay_observe_trigger_bucket_t, instant);
+}
+
+static AVS_RBTREE_ELEM(anjay_observe_trigger_bucket_t)
+find_or_create_trigger_bucket(anjay_observe_connection_entry_t *conn_state,
+                              avs_time_monotonic_t instant) {
+    AVS_RBTREE_ELEM(anjay_observe_trigger_bucket_t) bucket =
+            AVS_RBTREE_FIND(conn_state->trigger_buckets,
+                            trigger_bucket_query(&instant));
+    if (bucket) {
+        return bucket;
+    }
+    if (!(bucket = AVS_RBTREE_ELEM_NEW(anjay_observe_trigger_bucket_t))) {
+        anjay_log(ERROR, "out of memory");
+        return NULL;
+    }
+    bucket->instant = instant;
+    bucket->conn = conn_state;
+    if (AVS_SCHED_AT(_anjay_from_server(conn_state->conn_ref.server)->sched,
+                     &bucket->job, instant, trigger_bucket_job, &bucket,
+                     sizeof(bucket))) {
+        AVS_RBTREE_ELEM_DELETE_DETACHED(&bucket);
+        return NULL;
+    }
+    AVS_RBTREE_INSERT(conn_state->trigger_buckets, bucket);
+    return bucket;
+}
+
+typedef enum {
+    // notification must not be sent before the trigger instant (pmin)
+    TRIGGER_NOT_BEFORE,
+    // notification must not be sent after the trigger instant (pmax)
+    TRIGGER_NOT_AFTER
+} trigger_kind_t;
+
 static int schedule_trigger(anjay_observe_connection_entry_t *conn_state,
                             anjay_observation_t *observation,
-                            int32_t period) {
+                            int32_t period,
+                            trigger_kind_t kind) {
     if (period < 0) {
         return 0;
     }
@@ -302,14 +399,41 @@ static int schedule_trigger(anjay_observe_connection_entry_t *conn_state,
                     avs_time_real_diff(newest_value(observation)->timestamp,
                                        real_now),
                     avs_time_duration_from_scalar(period, AVS_TIME_S)));
-    if (avs_time_monotonic_before(trigger_instant, monotonic_now)) {
-        trigger_instant = monotonic_now;
+    if (avs_time_monotonic_before(monotonic_now, trigger_instant)
+            && trigger_instant.since_monotonic_epoch.nanoseconds > 0) {
+        // Periods are expressed in whole seconds, so future triggers are
+        // quantized to a whole second, so that triggers caused by the same
+        // periods elapsing for multiple observations share a bucket. pmin
+        // triggers are rounded up, which may only make them happen later.
+        // pmax triggers are rounded down, so that they are never late;
+        // has_pmax_expired() accepts expiry within the current second.
+        trigger_instant.since_monotonic_epoch.nanoseconds = 0;
+        if (kind == TRIGGER_NOT_BEFORE) {
+            ++trigger_instant.since_monotonic_epoch.seconds;
+        }
+    }
+    if (!avs_time_monotonic_before(monotonic_now, trigger_instant)) {
+        // Triggers that are already due join the earliest bucket if it is due
+        // as well, e.g. when multiple observations are affected by a single
+        // data model change.
+        const anjay_observe_trigger_bucket_t *first_bucket =
+                AVS_RBTREE_FIRST(conn_state->trigger_buckets);
+        if (first_bucket
+                && !avs_time_monotonic_before(monotonic_now,
+                                              first_bucket->instant)) {
+            trigger_instant = first_bucket->instant;
+        } else {
+            trigger_instant = monotonic_now;
+        }
     }
 
-    if (avs_time_monotonic_before(avs_sched_time(&observation->notify_task),
-                                  trigger_instant)) {
+    const anjay_observe_trigger_bucket_t *scheduled_bucket =
+            observation->trigger_bucket;
+    if (scheduled_bucket
+            && !avs_time_monotonic_before(trigger_instant,
+                                          scheduled_bucket->instant)) {
         anjay_log(LAZY_TRACE,
-                  "Notify for token %s already scheduled earlier than "
+                  "Notify for token %s already scheduled no later than "
                   "requested %ld.%09lds",
                   ANJAY_TOKEN_TO_STRING(observation->token),
                   (long) trigger_instant.since_monotonic_epoch.seconds,
@@ -322,22 +446,23 @@ static int schedule_trigger(anjay_observe_connection_entry_t *conn_state,
               (long) trigger_instant.since_monotonic_epoch.seconds,
               (long) trigger_instant.since_monotonic_epoch.nanoseconds);
 
-    int retval =
-            AVS_SCHED_AT(_anjay_from_server(conn_state->conn_ref.server)->sched,
-                         &observation->notify_task, trigger_instant,
-                         trigger_observe,
-                         (&(const trigger_observe_args_t) {
-                             .conn_state = conn_state,
-                             .observation = observation
-                         }),
-                         sizeof(trigger_observe_args_t));
-    if (retval) {
-        anjay_log(ERROR,
-                  "Could not schedule automatic notification trigger, result: "
-                  "%d",
-                  retval);
+    AVS_RBTREE_ELEM(anjay_observe_trigger_bucket_t) bucket =
+            find_or_create_trigger_bucket(conn_state, trigger_instant);
+    AVS_LIST(anjay_observation_t *) slot = NULL;
+    if (!bucket || !(slot = AVS_LIST_NEW_ELEMENT(anjay_observation_t *))) {
+        anjay_log(ERROR, "Could not schedule automatic notification trigger");
+        return -1;
+    }
+    cancel_trigger(observation);
+    *slot = observation;
+    AVS_LIST_APPEND(&bucket->observations_last, slot);
+    bucket->observations_last = slot;
+    if (!bucket->observations) {
+        bucket->observations = slot;
     }
-    return retval;
+    observation->trigger_bucket = bucket;
+    observation->trigger_slot = slot;
+    return 0;
 }
 
 static AVS_LIST(anjay_observation_value_t)
@@ -367,12 +492,26 @@ create_observation_value(const anjay_msg_details_t *details,
     return result;
 }
 
+/**
+ * Returns the number of values at the head of the unsent queue of @p conn that
+ * are being delivered right now. These are no longer considered queued, and
+ * must stay in place, as handle_notify_delivery() pops exactly that many.
+ */
+static size_t
+in_flight_values_count(const anjay_observe_connection_entry_t *conn) {
+    if (!avs_coap_exchange_id_valid(conn->notify_exchange_id)) {
+        return 0;
+    }
+    return AVS_MIN(conn->serialization_state.values_count, conn->unsent_count);
+}
+
 static size_t count_queued_notifications(const anjay_observe_state_t *observe) {
     size_t count = 0;
 
     AVS_LIST(anjay_observe_connection_entry_t) conn;
     AVS_LIST_FOREACH(conn, observe->connection_entries) {
-        count += AVS_LIST_SIZE(conn->unsent);
+        assert(!conn->unsent_count == !conn->unsent);
+        count += conn->unsent_count - in_flight_values_count(conn);
     }
 
     return count;
@@ -387,22 +526,34 @@ static bool is_observe_queue_full(const anjay_observe_state_t *observe) {
     anjay_log(TRACE, "%u/%u queued notifications", (unsigned) num_queued,
               (unsigned) observe->notify_queue_limit);
 
-    assert(num_queued <= observe->notify_queue_limit);
+    // values that failed to be delivered return to the queue, so the limit may
+    // be temporarily exceeded by what was in flight at the time
     return num_queued >= observe->notify_queue_limit;
 }
 
+static AVS_LIST(anjay_observation_value_t) *
+first_queued_value_ptr(anjay_observe_connection_entry_t *conn) {
+    AVS_LIST(anjay_observation_value_t) *value_ptr = &conn->unsent;
+    for (size_t i = in_flight_values_count(conn); i > 0; --i) {
+        value_ptr = AVS_LIST_NEXT_PTR(value_ptr);
+    }
+    return value_ptr;
+}
+
 static AVS_LIST(anjay_observe_connection_entry_t)
 find_oldest_queued_notification(anjay_observe_state_t *observe) {
     AVS_LIST(anjay_observe_connection_entry_t) oldest = NULL;
+    const anjay_observation_value_t *oldest_value = NULL;
 
     AVS_LIST(anjay_observe_connection_entry_t) conn;
     AVS_LIST_FOREACH(conn, observe->connection_entries) {
-        if (conn->unsent) {
-            if (!oldest
-                    || avs_time_real_before(conn->unsent->timestamp,
-                                            oldest->unsent->timestamp)) {
-                oldest = conn;
-            }
+        const anjay_observation_value_t *value = *first_queued_value_ptr(conn);
+        if (value
+                && (!oldest_value
+                    || avs_time_real_before(value->timestamp,
+                                            oldest_value->timestamp))) {
+            oldest = conn;
+            oldest_value = value;
         }
     }
 
@@ -410,20 +561,42 @@ find_oldest_queued_notification(anjay_observe_state_t *observe) {
 }
 
 static anjay_observation_value_t *
-detach_first_unsent_value(anjay_observe_connection_entry_t *conn_state) {
-    assert(conn_state->unsent);
-    anjay_observation_t *observation = conn_state->unsent->ref;
-    if (observation->last_unsent == conn_state->unsent) {
+detach_unsent_value(anjay_observe_connection_entry_t *conn_state,
+                    AVS_LIST(anjay_observation_value_t) *value_ptr) {
+    assert(*value_ptr);
+    anjay_observation_t *observation = (*value_ptr)->ref;
+    const bool was_last_unsent = (observation->last_unsent == *value_ptr);
+    const bool was_unsent_last = (conn_state->unsent_last == *value_ptr);
+    AVS_LIST(anjay_observation_value_t) prev = NULL;
+    if (was_last_unsent) {
         observation->last_unsent = NULL;
     }
-    anjay_observation_value_t *result = AVS_LIST_DETACH(&conn_state->unsent);
-    if (conn_state->unsent_last == result) {
-        assert(!conn_state->unsent);
-        conn_state->unsent_last = NULL;
+    if (was_last_unsent || was_unsent_last) {
+        // new last elements can only precede the detached value if it is not
+        // the head of the queue, i.e. when skipping values in flight
+        AVS_LIST(anjay_observation_value_t) it;
+        for (it = conn_state->unsent; it != *value_ptr;
+             prev = it, it = AVS_LIST_NEXT(it)) {
+            if (was_last_unsent && it->ref == observation) {
+                observation->last_unsent = it;
+            }
+        }
+    }
+    anjay_observation_value_t *result = AVS_LIST_DETACH(value_ptr);
+    assert(conn_state->unsent_count > 0);
+    --conn_state->unsent_count;
+    if (was_unsent_last) {
+        assert(!*value_ptr);
+        conn_state->unsent_last = prev;
     }
     return result;
 }
 
+static anjay_observation_value_t *
+detach_first_unsent_value(anjay_observe_connection_entry_t *conn_state) {
+    return detach_unsent_value(conn_state, &conn_state->unsent);
+}
+
 static void drop_oldest_queued_notification(anjay_observe_state_t *observe) {
     AVS_LIST(anjay_observe_connection_entry_t) oldest =
             find_oldest_queued_notification(observe);
@@ -431,7 +604,8 @@ static void drop_oldest_queued_notification(anjay_observe_state_t *observe) {
     AVS_ASSERT(oldest, "function is not supposed to be called when there are "
                        "no queued notifications");
 
-    anjay_observation_value_t *entry = detach_first_unsent_value(oldest);
+    anjay_observation_value_t *entry =
+            detach_unsent_value(oldest, first_queued_value_ptr(oldest));
     delete_value(&entry);
 }
 
@@ -442,7 +616,7 @@ static int insert_new_value(anjay_observe_connection_entry_t *conn_state,
                             const anjay_batch_t *const *values) {
     anjay_observe_state_t *observe =
             &_anjay_from_server(conn_state->conn_ref.server)->observe;
-    if (is_observe_queue_full(observe)) {
+    while (is_observe_queue_full(observe)) {
         switch (observe->notify_queue_limit_mode) {
         case NOTIFY_QUEUE_UNLIMITED:
             AVS_UNREACHABLE("is_observe_queue_full broken");
@@ -467,6 +641,7 @@ static int insert_new_value(anjay_observe_connection_entry_t *conn_state,
     if (!conn_state->unsent) {
         conn_state->unsent = res_value;
     }
+    ++conn_state->unsent_count;
     observation->last_unsent = res_value;
     return 0;
 }
@@ -474,7 +649,7 @@ static int insert_new_value(anjay_observe_connection_entry_t *conn_state,
 static int insert_error(anjay_observe_connection_entry_t *conn_state,
                         anjay_observation_t *observation,
                         int outer_result) {
-    avs_sched_del(&observation->notify_task);
+    cancel_trigger(observation);
     const anjay_msg_details_t details = {
         .msg_code = _anjay_make_error_response_code(outer_result),
         .format = AVS_COAP_FORMAT_NONE
@@ -528,6 +703,49 @@ static int get_effective_attrs(anjay_t *anjay,
     return _anjay_dm_effective_attrs(anjay, &details, out_attrs);
 }
 
+/**
+ * Works like get_effective_attrs() for the path of index @p path_index in
+ * @p observation, but reuses previously resolved attributes if caching is
+ * enabled and nothing that might affect them has changed in the meantime.
+ */
+static int get_observation_attrs(anjay_observe_connection_entry_t *conn,
+                                 anjay_observation_t *observation,
+                                 size_t path_index,
+                                 anjay_dm_internal_r_attrs_t *out_attrs) {
+    assert(path_index < observation->paths_count);
+    anjay_t *anjay = _anjay_from_server(conn->conn_ref.server);
+    const anjay_uri_path_t *path = &observation->paths[path_index];
+    anjay_ssid_t ssid = _anjay_server_ssid(conn->conn_ref.server);
+    if (!anjay->observe.cache_attributes) {
+        return get_effective_attrs(anjay, out_attrs, path, ssid);
+    }
+
+    if (!observation->attrs_cache
+            && !(observation->attrs_cache =
+                         (anjay_observation_attrs_cache_t *) avs_calloc(
+                                 observation->paths_count,
+                                 sizeof(anjay_observation_attrs_cache_t)))) {
+        anjay_log(ERROR, "out of memory");
+        return -1;
+    }
+    anjay_observation_attrs_cache_t *entry =
+            &observation->attrs_cache[path_index];
+    if (!entry->valid
+            || entry->attributes_generation != anjay->dm.attributes_generation
+            || entry->instances_generation != anjay->dm.instances_generation) {
+        int result = get_effective_attrs(anjay, &entry->attrs, path, ssid);
+        if (result) {
+            entry->valid = false;
+            return result;
+        }
+        entry->attributes_generation = anjay->dm.attributes_generation;
+        entry->instances_generation = anjay->dm.instances_generation;
+        entry->valid = true;
+    }
+    *out_attrs = entry->attrs;
+    return 0;
+}
+
 static inline bool is_pmax_valid(anjay_dm_oi_attributes_t attr) {
     if (attr.max_period < 0) {
         return false;
@@ -559,10 +777,7 @@ int _anjay_observe_schedule_pmax_trigger(
 
     for (size_t i = 0; i < observation->paths_count; ++i) {
         anjay_dm_internal_r_attrs_t attrs;
-        int result = get_effective_attrs(
-                _anjay_from_server(conn_state->conn_ref.server), &attrs,
-                &observation->paths[i],
-                _anjay_server_ssid(conn_state->conn_ref.server));
+        int result = get_observation_attrs(conn_state, observation, i, &attrs);
         if (result) {
             anjay_log(DEBUG, "Could not get observe attributes, result: %d",
                       result);
@@ -573,7 +788,8 @@ int _anjay_observe_schedule_pmax_trigger(
     }
 
     if (pmax >= 0) {
-        return schedule_trigger(conn_state, observation, pmax);
+        return schedule_trigger(conn_state, observation, pmax,
+                                TRIGGER_NOT_AFTER);
     }
     return 0;
 }
@@ -635,9 +851,8 @@ create_detached_observation(const avs_coap_token_t *token,
             AVS_LIST_ADVANCE(&it);
         }
     } else {
-        assert(paths->count == 1);
         memcpy((void *) (intptr_t) (const void *) &new_observation->paths[0],
-               paths->paths, sizeof(*paths->paths));
+               paths->paths, paths->count * sizeof(*paths->paths));
     }
     return new_observation;
 }
@@ -672,9 +887,16 @@ find_or_create_connection_state(anjay_connection_ref_t ref) {
                              anjay_observation_t, _anjay_observation_cmp))
                 || !((*conn_ptr)->observed_paths =
                              AVS_RBTREE_NEW(anjay_observe_path_entry_t,
-                                            _anjay_observe_path_entry_cmp))) {
+                                            _anjay_observe_path_entry_cmp))
+                || !((*conn_ptr)->trigger_buckets =
+                             AVS_RBTREE_NEW(anjay_observe_trigger_bucket_t,
+                                            trigger_bucket_cmp))) {
             anjay_log(ERROR, "out of memory");
-            AVS_LIST_DELETE(conn_ptr);
+            if (*conn_ptr) {
+                AVS_RBTREE_DELETE(&(*conn_ptr)->observations);
+                AVS_RBTREE_DELETE(&(*conn_ptr)->observed_paths);
+                AVS_LIST_DELETE(conn_ptr);
+            }
             return NULL;
         }
         memcpy((void *) (intptr_t) (const void *) &(*conn_ptr)->conn_ref, &ref,
@@ -705,8 +927,7 @@ static void observe_remove_entry(anjay_connection_ref_t connection,
                                  (*conn_ptr)->notify_exchange_id);
     }
     assert(!avs_coap_exchange_id_valid((*conn_ptr)->notify_exchange_id));
-    assert(!(*conn_ptr)->serialization_state.membuf_stream);
-    assert(!(*conn_ptr)->serialization_state.out_ctx);
+    assert(!(*conn_ptr)->serialization_state.payload);
     AVS_RBTREE_ELEM(anjay_observation_t) observation =
             AVS_RBTREE_FIND((*conn_ptr)->observations,
                             _anjay_observation_query(token));
@@ -749,12 +970,12 @@ attach_new_observation(anjay_observe_connection_entry_t *conn_state,
 }
 
 static AVS_RBTREE_ELEM(anjay_observation_t)
-put_entry_into_connection_state(const anjay_request_t *request,
+put_entry_into_connection_state(const avs_coap_token_t *token,
+                                anjay_request_action_t action,
                                 anjay_observe_connection_entry_t *conn_state,
                                 const paths_arg_t *paths) {
     AVS_RBTREE_ELEM(anjay_observation_t) observation =
-            create_detached_observation(&request->observe->token,
-                                        request->action, paths);
+            create_detached_observation(token, action, paths);
     if (!observation) {
         return NULL;
     }
@@ -810,54 +1031,21 @@ static int write_notify_payload(size_t payload_offset,
                                 void *conn_) {
     anjay_observe_connection_entry_t *conn =
             (anjay_observe_connection_entry_t *) conn_;
-    if (payload_offset != conn->serialization_state.expected_offset) {
+    const anjay_observation_serialization_state_t *state =
+            &conn->serialization_state;
+    if (payload_offset > state->payload_size) {
         anjay_log(DEBUG,
-                  "Server requested unexpected chunk of payload (expected "
-                  "offset %zu, got %zu)",
-                  conn->serialization_state.expected_offset, payload_offset);
+                  "Server requested chunk of payload past its end (payload "
+                  "size %zu, got offset %zu)",
+                  state->payload_size, payload_offset);
         return -1;
     }
-
-    anjay_t *anjay = _anjay_from_server(conn->conn_ref.server);
-    anjay_observation_value_t *value = conn->unsent;
-    anjay_observation_t *observation = value->ref;
-
-    char *write_ptr = (char *) payload_buf;
-    const char *end_ptr = write_ptr + payload_buf_size;
-    while (true) {
-        size_t bytes_read;
-        if (avs_is_err(avs_stream_read(conn->serialization_state.membuf_stream,
-                                       &bytes_read, NULL, write_ptr,
-                                       (size_t) (end_ptr - write_ptr)))) {
-            return -1;
-        }
-        write_ptr += bytes_read;
-        if (write_ptr >= end_ptr || !conn->serialization_state.out_ctx) {
-            break;
-        }
-        // NOTE: Access Control permissions have been checked during the
-        // _anjay_dm_read_as_batch() stage, so we're "spoofing"
-        // ANJAY_SSID_BOOTSTRAP as the permissions are checked now
-        int result = _anjay_batch_data_output_entry(
-                anjay, value->values[conn->serialization_state.curr_value_idx],
-                ANJAY_SSID_BOOTSTRAP,
-                conn->serialization_state.serialization_time,
-                &conn->serialization_state.output_state,
-                conn->serialization_state.out_ctx);
-        if (!result && !conn->serialization_state.output_state) {
-            ++conn->serialization_state.curr_value_idx;
-            if (conn->serialization_state.curr_value_idx
-                    >= observation->paths_count) {
-                result = _anjay_output_ctx_destroy_and_process_result(
-                        &conn->serialization_state.out_ctx, result);
-            }
-        }
-        if (result) {
-            return result;
-        }
+    *out_payload_chunk_size =
+            AVS_MIN(payload_buf_size, state->payload_size - payload_offset);
+    if (*out_payload_chunk_size) {
+        memcpy(payload_buf, (const char *) state->payload + payload_offset,
+               *out_payload_chunk_size);
     }
-    *out_payload_chunk_size = (size_t) (write_ptr - (char *) payload_buf);
-    conn->serialization_state.expected_offset += *out_payload_chunk_size;
     return 0;
 }
 
@@ -937,6 +1125,88 @@ static int read_observation_path(anjay_t *anjay,
     return result;
 }
 
+/**
+ * Determines which observations may share values read for @p path on behalf of
+ * @p connection_ssid. Reading an Object Instance or anything below it yields
+ * the same data for every Server allowed to read that Instance, so all such
+ * Servers share a single ANJAY_SSID_ANY class. Object-level and root reads are
+ * filtered per Instance, so they are only shared if Access Control does not
+ * differentiate between Servers at all.
+ *
+ * Returns false if the read is not allowed, in which case there is nothing
+ * worth caching.
+ */
+static bool get_read_access_class(anjay_t *anjay,
+                                  const anjay_uri_path_t *path,
+                                  anjay_ssid_t connection_ssid,
+                                  anjay_ssid_t *out_class) {
+    *out_class = ANJAY_SSID_ANY;
+    if (!_anjay_access_control_depends_on_ssid(anjay)) {
+        return true;
+    }
+    if (!_anjay_uri_path_has(path, ANJAY_ID_IID)
+            || path->ids[ANJAY_ID_OID] == ANJAY_DM_OID_SECURITY
+            || connection_ssid == ANJAY_SSID_BOOTSTRAP) {
+        *out_class = connection_ssid;
+        return true;
+    }
+    // with anjay_configuration_t::cache_access_control enabled, this is
+    // a lookup in the Access Control index
+    const anjay_action_info_t info = {
+        .oid = path->ids[ANJAY_ID_OID],
+        .iid = path->ids[ANJAY_ID_IID],
+        .ssid = connection_ssid,
+        .action = ANJAY_ACTION_READ
+    };
+    return _anjay_instance_action_allowed(anjay, &info);
+}
+
+/**
+ * Works like read_observation_path(), but reuses values already read on behalf
+ * of other observations (possibly of other Servers) during the current round
+ * of scheduler jobs, as long as Access Control rules allow that.
+ */
+static int read_observation_path_cached(anjay_t *anjay,
+                                        const anjay_uri_path_t *path,
+                                        anjay_request_action_t action,
+                                        anjay_ssid_t connection_ssid,
+                                        anjay_batch_t **out_batch) {
+    anjay_observe_read_cache_entry_t key = {
+        .path = *path,
+        .action = action
+    };
+    if (!get_read_access_class(anjay, path, connection_ssid,
+                               &key.access_class)) {
+        return read_observation_path(anjay, path, action, connection_ssid,
+                                     out_batch);
+    }
+    if (!anjay->observe.read_cache
+            && !(anjay->observe.read_cache =
+                         AVS_RBTREE_NEW(anjay_observe_read_cache_entry_t,
+                                        read_cache_entry_cmp))) {
+        anjay_log(ERROR, "out of memory");
+        return read_observation_path(anjay, path, action, connection_ssid,
+                                     out_batch);
+    }
+    AVS_RBTREE_ELEM(anjay_observe_read_cache_entry_t) entry =
+            AVS_RBTREE_FIND(anjay->observe.read_cache, &key);
+    if (entry) {
+        *out_batch = _anjay_batch_acquire(entry->batch);
+        return 0;
+    }
+
+    int result = read_observation_path(anjay, path, action, connection_ssid,
+                                       out_batch);
+    if (!result
+            && (entry = AVS_RBTREE_ELEM_NEW(
+                        anjay_observe_read_cache_entry_t))) {
+        *entry = key;
+        entry->batch = _anjay_batch_acquire(*out_batch);
+        AVS_RBTREE_INSERT(anjay->observe.read_cache, entry);
+    }
+    return result;
+}
+
 static int read_observation_values(anjay_t *anjay,
                                    const paths_arg_t *paths,
                                    anjay_request_action_t action,
@@ -1012,7 +1282,9 @@ static int observe_handle(anjay_t *anjay,
                                      cast_to_const_batch_array(batches));
 
     if (!(observation =
-                  put_entry_into_connection_state(request, *conn_ptr, paths))
+                  put_entry_into_connection_state(&request->observe->token,
+                                                  request->action, *conn_ptr,
+                                                  paths))
             || insert_initial_value(*conn_ptr, observation, &response_details,
                                     cast_to_const_batch_array(batches))
             || start_coap_observe(anjay->current_connection, request)) {
@@ -1052,6 +1324,76 @@ int _anjay_observe_handle(anjay_t *anjay, const anjay_request_t *request) {
                           request);
 }
 
+#ifdef WITH_AVS_PERSISTENCE
+int _anjay_observe_add_restored(anjay_connection_ref_t ref,
+                                const anjay_observe_persisted_entry_t *entry) {
+    AVS_LIST(anjay_observe_connection_entry_t) *conn_ptr =
+            find_or_create_connection_state(ref);
+    if (!conn_ptr) {
+        return -1;
+    }
+    if (AVS_RBTREE_FIND((*conn_ptr)->observations,
+                        _anjay_observation_query(&entry->token))) {
+        anjay_log(WARNING, "observation with token %s already exists",
+                  ANJAY_TOKEN_TO_STRING(entry->token));
+        return -1;
+    }
+
+    AVS_RBTREE_ELEM(anjay_observation_t) observation =
+            put_entry_into_connection_state(
+                    &entry->token, entry->action, *conn_ptr,
+                    &(const paths_arg_t) {
+                        .type = PATHS_POINTER_ARRAY,
+                        .paths = entry->paths,
+                        .count = entry->paths_count
+                    });
+    if (!observation) {
+        delete_connection_if_empty(conn_ptr);
+        return -1;
+    }
+
+    int result = -1;
+    if ((observation->last_sent = create_observation_value(
+                 &entry->details, AVS_COAP_NOTIFY_PREFER_NON_CONFIRMABLE,
+                 observation, cast_to_const_batch_array(entry->values)))) {
+        observation->last_sent->timestamp = entry->timestamp;
+        observation->last_confirmable = entry->last_confirmable;
+        result = _anjay_observe_schedule_pmax_trigger(*conn_ptr, observation);
+    }
+
+    anjay_connection_ref_t *heap_conn = NULL;
+    if (!result) {
+        if (!(heap_conn = (anjay_connection_ref_t *) avs_malloc(
+                      sizeof(anjay_connection_ref_t)))) {
+            anjay_log(ERROR, "out of memory");
+            result = -1;
+        } else {
+            *heap_conn = ref;
+        }
+    }
+    if (!result) {
+        avs_stream_inbuf_t coap_state_stream =
+                AVS_STREAM_INBUF_STATIC_INITIALIZER;
+        avs_stream_inbuf_set_buffer(&coap_state_stream, entry->coap_state,
+                                    entry->coap_state_size);
+        avs_persistence_context_t coap_state_ctx =
+                avs_persistence_restore_context_create(
+                        (avs_stream_t *) &coap_state_stream);
+        if (avs_is_err(avs_coap_observe_restore(_anjay_connection_get_coap(ref),
+                                                _anjay_observe_cancel_handler,
+                                                heap_conn, &coap_state_ctx))) {
+            anjay_log(WARNING, "could not restore CoAP observation state");
+            avs_free(heap_conn);
+            result = -1;
+        }
+    }
+    if (result) {
+        delete_observation(conn_ptr, &observation);
+    }
+    return result;
+}
+#endif // WITH_AVS_PERSISTENCE
+
 static int observe_gc_ssid_iterate(anjay_t *anjay,
                                    anjay_ssid_t ssid,
                                    void *conn_ptr_ptr_) {
@@ -1078,10 +1420,16 @@ void _anjay_observe_gc(anjay_t *anjay) {
     }
 }
 
+/**
+ * pmax triggers are rounded down to a whole second, so pmax is treated as
+ * expired if it elapses within the current second - otherwise notifications
+ * triggered early by such rounding would never be sent.
+ */
 static bool has_pmax_expired(const anjay_observation_value_t *value,
                              const anjay_dm_oi_attributes_t *attrs) {
     return is_pmax_valid(*attrs)
            && avs_time_real_diff(avs_time_real_now(), value->timestamp).seconds
+                              + 1
                       >= attrs->max_period;
 }
 
@@ -1157,6 +1505,76 @@ static void value_sent(anjay_observe_connection_entry_t *conn_state) {
     observation->last_sent = sent;
 }
 
+static bool format_supports_aggregation(uint16_t format) {
+    switch (format) {
+#ifdef WITH_LWM2M_JSON
+    case AVS_COAP_FORMAT_OMA_LWM2M_JSON:
+#endif // WITH_LWM2M_JSON
+    case AVS_COAP_FORMAT_SENML_CBOR:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool can_aggregate_values(const anjay_observation_value_t *first,
+                                 const anjay_observation_value_t *next) {
+    return next->ref == first->ref && !is_error_value(next)
+           && next->details.msg_code == first->details.msg_code
+           && next->details.format == first->details.format;
+}
+
+/**
+ * Moves further values queued for the same observation as the head of the
+ * unsent queue, so that they directly follow it, and returns the number of
+ * values that can be conveyed in a single notification (at least 1).
+ *
+ * Relative order of values belonging to each observation is preserved. The
+ * search stops at the first value of the observation that cannot be merged
+ * (e.g. an error), so that it is never reordered with respect to the others.
+ */
+static size_t
+gather_aggregated_values(anjay_observe_connection_entry_t *conn) {
+    assert(conn->unsent);
+    anjay_observation_value_t *const first = conn->unsent;
+    const size_t limit = _anjay_from_server(conn->conn_ref.server)
+                                 ->observe.aggregated_notification_limit;
+    if (limit <= 1 || is_error_value(first)
+            || !format_supports_aggregation(first->details.format)) {
+        return 1;
+    }
+
+    size_t count = 1;
+    anjay_observation_value_t *gathered_last = first;
+    anjay_observation_value_t *prev = first;
+    AVS_LIST(anjay_observation_value_t) *value_ptr =
+            AVS_LIST_NEXT_PTR(&conn->unsent);
+    while (*value_ptr && count < limit) {
+        anjay_observation_value_t *value = *value_ptr;
+        if (value->ref != first->ref) {
+            prev = value;
+            value_ptr = AVS_LIST_NEXT_PTR(value_ptr);
+            continue;
+        }
+        if (!can_aggregate_values(first, value)) {
+            break;
+        }
+        if (prev == gathered_last) {
+            prev = value;
+            value_ptr = AVS_LIST_NEXT_PTR(value_ptr);
+        } else {
+            if (conn->unsent_last == value) {
+                conn->unsent_last = prev;
+            }
+            AVS_LIST_INSERT(AVS_LIST_NEXT_PTR(&gathered_last),
+                            AVS_LIST_DETACH(value_ptr));
+        }
+        gathered_last = value;
+        ++count;
+    }
+    return count;
+}
+
 static bool notification_storing_enabled(anjay_connection_ref_t conn_ref) {
     anjay_t *anjay = _anjay_from_server(conn_ref.server);
     anjay_iid_t server_iid;
@@ -1185,7 +1603,7 @@ static void remove_all_unsent_values(anjay_observe_connection_entry_t *conn) {
 static void schedule_all_triggers(anjay_observe_connection_entry_t *conn) {
     AVS_RBTREE_ELEM(anjay_observation_t) observation;
     AVS_RBTREE_FOREACH(observation, conn->observations) {
-        if (!observation->notify_task) {
+        if (!observation->trigger_bucket) {
             _anjay_observe_schedule_pmax_trigger(conn, observation);
         }
     }
@@ -1287,16 +1705,19 @@ static void on_entry_flushed(anjay_observe_connection_entry_t *conn,
 
 static void
 cleanup_serialization_state(anjay_observation_serialization_state_t *state) {
-    _anjay_output_ctx_destroy(&state->out_ctx);
-    avs_stream_cleanup(&state->membuf_stream);
+    avs_free(state->payload);
+    state->payload = NULL;
+    state->payload_size = 0;
 }
 
 static int
-initialize_serialization_state(anjay_observe_connection_entry_t *conn) {
-    assert(!conn->serialization_state.membuf_stream);
-    assert(!conn->serialization_state.out_ctx);
+initialize_serialization_state(anjay_observe_connection_entry_t *conn,
+                               size_t values_count) {
+    assert(!conn->serialization_state.payload);
+    assert(values_count >= 1);
     memset(&conn->serialization_state, 0, sizeof(conn->serialization_state));
 
+    anjay_t *anjay = _anjay_from_server(conn->conn_ref.server);
     anjay_observation_value_t *value = conn->unsent;
     anjay_observation_t *observation = value->ref;
 
@@ -1313,15 +1734,46 @@ initialize_serialization_state(anjay_observe_connection_entry_t *conn) {
     // link here. -- marian
     const anjay_uri_path_t root_path = get_observation_path(observation);
 
-    if (!(conn->serialization_state.membuf_stream = avs_stream_membuf_create())
-            || _anjay_output_dynamic_construct(
-                       &conn->serialization_state.out_ctx,
-                       conn->serialization_state.membuf_stream, &root_path,
-                       value->details.format, observation->action)) {
-        return -1;
+    avs_stream_t *membuf = avs_stream_membuf_create();
+    anjay_output_ctx_t *out_ctx = NULL;
+    int result = -1;
+    if (membuf
+            && !(result = _anjay_output_dynamic_construct(
+                         &out_ctx, membuf, &root_path, value->details.format,
+                         observation->action))) {
+        const avs_time_real_t serialization_time = avs_time_real_now();
+        // Merged values are written one after another; each record carries
+        // its own timestamp, so that the server is able to tell them apart.
+        for (size_t v = 0; !result && v < values_count;
+             ++v, value = AVS_LIST_NEXT(value)) {
+            assert(value && value->ref == observation);
+            for (size_t i = 0; !result && i < observation->paths_count; ++i) {
+                const anjay_batch_data_output_state_t *output_state = NULL;
+                do {
+                    // NOTE: Access Control permissions have been checked
+                    // during the _anjay_dm_read_as_batch() stage, so we're
+                    // "spoofing" ANJAY_SSID_BOOTSTRAP as the permissions are
+                    // checked now
+                    result = _anjay_batch_data_output_entry(
+                            anjay, value->values[i], ANJAY_SSID_BOOTSTRAP,
+                            serialization_time, &output_state, out_ctx);
+                } while (!result && output_state);
+            }
+        }
+        result = _anjay_output_ctx_destroy_and_process_result(&out_ctx,
+                                                              result);
     }
-    conn->serialization_state.serialization_time = avs_time_real_now();
-    return 0;
+    if (!result
+            && avs_is_err(avs_stream_membuf_take_ownership(
+                       membuf, &conn->serialization_state.payload,
+                       &conn->serialization_state.payload_size))) {
+        result = -1;
+    }
+    if (!result) {
+        conn->serialization_state.values_count = values_count;
+    }
+    avs_stream_cleanup(&membuf);
+    return result;
 }
 
 static void
@@ -1331,6 +1783,7 @@ handle_notify_delivery(avs_coap_ctx_t *coap, avs_error_t err, void *conn_) {
             (anjay_observe_connection_entry_t *) conn_;
 
     conn->notify_exchange_id = AVS_COAP_EXCHANGE_ID_INVALID;
+    size_t values_count = conn->serialization_state.values_count;
     cleanup_serialization_state(&conn->serialization_state);
     if (avs_is_ok(err)) {
         assert(!is_error_value(conn->unsent));
@@ -1338,7 +1791,9 @@ handle_notify_delivery(avs_coap_ctx_t *coap, avs_error_t err, void *conn_) {
                 == AVS_COAP_NOTIFY_PREFER_CONFIRMABLE) {
             conn->unsent->ref->last_confirmable = avs_time_real_now();
         }
-        value_sent(conn);
+        do {
+            value_sent(conn);
+        } while (values_count-- > 1 && conn->unsent);
     }
     on_entry_flushed(conn, err);
 }
@@ -1347,9 +1802,24 @@ static void flush_next_unsent(anjay_observe_connection_entry_t *conn) {
     assert(conn->unsent);
     anjay_observation_t *observation = conn->unsent->ref;
     anjay_msg_details_t details = conn->unsent->details;
+    const size_t values_count = gather_aggregated_values(conn);
 
     if (confirmable_required(conn)) {
         conn->unsent->reliability_hint = AVS_COAP_NOTIFY_PREFER_CONFIRMABLE;
+    } else {
+        // if any of the merged values requires a Confirmable message, the
+        // whole notification needs to be Confirmable
+        AVS_LIST(anjay_observation_value_t) value =
+                AVS_LIST_NEXT(conn->unsent);
+        for (size_t i = 1; i < values_count;
+             ++i, value = AVS_LIST_NEXT(value)) {
+            if (value->reliability_hint
+                    == AVS_COAP_NOTIFY_PREFER_CONFIRMABLE) {
+                conn->unsent->reliability_hint =
+                        AVS_COAP_NOTIFY_PREFER_CONFIRMABLE;
+                break;
+            }
+        }
     }
 
     anjay_connection_ref_t conn_ref = conn->conn_ref;
@@ -1375,9 +1845,14 @@ static void flush_next_unsent(anjay_observe_connection_entry_t *conn) {
         avs_coap_payload_writer_t *payload_writer = NULL;
         if (!is_error_value(conn->unsent)) {
             payload_writer = write_notify_payload;
-            if (initialize_serialization_state(conn)) {
+            if (initialize_serialization_state(conn, values_count)) {
                 err = avs_errno(AVS_ENOMEM);
             }
+        } else {
+            // error responses carry no payload, but in-flight values are
+            // still tracked using values_count
+            assert(values_count == 1);
+            conn->serialization_state.values_count = 1;
         }
         if (avs_is_err(err)) {
             on_entry_flushed(conn, err);
@@ -1462,8 +1937,8 @@ update_notification_value(anjay_observe_connection_entry_t *conn_state,
     int result = 0;
     for (size_t i = 0; i < observation->paths_count; ++i) {
         anjay_dm_internal_r_attrs_t attrs;
-        if ((result = get_effective_attrs(anjay, &attrs, &observation->paths[i],
-                                          ssid))) {
+        if ((result = get_observation_attrs(conn_state, observation, i,
+                                            &attrs))) {
             anjay_log(ERROR, "Could not get attributes of path %s",
                       ANJAY_DEBUG_MAKE_PATH(&observation->paths[i]));
             goto finish;
@@ -1471,9 +1946,9 @@ update_notification_value(anjay_observe_connection_entry_t *conn_state,
 
         if (has_epmin_expired(newest_value(observation)->values[i],
                               &attrs.standard.common)) {
-            if ((result = read_observation_path(anjay, &observation->paths[i],
-                                                observation->action, ssid,
-                                                &batches[i]))) {
+            if ((result = read_observation_path_cached(
+                         anjay, &observation->paths[i], observation->action,
+                         ssid, &batches[i]))) {
                 anjay_log(ERROR, "Could not read path %s for notifying",
                           ANJAY_DEBUG_MAKE_PATH(&observation->paths[i]));
                 goto finish;
@@ -1519,7 +1994,7 @@ update_notification_value(anjay_observe_connection_entry_t *conn_state,
     }
 
     if (!result && pmax >= 0) {
-        schedule_trigger(conn_state, observation, pmax);
+        schedule_trigger(conn_state, observation, pmax, TRIGGER_NOT_AFTER);
     }
 
 finish:
@@ -1527,36 +2002,56 @@ finish:
     return result;
 }
 
-static void trigger_observe(avs_sched_t *sched, const void *args_) {
+static void trigger_bucket_job(avs_sched_t *sched, const void *bucket_ptr) {
     (void) sched;
-    const trigger_observe_args_t *args = (const trigger_observe_args_t *) args_;
-    assert(args->conn_state);
-    assert(args->observation);
-    bool ready_for_notifying = _anjay_connection_ready_for_outgoing_message(
-            args->conn_state->conn_ref);
-    if (ready_for_notifying
-            || notification_storing_enabled(args->conn_state->conn_ref)) {
-        int result =
-                update_notification_value(args->conn_state, args->observation);
-        if (result) {
-            insert_error(args->conn_state, args->observation, result);
+    AVS_RBTREE_ELEM(anjay_observe_trigger_bucket_t) bucket =
+            *(AVS_RBTREE_ELEM(anjay_observe_trigger_bucket_t) const *)
+                    bucket_ptr;
+    anjay_observe_connection_entry_t *conn_state = bucket->conn;
+    // detach the bucket first, so that any triggers scheduled while
+    // processing it end up in new buckets
+    AVS_RBTREE_DETACH(conn_state->trigger_buckets, bucket);
+
+    bool ready_for_notifying =
+            _anjay_connection_ready_for_outgoing_message(conn_state->conn_ref);
+    bool update_values =
+            (ready_for_notifying
+             || notification_storing_enabled(conn_state->conn_ref));
+    anjay_t *anjay = _anjay_from_server(conn_state->conn_ref.server);
+    _anjay_dm_resource_cache_begin(anjay);
+    AVS_LIST_CLEAR(&bucket->observations) {
+        anjay_observation_t *observation = *bucket->observations;
+        if (!observation) {
+            // rescheduled or removed in the meantime
+            continue;
+        }
+        assert(observation->trigger_bucket == bucket);
+        assert(observation->trigger_slot == bucket->observations);
+        observation->trigger_bucket = NULL;
+        observation->trigger_slot = NULL;
+        if (update_values) {
+            int result = update_notification_value(conn_state, observation);
+            if (result) {
+                insert_error(conn_state, observation, result);
+            }
         }
     }
-    if (ready_for_notifying && args->conn_state->unsent
-            && !avs_coap_exchange_id_valid(
-                       args->conn_state->notify_exchange_id)) {
-        avs_sched_del(&args->conn_state->flush_task);
-        assert(!args->conn_state->flush_task);
-        if (_anjay_connection_get_online_socket(args->conn_state->conn_ref)) {
-            flush_next_unsent(args->conn_state);
-        } else if (_anjay_server_registration_info(
-                           args->conn_state->conn_ref.server)
+    _anjay_dm_resource_cache_end(anjay);
+    AVS_RBTREE_ELEM_DELETE_DETACHED(&bucket);
+
+    if (ready_for_notifying && conn_state->unsent
+            && !avs_coap_exchange_id_valid(conn_state->notify_exchange_id)) {
+        avs_sched_del(&conn_state->flush_task);
+        assert(!conn_state->flush_task);
+        if (_anjay_connection_get_online_socket(conn_state->conn_ref)) {
+            flush_next_unsent(conn_state);
+        } else if (_anjay_server_registration_info(conn_state->conn_ref.server)
                            ->queue_mode) {
-            _anjay_connection_bring_online(args->conn_state->conn_ref);
+            _anjay_connection_bring_online(conn_state->conn_ref);
             // once the connection is up, _anjay_observe_sched_flush()
             // will be called; we're done here
-        } else if (!notification_storing_enabled(args->conn_state->conn_ref)) {
-            remove_all_unsent_values(args->conn_state);
+        } else if (!notification_storing_enabled(conn_state->conn_ref)) {
+            remove_all_unsent_values(conn_state);
         }
     }
 }
@@ -1565,9 +2060,27 @@ static anjay_dm_oi_attributes_t
 get_oi_attributes(anjay_observe_connection_entry_t *connection,
                   anjay_observe_path_entry_t *path_entry) {
     anjay_dm_internal_r_attrs_t attrs = ANJAY_DM_INTERNAL_R_ATTRS_EMPTY;
-    if (get_effective_attrs(_anjay_from_server(connection->conn_ref.server),
-                            &attrs, &path_entry->path,
-                            _anjay_server_ssid(connection->conn_ref.server))) {
+    // attributes are the same for all observations that include the path, so
+    // any of them may be used to look up the cached value
+    anjay_observation_t *observation = path_entry->refs ? *path_entry->refs
+                                                        : NULL;
+    size_t path_index = 0;
+    while (observation && path_index < observation->paths_count
+           && !_anjay_uri_path_equal(&observation->paths[path_index],
+                                     &path_entry->path)) {
+        ++path_index;
+    }
+    int result;
+    if (observation && path_index < observation->paths_count) {
+        result = get_observation_attrs(connection, observation, path_index,
+                                       &attrs);
+    } else {
+        result = get_effective_attrs(
+                _anjay_from_server(connection->conn_ref.server), &attrs,
+                &path_entry->path,
+                _anjay_server_ssid(connection->conn_ref.server));
+    }
+    if (result) {
         return ANJAY_DM_OI_ATTRIBUTES_EMPTY;
     }
     return attrs.standard.common;
@@ -1584,7 +2097,8 @@ static int notify_path_changed(anjay_observe_connection_entry_t *connection,
         assert(ref);
         assert(*ref);
         _anjay_update_ret((int *) result_ptr,
-                          schedule_trigger(connection, *ref, period));
+                          schedule_trigger(connection, *ref, period,
+                                           TRIGGER_NOT_BEFORE));
     }
     return 0;
 }
@@ -1707,6 +2221,8 @@ static int observe_notify_impl(anjay_t *anjay,
                                anjay_ssid_t ssid,
                                bool invert_server_match,
                                observe_for_each_matching_clb_t *clb) {
+    // values cached so far might no longer be up to date
+    _anjay_observe_read_cache_clear(&anjay->observe);
     // iterate through all SSIDs we have
     int result = 0;
     AVS_LIST(anjay_observe_connection_entry_t) connection;
@@ -37,12 +37,40 @@ typedef enum {
     NOTIFY_QUEUE_DROP_OLDEST
 } notify_queue_limit_mode_t;
 
+typedef struct anjay_observe_persisted_entry_struct
+        anjay_observe_persisted_entry_t;
+
+typedef struct {
+    anjay_uri_path_t path;
+    anjay_request_action_t action;
+    // Access rights class the value has been read under: ANJAY_SSID_ANY if it
+    // may be reused for every Server allowed to read the path, or SSID of the
+    // Server it has been read on behalf of otherwise
+    anjay_ssid_t access_class;
+    anjay_batch_t *batch;
+} anjay_observe_read_cache_entry_t;
+
 typedef struct {
     AVS_LIST(anjay_observe_connection_entry_t) connection_entries;
     bool confirmable_notifications;
+    bool cache_attributes;
 
     notify_queue_limit_mode_t notify_queue_limit_mode;
     size_t notify_queue_limit;
+
+    // maximum number of queued values of a single observation that may be
+    // merged into one notification; 0 or 1 disables merging
+    size_t aggregated_notification_limit;
+
+    // observations loaded by anjay_observe_restore() that have not been
+    // attached to their connections yet
+    AVS_LIST(anjay_observe_persisted_entry_t) restored;
+
+    // Values read while refreshing observations, shared between all
+    // connections. Valid only within a single anjay_sched_run() call, and
+    // until any change in the data model is notified.
+    // Keyed by (path, action, access_class); created lazily.
+    AVS_RBTREE(anjay_observe_read_cache_entry_t) read_cache;
 } anjay_observe_state_t;
 
 typedef struct {
@@ -61,10 +89,19 @@ typedef struct {
 
 void _anjay_observe_init(anjay_observe_state_t *observe,
                          bool confirmable_notifications,
-                         size_t stored_notification_limit);
+                         size_t stored_notification_limit,
+                         size_t aggregated_notification_limit,
+                         bool cache_attributes);
 
 void _anjay_observe_cleanup(anjay_observe_state_t *observe);
 
+/**
+ * Drops all values cached while refreshing observations. Called after each
+ * round of scheduler jobs, so that every observation of the same path,
+ * triggered at the same time, is served with a single data model read.
+ */
+void _anjay_observe_read_cache_clear(anjay_observe_state_t *observe);
+
 void _anjay_observe_gc(anjay_t *anjay);
 
 int _anjay_observe_handle(anjay_t *anjay, const anjay_request_t *request);
@@ -78,13 +115,31 @@ int _anjay_observe_notify(anjay_t *anjay,
                           anjay_ssid_t ssid,
                           bool invert_ssid_match);
 
+#    ifdef WITH_AVS_PERSISTENCE
+avs_error_t _anjay_observe_persist(anjay_t *anjay, avs_stream_t *out_stream);
+
+avs_error_t _anjay_observe_restore(anjay_t *anjay, avs_stream_t *in_stream);
+
+/**
+ * Attaches observations previously loaded by anjay_observe_restore() that
+ * belong to the connection @p ref. This needs to be called after the CoAP
+ * context for that connection is created, but before a socket is assigned to
+ * it - the CoAP layer does not allow restoring observations after that point.
+ */
+void _anjay_observe_restore_connection(anjay_connection_ref_t ref);
+#    else // WITH_AVS_PERSISTENCE
+#        define _anjay_observe_restore_connection(...) ((void) 0)
+#    endif // WITH_AVS_PERSISTENCE
+
 #else // WITH_OBSERVE
 
 #    define _anjay_observe_init(...) ((void) 0)
 #    define _anjay_observe_cleanup(...) ((void) 0)
+#    define _anjay_observe_read_cache_clear(...) ((void) 0)
 #    define _anjay_observe_gc(...) ((void) 0)
 #    define _anjay_observe_interrupt(...) ((void) 0)
 #    define _anjay_observe_sched_flush(...) 0
+#    define _anjay_observe_restore_connection(...) ((void) 0)
 
 #endif // WITH_OBSERVE
 
@@ -23,12 +23,28 @@
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
 
+typedef struct anjay_observe_trigger_bucket_struct
+        anjay_observe_trigger_bucket_t;
+
+typedef struct {
+    // values of anjay_dm_t::attributes_generation and
+    // anjay_dm_t::instances_generation at the time attrs have been resolved
+    uint64_t attributes_generation;
+    uint64_t instances_generation;
+    bool valid;
+    anjay_dm_internal_r_attrs_t attrs;
+} anjay_observation_attrs_cache_t;
+
 struct anjay_observation_struct {
     const avs_coap_token_t token;
 
     const anjay_request_action_t action;
 
-    avs_sched_handle_t notify_task;
+    // bucket in which the next notification trigger is scheduled, and the
+    // element of its observations list that refers to this observation; both
+    // are NULL if no trigger is scheduled
+    anjay_observe_trigger_bucket_t *trigger_bucket;
+    anjay_observation_t **trigger_slot;
     avs_time_real_t last_confirmable;
 
     // last_sent has ALWAYS EXACTLY one element,
@@ -43,6 +59,11 @@ struct anjay_observation_struct {
     // to this resource+format or not)
     AVS_LIST(anjay_observation_value_t) last_unsent;
 
+    // Effective attributes of each element of paths, as resolved for the
+    // Server owning the observation. Allocated on first use, and only if
+    // anjay_observe_state_t::cache_attributes is set.
+    anjay_observation_attrs_cache_t *attrs_cache;
+
     const size_t paths_count;
     const anjay_uri_path_t paths[];
 };
@@ -55,13 +76,37 @@ typedef struct {
     AVS_LIST(AVS_RBTREE_ELEM(anjay_observation_t)) refs;
 } anjay_observe_path_entry_t;
 
+/**
+ * Set of observations within a single connection whose notification triggers
+ * are due at the same time. All of them are handled by a single scheduler job,
+ * so that the number of jobs does not grow with the number of observations
+ * sharing the same periods, and notifications they produce are flushed
+ * together.
+ */
+struct anjay_observe_trigger_bucket_struct {
+    avs_time_monotonic_t instant;
+    anjay_observe_connection_entry_t *conn;
+    avs_sched_handle_t job;
+
+    // Observations to trigger, in order of scheduling. Elements are set to NULL
+    // (instead of being removed) when the observation is rescheduled or
+    // removed, so that it can be done in constant time.
+    AVS_LIST(anjay_observation_t *) observations;
+    // pointer to the last element of observations
+    AVS_LIST(anjay_observation_t *) observations_last;
+};
+
 typedef struct {
-    avs_stream_t *membuf_stream;
-    anjay_output_ctx_t *out_ctx;
-    size_t expected_offset;
-    avs_time_real_t serialization_time;
-    size_t curr_value_idx;
-    const anjay_batch_data_output_state_t *output_state;
+    // Complete payload of the notification currently being sent, encoded once
+    // when the exchange is started. Every chunk requested by the CoAP layer
+    // (including BLOCK2 continuations and repeated requests for the same block)
+    // is then served directly from this buffer.
+    void *payload;
+    size_t payload_size;
+    // Number of values, starting from the head of the unsent queue, that are
+    // conveyed in this payload; greater than 1 if queued values have been
+    // merged (see aggregated_notification_limit)
+    size_t values_count;
 } anjay_observation_serialization_state_t;
 
 struct anjay_observe_connection_entry_struct {
@@ -69,6 +114,7 @@ struct anjay_observe_connection_entry_struct {
 
     AVS_RBTREE(anjay_observation_t) observations;
     AVS_RBTREE(anjay_observe_path_entry_t) observed_paths;
+    AVS_RBTREE(anjay_observe_trigger_bucket_t) trigger_buckets;
     avs_sched_handle_t flush_task;
     avs_coap_exchange_id_t notify_exchange_id;
     anjay_observation_serialization_state_t serialization_state;
@@ -76,6 +122,9 @@ struct anjay_observe_connection_entry_struct {
     AVS_LIST(anjay_observation_value_t) unsent;
     // pointer to the last element of unsent
     AVS_LIST(anjay_observation_value_t) unsent_last;
+    // number of elements on the unsent list, maintained alongside it so that
+    // notify queue limit checks do not need to traverse the list
+    size_t unsent_count;
 };
 
 static inline bool
@@ -105,6 +154,48 @@ int _anjay_observe_schedule_pmax_trigger(
 
 void _anjay_observe_cancel_handler(avs_coap_observe_id_t id, void *ref_ptr);
 
+#ifdef WITH_AVS_PERSISTENCE
+/**
+ * Flat representation of a single observation, as stored by
+ * anjay_observe_persist() and loaded by anjay_observe_restore().
+ *
+ * Restored entries are kept in anjay_observe_state_t::restored until the
+ * connection they belong to gets its CoAP context created - see
+ * _anjay_observe_restore_connection().
+ */
+struct anjay_observe_persisted_entry_struct {
+    anjay_ssid_t ssid;
+    anjay_connection_type_t conn_type;
+    avs_coap_token_t token;
+    anjay_request_action_t action;
+    avs_time_real_t last_confirmable;
+
+    // details and timestamp of the last sent value
+    anjay_msg_details_t details;
+    avs_time_real_t timestamp;
+
+    size_t paths_count;
+    anjay_uri_path_t *paths;
+    // array of paths_count elements; values[i] corresponds to paths[i]
+    anjay_batch_t **values;
+
+    // CoAP-level observation state, as stored by avs_coap_observe_persist()
+    void *coap_state;
+    size_t coap_state_size;
+};
+
+/**
+ * Recreates an observation described by @p entry in the observe state of
+ * connection @p ref, and in its CoAP context.
+ *
+ * The CoAP context MUST NOT have a socket assigned yet.
+ */
+int _anjay_observe_add_restored(anjay_connection_ref_t ref,
+                                const anjay_observe_persisted_entry_t *entry);
+
+void _anjay_observe_clear_restored(anjay_observe_state_t *observe);
+#endif // WITH_AVS_PERSISTENCE
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif /* ANJAY_OBSERVE_INTERNAL_H */
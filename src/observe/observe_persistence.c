@@ -0,0 +1,272 @@
+/*
+ * Copyright 2017-2019 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <inttypes.h>
+
+#include <avsystem/commons/errno.h>
+#ifdef WITH_AVS_PERSISTENCE
+#    include <avsystem/commons/persistence.h>
+#endif // WITH_AVS_PERSISTENCE
+#include <avsystem/commons/stream/stream_membuf.h>
+
+#include <avsystem/coap/observe.h>
+
+#include "../anjay_core.h"
+#include "../servers_utils.h"
+
+#include "observe_internal.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+#ifdef WITH_AVS_PERSISTENCE
+
+/**
+ * NOTE: Magic header is followed by one byte which is supposed to be a version
+ * number.
+ *
+ * Known versions are:
+ * - 0: initial version
+ */
+static const char *MAGIC = "AOS";
+
+static const uint8_t SUPPORTED_VERSIONS[] = { 0 };
+
+static avs_error_t handle_path(avs_persistence_context_t *ctx,
+                               anjay_uri_path_t *path) {
+    avs_error_t err = AVS_OK;
+    for (size_t i = 0; avs_is_ok(err) && i < AVS_ARRAY_SIZE(path->ids); ++i) {
+        err = avs_persistence_u16(ctx, &path->ids[i]);
+    }
+    return err;
+}
+
+static void cleanup_entry(void *entry_) {
+    anjay_observe_persisted_entry_t *entry =
+            (anjay_observe_persisted_entry_t *) entry_;
+    if (entry->values) {
+        for (size_t i = 0; i < entry->paths_count; ++i) {
+            if (entry->values[i]) {
+                _anjay_batch_release(&entry->values[i]);
+            }
+        }
+        avs_free(entry->values);
+    }
+    avs_free(entry->paths);
+    avs_free(entry->coap_state);
+}
+
+static avs_error_t handle_entry(avs_persistence_context_t *ctx,
+                                void *entry_,
+                                void *user_data) {
+    (void) user_data;
+    anjay_observe_persisted_entry_t *entry =
+            (anjay_observe_persisted_entry_t *) entry_;
+    uint8_t conn_type = (uint8_t) entry->conn_type;
+    uint8_t action = (uint8_t) entry->action;
+    uint32_t paths_count = (uint32_t) entry->paths_count;
+    avs_error_t err;
+    if (avs_is_err((err = avs_persistence_u16(ctx, &entry->ssid)))
+            || avs_is_err((err = avs_persistence_u8(ctx, &conn_type)))
+            || avs_is_err((err = avs_persistence_u8(ctx, &entry->token.size)))
+            || avs_is_err((err = (avs_coap_token_valid(&entry->token)
+                                          ? AVS_OK
+                                          : avs_errno(AVS_EBADMSG))))
+            || avs_is_err((err = avs_persistence_bytes(ctx, entry->token.bytes,
+                                                       entry->token.size)))
+            || avs_is_err((err = avs_persistence_u8(ctx, &action)))
+            || avs_is_err((err = _anjay_persistence_time(
+                                   ctx, &entry->last_confirmable)))
+            || avs_is_err((err = avs_persistence_u8(
+                                   ctx, &entry->details.msg_code)))
+            || avs_is_err((err = avs_persistence_u16(
+                                   ctx, &entry->details.format)))
+            || avs_is_err(
+                       (err = _anjay_persistence_time(ctx, &entry->timestamp)))
+            || avs_is_err((err = avs_persistence_u32(ctx, &paths_count)))) {
+        return err;
+    }
+
+    if (avs_persistence_direction(ctx) == AVS_PERSISTENCE_RESTORE) {
+        if (conn_type >= ANJAY_CONNECTION_LIMIT_
+                || action != ANJAY_ACTION_READ || !paths_count
+                || _anjay_observe_is_error_details(&entry->details)) {
+            return avs_errno(AVS_EBADMSG);
+        }
+        entry->conn_type = (anjay_connection_type_t) conn_type;
+        entry->action = (anjay_request_action_t) action;
+        if (!(entry->paths = (anjay_uri_path_t *) avs_calloc(
+                      paths_count, sizeof(*entry->paths)))
+                || !(entry->values = (anjay_batch_t **) avs_calloc(
+                             paths_count, sizeof(*entry->values)))) {
+            anjay_log(ERROR, "out of memory");
+            return avs_errno(AVS_ENOMEM);
+        }
+        entry->paths_count = paths_count;
+    }
+
+    for (size_t i = 0; i < entry->paths_count; ++i) {
+        if (avs_is_err((err = handle_path(ctx, &entry->paths[i])))
+                || avs_is_err((err = _anjay_batch_persistence(
+                                       ctx, &entry->values[i])))) {
+            return err;
+        }
+    }
+    return avs_persistence_sized_buffer(ctx, &entry->coap_state,
+                                        &entry->coap_state_size);
+}
+
+static bool is_persistable(const anjay_observe_connection_entry_t *conn,
+                           const anjay_observation_t *observation) {
+    return _anjay_connection_get_coap(conn->conn_ref) && observation->last_sent
+           && !_anjay_observe_is_error_details(&observation->last_sent->details);
+}
+
+static avs_error_t persist_observation(avs_persistence_context_t *ctx,
+                                       anjay_observe_connection_entry_t *conn,
+                                       anjay_observation_t *observation) {
+    avs_stream_t *coap_state_stream = avs_stream_membuf_create();
+    if (!coap_state_stream) {
+        anjay_log(ERROR, "out of memory");
+        return avs_errno(AVS_ENOMEM);
+    }
+    avs_persistence_context_t coap_state_ctx =
+            avs_persistence_store_context_create(coap_state_stream);
+
+    anjay_observe_persisted_entry_t entry = {
+        .ssid = _anjay_server_ssid(conn->conn_ref.server),
+        .conn_type = conn->conn_ref.conn_type,
+        .token = observation->token,
+        .action = observation->action,
+        .last_confirmable = observation->last_confirmable,
+        .details = {
+            .msg_code = observation->last_sent->details.msg_code,
+            .format = observation->last_sent->details.format
+        },
+        .timestamp = observation->last_sent->timestamp,
+        .paths_count = observation->paths_count,
+        .paths = (anjay_uri_path_t *) (intptr_t) observation->paths,
+        .values = observation->last_sent->values
+    };
+    avs_error_t err;
+    (void) (avs_is_err((err = avs_coap_observe_persist(
+                                _anjay_connection_get_coap(conn->conn_ref),
+                                (avs_coap_observe_id_t) {
+                                    .token = observation->token
+                                },
+                                &coap_state_ctx)))
+            || avs_is_err((err = avs_stream_membuf_take_ownership(
+                                   coap_state_stream, &entry.coap_state,
+                                   &entry.coap_state_size)))
+            || avs_is_err((err = handle_entry(ctx, &entry, NULL))));
+    avs_free(entry.coap_state);
+    avs_stream_cleanup(&coap_state_stream);
+    return err;
+}
+
+avs_error_t _anjay_observe_persist(anjay_t *anjay, avs_stream_t *out_stream) {
+    uint32_t count = 0;
+    AVS_LIST(anjay_observe_connection_entry_t) conn;
+    AVS_RBTREE_ELEM(anjay_observation_t) observation;
+    AVS_LIST_FOREACH(conn, anjay->observe.connection_entries) {
+        AVS_RBTREE_FOREACH(observation, conn->observations) {
+            if (is_persistable(conn, observation)) {
+                ++count;
+            }
+        }
+    }
+
+    avs_persistence_context_t ctx =
+            avs_persistence_store_context_create(out_stream);
+    uint8_t version = SUPPORTED_VERSIONS[AVS_ARRAY_SIZE(SUPPORTED_VERSIONS) - 1];
+    avs_error_t err;
+    if (avs_is_err((err = avs_persistence_magic_string(&ctx, MAGIC)))
+            || avs_is_err((err = avs_persistence_version(
+                                   &ctx, &version, SUPPORTED_VERSIONS,
+                                   sizeof(SUPPORTED_VERSIONS))))
+            || avs_is_err((err = avs_persistence_u32(&ctx, &count)))) {
+        return err;
+    }
+    AVS_LIST_FOREACH(conn, anjay->observe.connection_entries) {
+        AVS_RBTREE_FOREACH(observation, conn->observations) {
+            if (is_persistable(conn, observation)
+                    && avs_is_err((err = persist_observation(&ctx, conn,
+                                                             observation)))) {
+                return err;
+            }
+        }
+    }
+    anjay_log(INFO, "%" PRIu32 " observations persisted", count);
+    return AVS_OK;
+}
+
+avs_error_t _anjay_observe_restore(anjay_t *anjay, avs_stream_t *in_stream) {
+    AVS_LIST(anjay_observe_persisted_entry_t) restored = NULL;
+    avs_persistence_context_t ctx =
+            avs_persistence_restore_context_create(in_stream);
+    uint8_t version;
+    avs_error_t err;
+    (void) (avs_is_err((err = avs_persistence_magic_string(&ctx, MAGIC)))
+            || avs_is_err((err = avs_persistence_version(
+                                   &ctx, &version, SUPPORTED_VERSIONS,
+                                   sizeof(SUPPORTED_VERSIONS))))
+            || avs_is_err((err = avs_persistence_list(
+                                   &ctx, (AVS_LIST(void) *) &restored,
+                                   sizeof(anjay_observe_persisted_entry_t),
+                                   handle_entry, NULL, cleanup_entry))));
+    if (avs_is_err(err)) {
+        AVS_LIST_CLEAR(&restored) {
+            cleanup_entry(restored);
+        }
+        return err;
+    }
+
+    _anjay_observe_clear_restored(&anjay->observe);
+    anjay->observe.restored = restored;
+    anjay_log(INFO, "%lu observations restored",
+              (unsigned long) AVS_LIST_SIZE(restored));
+    return AVS_OK;
+}
+
+void _anjay_observe_restore_connection(anjay_connection_ref_t ref) {
+    anjay_t *anjay = _anjay_from_server(ref.server);
+    const anjay_ssid_t ssid = _anjay_server_ssid(ref.server);
+    AVS_LIST(anjay_observe_persisted_entry_t) *entry_ptr;
+    AVS_LIST(anjay_observe_persisted_entry_t) helper;
+    AVS_LIST_DELETABLE_FOREACH_PTR(entry_ptr, helper,
+                                   &anjay->observe.restored) {
+        if ((*entry_ptr)->ssid != ssid
+                || (*entry_ptr)->conn_type != ref.conn_type) {
+            continue;
+        }
+        if (_anjay_observe_add_restored(ref, *entry_ptr)) {
+            anjay_log(WARNING,
+                      "could not restore observation %s for SSID %" PRIu16,
+                      ANJAY_TOKEN_TO_STRING((*entry_ptr)->token), ssid);
+        }
+        cleanup_entry(*entry_ptr);
+        AVS_LIST_DELETE(entry_ptr);
+    }
+}
+
+void _anjay_observe_clear_restored(anjay_observe_state_t *observe) {
+    AVS_LIST_CLEAR(&observe->restored) {
+        cleanup_entry(observe->restored);
+    }
+}
+
+#endif // WITH_AVS_PERSISTENCE
@@ -18,7 +18,9 @@
 
 #include <math.h>
 #include <stdarg.h>
+#include <string.h>
 
+#include <avsystem/commons/stream/stream_membuf.h>
 #include <avsystem/commons/unit/test.h>
 
 #include <anjay_test/dm.h>
@@ -65,6 +67,7 @@ static void assert_observe_consistency(anjay_t *anjay) {
             }
         }
         AVS_UNIT_ASSERT_EQUAL(path_refs_in_observations, path_refs);
+        AVS_UNIT_ASSERT_EQUAL(conn->unsent_count, AVS_LIST_SIZE(conn->unsent));
     }
 }
 
@@ -761,7 +764,7 @@ static void notify_max_period_test(const char *con_notify_ack,
 
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
     AVS_UNIT_ASSERT_EQUAL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
                     ->last_sent->timestamp.since_real_epoch.seconds,
@@ -832,6 +835,155 @@ AVS_UNIT_TEST(notify, max_period) {
     notify_max_period_test("\x70\x00\x26\xDC", 4, 0); // Reset
 }
 
+#ifdef WITH_AVS_PERSISTENCE
+AVS_UNIT_TEST(observe, persistence_roundtrip) {
+    static const anjay_dm_internal_r_attrs_t ATTRS = {
+        .standard = {
+            .common = {
+                .min_period = 1,
+                .max_period = 10,
+                .min_eval_period = ANJAY_ATTRIB_PERIOD_NONE,
+                .max_eval_period = ANJAY_ATTRIB_PERIOD_NONE
+            },
+            .greater_than = ANJAY_ATTRIB_VALUE_NONE,
+            .less_than = ANJAY_ATTRIB_VALUE_NONE,
+            .step = ANJAY_ATTRIB_VALUE_NONE
+        }
+    };
+
+    DM_TEST_INIT_WITH_SSIDS(14);
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID_TOKEN(0x69ED, "Res4"),
+                    OBSERVE(0), PATH("42", "69", "4"));
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_FLOAT(0, 514.0));
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTENT,
+                            ID_TOKEN(0x69ED, "Res4"), CONTENT_FORMAT(PLAINTEXT),
+                            OBSERVE(0), PAYLOAD("514"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    assert_observe_size(anjay, 1);
+
+    AVS_RBTREE_ELEM(anjay_observation_t) observation =
+            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations);
+    const avs_time_real_t last_sent_timestamp =
+            observation->last_sent->timestamp;
+    const avs_time_real_t last_confirmable = observation->last_confirmable;
+
+    avs_stream_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_observe_persist(anjay, stream));
+
+    // simulate a restart: dropping the CoAP context cancels the observation
+    const anjay_connection_ref_t ref = {
+        .server = anjay->servers->servers,
+        .conn_type = ANJAY_CONNECTION_PRIMARY
+    };
+    anjay_server_connection_t *connection = _anjay_get_server_connection(ref);
+    AVS_UNIT_ASSERT_NOT_NULL(connection);
+    _anjay_coap_ctx_cleanup(anjay, &connection->coap_ctx);
+    AVS_UNIT_ASSERT_NULL(anjay->observe.connection_entries);
+
+    AVS_UNIT_ASSERT_SUCCESS(anjay_observe_restore(anjay, stream));
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(anjay->observe.restored), 1);
+
+    // CoAP observation state can only be restored into a socket-less context
+    connection->coap_ctx = avs_coap_udp_ctx_create(
+            anjay->sched, &AVS_COAP_DEFAULT_UDP_TX_PARAMS,
+            anjay->in_shared_buffer, anjay->out_shared_buffer,
+            anjay->udp_response_cache);
+    AVS_UNIT_ASSERT_NOT_NULL(connection->coap_ctx);
+    // attributes are not persisted, they are read again from the data model
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
+    _anjay_observe_restore_connection(ref);
+    AVS_UNIT_ASSERT_NULL(anjay->observe.restored);
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_coap_ctx_set_socket(connection->coap_ctx, mocksocks[0]));
+
+    assert_observe_consistency(anjay);
+    assert_observe_size(anjay, 1);
+    assert_observe(anjay, 14,
+                   &(const avs_coap_token_t) {
+                       .size = 4,
+                       .bytes = "Res4"
+                   },
+                   &MAKE_RESOURCE_PATH(42, 69, 4),
+                   &(const anjay_msg_details_t) {
+                       .msg_code = AVS_COAP_CODE_CONTENT,
+                       .format = AVS_COAP_FORMAT_PLAINTEXT
+                   },
+                   "514", 3);
+
+    observation =
+            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations);
+    AVS_UNIT_ASSERT_NOT_NULL(observation->trigger_bucket);
+    AVS_UNIT_ASSERT_TRUE(avs_time_real_equal(observation->last_sent->timestamp,
+                                             last_sent_timestamp));
+    AVS_UNIT_ASSERT_TRUE(avs_time_real_equal(observation->last_confirmable,
+                                             last_confirmable));
+
+    avs_stream_cleanup(&stream);
+    DM_TEST_FINISH;
+}
+#endif // WITH_AVS_PERSISTENCE
+
+AVS_UNIT_TEST(notify, cached_attributes) {
+    static const anjay_dm_internal_r_attrs_t ATTRS = {
+        .standard = {
+            .common = {
+                .min_period = 1,
+                .max_period = 10,
+                .min_eval_period = ANJAY_ATTRIB_PERIOD_NONE,
+                .max_eval_period = ANJAY_ATTRIB_PERIOD_NONE
+            },
+            .greater_than = ANJAY_ATTRIB_VALUE_NONE,
+            .less_than = ANJAY_ATTRIB_VALUE_NONE,
+            .step = ANJAY_ATTRIB_VALUE_NONE
+        }
+    };
+
+    ////// INITIALIZATION //////
+    DM_TEST_INIT_GENERIC((DM_TEST_DEFAULT_OBJECTS), (14),
+                         (.cache_observe_attributes = true));
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID_TOKEN(0x69ED, "Res4"),
+                    OBSERVE(0), PATH("42", "69", "4"));
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_FLOAT(0, 514.0));
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTENT,
+                            ID_TOKEN(0x69ED, "Res4"), CONTENT_FORMAT(PLAINTEXT),
+                            OBSERVE(0), PAYLOAD("514"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+
+    assert_observe_size(anjay, 1);
+
+    ////// NOTIFICATION - ATTRIBUTES NOT QUERIED AGAIN //////
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(10, AVS_TIME_S));
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_STRING(0, "Hello"));
+    const coap_test_msg_t *notify_response =
+            COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE, "Res4"), OBSERVE(1),
+                     CONTENT_FORMAT(PLAINTEXT), PAYLOAD("Hello"));
+    avs_unit_mocksock_expect_output(mocksocks[0], notify_response->content,
+                                    notify_response->length);
+    anjay_sched_run(anjay);
+    assert_observe_consistency(anjay);
+    assert_observe_size(anjay, 1);
+
+    ////// NOTIFICATION - ATTRIBUTES INVALIDATED //////
+    _anjay_dm_attributes_changed(anjay);
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(10, AVS_TIME_S));
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_STRING(0, "Hi!"));
+    const coap_test_msg_t *second_notify_response =
+            COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE + 1, "Res4"),
+                     OBSERVE(2), CONTENT_FORMAT(PLAINTEXT), PAYLOAD("Hi!"));
+    avs_unit_mocksock_expect_output(mocksocks[0],
+                                    second_notify_response->content,
+                                    second_notify_response->length);
+    anjay_sched_run(anjay);
+    assert_observe_consistency(anjay);
+    assert_observe_size(anjay, 1);
+
+    DM_TEST_FINISH;
+}
+
 AVS_UNIT_TEST(notify, min_period) {
     static const anjay_dm_internal_r_attrs_t ATTRS = {
         .standard = {
@@ -892,7 +1044,206 @@ AVS_UNIT_TEST(notify, min_period) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
+
+    DM_TEST_FINISH;
+}
+
+static anjay_observation_t *find_observation(anjay_t *anjay,
+                                             const char *token) {
+    avs_coap_token_t coap_token = {
+        .size = (uint8_t) strlen(token)
+    };
+    memcpy(coap_token.bytes, token, coap_token.size);
+    AVS_UNIT_ASSERT_NOT_NULL(anjay->observe.connection_entries);
+    AVS_RBTREE_ELEM(anjay_observation_t) observation = AVS_RBTREE_FIND(
+            anjay->observe.connection_entries->observations,
+            _anjay_observation_query(&coap_token));
+    AVS_UNIT_ASSERT_NOT_NULL(observation);
+    return observation;
+}
+
+AVS_UNIT_TEST(notify, triggers_coalesced_into_bucket) {
+    static const anjay_dm_internal_r_attrs_t ATTRS = {
+        .standard = {
+            .common = {
+                .min_period = 5,
+                .max_period = 365 * 24 * 60 * 60 /* a year */,
+                .min_eval_period = ANJAY_ATTRIB_PERIOD_NONE,
+                .max_eval_period = ANJAY_ATTRIB_PERIOD_NONE
+            },
+            .greater_than = ANJAY_ATTRIB_VALUE_NONE,
+            .less_than = ANJAY_ATTRIB_VALUE_NONE,
+            .step = ANJAY_ATTRIB_VALUE_NONE
+        }
+    };
+
+    ////// INITIALIZATION //////
+    DM_TEST_INIT_WITH_SSIDS(14);
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(200, AVS_TIME_MS));
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID_TOKEN(0x69ED, "A"), OBSERVE(0),
+                    PATH("42", "69", "4"));
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_FLOAT(0, 514.0));
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTENT, ID_TOKEN(0x69ED, "A"),
+                            CONTENT_FORMAT(PLAINTEXT), OBSERVE(0),
+                            PAYLOAD("514"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+
+    // pmax deadlines are rounded down, so that they are never late
+    avs_time_monotonic_t a_pmax_instant = avs_time_monotonic_add(
+            avs_time_monotonic_now(),
+            avs_time_duration_from_scalar(ATTRS.standard.common.max_period,
+                                          AVS_TIME_S));
+    a_pmax_instant.since_monotonic_epoch.nanoseconds = 0;
+    AVS_UNIT_ASSERT_NOT_NULL(find_observation(anjay, "A")->trigger_bucket);
+    AVS_UNIT_ASSERT_TRUE(avs_time_monotonic_equal(
+            find_observation(anjay, "A")->trigger_bucket->instant,
+            a_pmax_instant));
+
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(300, AVS_TIME_MS));
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID_TOKEN(0x69EE, "B"), OBSERVE(0),
+                    PATH("42", "69", "5"));
+    expect_read_res(anjay, &OBJ, 69, 5, ANJAY_MOCK_DM_FLOAT(0, 42.0));
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 5, &ATTRS);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTENT, ID_TOKEN(0x69EE, "B"),
+                            CONTENT_FORMAT(PLAINTEXT), OBSERVE(0),
+                            PAYLOAD("42"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+
+    assert_observe_size(anjay, 2);
+
+    ////// CHANGES AT DIFFERENT TIMES BEFORE PMIN //////
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(500, AVS_TIME_MS));
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    anjay_sched_run(anjay);
+
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(400, AVS_TIME_MS));
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 5, &ATTRS);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 5));
+    anjay_sched_run(anjay);
+
+    // pmin elapses 0.2s and 0.5s past a whole second for the two observations;
+    // both triggers are rounded up to the same bucket
+    anjay_observe_trigger_bucket_t *bucket =
+            find_observation(anjay, "A")->trigger_bucket;
+    AVS_UNIT_ASSERT_NOT_NULL(bucket);
+    AVS_UNIT_ASSERT_TRUE(find_observation(anjay, "B")->trigger_bucket
+                         == bucket);
+    AVS_UNIT_ASSERT_EQUAL(bucket->instant.since_monotonic_epoch.nanoseconds,
+                          0);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(bucket->observations), 2);
+
+    ////// SINGLE FLUSH //////
+    _anjay_mock_clock_advance(avs_time_duration_diff(
+            avs_time_monotonic_diff(bucket->instant, avs_time_monotonic_now()),
+            avs_time_duration_from_scalar(1, AVS_TIME_MS)));
+    anjay_sched_run(anjay);
+    AVS_UNIT_ASSERT_TRUE(find_observation(anjay, "A")->trigger_bucket
+                         == bucket);
+
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(1, AVS_TIME_MS));
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_STRING(0, "Hi!"));
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 5, &ATTRS);
+    expect_read_res(anjay, &OBJ, 69, 5, ANJAY_MOCK_DM_STRING(0, "Ho!"));
+    const coap_test_msg_t *a_notify_response =
+            COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE, "A"), OBSERVE(1),
+                     CONTENT_FORMAT(PLAINTEXT), PAYLOAD("Hi!"));
+    avs_unit_mocksock_expect_output(mocksocks[0], a_notify_response->content,
+                                    a_notify_response->length);
+    const coap_test_msg_t *b_notify_response =
+            COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE + 1, "B"), OBSERVE(1),
+                     CONTENT_FORMAT(PLAINTEXT), PAYLOAD("Ho!"));
+    avs_unit_mocksock_expect_output(mocksocks[0], b_notify_response->content,
+                                    b_notify_response->length);
+    anjay_sched_run(anjay);
+    assert_observe_consistency(anjay);
+    assert_observe_size(anjay, 2);
+    AVS_UNIT_ASSERT_NULL(find_observation(anjay, "A")->last_unsent);
+    AVS_UNIT_ASSERT_NULL(find_observation(anjay, "B")->last_unsent);
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(notify, pmax_triggers_coalesced_into_bucket) {
+    static const anjay_dm_internal_r_attrs_t ATTRS = {
+        .standard = {
+            .common = {
+                .min_period = 0,
+                .max_period = 10,
+                .min_eval_period = ANJAY_ATTRIB_PERIOD_NONE,
+                .max_eval_period = ANJAY_ATTRIB_PERIOD_NONE
+            },
+            .greater_than = ANJAY_ATTRIB_VALUE_NONE,
+            .less_than = ANJAY_ATTRIB_VALUE_NONE,
+            .step = ANJAY_ATTRIB_VALUE_NONE
+        }
+    };
+
+    ////// INITIALIZATION //////
+    DM_TEST_INIT_WITH_SSIDS(14);
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(200, AVS_TIME_MS));
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID_TOKEN(0x69ED, "A"), OBSERVE(0),
+                    PATH("42", "69", "4"));
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_FLOAT(0, 514.0));
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTENT, ID_TOKEN(0x69ED, "A"),
+                            CONTENT_FORMAT(PLAINTEXT), OBSERVE(0),
+                            PAYLOAD("514"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(300, AVS_TIME_MS));
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID_TOKEN(0x69EE, "B"), OBSERVE(0),
+                    PATH("42", "69", "5"));
+    expect_read_res(anjay, &OBJ, 69, 5, ANJAY_MOCK_DM_FLOAT(0, 42.0));
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 5, &ATTRS);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTENT, ID_TOKEN(0x69EE, "B"),
+                            CONTENT_FORMAT(PLAINTEXT), OBSERVE(0),
+                            PAYLOAD("42"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+
+    assert_observe_size(anjay, 2);
+
+    // pmax elapses 0.2s and 0.5s past the same whole second for the two
+    // observations; both triggers are rounded down to the same bucket
+    anjay_observe_trigger_bucket_t *bucket =
+            find_observation(anjay, "A")->trigger_bucket;
+    AVS_UNIT_ASSERT_NOT_NULL(bucket);
+    AVS_UNIT_ASSERT_TRUE(find_observation(anjay, "B")->trigger_bucket
+                         == bucket);
+    AVS_UNIT_ASSERT_EQUAL(bucket->instant.since_monotonic_epoch.nanoseconds,
+                          0);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(bucket->observations), 2);
+
+    ////// SINGLE FLUSH //////
+    _anjay_mock_clock_advance(
+            avs_time_monotonic_diff(bucket->instant, avs_time_monotonic_now()));
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_FLOAT(0, 514.0));
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 5, &ATTRS);
+    expect_read_res(anjay, &OBJ, 69, 5, ANJAY_MOCK_DM_FLOAT(0, 42.0));
+    const coap_test_msg_t *a_notify_response =
+            COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE, "A"), OBSERVE(1),
+                     CONTENT_FORMAT(PLAINTEXT), PAYLOAD("514"));
+    avs_unit_mocksock_expect_output(mocksocks[0], a_notify_response->content,
+                                    a_notify_response->length);
+    const coap_test_msg_t *b_notify_response =
+            COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE + 1, "B"), OBSERVE(1),
+                     CONTENT_FORMAT(PLAINTEXT), PAYLOAD("42"));
+    avs_unit_mocksock_expect_output(mocksocks[0], b_notify_response->content,
+                                    b_notify_response->length);
+    anjay_sched_run(anjay);
+    assert_observe_consistency(anjay);
+    assert_observe_size(anjay, 2);
+    AVS_UNIT_ASSERT_NULL(find_observation(anjay, "A")->last_unsent);
+    AVS_UNIT_ASSERT_NULL(find_observation(anjay, "B")->last_unsent);
+
+    // both are sent at the same time, so they share the next bucket as well
+    AVS_UNIT_ASSERT_NOT_NULL(find_observation(anjay, "A")->trigger_bucket);
+    AVS_UNIT_ASSERT_TRUE(find_observation(anjay, "A")->trigger_bucket
+                         == find_observation(anjay, "B")->trigger_bucket);
 
     DM_TEST_FINISH;
 }
@@ -1101,7 +1452,7 @@ AVS_UNIT_TEST(notify, extremes) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     ////// EVEN LESS //////
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1114,7 +1465,7 @@ AVS_UNIT_TEST(notify, extremes) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     ////// IN BETWEEN //////
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1132,7 +1483,7 @@ AVS_UNIT_TEST(notify, extremes) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     ////// EQUAL - STILL NOT CROSSING //////
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1145,7 +1496,7 @@ AVS_UNIT_TEST(notify, extremes) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     ////// GREATER //////
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1163,7 +1514,7 @@ AVS_UNIT_TEST(notify, extremes) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     ////// STILL GREATER //////
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1176,7 +1527,7 @@ AVS_UNIT_TEST(notify, extremes) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     ////// LESS AGAIN //////
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1194,7 +1545,7 @@ AVS_UNIT_TEST(notify, extremes) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     DM_TEST_FINISH;
 }
@@ -1238,7 +1589,7 @@ AVS_UNIT_TEST(notify, greater_only) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     ////// LESS //////
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1256,7 +1607,7 @@ AVS_UNIT_TEST(notify, greater_only) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     ////// GREATER AGAIN //////
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1274,7 +1625,7 @@ AVS_UNIT_TEST(notify, greater_only) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     DM_TEST_FINISH;
 }
@@ -1323,7 +1674,7 @@ AVS_UNIT_TEST(notify, less_only) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     ////// STILL LESS //////
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1336,7 +1687,7 @@ AVS_UNIT_TEST(notify, less_only) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     ////// GREATER //////
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1354,7 +1705,7 @@ AVS_UNIT_TEST(notify, less_only) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     ////// LESS AGAIN //////
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1372,7 +1723,7 @@ AVS_UNIT_TEST(notify, less_only) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     DM_TEST_FINISH;
 }
@@ -1415,7 +1766,7 @@ AVS_UNIT_TEST(notify, step) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     ////// INCREASE BY EXACTLY stp //////
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1433,7 +1784,7 @@ AVS_UNIT_TEST(notify, step) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     ////// INCREASE BY OVER stp //////
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1451,7 +1802,7 @@ AVS_UNIT_TEST(notify, step) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     ////// NON-NUMERIC VALUE //////
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1469,7 +1820,7 @@ AVS_UNIT_TEST(notify, step) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     ////// BACK TO NUMBERS //////
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1487,7 +1838,7 @@ AVS_UNIT_TEST(notify, step) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     ////// TOO LITTLE DECREASE //////
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1500,7 +1851,7 @@ AVS_UNIT_TEST(notify, step) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     ////// DECREASE BY EXACTLY stp //////
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1518,7 +1869,7 @@ AVS_UNIT_TEST(notify, step) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     ////// DECREASE BY MORE THAN stp //////
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1536,7 +1887,7 @@ AVS_UNIT_TEST(notify, step) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     ////// INCREASE BY EXACTLY stp //////
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1554,7 +1905,7 @@ AVS_UNIT_TEST(notify, step) {
     assert_observe_size(anjay, 1);
     AVS_UNIT_ASSERT_NOT_NULL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+                    ->trigger_bucket);
 
     DM_TEST_FINISH;
 }
@@ -1618,16 +1969,16 @@ AVS_UNIT_TEST(notify, multiple_formats) {
     avs_unit_mocksock_expect_output(mocksocks[0], n_notify_response->content,
                                     n_notify_response->length);
     // plaintext
+    // value already read for the first observation is reused
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
-    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_STRING(0, "Hello"));
     const coap_test_msg_t *p_notify_response =
             COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE + 1, "P"), OBSERVE(1),
                      CONTENT_FORMAT(PLAINTEXT), PAYLOAD("Hello"));
     avs_unit_mocksock_expect_output(mocksocks[0], p_notify_response->content,
                                     p_notify_response->length);
     // TLV
+    // value already read for the first observation is reused
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
-    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_STRING(0, "Hello"));
     const coap_test_msg_t *t_notify_response =
             COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE + 2, "T"), OBSERVE(1),
                      CONTENT_FORMAT(OMA_LWM2M_TLV),
@@ -1651,18 +2002,16 @@ AVS_UNIT_TEST(notify, multiple_formats) {
     avs_unit_mocksock_expect_output(mocksocks[0], n_bytes_response->content,
                                     n_bytes_response->length);
     // plaintext
+    // value already read for the first observation is reused
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
-    expect_read_res(anjay, &OBJ, 69, 4,
-                    ANJAY_MOCK_DM_BYTES(0, "\x12\x34\x56\x78"));
     const coap_test_msg_t *p_bytes_response =
             COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE + 4, "P"), OBSERVE(2),
                      CONTENT_FORMAT(PLAINTEXT), PAYLOAD("EjRWeA=="));
     avs_unit_mocksock_expect_output(mocksocks[0], p_bytes_response->content,
                                     p_bytes_response->length);
     // TLV
+    // value already read for the first observation is reused
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
-    expect_read_res(anjay, &OBJ, 69, 4,
-                    ANJAY_MOCK_DM_BYTES(0, "\x12\x34\x56\x78"));
     const coap_test_msg_t *t_bytes_response =
             COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE + 5, "T"), OBSERVE(2),
                      CONTENT_FORMAT(OMA_LWM2M_TLV),
@@ -2156,3 +2505,288 @@ AVS_UNIT_TEST(notify, no_storing_of_errors) {
     // errors, regardless of the actual setting.
     storing_of_errors_test_impl(false);
 }
+
+static anjay_observe_connection_entry_t *
+aggregation_test_connection(anjay_t *anjay, size_t limit) {
+    anjay->observe.aggregated_notification_limit = limit;
+    AVS_LIST(anjay_observe_connection_entry_t) *conn_ptr =
+            find_or_create_connection_state((anjay_connection_ref_t) {
+                .server = anjay->servers->servers,
+                .conn_type = ANJAY_CONNECTION_PRIMARY
+            });
+    AVS_UNIT_ASSERT_NOT_NULL(conn_ptr);
+    return *conn_ptr;
+}
+
+static anjay_observation_t *
+aggregation_test_observation(anjay_observe_connection_entry_t *conn,
+                             const char *token,
+                             anjay_rid_t rid) {
+    avs_coap_token_t coap_token = {
+        .size = (uint8_t) strlen(token)
+    };
+    memcpy(coap_token.bytes, token, coap_token.size);
+    const anjay_uri_path_t path = MAKE_RESOURCE_PATH(42, 69, rid);
+    anjay_observation_t *observation = put_entry_into_connection_state(
+            &coap_token, ANJAY_ACTION_READ, conn,
+            &(const paths_arg_t) {
+                .type = PATHS_POINTER_ARRAY,
+                .paths = &path,
+                .count = 1
+            });
+    AVS_UNIT_ASSERT_NOT_NULL(observation);
+    return observation;
+}
+
+static anjay_observation_value_t *
+queue_string_value(anjay_observe_connection_entry_t *conn,
+                   anjay_observation_t *observation,
+                   uint16_t format,
+                   const char *value) {
+    anjay_batch_builder_t *builder = _anjay_batch_builder_new();
+    AVS_UNIT_ASSERT_NOT_NULL(builder);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_string(
+            builder, &observation->paths[0], avs_time_real_now(), value));
+    anjay_batch_t *batch = _anjay_batch_builder_compile(&builder);
+    AVS_UNIT_ASSERT_NOT_NULL(batch);
+    AVS_UNIT_ASSERT_SUCCESS(insert_new_value(
+            conn, observation, AVS_COAP_NOTIFY_PREFER_NON_CONFIRMABLE,
+            &(const anjay_msg_details_t) {
+                .msg_code = AVS_COAP_CODE_CONTENT,
+                .format = format
+            },
+            (const anjay_batch_t *const[]) { batch }));
+    _anjay_batch_release(&batch);
+    // values are queued 1s apart, so that their age is unambiguous
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(1, AVS_TIME_S));
+    return conn->unsent_last;
+}
+
+static void assert_unsent_values(anjay_observe_connection_entry_t *conn,
+                                 anjay_observation_value_t *const *values,
+                                 size_t count) {
+    AVS_UNIT_ASSERT_EQUAL(conn->unsent_count, count);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(conn->unsent), count);
+    AVS_LIST(anjay_observation_value_t) value = conn->unsent;
+    for (size_t i = 0; i < count; ++i, value = AVS_LIST_NEXT(value)) {
+        AVS_UNIT_ASSERT_TRUE(value == values[i]);
+    }
+    AVS_UNIT_ASSERT_TRUE(conn->unsent_last == (count ? values[count - 1]
+                                                     : NULL));
+}
+
+/**
+ * Checks that @p str occurs in the serialized payload at or after
+ * @p *inout_offset, and moves the offset past it.
+ */
+static void assert_payload_contains(anjay_observe_connection_entry_t *conn,
+                                    const char *str,
+                                    size_t *inout_offset) {
+    const char *payload = (const char *) conn->serialization_state.payload;
+    const size_t length = strlen(str);
+    for (size_t i = *inout_offset;
+         i + length <= conn->serialization_state.payload_size;
+         ++i) {
+        if (!memcmp(payload + i, str, length)) {
+            *inout_offset = i + length;
+            return;
+        }
+    }
+    AVS_UNIT_ASSERT_TRUE(false);
+}
+
+AVS_UNIT_TEST(notify_aggregation, values_merged_into_single_notification) {
+    DM_TEST_INIT_WITH_SSIDS(14);
+    (void) mocksocks;
+    anjay_observe_connection_entry_t *conn =
+            aggregation_test_connection(anjay, 3);
+    anjay_observation_t *observation =
+            aggregation_test_observation(conn, "Agg", 4);
+
+    anjay_observation_value_t *values[] = {
+        queue_string_value(conn, observation, AVS_COAP_FORMAT_SENML_CBOR,
+                           "Rin"),
+        queue_string_value(conn, observation, AVS_COAP_FORMAT_SENML_CBOR,
+                           "Len"),
+        queue_string_value(conn, observation, AVS_COAP_FORMAT_SENML_CBOR,
+                           "Miku")
+    };
+    AVS_UNIT_ASSERT_EQUAL(gather_aggregated_values(conn), 3);
+    assert_unsent_values(conn, values, 3);
+
+    AVS_UNIT_ASSERT_SUCCESS(initialize_serialization_state(conn, 3));
+    AVS_UNIT_ASSERT_EQUAL(conn->serialization_state.values_count, 3);
+    size_t offset = 0;
+    assert_payload_contains(conn, "Rin", &offset);
+    assert_payload_contains(conn, "Len", &offset);
+    assert_payload_contains(conn, "Miku", &offset);
+
+    // all merged values are sent at once; pmax triggers are then rescheduled
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    handle_notify_delivery(NULL, AVS_OK, conn);
+    assert_unsent_values(conn, NULL, 0);
+    AVS_UNIT_ASSERT_TRUE(observation->last_sent == values[2]);
+    AVS_UNIT_ASSERT_NULL(observation->last_unsent);
+    AVS_UNIT_ASSERT_NULL(conn->serialization_state.payload);
+    assert_observe_consistency(anjay);
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(notify_aggregation, limit_honoured) {
+    DM_TEST_INIT_WITH_SSIDS(14);
+    (void) mocksocks;
+    anjay_observe_connection_entry_t *conn =
+            aggregation_test_connection(anjay, 2);
+    anjay_observation_t *observation =
+            aggregation_test_observation(conn, "Agg", 4);
+    anjay_observation_t *other = aggregation_test_observation(conn, "Oth", 5);
+
+    anjay_observation_value_t *a1 = queue_string_value(
+            conn, observation, AVS_COAP_FORMAT_SENML_CBOR, "a1");
+    anjay_observation_value_t *o1 =
+            queue_string_value(conn, other, AVS_COAP_FORMAT_SENML_CBOR, "o1");
+    anjay_observation_value_t *a2 = queue_string_value(
+            conn, observation, AVS_COAP_FORMAT_SENML_CBOR, "a2");
+    anjay_observation_value_t *a3 = queue_string_value(
+            conn, observation, AVS_COAP_FORMAT_SENML_CBOR, "a3");
+
+    // a2 is moved in front of o1; a3 would exceed the limit
+    AVS_UNIT_ASSERT_EQUAL(gather_aggregated_values(conn), 2);
+    assert_unsent_values(conn, (anjay_observation_value_t *const[]) {
+                                       a1, a2, o1, a3 },
+                         4);
+    AVS_UNIT_ASSERT_TRUE(observation->last_unsent == a3);
+
+    AVS_UNIT_ASSERT_SUCCESS(initialize_serialization_state(conn, 2));
+    size_t offset = 0;
+    assert_payload_contains(conn, "a1", &offset);
+    assert_payload_contains(conn, "a2", &offset);
+    handle_notify_delivery(NULL, AVS_OK, conn);
+    assert_unsent_values(conn, (anjay_observation_value_t *const[]) { o1, a3 },
+                         2);
+    AVS_UNIT_ASSERT_TRUE(observation->last_sent == a2);
+    AVS_UNIT_ASSERT_TRUE(observation->last_unsent == a3);
+
+    // values of another observation are never merged
+    AVS_UNIT_ASSERT_EQUAL(gather_aggregated_values(conn), 1);
+    assert_unsent_values(conn, (anjay_observation_value_t *const[]) { o1, a3 },
+                         2);
+    assert_observe_consistency(anjay);
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(notify_aggregation, stops_at_unmergeable_values) {
+    DM_TEST_INIT_WITH_SSIDS(14);
+    (void) mocksocks;
+    anjay_observe_connection_entry_t *conn =
+            aggregation_test_connection(anjay, 5);
+    anjay_observation_t *observation =
+            aggregation_test_observation(conn, "Agg", 4);
+
+    // formats without per-record timestamps are never merged
+    queue_string_value(conn, observation, AVS_COAP_FORMAT_PLAINTEXT, "p1");
+    queue_string_value(conn, observation, AVS_COAP_FORMAT_PLAINTEXT, "p2");
+    AVS_UNIT_ASSERT_EQUAL(gather_aggregated_values(conn), 1);
+    remove_all_unsent_values(conn);
+
+    // an error value is never reordered with respect to other values
+    queue_string_value(conn, observation, AVS_COAP_FORMAT_SENML_CBOR, "c1");
+    AVS_UNIT_ASSERT_SUCCESS(
+            insert_error(conn, observation, ANJAY_ERR_INTERNAL));
+    queue_string_value(conn, observation, AVS_COAP_FORMAT_SENML_CBOR, "c2");
+    AVS_UNIT_ASSERT_EQUAL(gather_aggregated_values(conn), 1);
+    AVS_UNIT_ASSERT_EQUAL(conn->unsent_count, 3);
+    AVS_UNIT_ASSERT_TRUE(is_error_value(AVS_LIST_NEXT(conn->unsent)));
+    assert_observe_consistency(anjay);
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(notify_aggregation, retry_after_failed_delivery) {
+    DM_TEST_INIT_WITH_SSIDS(14);
+    (void) mocksocks;
+    anjay_observe_connection_entry_t *conn =
+            aggregation_test_connection(anjay, 3);
+    anjay_observation_t *observation =
+            aggregation_test_observation(conn, "Agg", 4);
+
+    anjay_observation_value_t *values[] = {
+        queue_string_value(conn, observation, AVS_COAP_FORMAT_SENML_CBOR,
+                           "Rin"),
+        queue_string_value(conn, observation, AVS_COAP_FORMAT_SENML_CBOR,
+                           "Len")
+    };
+
+    AVS_UNIT_ASSERT_EQUAL(gather_aggregated_values(conn), 2);
+    AVS_UNIT_ASSERT_SUCCESS(initialize_serialization_state(conn, 2));
+    // non-fatal error; values are kept, as notification storing is enabled
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    handle_notify_delivery(NULL, avs_errno(AVS_ENOMEM), conn);
+    assert_unsent_values(conn, values, 2);
+    AVS_UNIT_ASSERT_NULL(observation->last_sent);
+    AVS_UNIT_ASSERT_NULL(conn->serialization_state.payload);
+
+    // a value queued in the meantime is merged in the retried notification
+    anjay_observation_value_t *third = queue_string_value(
+            conn, observation, AVS_COAP_FORMAT_SENML_CBOR, "Miku");
+    AVS_UNIT_ASSERT_EQUAL(gather_aggregated_values(conn), 3);
+    AVS_UNIT_ASSERT_SUCCESS(initialize_serialization_state(conn, 3));
+    size_t offset = 0;
+    assert_payload_contains(conn, "Rin", &offset);
+    assert_payload_contains(conn, "Len", &offset);
+    assert_payload_contains(conn, "Miku", &offset);
+
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    handle_notify_delivery(NULL, AVS_OK, conn);
+    assert_unsent_values(conn, NULL, 0);
+    AVS_UNIT_ASSERT_TRUE(observation->last_sent == third);
+    assert_observe_consistency(anjay);
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(notify_aggregation, drop_oldest_skips_values_in_flight) {
+    DM_TEST_INIT_WITH_SSIDS(14);
+    (void) mocksocks;
+    anjay->observe.notify_queue_limit_mode = NOTIFY_QUEUE_DROP_OLDEST;
+    anjay->observe.notify_queue_limit = 2;
+    anjay_observe_connection_entry_t *conn =
+            aggregation_test_connection(anjay, 2);
+    anjay_observation_t *observation =
+            aggregation_test_observation(conn, "Agg", 4);
+
+    anjay_observation_value_t *a = queue_string_value(
+            conn, observation, AVS_COAP_FORMAT_SENML_CBOR, "a");
+    anjay_observation_value_t *b = queue_string_value(
+            conn, observation, AVS_COAP_FORMAT_SENML_CBOR, "b");
+    AVS_UNIT_ASSERT_EQUAL(gather_aggregated_values(conn), 2);
+    AVS_UNIT_ASSERT_SUCCESS(initialize_serialization_state(conn, 2));
+    // pretend that the exchange has been started
+    conn->notify_exchange_id = (avs_coap_exchange_id_t) {
+        .value = 1
+    };
+
+    // a and b are in flight, so they do not count towards the limit...
+    queue_string_value(conn, observation, AVS_COAP_FORMAT_SENML_CBOR, "c");
+    anjay_observation_value_t *d = queue_string_value(
+            conn, observation, AVS_COAP_FORMAT_SENML_CBOR, "d");
+    // ...and are not dropped when it is reached; c is the oldest queued one
+    anjay_observation_value_t *e = queue_string_value(
+            conn, observation, AVS_COAP_FORMAT_SENML_CBOR, "e");
+    assert_unsent_values(conn, (anjay_observation_value_t *const[]) {
+                                       a, b, d, e },
+                         4);
+    AVS_UNIT_ASSERT_TRUE(observation->last_unsent == e);
+
+    // exactly the values that have been sent are removed from the queue
+    handle_notify_delivery(NULL, AVS_OK, conn);
+    assert_unsent_values(conn, (anjay_observation_value_t *const[]) { d, e },
+                         2);
+    AVS_UNIT_ASSERT_TRUE(observation->last_sent == b);
+    AVS_UNIT_ASSERT_TRUE(observation->last_unsent == e);
+    assert_observe_consistency(anjay);
+
+    DM_TEST_FINISH;
+}
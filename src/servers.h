@@ -106,7 +106,17 @@ typedef struct {
 
 typedef struct {
     int64_t lifetime_s;
+    /**
+     * List of Objects and Instances in CoRE Link Format. May be NULL in
+     * parameters of an Update if the list is known not to have changed since
+     * the last successful Register or Update, based on <c>dm_generation</c>.
+     */
     char *dm;
+    /**
+     * Value of @ref anjay_dm_t::instances_generation at the time <c>dm</c> was
+     * generated.
+     */
+    uint64_t dm_generation;
     anjay_binding_mode_t binding_mode;
 } anjay_update_parameters_t;
 
@@ -19,6 +19,7 @@
 #include <avsystem/commons/errno.h>
 #include <avsystem/commons/utils.h>
 
+#include <avsystem/coap/tcp.h>
 #include <avsystem/coap/udp.h>
 
 #include <inttypes.h>
@@ -90,7 +91,7 @@ static avs_error_t connect_socket(anjay_t *anjay,
     if (!avs_coap_ctx_has_socket(connection->coap_ctx)
             && avs_is_err((err = avs_coap_ctx_set_socket(connection->coap_ctx,
                                                          socket)))) {
-        anjay_log(ERROR, "could not assign socket to CoAP/UDP context");
+        anjay_log(ERROR, "could not assign socket to CoAP context");
         return err;
     }
 
@@ -226,3 +227,41 @@ const anjay_connection_type_definition_t ANJAY_CONNECTION_DEF_UDP = {
     .connect_socket = connect_udp_socket
 };
 #endif // WITH_AVS_COAP_UDP
+
+#ifdef WITH_AVS_COAP_TCP
+static int ensure_tcp_coap_context(anjay_t *anjay,
+                                   anjay_server_connection_t *connection) {
+    if (!connection->coap_ctx) {
+        connection->coap_ctx = avs_coap_tcp_ctx_create(
+                anjay->sched, anjay->in_shared_buffer, anjay->out_shared_buffer,
+                AVS_COAP_DEFAULT_TCP_REQUEST_TIMEOUT);
+        if (!connection->coap_ctx) {
+            anjay_log(ERROR, "could not create CoAP/TCP context");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static avs_error_t connect_tcp_socket(anjay_t *anjay,
+                                      anjay_server_connection_t *connection) {
+    if (avs_coap_ctx_has_socket(connection->coap_ctx)) {
+        // Capabilities and Settings Messages need to be exchanged again on
+        // every new TCP connection, which happens when the socket is assigned
+        // to a fresh CoAP context
+        _anjay_coap_ctx_cleanup(anjay, &connection->coap_ctx);
+        if (ensure_tcp_coap_context(anjay, connection)) {
+            return avs_errno(AVS_ENOMEM);
+        }
+    }
+    return connect_socket(anjay, connection);
+}
+
+const anjay_connection_type_definition_t ANJAY_CONNECTION_DEF_TCP = {
+    .name = "TCP",
+    .get_dtls_handshake_timeouts = get_tls_handshake_timeouts,
+    .prepare_connection = prepare_connection,
+    .ensure_coap_context = ensure_tcp_coap_context,
+    .connect_socket = connect_tcp_socket
+};
+#endif // WITH_AVS_COAP_TCP
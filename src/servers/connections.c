@@ -86,6 +86,10 @@ get_connection_type_def(anjay_socket_transport_t type) {
     case ANJAY_SOCKET_TRANSPORT_UDP:
         return &ANJAY_CONNECTION_DEF_UDP;
 #endif // WITH_AVS_COAP_UDP
+#ifdef WITH_AVS_COAP_TCP
+    case ANJAY_SOCKET_TRANSPORT_TCP:
+        return &ANJAY_CONNECTION_DEF_TCP;
+#endif // WITH_AVS_COAP_TCP
     default:
         return NULL;
     }
@@ -115,8 +119,18 @@ avs_error_t _anjay_server_connection_internal_bring_online(
         return AVS_OK;
     }
 
+    int result = def->ensure_coap_context(server->anjay, connection);
+    if (!result && !avs_coap_ctx_has_socket(connection->coap_ctx)) {
+        // observations can only be restored into a CoAP context that does not
+        // have a socket assigned yet
+        _anjay_observe_restore_connection((anjay_connection_ref_t) {
+            .server = server,
+            .conn_type = conn_type
+        });
+    }
+
     avs_error_t err = avs_errno(AVS_ENOMEM);
-    if (def->ensure_coap_context(server->anjay, connection)
+    if (result
             || avs_is_err((
                        err = def->connect_socket(server->anjay, connection)))) {
         connection->state = ANJAY_SERVER_CONNECTION_ERROR;
@@ -66,6 +66,10 @@ typedef struct {
 extern const anjay_connection_type_definition_t ANJAY_CONNECTION_DEF_UDP;
 #endif // WITH_AVS_COAP_UDP
 
+#ifdef WITH_AVS_COAP_TCP
+extern const anjay_connection_type_definition_t ANJAY_CONNECTION_DEF_TCP;
+#endif // WITH_AVS_COAP_TCP
+
 int _anjay_connection_init_psk_security(avs_net_security_info_t *security,
                                         const anjay_server_dtls_keys_t *keys);
 
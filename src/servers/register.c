@@ -308,9 +308,10 @@ static int query_dm_object(anjay_t *anjay,
     return 0;
 }
 
-static int query_dm(anjay_t *anjay, char **out) {
+static int query_dm(anjay_t *anjay, char **out, uint64_t *out_generation) {
     assert(out);
     assert(!*out);
+    *out_generation = anjay->dm.instances_generation;
     avs_stream_t *stream = avs_stream_membuf_create();
     if (!stream) {
         anjay_log(ERROR, "out of memory");
@@ -356,10 +357,25 @@ get_binding_mode_for_version(anjay_server_info_t *server,
     }
 }
 
+static bool dm_known_unchanged(anjay_server_info_t *server) {
+    const anjay_update_parameters_t *last_params =
+            &server->registration_info.last_update_params;
+    // The generation counter is only reliable if the application is required
+    // to notify about all changes to the sets of Instances, which is the case
+    // when Instance lists are cached.
+    return server->anjay->dm.cache_instance_lists && last_params->dm
+           && last_params->dm_generation
+                      == server->anjay->dm.instances_generation
+           && !_anjay_server_registration_expired(server);
+}
+
 static int update_parameters_init(anjay_server_info_t *server,
                                   anjay_update_parameters_t *out_params) {
     memset(out_params, 0, sizeof(*out_params));
-    if (query_dm(server->anjay, &out_params->dm)) {
+    if (dm_known_unchanged(server)) {
+        anjay_log(TRACE, "data model unchanged since last Register/Update");
+    } else if (query_dm(server->anjay, &out_params->dm,
+                        &out_params->dm_generation)) {
         goto error;
     }
     if (get_server_lifetime(server->anjay, _anjay_server_ssid(server),
@@ -614,6 +630,7 @@ static void move_assign_update_params(anjay_update_parameters_t *out,
         if (move_in->dm) {
             avs_free(out->dm);
             out->dm = move_in->dm;
+            out->dm_generation = move_in->dm_generation;
             move_in->dm = NULL;
         }
 
@@ -705,6 +722,17 @@ static void register_with_version(anjay_server_info_t *server,
 
 static void do_register(anjay_server_info_t *server,
                         anjay_update_parameters_t *move_params) {
+    // Register always needs the full list of Objects and Instances, but it
+    // might have been skipped if we were originally about to send an Update
+    if (!move_params->dm
+            && query_dm(server->anjay, &move_params->dm,
+                        &move_params->dm_generation)) {
+        update_parameters_cleanup(move_params);
+        _anjay_server_on_updated_registration(
+                server, ANJAY_REGISTRATION_ERROR_OTHER,
+                avs_errno(AVS_UNKNOWN_ERROR));
+        return;
+    }
     anjay_lwm2m_version_t attempted_version = ANJAY_LWM2M_VERSION_1_0;
     anjay_log(INFO, "Attempting to register with LwM2M version %s",
               _anjay_lwm2m_version_as_string(attempted_version));
@@ -734,7 +762,7 @@ setup_update_request_options(avs_coap_options_t *opts,
                     ? NULL
                     : new_params->binding_mode;
     *out_dm_changed_since_last_update =
-            !dm_caches_equal(old_params->dm, new_params->dm);
+            new_params->dm && !dm_caches_equal(old_params->dm, new_params->dm);
 
     avs_error_t err;
     (void) ((*out_dm_changed_since_last_update
@@ -933,7 +961,8 @@ needs_registration_update(anjay_server_info_t *server,
     return info->update_forced
            || old_params->lifetime_s != new_params->lifetime_s
            || strcmp(old_params->binding_mode, new_params->binding_mode)
-           || !dm_caches_equal(old_params->dm, new_params->dm);
+           || (new_params->dm
+               && !dm_caches_equal(old_params->dm, new_params->dm));
 }
 
 static void update_registration(anjay_server_info_t *server,
@@ -3148,3 +3148,239 @@ AVS_UNIT_TEST(dm_res_read, objlnk) {
 
     DM_TEST_FINISH;
 }
+
+static int collect_oids_clb(anjay_t *anjay,
+                            const anjay_dm_object_def_t *const *obj,
+                            void *oids_) {
+    (void) anjay;
+    AVS_LIST(anjay_oid_t) **oids_insert_ptr = (AVS_LIST(anjay_oid_t) **) oids_;
+    AVS_UNIT_ASSERT_NOT_NULL(AVS_LIST_INSERT_NEW(anjay_oid_t, *oids_insert_ptr));
+    ***oids_insert_ptr = (*obj)->oid;
+    AVS_LIST_ADVANCE_PTR(oids_insert_ptr);
+    return 0;
+}
+
+AVS_UNIT_TEST(dm_objects, find_and_iterate) {
+    DM_TEST_INIT;
+
+    ASSERT_TRUE(_anjay_dm_find_object_by_oid(anjay, 0) == &FAKE_SECURITY);
+    ASSERT_TRUE(_anjay_dm_find_object_by_oid(anjay, 1) == &FAKE_SERVER);
+    ASSERT_TRUE(_anjay_dm_find_object_by_oid(anjay, 25) == &OBJ_WITH_RESET);
+    ASSERT_TRUE(_anjay_dm_find_object_by_oid(anjay, 42) == &OBJ);
+    ASSERT_TRUE(_anjay_dm_find_object_by_oid(anjay, 128)
+                == (const anjay_dm_object_def_t *const *) &EXECUTE_OBJ);
+    ASSERT_NULL(_anjay_dm_find_object_by_oid(anjay, 2));
+    ASSERT_NULL(_anjay_dm_find_object_by_oid(anjay, 43));
+    ASSERT_NULL(_anjay_dm_find_object_by_oid(anjay, 65534));
+
+    ASSERT_FAIL(anjay_register_object(anjay, &OBJ));
+    ASSERT_FAIL(anjay_unregister_object(anjay, &FAKE_SECURITY2));
+
+    AVS_LIST(anjay_oid_t) oids = NULL;
+    AVS_LIST(anjay_oid_t) *oids_insert_ptr = &oids;
+    ASSERT_OK(_anjay_dm_foreach_object(anjay, collect_oids_clb,
+                                       &oids_insert_ptr));
+    const anjay_oid_t expected_oids[] = { 0, 1, 25, 42, 128 };
+    ASSERT_EQ(AVS_LIST_SIZE(oids), AVS_ARRAY_SIZE(expected_oids));
+    size_t i = 0;
+    AVS_LIST(anjay_oid_t) oid;
+    AVS_LIST_FOREACH(oid, oids) {
+        ASSERT_EQ(*oid, expected_oids[i++]);
+    }
+    AVS_LIST_CLEAR(&oids);
+
+    ASSERT_OK(anjay_unregister_object(
+            anjay, (const anjay_dm_object_def_t *const *) &EXECUTE_OBJ));
+    ASSERT_NULL(_anjay_dm_find_object_by_oid(anjay, 128));
+    ASSERT_TRUE(_anjay_dm_find_object_by_oid(anjay, 42) == &OBJ);
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(dm_instance_present, cached_instance_list) {
+    DM_TEST_INIT_WITH_CONFIG(.cache_instance_lists = true);
+
+    _anjay_mock_dm_expect_list_instances(
+            anjay, &OBJ, 0,
+            (const anjay_iid_t[]) { 14, 42, 69, ANJAY_ID_INVALID });
+    ASSERT_EQ(_anjay_dm_instance_present(anjay, &OBJ, 42), 1);
+    ASSERT_EQ(_anjay_dm_instance_present(anjay, &OBJ, 69), 1);
+    ASSERT_EQ(_anjay_dm_instance_present(anjay, &OBJ, 43), 0);
+    ASSERT_EQ(_anjay_dm_instance_present(anjay, &OBJ, 14), 1);
+
+    ASSERT_OK(anjay_notify_instances_changed(anjay, OBJ->oid));
+    anjay_sched_run(anjay);
+
+    _anjay_mock_dm_expect_list_instances(
+            anjay, &OBJ, 0, (const anjay_iid_t[]) { 14, ANJAY_ID_INVALID });
+    ASSERT_EQ(_anjay_dm_instance_present(anjay, &OBJ, 42), 0);
+    ASSERT_EQ(_anjay_dm_instance_present(anjay, &OBJ, 14), 1);
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(dm_instance_present, instances_generation) {
+    DM_TEST_INIT_WITH_CONFIG(.cache_instance_lists = true);
+
+    const uint64_t initial_generation = anjay->dm.instances_generation;
+    anjay_sched_run(anjay);
+    ASSERT_EQ(anjay->dm.instances_generation, initial_generation);
+
+    ASSERT_OK(anjay_notify_instances_changed(anjay, OBJ->oid));
+    anjay_sched_run(anjay);
+    ASSERT_TRUE(anjay->dm.instances_generation > initial_generation);
+
+    DM_TEST_FINISH;
+}
+
+static const anjay_dm_object_def_t *const OBJ_WITH_PRESENT =
+        &(const anjay_dm_object_def_t) {
+            .oid = 77,
+            .handlers = { ANJAY_MOCK_DM_HANDLERS,
+                          .instance_reset = _anjay_test_dm_instance_reset_NOOP,
+                          .instance_present = _anjay_mock_dm_instance_present }
+        };
+
+AVS_UNIT_TEST(dm_instance_present, handler) {
+    DM_TEST_INIT_GENERIC((DM_TEST_DEFAULT_OBJECTS, &OBJ_WITH_PRESENT), (1),
+                         (.cache_instance_lists = true));
+
+    // no list_instances calls are expected
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ_WITH_PRESENT, 42, 1);
+    ASSERT_EQ(_anjay_dm_instance_present(anjay, &OBJ_WITH_PRESENT, 42), 1);
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ_WITH_PRESENT, 42, 1);
+    ASSERT_EQ(_anjay_dm_instance_present(anjay, &OBJ_WITH_PRESENT, 42), 1);
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ_WITH_PRESENT, 43, 0);
+    ASSERT_EQ(_anjay_dm_instance_present(anjay, &OBJ_WITH_PRESENT, 43), 0);
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ_WITH_PRESENT, 69,
+                                           ANJAY_ERR_INTERNAL);
+    ASSERT_EQ(_anjay_dm_instance_present(anjay, &OBJ_WITH_PRESENT, 69),
+              ANJAY_ERR_INTERNAL);
+
+    DM_TEST_FINISH;
+}
+
+static int present_overlay(anjay_t *anjay,
+                           const anjay_dm_object_def_t *const *obj_ptr,
+                           anjay_iid_t iid);
+
+static const anjay_dm_module_t PRESENT_OVERLAY_MODULE = {
+    .overlay_handlers = {
+        .instance_present = present_overlay
+    }
+};
+
+static int present_overlay_calls;
+
+static int present_overlay(anjay_t *anjay,
+                           const anjay_dm_object_def_t *const *obj_ptr,
+                           anjay_iid_t iid) {
+    ++present_overlay_calls;
+    return _anjay_dm_call_instance_present(anjay, obj_ptr, iid,
+                                           &PRESENT_OVERLAY_MODULE);
+}
+
+AVS_UNIT_TEST(dm_instance_present, overlay) {
+    DM_TEST_INIT_GENERIC((DM_TEST_DEFAULT_OBJECTS, &OBJ_WITH_PRESENT), (1),
+                         ());
+    ASSERT_OK(_anjay_dm_module_install(anjay, &PRESENT_OVERLAY_MODULE, NULL));
+    present_overlay_calls = 0;
+
+    // the overlay is called first, and passes the call down to the Object
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ_WITH_PRESENT, 42, 1);
+    ASSERT_EQ(_anjay_dm_instance_present(anjay, &OBJ_WITH_PRESENT, 42), 1);
+    ASSERT_EQ(present_overlay_calls, 1);
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ_WITH_PRESENT, 69,
+                                           ANJAY_ERR_INTERNAL);
+    ASSERT_EQ(_anjay_dm_instance_present(anjay, &OBJ_WITH_PRESENT, 69),
+              ANJAY_ERR_INTERNAL);
+    ASSERT_EQ(present_overlay_calls, 2);
+
+    // the overlay takes precedence over list_instances of Objects that do not
+    // implement instance_present themselves
+    ASSERT_EQ(_anjay_dm_instance_present(anjay, &OBJ, 42),
+              ANJAY_ERR_METHOD_NOT_ALLOWED);
+    ASSERT_EQ(present_overlay_calls, 3);
+
+    ASSERT_OK(_anjay_dm_module_uninstall(anjay, &PRESENT_OVERLAY_MODULE));
+    _anjay_mock_dm_expect_list_instances(
+            anjay, &OBJ, 0, (const anjay_iid_t[]) { 42, ANJAY_ID_INVALID });
+    ASSERT_EQ(_anjay_dm_instance_present(anjay, &OBJ, 42), 1);
+    ASSERT_EQ(present_overlay_calls, 3);
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(dm_resource_cache, cached_within_period) {
+    DM_TEST_INIT_WITH_CONFIG(.cache_resource_lists = true);
+
+    anjay_dm_resource_kind_t kind;
+    anjay_dm_resource_presence_t presence;
+    const anjay_mock_dm_res_entry_t resources[] = {
+        { 4, ANJAY_DM_RES_RW, ANJAY_DM_RES_PRESENT },
+        { 5, ANJAY_DM_RES_R, ANJAY_DM_RES_ABSENT },
+        ANJAY_MOCK_DM_RES_END
+    };
+
+    _anjay_dm_resource_cache_begin(anjay);
+    _anjay_mock_dm_expect_list_resources(anjay, &OBJ, 69, 0, resources);
+    ASSERT_OK(_anjay_dm_resource_kind_and_presence(anjay, &OBJ, 69, 4, &kind,
+                                                   &presence));
+    ASSERT_EQ(kind, ANJAY_DM_RES_RW);
+    ASSERT_EQ(presence, ANJAY_DM_RES_PRESENT);
+    ASSERT_OK(_anjay_dm_resource_kind_and_presence(anjay, &OBJ, 69, 5, &kind,
+                                                   &presence));
+    ASSERT_EQ(kind, ANJAY_DM_RES_R);
+    ASSERT_EQ(presence, ANJAY_DM_RES_ABSENT);
+    ASSERT_EQ(_anjay_dm_resource_kind_and_presence(anjay, &OBJ, 69, 6, NULL,
+                                                   NULL),
+              ANJAY_ERR_NOT_FOUND);
+
+    ASSERT_OK(anjay_notify_changed(anjay, OBJ->oid, 69, 4));
+    _anjay_mock_dm_expect_list_resources(anjay, &OBJ, 69, 0, resources);
+    ASSERT_OK(_anjay_dm_resource_kind_and_presence(anjay, &OBJ, 69, 4, NULL,
+                                                   NULL));
+    _anjay_dm_resource_cache_end(anjay);
+    anjay_sched_run(anjay);
+
+    _anjay_mock_dm_expect_list_resources(anjay, &OBJ, 69, 0, resources);
+    ASSERT_OK(_anjay_dm_resource_kind_and_presence(anjay, &OBJ, 69, 4, NULL,
+                                                   NULL));
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(dm_resource_cache, invalidated_entries_replaced) {
+    DM_TEST_INIT_WITH_CONFIG(.cache_resource_lists = true);
+
+    const anjay_mock_dm_res_entry_t resources[] = {
+        { 4, ANJAY_DM_RES_RW, ANJAY_DM_RES_PRESENT },
+        ANJAY_MOCK_DM_RES_END
+    };
+
+    _anjay_dm_resource_cache_begin(anjay);
+    _anjay_mock_dm_expect_list_resources(anjay, &OBJ, 69, 0, resources);
+    ASSERT_OK(_anjay_dm_resource_kind_and_presence(anjay, &OBJ, 69, 4, NULL,
+                                                   NULL));
+    _anjay_mock_dm_expect_list_resources(anjay, &OBJ, 14, 0, resources);
+    ASSERT_OK(_anjay_dm_resource_kind_and_presence(anjay, &OBJ, 14, 4, NULL,
+                                                   NULL));
+    ASSERT_EQ(anjay->dm.resource_cache_count, 2);
+
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_OK(anjay_notify_changed(anjay, OBJ->oid, 69, 4));
+        _anjay_mock_dm_expect_list_resources(anjay, &OBJ, 69, 0, resources);
+        ASSERT_OK(_anjay_dm_resource_kind_and_presence(anjay, &OBJ, 69, 4,
+                                                       NULL, NULL));
+        // still served from cache
+        ASSERT_OK(_anjay_dm_resource_kind_and_presence(anjay, &OBJ, 14, 4,
+                                                       NULL, NULL));
+        ASSERT_EQ(anjay->dm.resource_cache_count, 2);
+    }
+
+    _anjay_dm_resource_cache_end(anjay);
+    ASSERT_EQ(anjay->dm.resource_cache_count, 0);
+    anjay_sched_run(anjay);
+
+    DM_TEST_FINISH;
+}
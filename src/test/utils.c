@@ -337,3 +337,11 @@ AVS_UNIT_TEST(snprintf, no_space_for_terminating_nullbyte) {
 AVS_UNIT_TEST(binding_mode_valid, unsupported_binding_mode) {
     AVS_UNIT_ASSERT_FALSE(anjay_binding_mode_valid("☃"));
 }
+
+#ifdef WITH_AVS_COAP_TCP
+AVS_UNIT_TEST(binding_mode_valid, tcp_binding_mode) {
+    AVS_UNIT_ASSERT_TRUE(anjay_binding_mode_valid("T"));
+    AVS_UNIT_ASSERT_TRUE(anjay_binding_mode_valid("TQ"));
+    AVS_UNIT_ASSERT_FALSE(anjay_binding_mode_valid("QT"));
+}
+#endif // WITH_AVS_COAP_TCP
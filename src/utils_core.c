@@ -225,6 +225,7 @@ static bool is_valid_lwm2m_1_0_binding_mode(const char *binding_mode) {
 
 static const anjay_binding_info_t BINDING_INFOS[] = {
     { 'U', ANJAY_SOCKET_TRANSPORT_UDP },
+    { 'T', ANJAY_SOCKET_TRANSPORT_TCP },
 };
 
 const anjay_binding_info_t *
@@ -239,7 +240,19 @@ _anjay_binding_info_by_transport(anjay_socket_transport_t transport) {
     return NULL;
 }
 
+#ifdef WITH_AVS_COAP_TCP
+static bool is_valid_tcp_binding_mode(const char *binding_mode) {
+    // TCP binding letter, as defined in LwM2M TS 1.1
+    return strcmp(binding_mode, "T") == 0 || strcmp(binding_mode, "TQ") == 0;
+}
+#endif // WITH_AVS_COAP_TCP
+
 bool anjay_binding_mode_valid(const char *binding_mode) {
+#ifdef WITH_AVS_COAP_TCP
+    if (is_valid_tcp_binding_mode(binding_mode)) {
+        return true;
+    }
+#endif // WITH_AVS_COAP_TCP
     return is_valid_lwm2m_1_0_binding_mode(binding_mode);
 }
 
@@ -376,6 +389,22 @@ int _anjay_copy_tls_ciphersuites(avs_net_socket_tls_ciphersuites_t *dest,
     return 0;
 }
 
+#ifdef WITH_AVS_PERSISTENCE
+avs_error_t _anjay_persistence_time(avs_persistence_context_t *ctx,
+                                    avs_time_real_t *time) {
+    uint64_t seconds = (uint64_t) time->since_real_epoch.seconds;
+    uint32_t nanoseconds = (uint32_t) time->since_real_epoch.nanoseconds;
+    avs_error_t err;
+    (void) (avs_is_err((err = avs_persistence_u64(ctx, &seconds)))
+            || avs_is_err((err = avs_persistence_u32(ctx, &nanoseconds))));
+    if (avs_is_ok(err)) {
+        time->since_real_epoch.seconds = (int64_t) seconds;
+        time->since_real_epoch.nanoseconds = (int32_t) nanoseconds;
+    }
+    return err;
+}
+#endif // WITH_AVS_PERSISTENCE
+
 #ifdef ANJAY_TEST
 #    include "test/utils.c"
 #endif // ANJAY_TEST
@@ -18,6 +18,9 @@
 #define ANJAY_UTILS_H
 
 #include <avsystem/commons/list.h>
+#ifdef WITH_AVS_PERSISTENCE
+#    include <avsystem/commons/persistence.h>
+#endif // WITH_AVS_PERSISTENCE
 #include <avsystem/commons/socket.h>
 #include <avsystem/commons/utils.h>
 
@@ -109,6 +112,14 @@ int _anjay_copy_tls_ciphersuites(avs_net_socket_tls_ciphersuites_t *dest,
 
 #define ANJAY_SMS_URI_SCHEME "tel"
 
+#ifdef WITH_AVS_PERSISTENCE
+/**
+ * Stores or restores @p time using @p ctx, depending on its direction.
+ */
+avs_error_t _anjay_persistence_time(avs_persistence_context_t *ctx,
+                                    avs_time_real_t *time);
+#endif // WITH_AVS_PERSISTENCE
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif // ANJAY_UTILS_H
@@ -140,6 +140,7 @@ anjay_dm_object_read_default_attrs_t _anjay_mock_dm_object_read_default_attrs;
 anjay_dm_object_write_default_attrs_t _anjay_mock_dm_object_write_default_attrs;
 anjay_dm_instance_reset_t _anjay_mock_dm_instance_reset;
 anjay_dm_list_instances_t _anjay_mock_dm_list_instances;
+anjay_dm_instance_present_t _anjay_mock_dm_instance_present;
 anjay_dm_instance_create_t _anjay_mock_dm_instance_create;
 anjay_dm_instance_remove_t _anjay_mock_dm_instance_remove;
 anjay_dm_instance_read_default_attrs_t
@@ -205,6 +206,11 @@ void _anjay_mock_dm_expect_list_instances(
         const anjay_dm_object_def_t *const *obj_ptr,
         int retval,
         const anjay_iid_t *iid_array);
+void _anjay_mock_dm_expect_instance_present(
+        anjay_t *anjay,
+        const anjay_dm_object_def_t *const *obj_ptr,
+        anjay_iid_t iid,
+        int retval);
 void _anjay_mock_dm_expect_instance_create(
         anjay_t *anjay,
         const anjay_dm_object_def_t *const *obj_ptr,
@@ -100,6 +100,54 @@ def _parse_udp_header(packet):
 
     return Header(code, version, type, msg_id, token_length), at
 
+
+# RFC 8323, 3.3: values of the Len nibble that denote Extended Length fields
+_TCP_EXTENDED_LENGTHS = [  # (Len, Extended Length size, offset)
+    (15, 4, 65805),
+    (14, 2, 269),
+    (13, 1, 13),
+]
+
+
+def tcp_header_size(first_byte):
+    """
+    Returns the size of CoAP/TCP message header, including the token, based on
+    its first byte.
+    """
+    size = 2 + (first_byte & 0x0F)
+    for nibble, ext_size, _ in _TCP_EXTENDED_LENGTHS:
+        if first_byte >> 4 == nibble:
+            return size + ext_size
+    return size
+
+
+def tcp_message_size(header):
+    """
+    Returns the size of the whole CoAP/TCP message with the given header.
+    """
+    token_length = header[0] & 0x0F
+    header_size = tcp_header_size(header[0])
+    ext_length = header[1:header_size - token_length - 1]
+    length = header[0] >> 4
+    for nibble, _, offset in _TCP_EXTENDED_LENGTHS:
+        if length == nibble:
+            length = int.from_bytes(ext_length, 'big') + offset
+    return header_size + length
+
+
+def _parse_tcp_header(packet):
+    if len(packet) < 2 or len(packet) < tcp_header_size(packet[0]) - (packet[0] & 0x0F):
+        raise ValueError("invalid CoAP/TCP message: %s" % hexlify(packet))
+    if tcp_message_size(packet) != len(packet):
+        raise ValueError("CoAP/TCP message length mismatch: %s" % hexlify(packet))
+
+    token_length = packet[0] & 0x0F
+    at = tcp_header_size(packet[0]) - token_length
+    code = Code.from_byte(packet[at - 1])
+
+    return Header(code, None, None, None, token_length), at
+
+
 class Packet(object):
     def __init__(self, type=None, code=1, msg_id=0, token=b'', options=None, content=b'', version=1):
         self.version = version
@@ -129,7 +177,7 @@ class Packet(object):
                    repr(self.content),
                    self.version))
 
-    def _size_breakdown(self, header):
+    def _size_breakdown(self, header, transport=Transport.UDP):
         serialized_opt_sizes = []
         prev_opt_number = 0
         for o in self.options:
@@ -137,13 +185,16 @@ class Packet(object):
             prev_opt_number = o.number
 
         sizes = {
-            'header_size': 4,
+            'header_size': 4 if transport == Transport.UDP else None,
             'token_size': len(self.token) if self.token else 0,
             'options_size': sum(serialized_opt_sizes),
             'marker_size': (1 if self.content else 0),
             'payload_size': len(self.content) if self.content else 0
         }
 
+        if transport == Transport.TCP:
+            length = sizes['options_size'] + sizes['marker_size'] + sizes['payload_size']
+            sizes['header_size'] = len(self._serialize_tcp_header(length))
         options_breakdown = [
             '- %d for %s' % (size, opt) for size, opt in zip(serialized_opt_sizes, self.options)
         ]
@@ -167,6 +218,8 @@ class Packet(object):
         packet = memoryview(self)
         if transport == Transport.UDP:
             header, offset = _parse_udp_header(packet)
+        elif transport == Transport.TCP:
+            header, offset = _parse_tcp_header(packet)
         else:
             raise ValueError("Invalid transport: %r" % (transport,))
 
@@ -194,9 +247,7 @@ class Packet(object):
             raise ValueError("CoAP packet malformed starting at offset %d: %s" % (offset, hexlify(packet[offset:])))
 
         pkt = Packet(header.type, header.code, header.id, token, options, content, header.version)
-        if transport == Transport.UDP:
-            # TODO: add log for TCP
-            logging.debug('%s', pkt._size_breakdown('received'))
+        logging.debug('%s', pkt._size_breakdown('received', transport))
         return pkt
 
     def fill_placeholders(self):
@@ -218,6 +269,14 @@ class Packet(object):
                         self.code.as_byte(),
                         self.msg_id)
 
+    def _serialize_tcp_header(self, length):
+        for nibble, ext_size, offset in _TCP_EXTENDED_LENGTHS:
+            if length >= offset:
+                return (bytes([(nibble << 4) | (len(self.token) & 0xF)])
+                        + (length - offset).to_bytes(ext_size, 'big')
+                        + bytes([self.code.as_byte()]))
+        return bytes([(length << 4) | (len(self.token) & 0xF), self.code.as_byte()])
+
     def serialize(self, transport=Transport.UDP):
         if any(x is ANY for x in (self.msg_id, self.token, self.options, self.content)):
             raise ValueError('cannot serialize CoAP packet: placeholder values present')
@@ -233,6 +292,10 @@ class Packet(object):
         if transport == Transport.UDP:
             logging.debug('%s', self._size_breakdown('sent'))
             data = self._serialize_udp_header()
+        elif transport == Transport.TCP:
+            logging.debug('%s', self._size_breakdown('sent', transport))
+            data = self._serialize_tcp_header(
+                sum(len(o) for o in serialized_opts) + len(content))
         else:
             raise ValueError("Invalid transport: %r" % (transport,))
 
@@ -19,7 +19,7 @@ import socket
 import errno
 from typing import Tuple, Optional
 
-from .packet import Packet
+from .packet import Packet, tcp_header_size, tcp_message_size
 from .transport import Transport
 from .code import Code
 
@@ -131,6 +131,14 @@ class Server(object):
                 _, remote_addr_port = self.socket.recvfrom(1, socket.MSG_PEEK)
 
             self.connect_to_client(remote_addr_port)
+        elif self.transport == Transport.TCP:
+            with _override_timeout(self.socket, timeout_s):
+                client_socket, _ = self.socket.accept()
+            client_socket.settimeout(self.socket.gettimeout())
+
+            self.socket.close()
+            self.socket = client_socket
+            self.accepted_connection = True
         else:
             raise ValueError("Invalid transport: %r" % (self.transport,))
 
@@ -213,6 +221,8 @@ class Server(object):
         self.socket.setsockopt(
             socket.SOL_SOCKET, socket.SO_REUSEPORT, 1 if self.reuse_port else 0)
         self.socket.bind(('', listen_port))
+        if self.transport == Transport.TCP:
+            self.socket.listen(1)
         self.accepted_connection = False
 
     def send(self, coap_packet: Packet) -> None:
@@ -228,8 +238,25 @@ class Server(object):
         self.accepted_connection = True
 
         with _override_timeout(self.socket, timeout_s):
+            if self.transport == Transport.TCP:
+                return self._recv_tcp_message()
             return self.socket.recv(65536)
 
+    def _recv_exactly(self, size: int) -> bytes:
+        data = b''
+        while len(data) < size:
+            chunk = self.socket.recv(size - len(data))
+            if not chunk:
+                raise ConnectionResetError('connection closed by peer')
+            data += chunk
+        return data
+
+    def _recv_tcp_message(self) -> bytes:
+        # RFC 8323, 3.2: message boundaries are determined by the Len field
+        data = self._recv_exactly(1)
+        data += self._recv_exactly(tcp_header_size(data[0]) - 1)
+        return data + self._recv_exactly(tcp_message_size(data) - len(data))
+
     def recv(self, timeout_s: float = -1) -> Packet:
         return Packet.parse(self.recv_raw(timeout_s), transport=self.transport)
 
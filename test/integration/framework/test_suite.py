@@ -351,8 +351,10 @@ class Lwm2mTest(unittest.TestCase, Lwm2mAsserts):
                 '--fw-updated-marker-path', fw_updated_marker_path, '--security-mode', security_mode]
 
         for serv in servers:
-            args += ['--server-uri', '%s://127.0.0.1:%d' %
-                     (protocol, serv.get_listen_port(),)]
+            args += ['--server-uri', '%s%s://127.0.0.1:%d' %
+                     (protocol,
+                      '+tcp' if serv.transport == Transport.TCP else '',
+                      serv.get_listen_port(),)]
 
         return args
 
@@ -847,6 +849,39 @@ class Lwm2mDtlsSingleServerTest(Lwm2mSingleServerTest):
         super().setUp(psk_identity=self.PSK_IDENTITY, psk_key=self.PSK_KEY, *args, **kwargs)
 
 
+class Lwm2mSingleTcpServerTest(Lwm2mSingleServerTest):
+    def setUp(self, extra_cmdline_args=None, auto_register=True, *args, **kwargs):
+        extra_args = ['--binding', 'T']
+        if extra_cmdline_args is not None:
+            extra_args += extra_cmdline_args
+
+        if 'servers' not in kwargs:
+            kwargs['servers'] = [Lwm2mServer(coap.Server(transport=Transport.TCP))]
+
+        super().setUp(extra_cmdline_args=extra_args, auto_register=False, *args, **kwargs)
+
+        try:
+            self.assertDemoExchangesCsm(self.serv)
+            if auto_register:
+                self.assertDemoRegisters(self.serv, lifetime=kwargs.get('lifetime'))
+        except Exception:
+            try:
+                self.teardown_demo_with_servers(auto_deregister=False)
+            finally:
+                raise
+
+    def assertDemoExchangesCsm(self, server, max_message_size=1152):
+        # RFC 8323, 5.3: CSM is the first message sent on a new connection
+        pkt = server.recv()
+        self.assertEqual(coap.Code.SIGNALING_CSM, pkt.code)
+        # Max-Message-Size
+        self.assertEqual(1, len([opt for opt in pkt.options if opt.number == 2]))
+        server.send(coap.Packet(code=coap.Code.SIGNALING_CSM,
+                                msg_id=None,
+                                options=[coap.Option(2, max_message_size.to_bytes(2, 'big'))]))
+        return pkt
+
+
 # This class **MUST** be specified as the first in superclass list, due to Python's method resolution order
 # (see https://www.python-course.eu/python3_multiple_inheritance.php) and the fact that not all setUp() methods
 # call super().setUp(). Failure to fulfill this requirement may lead to "make check" failing on systems
@@ -0,0 +1,54 @@
+# -*- coding: utf-8 -*-
+#
+# Copyright 2017-2019 AVSystem <avsystem@avsystem.com>
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import socket
+
+from framework.lwm2m_test import *
+
+
+class TcpRegisterTest(test_suite.Lwm2mSingleTcpServerTest):
+    def setUp(self):
+        super().setUp(auto_register=False)
+
+    def runTest(self):
+        # CSM exchange is verified in setUp(); Register follows it directly
+        pkt = self.serv.recv()
+        self.assertMsgEqual(
+            Lwm2mRegister('/rd?lwm2m=1.0&ep=%s&lt=86400&b=T' % (DEMO_ENDPOINT_NAME,)),
+            pkt)
+        self.serv.send(Lwm2mCreated.matching(pkt)(location='/rd/demo'))
+
+        # TCP guarantees delivery, so there are no retransmissions
+        with self.assertRaises(socket.timeout, msg='unexpected message'):
+            print(self.serv.recv(timeout_s=3))
+
+
+class TcpPingTest(test_suite.Lwm2mSingleTcpServerTest):
+    def runTest(self):
+        ping = coap.Packet(code=coap.Code.SIGNALING_PING, msg_id=None,
+                           token=b'ping')
+        self.serv.send(ping)
+
+        pkt = self.serv.recv()
+        self.assertEqual(coap.Code.SIGNALING_PONG, pkt.code)
+        self.assertEqual(ping.token, pkt.token)
+
+
+class TcpReadTest(test_suite.Lwm2mSingleTcpServerTest, test_suite.Lwm2mDmOperations):
+    def runTest(self):
+        res = self.read_resource(self.serv, OID.Device, 0, RID.Device.Manufacturer,
+                                 accept=coap.ContentFormat.TEXT_PLAIN)
+        self.assertEqual(b'0023C7', res.content)
@@ -17,6 +17,8 @@
 import concurrent.futures
 import contextlib
 import os
+import re
+import socketserver
 import time
 import http.server
 import threading
@@ -434,3 +436,143 @@ class HttpDownloadDoesNotBlockOnNoPayloadAfterHeaders(HttpDownload.Test):
             self.assertDemoUpdatesRegistration()
 
             self.cv_notify_all()
+
+
+class HttpRangeDownload:
+    class Test(HttpDownload.Test):
+        PAYLOAD = os.urandom(64 * 1024)
+        ETAG = '"range-test"'
+        MAX_CONNECTIONS = 4
+        RANGE_SIZE = 4096
+
+        DOWNLOAD_FINISHED = 0
+        DOWNLOAD_ERR_FAILED = 1
+
+        def _create_server(self):
+            class ThreadingHTTPServer(socketserver.ThreadingMixIn, http.server.HTTPServer):
+                daemon_threads = True
+
+            return ThreadingHTTPServer(('', 0), self.make_request_handler())
+
+        def setUp(self, *args, **kwargs):
+            self.requested_ranges = []
+            super().setUp(*args, **kwargs)
+
+        def send_body(self, handler, data):
+            try:
+                handler.wfile.write(data)
+                handler.wfile.flush()
+            except (BrokenPipeError, ConnectionResetError):
+                # the client closes the first connection once it receives
+                # the first range
+                pass
+
+        def send_range(self, handler, start, end):
+            handler.send_response(http.HTTPStatus.PARTIAL_CONTENT)
+            handler.send_header('Content-Range',
+                                'bytes %d-%d/%d' % (start, end - 1, len(self.PAYLOAD)))
+            handler.send_header('Content-Length', str(end - start))
+            handler.send_header('ETag', self.ETAG)
+            handler.end_headers()
+            self.send_body(handler, self.PAYLOAD[start:end])
+
+        def send_whole(self, handler):
+            handler.send_response(http.HTTPStatus.OK)
+            handler.send_header('Content-Length', str(len(self.PAYLOAD)))
+            handler.send_header('Accept-Ranges', 'bytes')
+            handler.send_header('ETag', self.ETAG)
+            handler.end_headers()
+            self.send_body(handler, self.PAYLOAD)
+
+        def handle_range_request(self, handler, start, end):
+            self.send_range(handler, start, end)
+
+        def make_request_handler(self):
+            test_case = self
+
+            class RequestHandler(http.server.BaseHTTPRequestHandler):
+                def do_GET(self):
+                    if 'Range' not in self.headers:
+                        test_case.send_whole(self)
+                        return
+                    match = re.fullmatch(r'bytes=([0-9]+)-([0-9]+)', self.headers['Range'])
+                    test_case.assertIsNotNone(match)
+                    test_case.assertEqual(test_case.ETAG, self.headers['If-Match'])
+                    start, end = int(match.group(1)), int(match.group(2)) + 1
+                    test_case.requested_ranges.append((start, end))
+                    test_case.handle_range_request(self, start, end)
+
+                def log_request(code='-', size='-'):
+                    # don't display logs on successful request
+                    pass
+
+            return RequestHandler
+
+        def download(self):
+            """
+            Downloads the payload and returns the download result and the data
+            passed to the client.
+            """
+            with tempfile.NamedTemporaryFile() as temp_file:
+                result = self.communicate(
+                    'download-ranges http://127.0.0.1:%d %s %d %d' % (
+                        self.http_server.server_address[1], temp_file.name,
+                        self.MAX_CONNECTIONS, self.RANGE_SIZE),
+                    match_regex='download finished, result == ([0-9]+)\n', timeout=15)
+                self.assertIsNotNone(result)
+                with open(temp_file.name, 'rb') as f:
+                    return int(result.group(1)), f.read()
+
+
+class HttpRangeDownloadSucceeds(HttpRangeDownload.Test):
+    def runTest(self):
+        result, data = self.download()
+        self.assertEqual(self.DOWNLOAD_FINISHED, result)
+        self.assertEqual(self.PAYLOAD, data)
+
+        # the first range is received over the initial connection
+        self.assertEqual([(offset, offset + self.RANGE_SIZE)
+                          for offset in range(self.RANGE_SIZE, len(self.PAYLOAD),
+                                              self.RANGE_SIZE)],
+                         sorted(self.requested_ranges))
+
+
+class HttpRangeDownloadFailsOnShortPartialContent(HttpRangeDownload.Test):
+    def handle_range_request(self, handler, start, end):
+        self.send_range(handler, start, (start + end) // 2)
+
+    def runTest(self):
+        result, data = self.download()
+        self.assertEqual(self.DOWNLOAD_ERR_FAILED, result)
+        self.assertTrue(self.PAYLOAD.startswith(data))
+
+
+class HttpRangeDownloadFailsIfServerIgnoresRange(HttpRangeDownload.Test):
+    def handle_range_request(self, handler, start, end):
+        self.send_whole(handler)
+
+    def runTest(self):
+        result, data = self.download()
+        self.assertEqual(self.DOWNLOAD_ERR_FAILED, result)
+        self.assertTrue(self.PAYLOAD.startswith(data))
+
+
+class HttpRangeDownloadFailsOnBrokenConnection(HttpRangeDownload.Test):
+    def handle_range_request(self, handler, start, end):
+        if start != 2 * self.RANGE_SIZE:
+            self.send_range(handler, start, end)
+            return
+        # announce the whole range, but close the connection halfway through
+        handler.send_response(http.HTTPStatus.PARTIAL_CONTENT)
+        handler.send_header('Content-Range',
+                            'bytes %d-%d/%d' % (start, end - 1, len(self.PAYLOAD)))
+        handler.send_header('Content-Length', str(end - start))
+        handler.send_header('ETag', self.ETAG)
+        handler.end_headers()
+        self.send_body(handler, self.PAYLOAD[start:(start + end) // 2])
+
+    def runTest(self):
+        result, data = self.download()
+        self.assertEqual(self.DOWNLOAD_ERR_FAILED, result)
+        self.assertTrue(self.PAYLOAD.startswith(data))
+        self.assertLessEqual(len(data), 2 * self.RANGE_SIZE + self.RANGE_SIZE // 2)
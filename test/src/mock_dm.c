@@ -31,6 +31,7 @@ typedef enum {
     MOCK_DM_OBJECT_WRITE_DEFAULT_ATTRS,
     MOCK_DM_INSTANCE_RESET,
     MOCK_DM_LIST_INSTANCES,
+    MOCK_DM_INSTANCE_PRESENT,
     MOCK_DM_INSTANCE_CREATE,
     MOCK_DM_INSTANCE_REMOVE,
     MOCK_DM_INSTANCE_READ_DEFAULT_ATTRS,
@@ -186,6 +187,7 @@ int _anjay_mock_dm_list_instances(anjay_t *anjay,
     }
 
 INSTANCE_ACTION(reset, RESET)
+INSTANCE_ACTION(present, PRESENT)
 INSTANCE_ACTION(remove, REMOVE)
 INSTANCE_ACTION(create, CREATE)
 
@@ -530,6 +532,7 @@ void _anjay_mock_dm_expect_list_instances(
     }
 
 EXPECT_INSTANCE_ACTION(reset, RESET)
+EXPECT_INSTANCE_ACTION(present, PRESENT)
 EXPECT_INSTANCE_ACTION(remove, REMOVE)
 EXPECT_INSTANCE_ACTION(create, CREATE)
 